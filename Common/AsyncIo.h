@@ -0,0 +1,428 @@
+#pragma once
+// AsyncIo.h
+// Batched file I/O for work over many small files (repacking a list of DSPs, a folder of
+// WAVs). A batch of reads - open, size, read, close per file - is submitted at once and
+// returns when every file is done, so the cost is a few round trips per batch instead of
+// four blocking calls per file.
+//   Linux:     io_uring (raw syscalls, no liburing): each phase of up to depth() files
+//              is one submission - OPENAT for all of them, then READ (linked behind a
+//              FADVISE when a hint is given), then CLOSE.
+//   elsewhere: a ThreadPool of blocking positional reads/writes, also used when the
+//              kernel refuses io_uring; any request the ring cannot finish (old kernel,
+//              short read) is redone this way, so results never depend on the backend.
+// Read-ahead hints: Sequential for whole files that are streamed once, Random for header
+// reads where the kernel's read-ahead would only fetch bytes nobody looks at.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define ASYNCIO_URING 1
+#endif
+#endif
+
+#include "ThreadPool.h"
+#include "Trace.h"
+
+enum class IoHint { None, Sequential, Random };
+
+constexpr uint64_t IO_TO_END = ~0ull;
+
+// One file to read: in 'path', 'offset', 'length'; out the rest.
+struct IoRead {
+    std::filesystem::path path;
+    uint64_t offset = 0;
+    uint64_t length = IO_TO_END;    // clipped to the file
+
+    std::vector<uint8_t> data;      // the bytes read
+    uint64_t file_size = 0;
+    int error = 0;                  // 0, or errno / GetLastError() of the failed step
+
+    bool ok() const { return error == 0; }
+};
+
+// Bytes to place at 'offset' of an IoOutput; the memory must live until write() returns.
+struct IoWrite {
+    uint64_t offset;
+    const void* data;
+    size_t length;
+};
+
+// Output file for AsyncIo::write(); created (truncated) by open().
+class IoOutput {
+public:
+    IoOutput() = default;
+    ~IoOutput() { close(); }
+    IoOutput(const IoOutput&) = delete;
+    IoOutput& operator=(const IoOutput&) = delete;
+
+    bool open(const std::filesystem::path& path) {
+        close();
+#ifdef _WIN32
+        m_file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_file == INVALID_HANDLE_VALUE) { m_file = NULL; return false; }
+#else
+        m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (m_fd < 0) return false;
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (m_file) CloseHandle(m_file);
+        m_file = NULL;
+#else
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+#endif
+    }
+
+#ifdef _WIN32
+    bool is_open() const { return m_file != NULL; }
+#else
+    bool is_open() const { return m_fd >= 0; }
+#endif
+
+private:
+    friend class AsyncIo;
+#ifdef _WIN32
+    HANDLE m_file = NULL;
+#else
+    int m_fd = -1;
+#endif
+};
+
+namespace io_detail {
+// Blocking versions; the thread-pool backend and the ring's fallback for a single request.
+#ifdef _WIN32
+inline int LastError() { return static_cast<int>(GetLastError()); }
+
+inline bool ReadAt(HANDLE f, uint64_t offset, uint8_t* p, size_t bytes) {
+    while (bytes) {
+        OVERLAPPED ov{};
+        ov.Offset = static_cast<DWORD>(offset); ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD got = 0;
+        const DWORD want = static_cast<DWORD>((std::min)(bytes, static_cast<size_t>(1u << 30)));
+        if (!ReadFile(f, p, want, &got, &ov) || got == 0) return false;
+        p += got; offset += got; bytes -= got;
+    }
+    return true;
+}
+
+inline bool WriteAt(HANDLE f, uint64_t offset, const uint8_t* p, size_t bytes) {
+    while (bytes) {
+        OVERLAPPED ov{};
+        ov.Offset = static_cast<DWORD>(offset); ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD put = 0;
+        const DWORD want = static_cast<DWORD>((std::min)(bytes, static_cast<size_t>(1u << 30)));
+        if (!WriteFile(f, p, want, &put, &ov) || put == 0) return false;
+        p += put; offset += put; bytes -= put;
+    }
+    return true;
+}
+
+inline void ReadOne(IoRead& r, IoHint hint) {
+    const DWORD flags = hint == IoHint::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : hint == IoHint::Random ? FILE_FLAG_RANDOM_ACCESS : 0;
+    HANDLE f = CreateFileW(r.path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | flags, NULL);
+    if (f == INVALID_HANDLE_VALUE) { r.error = LastError(); return; }
+    LARGE_INTEGER sz{};
+    if (!GetFileSizeEx(f, &sz)) { r.error = LastError(); CloseHandle(f); return; }
+    r.file_size = static_cast<uint64_t>(sz.QuadPart);
+    const uint64_t want = r.offset < r.file_size ? (std::min)(r.length, r.file_size - r.offset) : 0;
+    r.data.resize(static_cast<size_t>(want));
+    if (want && !ReadAt(f, r.offset, r.data.data(), r.data.size())) { r.error = LastError(); r.data.clear(); }
+    CloseHandle(f);
+}
+#else
+inline bool ReadAt(int fd, uint64_t offset, uint8_t* p, size_t bytes) {
+    while (bytes) {
+        const ssize_t got = pread(fd, p, bytes, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) { if (got == 0) errno = EIO; return false; }
+        p += got; offset += static_cast<uint64_t>(got); bytes -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+inline bool WriteAt(int fd, uint64_t offset, const uint8_t* p, size_t bytes) {
+    while (bytes) {
+        const ssize_t put = pwrite(fd, p, bytes, static_cast<off_t>(offset));
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) { if (put == 0) errno = EIO; return false; }
+        p += put; offset += static_cast<uint64_t>(put); bytes -= static_cast<size_t>(put);
+    }
+    return true;
+}
+
+inline int Advice(IoHint hint) { return hint == IoHint::Sequential ? POSIX_FADV_SEQUENTIAL : POSIX_FADV_RANDOM; }
+
+// Size, buffer and byte count of a request whose file is open as 'fd'; false on fstat failure.
+inline bool Prepare(IoRead& r, int fd) {
+    struct stat st {};
+    if (fstat(fd, &st) != 0) { r.error = errno; return false; }
+    r.file_size = static_cast<uint64_t>(st.st_size);
+    const uint64_t want = r.offset < r.file_size ? (std::min)(r.length, r.file_size - r.offset) : 0;
+    r.data.resize(static_cast<size_t>(want));
+    return true;
+}
+
+inline void ReadOne(IoRead& r, IoHint hint) {
+    r.error = 0; r.data.clear();
+    const int fd = ::open(r.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { r.error = errno; return; }
+    if (Prepare(r, fd) && !r.data.empty()) {
+        if (hint != IoHint::None) posix_fadvise(fd, static_cast<off_t>(r.offset), static_cast<off_t>(r.data.size()), Advice(hint));
+        if (!ReadAt(fd, r.offset, r.data.data(), r.data.size())) { r.error = errno; r.data.clear(); }
+    }
+    ::close(fd);
+}
+#endif
+
+#ifdef ASYNCIO_URING
+// Minimal io_uring: submit what has been queued, then reap exactly that many completions.
+class Ring {
+public:
+    ~Ring() {
+        if (m_sqes) munmap(m_sqes, m_sqes_bytes);
+        if (m_cq_ptr && m_cq_ptr != m_sq_ptr) munmap(m_cq_ptr, m_cq_bytes);
+        if (m_sq_ptr) munmap(m_sq_ptr, m_sq_bytes);
+        if (m_fd >= 0) ::close(m_fd);
+    }
+
+    bool init(unsigned entries) {
+        io_uring_params p{};
+        m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+        if (m_fd < 0) return false;
+        m_sq_bytes = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        m_cq_bytes = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) m_sq_bytes = m_cq_bytes = (std::max)(m_sq_bytes, m_cq_bytes);
+        m_sq_ptr = Map(m_sq_bytes, IORING_OFF_SQ_RING);
+        m_cq_ptr = single ? m_sq_ptr : Map(m_cq_bytes, IORING_OFF_CQ_RING);
+        m_sqes_bytes = p.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe*>(Map(m_sqes_bytes, IORING_OFF_SQES));
+        if (!m_sq_ptr || !m_cq_ptr || !m_sqes) return false;
+        char* sq = static_cast<char*>(m_sq_ptr);
+        char* cq = static_cast<char*>(m_cq_ptr);
+        m_sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        m_sq_mask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        m_sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        m_cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        m_cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        m_cq_mask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        m_entries = p.sq_entries;
+        return true;
+    }
+
+    unsigned entries() const { return m_entries; }
+    // At most this many entries per io_uring_enter (tests use it to force partial submits).
+    void set_submit_limit(unsigned n) { m_submit_limit = (std::max)(1u, n); }
+
+    // Next free submission slot (zeroed); the caller keeps within entries() per batch.
+    io_uring_sqe* queue(uint8_t opcode, int fd, uint64_t user_data) {
+        const unsigned idx = (*m_sq_tail + m_queued) & m_sq_mask;
+        io_uring_sqe* sqe = &m_sqes[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode; sqe->fd = fd; sqe->user_data = user_data;
+        m_sq_array[idx] = idx;
+        ++m_queued;
+        return sqe;
+    }
+
+    // Submits the queue and calls done(user_data, res) once for each queued entry. The
+    // kernel may take fewer entries than offered; the rest are offered again until all are
+    // in. If it stops taking them (an error, or no progress after MAX_STALLS tries), the
+    // entries it never saw are taken back off the ring and reported as done(user_data,
+    // -errno). False, with no done() calls, if not a single entry was submitted.
+    template <class F> bool run(F&& done) {
+        constexpr int MAX_STALLS = 64;
+        const unsigned n = m_queued;
+        if (!n) return true;
+        const unsigned tail = *m_sq_tail;
+        __atomic_store_n(m_sq_tail, tail + n, __ATOMIC_RELEASE);
+        m_queued = 0;
+        unsigned submitted = 0;
+        int error = 0;
+        for (int stalls = 0; submitted < n;) {
+            const long r = syscall(__NR_io_uring_enter, m_fd, (std::min)(n - submitted, m_submit_limit), 0, 0, nullptr, 0);
+            if (r > 0) { submitted += static_cast<unsigned>(r); stalls = 0; continue; }
+            error = r == 0 ? EAGAIN : errno;
+            if ((error == EINTR || error == EAGAIN) && ++stalls < MAX_STALLS) continue;
+            break;
+        }
+        if (submitted < n) {
+            // Without SQPOLL the kernel reads the queue only inside io_uring_enter, so the
+            // entries past 'submitted' are still ours to withdraw.
+            __atomic_store_n(m_sq_tail, tail + submitted, __ATOMIC_RELEASE);
+            if (!submitted) return false;
+        }
+        for (unsigned reaped = 0; reaped < submitted;) {
+            const unsigned head = *m_cq_head;
+            if (head == __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE)) {
+                syscall(__NR_io_uring_enter, m_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                continue;
+            }
+            const io_uring_cqe& cqe = m_cqes[head & m_cq_mask];
+            done(cqe.user_data, cqe.res);
+            __atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+            ++reaped;
+        }
+        for (unsigned k = submitted; k < n; ++k) done(m_sqes[(tail + k) & m_sq_mask].user_data, -error);
+        return true;
+    }
+
+private:
+    void* Map(size_t bytes, off_t at) {
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, at);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    int m_fd = -1;
+    void* m_sq_ptr = nullptr; void* m_cq_ptr = nullptr;
+    size_t m_sq_bytes = 0, m_cq_bytes = 0, m_sqes_bytes = 0;
+    io_uring_sqe* m_sqes = nullptr;
+    io_uring_cqe* m_cqes = nullptr;
+    unsigned* m_sq_tail = nullptr; unsigned* m_sq_array = nullptr;
+    unsigned* m_cq_head = nullptr; unsigned* m_cq_tail = nullptr;
+    unsigned m_sq_mask = 0, m_cq_mask = 0, m_entries = 0, m_queued = 0, m_submit_limit = ~0u;
+};
+#endif
+} // namespace io_detail
+
+class AsyncIo {
+public:
+    // 'depth' = files in flight per submission (ring backend) or threads (fallback, capped).
+    // allow_ring = false always takes the thread pool (tests compare the two).
+    explicit AsyncIo(unsigned depth = 256, bool allow_ring = true) : m_depth((std::max)(1u, depth)) {
+#ifdef ASYNCIO_URING
+        // Two slots per file: a FADVISE linked in front of each READ.
+        auto ring = std::make_unique<io_detail::Ring>();
+        if (allow_ring && ring->init(m_depth * 2) && ring->entries() >= m_depth * 2) m_ring = std::move(ring);
+        else
+#else
+        (void)allow_ring;
+#endif
+        m_pool = std::make_unique<ThreadPool>((std::min)(m_depth, 64u));
+    }
+
+    unsigned depth() const { return m_depth; }
+    const char* backend() const {
+#ifdef ASYNCIO_URING
+        if (m_ring) return "io_uring";
+#endif
+        return "threads";
+    }
+
+    // Reads every request; returns when all have completed (check each one's ok()).
+    void read(std::vector<IoRead>& reads, IoHint hint = IoHint::None) {
+        TRACE_SCOPE_CAT("AsyncIo::read", "io");
+        for (IoRead& r : reads) { r.error = 0; r.file_size = 0; r.data.clear(); }
+#ifdef ASYNCIO_URING
+        if (m_ring) { for (size_t at = 0; at < reads.size(); at += m_depth) ring_read(reads.data() + at, (std::min)(reads.size() - at, static_cast<size_t>(m_depth)), hint); return; }
+#endif
+        m_pool->parallel_for(reads.size(), [&](size_t i, unsigned) { io_detail::ReadOne(reads[i], hint); });
+    }
+
+    // Places every write at its offset; ranges should not overlap. False if any failed.
+    bool write(IoOutput& out, const std::vector<IoWrite>& writes) {
+        TRACE_SCOPE_CAT("AsyncIo::write", "io");
+        if (!out.is_open()) return false;
+#ifdef _WIN32
+        std::atomic<bool> ok{ true };
+        m_pool->parallel_for(writes.size(), [&](size_t i, unsigned) {
+            if (!io_detail::WriteAt(out.m_file, writes[i].offset, static_cast<const uint8_t*>(writes[i].data), writes[i].length)) ok = false;
+        });
+        return ok;
+#else
+#ifdef ASYNCIO_URING
+        if (m_ring) return ring_write(out.m_fd, writes);
+#endif
+        std::atomic<bool> ok{ true };
+        m_pool->parallel_for(writes.size(), [&](size_t i, unsigned) {
+            if (!io_detail::WriteAt(out.m_fd, writes[i].offset, static_cast<const uint8_t*>(writes[i].data), writes[i].length)) ok = false;
+        });
+        return ok;
+#endif
+    }
+
+private:
+#ifdef ASYNCIO_URING
+    // One batch of at most depth() files: open all, read all, close all.
+    void ring_read(IoRead* reads, size_t n, IoHint hint) {
+        constexpr uint64_t ADVISE_TAG = 1ull << 63;
+        std::vector<int> fds(n, -1);
+        std::vector<uint8_t> redo(n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            io_uring_sqe* sqe = m_ring->queue(IORING_OP_OPENAT, AT_FDCWD, i);
+            sqe->addr = reinterpret_cast<uintptr_t>(reads[i].path.c_str());
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        }
+        if (!m_ring->run([&](uint64_t i, int res) { if (res >= 0) fds[i] = res; else redo[i] = 1; })) redo.assign(n, 1);
+
+        for (size_t i = 0; i < n; ++i) {
+            if (fds[i] < 0) continue;
+            if (!io_detail::Prepare(reads[i], fds[i])) { redo[i] = 1; continue; }
+            if (reads[i].data.empty()) continue;
+            const uint32_t len = static_cast<uint32_t>((std::min)(reads[i].data.size(), static_cast<size_t>(1u << 30)));
+            if (hint != IoHint::None) {
+                io_uring_sqe* adv = m_ring->queue(IORING_OP_FADVISE, fds[i], i | ADVISE_TAG);
+                adv->off = reads[i].offset; adv->len = len; adv->fadvise_advice = static_cast<uint32_t>(io_detail::Advice(hint));
+                adv->flags = IOSQE_IO_LINK;
+            }
+            io_uring_sqe* sqe = m_ring->queue(IORING_OP_READ, fds[i], i);
+            sqe->addr = reinterpret_cast<uintptr_t>(reads[i].data.data()); sqe->len = len; sqe->off = reads[i].offset;
+        }
+        // A hint that fails only cancels its read; the read is then redone without the ring.
+        if (!m_ring->run([&](uint64_t tag, int res) {
+                if (tag & ADVISE_TAG) return;
+                if (res < 0 || static_cast<size_t>(res) != reads[tag].data.size()) redo[tag] = 1;
+            })) redo.assign(n, 1);
+
+        for (size_t i = 0; i < n; ++i) if (fds[i] >= 0) m_ring->queue(IORING_OP_CLOSE, fds[i], i);
+        if (!m_ring->run([&](uint64_t i, int res) { if (res < 0) ::close(fds[i]); })) for (int fd : fds) if (fd >= 0) ::close(fd);
+
+        for (size_t i = 0; i < n; ++i) if (redo[i]) io_detail::ReadOne(reads[i], hint);
+    }
+
+    bool ring_write(int fd, const std::vector<IoWrite>& writes) {
+        bool ok = true;
+        for (size_t at = 0; at < writes.size(); at += m_depth) {
+            const size_t n = (std::min)(writes.size() - at, static_cast<size_t>(m_depth));
+            std::vector<uint8_t> redo(n, 0);
+            for (size_t i = 0; i < n; ++i) {
+                const IoWrite& w = writes[at + i];
+                io_uring_sqe* sqe = m_ring->queue(IORING_OP_WRITE, fd, i);
+                sqe->addr = reinterpret_cast<uintptr_t>(w.data);
+                sqe->len = static_cast<uint32_t>((std::min)(w.length, static_cast<size_t>(1u << 30)));
+                sqe->off = w.offset;
+            }
+            if (!m_ring->run([&](uint64_t i, int res) { if (res < 0 || static_cast<size_t>(res) != writes[at + i].length) redo[i] = 1; })) redo.assign(n, 1);
+            for (size_t i = 0; i < n; ++i)
+                if (redo[i] && !io_detail::WriteAt(fd, writes[at + i].offset, static_cast<const uint8_t*>(writes[at + i].data), writes[at + i].length)) ok = false;
+        }
+        return ok;
+    }
+
+    std::unique_ptr<io_detail::Ring> m_ring;
+#endif
+    unsigned m_depth;
+    std::unique_ptr<ThreadPool> m_pool;
+};
@@ -0,0 +1,250 @@
+#pragma once
+// BeLayout.h
+// Big-endian GameCube headers described once. Each header is a plain struct whose
+// members sit exactly where the fields sit on disc, plus a constexpr table of its fields
+// (offset, element width, element count). From the table the compiler builds per-byte
+// masks, and BeLoad / BeStore turn a whole header around in one pass of 16 bytes per
+// step with SSE2 (16-bit and 32-bit lanes swapped together and blended by
+// the masks), so the 16 coefficients cost the same as one field. The table must cover
+// every byte of the struct exactly once; that is checked at compile time.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BELAYOUT_SSE2 1
+#endif
+
+struct BeField {
+    uint16_t offset;   // bytes from the start of the header
+    uint8_t width;     // element size: 1 (bytes, never swapped), 2 or 4
+    uint16_t count;    // elements (arrays)
+};
+
+// One table row per member: BE_FIELD(DspHeader, coefs) -> { 0x1C, 2, 16 }.
+#define BE_FIELD(T, member) \
+    BeField{ static_cast<uint16_t>(offsetof(T, member)), \
+             static_cast<uint8_t>(sizeof(std::remove_all_extents_t<decltype(T::member)>)), \
+             static_cast<uint16_t>(sizeof(T::member) / sizeof(std::remove_all_extents_t<decltype(T::member)>)) }
+
+// Specialised next to each header struct: static constexpr std::array<BeField, N> fields.
+template <class T> struct BeLayoutOf;
+
+// 'head' followed by 'tail' moved to 'at' (a header nested inside an entry).
+template <size_t N, size_t M>
+constexpr std::array<BeField, N + M> BeAppend(const std::array<BeField, N>& head, const std::array<BeField, M>& tail, size_t at) {
+    std::array<BeField, N + M> out{};
+    for (size_t i = 0; i < N; ++i) out[i] = head[i];
+    for (size_t i = 0; i < M; ++i) out[N + i] = BeField{ static_cast<uint16_t>(tail[i].offset + at), tail[i].width, tail[i].count };
+    return out;
+}
+
+namespace be_detail {
+template <size_t Bytes>
+struct Masks {
+    static constexpr size_t PADDED = (Bytes + 15) / 16 * 16;
+    uint8_t in16[PADDED] = {};   // 0xFF where the byte belongs to a 16-bit element
+    uint8_t in32[PADDED] = {};   // 0xFF where the byte belongs to a 32-bit element
+    bool valid = true;           // every byte covered once, every element aligned to its width
+};
+
+template <class T>
+constexpr Masks<sizeof(T)> BuildMasks() {
+    Masks<sizeof(T)> m{};
+    uint8_t covered[sizeof(T)] = {};
+    for (const BeField& f : BeLayoutOf<T>::fields) {
+        if (f.width != 1 && f.width != 2 && f.width != 4) { m.valid = false; continue; }
+        if (f.offset % f.width != 0) m.valid = false;
+        for (size_t b = 0; b < static_cast<size_t>(f.width) * f.count; ++b) {
+            const size_t at = f.offset + b;
+            if (at >= sizeof(T) || covered[at]) { m.valid = false; continue; }
+            covered[at] = 1;
+            if (f.width == 2) m.in16[at] = 0xFF;
+            if (f.width == 4) m.in32[at] = 0xFF;
+        }
+    }
+    for (size_t i = 0; i < sizeof(T); ++i) if (!covered[i]) m.valid = false;
+    return m;
+}
+
+template <class T>
+inline constexpr Masks<sizeof(T)> kMasks = BuildMasks<T>();
+
+// dst = src with every 16/32-bit element reversed. dst and src may be the same buffer.
+template <class T>
+inline void SwapCopy(uint8_t* dst, const uint8_t* src) {
+    constexpr const Masks<sizeof(T)>& m = kMasks<T>;
+    static_assert(m.valid, "BeLayoutOf<T>::fields must cover every byte of T once, each element aligned to its width");
+    size_t i = 0;
+#ifdef BELAYOUT_SSE2
+    for (; i + 16 <= sizeof(T); i += 16) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i k16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m.in16 + i));
+        const __m128i k32 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m.in32 + i));
+        const __m128i s16 = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));              // AB -> BA per 16-bit lane
+        const __m128i s32 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s16, 0xB1), 0xB1);            // then swap the halves of each 32
+        const __m128i keep = _mm_andnot_si128(_mm_or_si128(k16, k32), x);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(keep, _mm_or_si128(_mm_and_si128(s16, k16), _mm_and_si128(s32, k32))));
+    }
+#endif
+    while (i < sizeof(T)) {
+        if (m.in32[i]) {
+            const uint8_t a = src[i], b = src[i + 1], c = src[i + 2], d = src[i + 3];
+            dst[i] = d; dst[i + 1] = c; dst[i + 2] = b; dst[i + 3] = a; i += 4;
+        } else if (m.in16[i]) {
+            const uint8_t a = src[i], b = src[i + 1];
+            dst[i] = b; dst[i + 1] = a; i += 2;
+        } else {
+            dst[i] = src[i]; i += 1;
+        }
+    }
+}
+} // namespace be_detail
+
+// Disc bytes -> host struct.
+template <class T>
+inline void BeLoad(const uint8_t* src, T& out) {
+    static_assert(std::is_trivially_copyable_v<T>, "BeLoad needs a plain header struct");
+    be_detail::SwapCopy<T>(reinterpret_cast<uint8_t*>(&out), src);
+}
+
+// Host struct -> disc bytes.
+template <class T>
+inline void BeStore(const T& in, uint8_t* dst) {
+    static_assert(std::is_trivially_copyable_v<T>, "BeStore needs a plain header struct");
+    be_detail::SwapCopy<T>(dst, reinterpret_cast<const uint8_t*>(&in));
+}
+
+// ---------------------------------------------------------------------------------
+// GameCube DSP ADPCM channel header (0x60 bytes), as written by DS2Tool and read by
+// every tool; DS2 files carry two back to back.
+struct DspHeader {
+    uint32_t num_samples;
+    uint32_t num_nibbles;
+    uint32_t sample_rate;
+    uint16_t loop_flag;
+    uint16_t format;
+    uint32_t loop_start;        // nibble address
+    uint32_t loop_end;          // nibble address
+    uint32_t current_address;
+    int16_t coefs[16];
+    uint16_t gain;
+    uint16_t initial_ps;        // predictor/scale of the first frame
+    int16_t initial_hist1;
+    int16_t initial_hist2;
+    uint16_t loop_ps;
+    int16_t loop_hist1;
+    int16_t loop_hist2;
+    uint16_t reserved[7];       // 0x4A..0x57; DS2Tool writes 0x5E3D, 0 into the first two
+    uint32_t data_size;         // ADPCM bytes of this channel
+    uint32_t data_offset;       // from the start of the file
+};
+static_assert(sizeof(DspHeader) == 0x60, "DSP header is 0x60 bytes");
+
+template <> struct BeLayoutOf<DspHeader> {
+    static constexpr std::array<BeField, 19> fields = { {
+        BE_FIELD(DspHeader, num_samples), BE_FIELD(DspHeader, num_nibbles), BE_FIELD(DspHeader, sample_rate),
+        BE_FIELD(DspHeader, loop_flag), BE_FIELD(DspHeader, format),
+        BE_FIELD(DspHeader, loop_start), BE_FIELD(DspHeader, loop_end), BE_FIELD(DspHeader, current_address),
+        BE_FIELD(DspHeader, coefs), BE_FIELD(DspHeader, gain), BE_FIELD(DspHeader, initial_ps),
+        BE_FIELD(DspHeader, initial_hist1), BE_FIELD(DspHeader, initial_hist2),
+        BE_FIELD(DspHeader, loop_ps), BE_FIELD(DspHeader, loop_hist1), BE_FIELD(DspHeader, loop_hist2),
+        BE_FIELD(DspHeader, reserved), BE_FIELD(DspHeader, data_size), BE_FIELD(DspHeader, data_offset),
+    } };
+};
+
+// SPT "part1" record (0x1C bytes): one per stream, addresses are absolute SPD nibbles.
+struct SptPart1 {
+    uint32_t loop_flag;
+    uint32_t sample_rate;
+    uint32_t loop_start;
+    uint32_t loop_end;
+    uint32_t end_address;       // last nibble, inclusive
+    uint32_t current_address;
+    uint32_t reserved;
+};
+static_assert(sizeof(SptPart1) == 0x1C, "SPT part1 record is 0x1C bytes");
+
+template <> struct BeLayoutOf<SptPart1> {
+    static constexpr std::array<BeField, 7> fields = { {
+        BE_FIELD(SptPart1, loop_flag), BE_FIELD(SptPart1, sample_rate), BE_FIELD(SptPart1, loop_start),
+        BE_FIELD(SptPart1, loop_end), BE_FIELD(SptPart1, end_address), BE_FIELD(SptPart1, current_address),
+        BE_FIELD(SptPart1, reserved),
+    } };
+};
+
+// SPT "part2" record (0x2E bytes): the decoder state of a DSP header, coefs..loop_hist2.
+struct SptPart2 {
+    int16_t coefs[16];
+    uint16_t gain;
+    uint16_t initial_ps;
+    int16_t initial_hist1;
+    int16_t initial_hist2;
+    uint16_t loop_ps;
+    int16_t loop_hist1;
+    int16_t loop_hist2;
+};
+static_assert(sizeof(SptPart2) == 0x2E, "SPT part2 record is 0x2E bytes");
+static_assert(offsetof(DspHeader, coefs) == 0x1C && offsetof(DspHeader, reserved) == 0x1C + sizeof(SptPart2),
+    "SPT part2 is DSP header bytes 0x1C..0x4A");
+
+template <> struct BeLayoutOf<SptPart2> {
+    static constexpr std::array<BeField, 8> fields = { {
+        BE_FIELD(SptPart2, coefs), BE_FIELD(SptPart2, gain), BE_FIELD(SptPart2, initial_ps),
+        BE_FIELD(SptPart2, initial_hist1), BE_FIELD(SptPart2, initial_hist2),
+        BE_FIELD(SptPart2, loop_ps), BE_FIELD(SptPart2, loop_hist1), BE_FIELD(SptPart2, loop_hist2),
+    } };
+};
+
+// SPT file header: the stream count, followed by the part1 then the part2 records.
+struct SptFileHeader {
+    uint32_t count;
+};
+static_assert(sizeof(SptFileHeader) == 4, "SPT file header is 4 bytes");
+
+template <> struct BeLayoutOf<SptFileHeader> {
+    static constexpr std::array<BeField, 1> fields = { { BE_FIELD(SptFileHeader, count) } };
+};
+
+// DSH / D2H file header: the big-endian entry count, zero padding to 0x20.
+struct DshFileHeader {
+    uint32_t count;
+    uint8_t reserved[0x1C];
+};
+static_assert(sizeof(DshFileHeader) == 0x20, "DSH/D2H file header is 0x20 bytes");
+
+template <> struct BeLayoutOf<DshFileHeader> {
+    static constexpr std::array<BeField, 2> fields = { { BE_FIELD(DshFileHeader, count), BE_FIELD(DshFileHeader, reserved) } };
+};
+
+// DSH / D2H index entries, after the file header: a 0x100-byte zero-padded UTF-8 name,
+// then the stream's header(s) copied from the DSP (one) or DS2 (two) file.
+constexpr size_t DSH_FILE_HEADER_BYTES = sizeof(DshFileHeader);
+constexpr size_t DSH_NAME_BYTES = 0x100;
+
+struct DshEntry {
+    char name[DSH_NAME_BYTES];
+    DspHeader header;
+};
+static_assert(sizeof(DshEntry) == 0x160, "DSH entry is 0x160 bytes");
+
+struct D2hEntry {
+    char name[DSH_NAME_BYTES];
+    DspHeader left;
+    DspHeader right;
+};
+static_assert(sizeof(D2hEntry) == 0x1C0, "D2H entry is 0x1C0 bytes");
+
+template <> struct BeLayoutOf<DshEntry> {
+    static constexpr auto fields = BeAppend(std::array<BeField, 1>{ { BE_FIELD(DshEntry, name) } },
+        BeLayoutOf<DspHeader>::fields, offsetof(DshEntry, header));
+};
+
+template <> struct BeLayoutOf<D2hEntry> {
+    static constexpr auto fields = BeAppend(BeAppend(std::array<BeField, 1>{ { BE_FIELD(D2hEntry, name) } },
+        BeLayoutOf<DspHeader>::fields, offsetof(D2hEntry, left)), BeLayoutOf<DspHeader>::fields, offsetof(D2hEntry, right));
+};
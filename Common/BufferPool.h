@@ -0,0 +1,130 @@
+#pragma once
+// BufferPool.h
+// Reusable scratch vectors for per-file work in batch runs. A Scratch<T> takes a vector
+// from the calling thread's pool and hands it back when it goes out of scope, so the
+// next file's decode/encode buffers reuse memory that is already allocated and faulted
+// in instead of going through the heap and fresh pages every time.
+//
+// Each thread has its own pool per element type (no locking). Pooled vectors are kept by
+// size class - the bit width of their capacity in bytes - and a request is served from
+// its own class or the next one up, so a buffer is never more than 4x the size asked
+// for. A class keeps at most MAX_PER_CLASS vectors and a thread at most MAX_HELD_BYTES;
+// anything beyond that is freed as usual. Counters are process-wide.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct BufferPoolStats {
+    uint64_t takes = 0;        // Scratch buffers handed out
+    uint64_t reused = 0;       // ... of which came from a pool
+    uint64_t allocated = 0;    // ... of which needed a new heap block
+    uint64_t released = 0;     // returned buffers freed because the pool was full
+};
+
+namespace pool_detail {
+struct Counters {
+    std::atomic<uint64_t> takes{ 0 }, reused{ 0 }, allocated{ 0 }, released{ 0 };
+};
+inline Counters& Global() { static Counters c; return c; }
+
+inline unsigned SizeClass(size_t bytes) {
+    unsigned c = 0;
+    while (bytes >>= 1) ++c;
+    return c;
+}
+
+template <class T>
+class LocalPool {
+public:
+    static constexpr unsigned CLASSES = 48;
+    static constexpr size_t MAX_PER_CLASS = 4;
+    static constexpr size_t MAX_HELD_BYTES = size_t(256) << 20;
+
+    static LocalPool& Local() { thread_local LocalPool pool; return pool; }
+
+    // A vector of n value-initialised elements.
+    std::vector<T> take(size_t n) {
+        Counters& g = Global();
+        g.takes.fetch_add(1, std::memory_order_relaxed);
+        if (n) {
+            const unsigned c = SizeClass(n * sizeof(T));
+            for (unsigned k = c; k < CLASSES && k <= c + 1; ++k) {
+                std::vector<std::vector<T>>& bin = m_bins[k];
+                for (size_t i = bin.size(); i-- > 0;) {
+                    if (bin[i].capacity() < n) continue;
+                    std::vector<T> v = std::move(bin[i]);
+                    bin.erase(bin.begin() + static_cast<std::ptrdiff_t>(i));
+                    m_held -= v.capacity() * sizeof(T);
+                    g.reused.fetch_add(1, std::memory_order_relaxed);
+                    v.resize(n);
+                    return v;
+                }
+            }
+            g.allocated.fetch_add(1, std::memory_order_relaxed);
+        }
+        return std::vector<T>(n);
+    }
+
+    void give(std::vector<T>&& v) {
+        const size_t bytes = v.capacity() * sizeof(T);
+        if (!bytes) return;
+        const unsigned c = SizeClass(bytes);
+        if (c >= CLASSES || m_bins[c].size() >= MAX_PER_CLASS || m_held + bytes > MAX_HELD_BYTES) {
+            Global().released.fetch_add(1, std::memory_order_relaxed);
+            return;   // v frees its block on the way out
+        }
+        v.clear();
+        m_held += bytes;
+        m_bins[c].push_back(std::move(v));
+    }
+
+private:
+    std::vector<std::vector<T>> m_bins[CLASSES];
+    size_t m_held = 0;
+};
+} // namespace pool_detail
+
+inline BufferPoolStats GetBufferPoolStats() {
+    const pool_detail::Counters& g = pool_detail::Global();
+    BufferPoolStats s;
+    s.takes = g.takes.load(std::memory_order_relaxed);
+    s.reused = g.reused.load(std::memory_order_relaxed);
+    s.allocated = g.allocated.load(std::memory_order_relaxed);
+    s.released = g.released.load(std::memory_order_relaxed);
+    return s;
+}
+
+// A pooled std::vector<T> of n elements for the lifetime of this object. Use * / -> for
+// the vector itself (to pass on as std::vector<T>&), or the shortcuts below.
+template <class T>
+class Scratch {
+public:
+    explicit Scratch(size_t n = 0) : m_v(pool_detail::LocalPool<T>::Local().take(n)) {}
+    ~Scratch() { pool_detail::LocalPool<T>::Local().give(std::move(m_v)); }
+
+    Scratch(Scratch&& other) noexcept : m_v(std::move(other.m_v)) { other.m_v = std::vector<T>(); }
+    Scratch& operator=(Scratch&& other) noexcept {
+        if (this != &other) { std::swap(m_v, other.m_v); }
+        return *this;
+    }
+    Scratch(const Scratch&) = delete;
+    Scratch& operator=(const Scratch&) = delete;
+
+    std::vector<T>& operator*() { return m_v; }
+    const std::vector<T>& operator*() const { return m_v; }
+    std::vector<T>* operator->() { return &m_v; }
+    const std::vector<T>* operator->() const { return &m_v; }
+
+    T* data() { return m_v.data(); }
+    const T* data() const { return m_v.data(); }
+    size_t size() const { return m_v.size(); }
+    bool empty() const { return m_v.empty(); }
+    T& operator[](size_t i) { return m_v[i]; }
+    const T& operator[](size_t i) const { return m_v[i]; }
+
+private:
+    std::vector<T> m_v;
+};
@@ -0,0 +1,467 @@
+#pragma once
+// CorpusScan.h
+// Walks a game data tree and reads only the headers of its sound files - DSP, DS2,
+// DSH, D2H, SPT and XBB - to answer corpus questions (how many looped sounds, which
+// sample rates, how many ADPCM bytes per bank) without decoding or extracting anything.
+//
+// Files are spread over a ThreadPool. Each worker reads through a HeaderReader: positional
+// reads (pread / ReadFile at an offset, no shared file pointer) into a window buffer. A
+// DSH/D2H/SPT entry table arrives in one read of exactly its size; XBB entry headers are
+// walked with 64 KiB read-ahead, so runs of small entries share a read. Audio payloads
+// are never requested. The result is one CorpusReport, written as JSON (summary + per file)
+// and CSV (one row per stream).
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "BeLayout.h"
+#include "DspContainer.h"
+#include "JsonWriter.h"
+#include "Riff.h"
+#include "RunMetrics.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+// Read-only file accessed by offset. read() hands out a pointer into a window buffer that
+// is refilled with one positional read whenever a request falls outside it; that read
+// covers at least the read-ahead (0 = exactly what was asked for).
+class HeaderReader {
+public:
+    static constexpr size_t READ_AHEAD_BYTES = 64 << 10;
+
+    HeaderReader() = default;
+    ~HeaderReader() { close(); }
+    HeaderReader(const HeaderReader&) = delete;
+    HeaderReader& operator=(const HeaderReader&) = delete;
+
+    bool open(const std::filesystem::path& path) {
+        close();
+#ifdef _WIN32
+        m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+        if (m_file == INVALID_HANDLE_VALUE) { m_file = NULL; return false; }
+        LARGE_INTEGER sz{};
+        if (!GetFileSizeEx(m_file, &sz)) { close(); return false; }
+        m_size = static_cast<uint64_t>(sz.QuadPart);
+#else
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        if (m_fd < 0) return false;
+        struct stat st {};
+        if (fstat(m_fd, &st) != 0) { close(); return false; }
+        m_size = static_cast<uint64_t>(st.st_size);
+#endif
+        m_window_at = 0; m_window.clear();
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (m_file) CloseHandle(m_file);
+        m_file = NULL;
+#else
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+#endif
+        m_size = 0; m_window.clear();
+    }
+
+    void set_read_ahead(size_t bytes) { m_read_ahead = bytes; }
+    uint64_t size() const { return m_size; }
+    uint64_t bytes_read() const { return m_bytes_read; }
+    uint64_t reads() const { return m_reads; }
+
+    // [offset, offset + len) of the file, or nullptr if the file is shorter. Valid until
+    // the next read().
+    const uint8_t* read(uint64_t offset, size_t len) {
+        if (offset > m_size || len > m_size - offset) return nullptr;
+        if (offset >= m_window_at && offset + len <= m_window_at + m_window.size()) return m_window.data() + (offset - m_window_at);
+        const size_t want = static_cast<size_t>((std::min)(static_cast<uint64_t>((std::max)(len, m_read_ahead)), m_size - offset));
+        m_window.resize(want);
+        if (!read_at(offset, m_window.data(), want)) { m_window.clear(); return nullptr; }
+        m_window_at = offset;
+        ++m_reads; m_bytes_read += want;
+        return m_window.data();
+    }
+
+private:
+#ifdef _WIN32
+    bool read_at(uint64_t offset, uint8_t* p, size_t bytes) {
+        while (bytes) {
+            OVERLAPPED ov{};
+            ov.Offset = static_cast<DWORD>(offset); ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD done = 0;
+            const DWORD chunk = static_cast<DWORD>((std::min)(bytes, static_cast<size_t>(1) << 30));
+            if (!ReadFile(m_file, p, chunk, &done, &ov) || done == 0) return false;
+            p += done; offset += done; bytes -= done;
+        }
+        return true;
+    }
+    HANDLE m_file = NULL;
+#else
+    bool read_at(uint64_t offset, uint8_t* p, size_t bytes) {
+        while (bytes) {
+            const ssize_t done = ::pread(m_fd, p, bytes, static_cast<off_t>(offset));
+            if (done <= 0) return false;
+            p += done; offset += static_cast<uint64_t>(done); bytes -= static_cast<size_t>(done);
+        }
+        return true;
+    }
+    int m_fd = -1;
+#endif
+    uint64_t m_size = 0;
+    uint64_t m_window_at = 0;
+    size_t m_read_ahead = 0;
+    std::vector<uint8_t> m_window;
+    uint64_t m_bytes_read = 0, m_reads = 0;
+};
+
+enum class ScanKind { Dsp, Ds2, Dsh, D2h, Spt, Xbb, Count };
+
+inline const char* ScanKindName(ScanKind k) {
+    switch (k) {
+    case ScanKind::Dsp: return "dsp";
+    case ScanKind::Ds2: return "ds2";
+    case ScanKind::Dsh: return "dsh";
+    case ScanKind::D2h: return "d2h";
+    case ScanKind::Spt: return "spt";
+    case ScanKind::Xbb: return "xbb";
+    default: return "?";
+    }
+}
+
+// One sound: a whole DSP/DS2 file or one bank entry.
+struct ScanStream {
+    uint32_t index = 0;            // entry number inside the bank
+    std::string name;              // DSH/D2H entry name (UTF-8), empty elsewhere
+    uint16_t format = 0;           // XBB WAVE format tag; 0 = GameCube DSP ADPCM
+    uint16_t channels = 1;
+    uint32_t sample_rate = 0;
+    uint32_t samples = 0;          // per channel
+    bool looped = false;
+    uint32_t loop_start = 0;       // nibble addresses (DSP) / sample frames (XBB smpl)
+    uint32_t loop_end = 0;
+    uint64_t data_bytes = 0;       // encoded payload, all channels
+};
+
+struct ScanFile {
+    std::filesystem::path path;
+    ScanKind kind = ScanKind::Dsp;
+    uint64_t size = 0;
+    std::vector<ScanStream> streams;
+    std::string error;             // empty = headers parsed
+    uint64_t bytes_read = 0, reads = 0;
+};
+
+struct CorpusReport {
+    std::filesystem::path root;
+    std::vector<ScanFile> files;
+    unsigned threads = 0;
+    double walk_ms = 0, scan_ms = 0;
+};
+
+namespace scan_detail {
+inline uint32_t le32(const uint8_t* p) { return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24); }
+inline uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+constexpr size_t XBB_HEADER_PREFIX = 4096;   // enough for RIFF/fmt/smpl; inline audio past it is never read
+
+inline bool KindOf(const std::filesystem::path& p, ScanKind& kind) {
+    std::wstring ext = p.extension().wstring();
+    for (auto& c : ext) if (c >= L'A' && c <= L'Z') c = static_cast<wchar_t>(c - L'A' + L'a');
+    static const struct { const wchar_t* ext; ScanKind kind; } kinds[] = {
+        { L".dsp", ScanKind::Dsp }, { L".ds2", ScanKind::Ds2 }, { L".dsh", ScanKind::Dsh },
+        { L".d2h", ScanKind::D2h }, { L".spt", ScanKind::Spt }, { L".xbb", ScanKind::Xbb },
+    };
+    for (const auto& k : kinds) if (ext == k.ext) { kind = k.kind; return true; }
+    return false;
+}
+
+inline std::string Utf8(const std::filesystem::path& p) { const auto s = p.u8string(); return std::string(s.begin(), s.end()); }
+
+// GameCube channel header -> stream fields (payload from nibbles or samples, as DspPayloadBytes).
+inline void FromDspHeader(const uint8_t* raw, ScanStream& s) {
+    DspHeader h;
+    BeLoad(raw, h);
+    s.sample_rate = h.sample_rate; s.samples = h.num_samples;
+    s.looped = h.loop_flag != 0; s.loop_start = h.loop_start; s.loop_end = h.loop_end;
+    s.data_bytes += DspPayloadBytes(h);
+}
+
+inline bool ScanDsp(HeaderReader& r, ScanFile& f) {
+    const uint8_t* p = r.read(0, DSP_HEADER_BYTES);
+    if (!p) { f.error = "shorter than a DSP header"; return false; }
+    ScanStream s;
+    FromDspHeader(p, s);
+    f.streams.push_back(s);
+    return true;
+}
+
+inline bool ScanDs2(HeaderReader& r, ScanFile& f) {
+    const uint8_t* p = r.read(0, DS2_HEADER_BYTES);
+    if (!p) { f.error = "shorter than a DS2 header"; return false; }
+    ScanStream s;
+    s.channels = 2;
+    FromDspHeader(p + DSP_HEADER_BYTES, s);   // right first: the left header sets the fields
+    FromDspHeader(p, s);
+    f.streams.push_back(s);
+    return true;
+}
+
+// DSH (one DSP header per entry) and D2H (two).
+template <class Entry>
+inline bool ScanHeaderBank(HeaderReader& r, ScanFile& f, uint16_t channels) {
+    const uint8_t* p = r.read(0, DSH_FILE_HEADER_BYTES);
+    if (!p) { f.error = "shorter than the bank header"; return false; }
+    DshFileHeader head;
+    BeLoad(p, head);
+    const uint32_t count = head.count;
+    if (count > (r.size() - DSH_FILE_HEADER_BYTES) / sizeof(Entry)) { f.error = "entry count runs past the end of the file"; return false; }
+    const uint8_t* table = r.read(DSH_FILE_HEADER_BYTES, count * sizeof(Entry));   // the whole table, one read
+    if (!table && count) { f.error = "entry table unreadable"; return false; }
+    f.streams.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* e = table + i * sizeof(Entry);
+        ScanStream& s = f.streams[i];
+        s.index = i; s.channels = channels;
+        s.name.assign(reinterpret_cast<const char*>(e), strnlen(reinterpret_cast<const char*>(e), DSH_NAME_BYTES));
+        for (uint16_t c = channels; c-- > 0;) FromDspHeader(e + DSH_NAME_BYTES + c * DSP_HEADER_BYTES, s);
+    }
+    return true;
+}
+
+// Stream bounds follow ParseSptSpd: each stream starts at the previous one's 8-byte aligned end.
+inline bool ScanSpt(HeaderReader& r, ScanFile& f) {
+    const uint8_t* p = r.read(0, SPT_HEADER_BYTES);
+    if (!p) { f.error = "shorter than the SPT count"; return false; }
+    SptFileHeader head;
+    BeLoad(p, head);
+    const uint32_t count = head.count;
+    if (count > (r.size() - SPT_HEADER_BYTES) / (SPT_PART1_BYTES + SPT_PART2_BYTES)) { f.error = "entry count runs past the end of the file"; return false; }
+    const uint8_t* table = r.read(SPT_HEADER_BYTES, count * (SPT_PART1_BYTES + SPT_PART2_BYTES));
+    if (!table && count) { f.error = "entry table unreadable"; return false; }
+    f.streams.resize(count);
+    uint32_t start = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        SptPart1 p1;
+        BeLoad(table + i * SPT_PART1_BYTES, p1);
+        const uint32_t stop = p1.end_address / 2 + 1;
+        if (stop <= start) { f.streams.resize(i); f.error = "stream " + std::to_string(i) + " ends before it starts"; return false; }
+        const uint32_t nibbles = p1.end_address + 1 - start * 2;
+        ScanStream& s = f.streams[i];
+        s.index = i; s.sample_rate = p1.sample_rate;
+        s.samples = nibbles - 2 * ((nibbles + 15) / 16);
+        s.looped = (p1.loop_flag & 1) != 0;
+        s.loop_start = p1.loop_start - start * 2; s.loop_end = p1.loop_end - start * 2;
+        s.data_bytes = ((stop + 7) & ~7u) - start;
+        start = (stop + 7) & ~7u;
+    }
+    return true;
+}
+
+// Entries are a RIFF header plus an 8-byte (XSB offset, length) trailer; see OpenXbbBank.
+inline bool ScanXbb(HeaderReader& r, ScanFile& f) {
+    const uint8_t* p = r.read(0, 8);
+    if (!p) { f.error = "shorter than the XBB header"; return false; }
+    const uint32_t count = le32(p + 4);
+    uint64_t cursor = 8;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* head = r.read(cursor, 8);
+        if (!head) { f.error = "entry table ends after " + std::to_string(i) + " of " + std::to_string(count) + " entries"; return false; }
+        const uint32_t header_len = le32(head + 4);
+        if (header_len == 0 || cursor + header_len + 8 > r.size()) { cursor += 8; continue; }
+        const size_t prefix = (std::min)(static_cast<size_t>(header_len), XBB_HEADER_PREFIX);
+        ScanStream s;
+        s.index = i;
+        uint16_t bits = 0;
+        uint32_t inline_len = 0;
+        if (const uint8_t* h = r.read(cursor, prefix)) {
+            RiffReader riff(h, prefix);
+            RiffChunk c;
+            while (riff.next(c)) {
+                if (c.is("fmt ") && c.avail >= 16) {
+                    s.format = le16(c.data); s.channels = le16(c.data + 2); s.sample_rate = le32(c.data + 4); bits = le16(c.data + 14);
+                }
+                else if (c.is("smpl") && c.avail >= 36 + 24 && le32(c.data + 28) > 0) {
+                    s.looped = true; s.loop_start = le32(c.data + 36 + 8); s.loop_end = le32(c.data + 36 + 12);
+                }
+                else if (c.is("data")) {
+                    const uint64_t end = static_cast<uint64_t>(c.data_offset()) + c.size;
+                    if (c.size > 0 && c.size < 0xF0000000 && (end == header_len || end == static_cast<uint64_t>(header_len) + 8)) inline_len = static_cast<uint32_t>(c.size);
+                }
+            }
+        }
+        const uint8_t* trailer = r.read(cursor + header_len, 8);
+        s.data_bytes = inline_len ? inline_len : (trailer ? le32(trailer + 4) : 0);
+        if (s.channels) {
+            if (s.format == 0x0069) s.samples = static_cast<uint32_t>(s.data_bytes / (36ull * s.channels) * 64);   // Xbox ADPCM
+            else if (bits >= 8) s.samples = static_cast<uint32_t>(s.data_bytes / (static_cast<uint64_t>(s.channels) * (bits / 8)));
+        }
+        f.streams.push_back(s);
+        cursor += header_len + 8;
+    }
+    return true;
+}
+
+inline void ScanOne(ScanFile& f) {
+    TRACE_SCOPE_CAT("ScanOne", "io");
+    HeaderReader r;
+    if (!r.open(f.path)) { f.error = "cannot open"; return; }
+    f.size = r.size();
+    switch (f.kind) {
+    case ScanKind::Dsp: ScanDsp(r, f); break;
+    case ScanKind::Ds2: ScanDs2(r, f); break;
+    case ScanKind::Dsh: ScanHeaderBank<DshEntry>(r, f, 1); break;
+    case ScanKind::D2h: ScanHeaderBank<D2hEntry>(r, f, 2); break;
+    case ScanKind::Spt: ScanSpt(r, f); break;
+    case ScanKind::Xbb: r.set_read_ahead(HeaderReader::READ_AHEAD_BYTES); ScanXbb(r, f); break;
+    default: break;
+    }
+    f.bytes_read = r.bytes_read(); f.reads = r.reads();
+}
+
+inline double Ms(std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+} // namespace scan_detail
+
+// Scans every recognised file under 'root' (threads = 0: one per hardware thread). With
+// 'metrics', each file is also counted there as one unit of work.
+inline CorpusReport ScanCorpus(const std::filesystem::path& root, unsigned threads = 0, RunMetrics* metrics = nullptr) {
+    namespace fs = std::filesystem;
+    CorpusReport report;
+    report.root = root;
+    const auto t0 = std::chrono::steady_clock::now();
+    {
+        TRACE_SCOPE_CAT("ScanCorpus walk", "io");
+        std::optional<RunStageTimer> walk_time;
+        if (metrics) walk_time.emplace(*metrics, RunStage::Walk);
+        std::error_code ec;
+        for (auto it = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, ec); it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) { ec.clear(); continue; }
+            ScanKind kind;
+            if (!it->is_regular_file(ec) || !scan_detail::KindOf(it->path(), kind)) continue;
+            ScanFile f;
+            f.path = it->path(); f.kind = kind;
+            report.files.push_back(std::move(f));
+        }
+        std::sort(report.files.begin(), report.files.end(), [](const ScanFile& a, const ScanFile& b) { return a.path < b.path; });
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    ThreadPool pool(threads);
+    report.threads = pool.size();
+    pool.parallel_for(report.files.size(), [&](size_t i, unsigned) {
+        ScanFile& f = report.files[i];
+        if (!metrics) { scan_detail::ScanOne(f); return; }
+        RunFile file(*metrics);
+        scan_detail::ScanOne(f);
+        file.bytes_in(f.bytes_read);
+        for (const ScanStream& st : f.streams) file.samples(uint64_t(st.samples) * st.channels);
+        if (!f.error.empty()) file.fail(f.error == "cannot open" ? RunError::Open : RunError::Format);
+    });
+    report.walk_ms = scan_detail::Ms(t0, t1);
+    report.scan_ms = scan_detail::Ms(t1, std::chrono::steady_clock::now());
+    return report;
+}
+
+// Corpus totals, computed from the per-file results.
+struct CorpusSummary {
+    uint64_t files = 0, failed = 0, streams = 0, looped = 0, data_bytes = 0, bytes_read = 0, reads = 0;
+    double seconds = 0;
+    uint64_t files_by_kind[static_cast<size_t>(ScanKind::Count)] = {};
+    std::map<uint32_t, uint64_t> rates;        // sample rate -> streams
+    std::map<uint16_t, uint64_t> channels;     // channel count -> streams
+};
+
+inline CorpusSummary SummarizeCorpus(const CorpusReport& report) {
+    CorpusSummary s;
+    for (const ScanFile& f : report.files) {
+        ++s.files; ++s.files_by_kind[static_cast<size_t>(f.kind)];
+        if (!f.error.empty()) ++s.failed;
+        s.bytes_read += f.bytes_read; s.reads += f.reads;
+        for (const ScanStream& st : f.streams) {
+            ++s.streams; s.looped += st.looped; s.data_bytes += st.data_bytes;
+            ++s.rates[st.sample_rate]; ++s.channels[st.channels];
+            if (st.sample_rate) s.seconds += static_cast<double>(st.samples) / st.sample_rate;
+        }
+    }
+    return s;
+}
+
+inline bool WriteCorpusJson(const CorpusReport& report, const std::filesystem::path& path) {
+    using scan_detail::Utf8;
+    const CorpusSummary s = SummarizeCorpus(report);
+    JsonWriter j;
+    j.begin_object();
+    j.field("root", Utf8(report.root)).field("threads", report.threads);
+    j.field("walk_ms", report.walk_ms).field("scan_ms", report.scan_ms);
+    j.key("summary").begin_object();
+    j.field("files", s.files).field("failed", s.failed).field("streams", s.streams).field("looped", s.looped);
+    j.field("data_bytes", s.data_bytes).field("duration_seconds", s.seconds);
+    j.field("header_bytes_read", s.bytes_read).field("reads", s.reads);
+    j.key("files_by_kind").begin_object();
+    for (size_t k = 0; k < static_cast<size_t>(ScanKind::Count); ++k) j.field(ScanKindName(static_cast<ScanKind>(k)), s.files_by_kind[k]);
+    j.end_object();
+    j.key("sample_rates").begin_object();
+    for (const auto& r : s.rates) j.field(std::to_string(r.first), r.second);
+    j.end_object();
+    j.key("channels").begin_object();
+    for (const auto& c : s.channels) j.field(std::to_string(c.first), c.second);
+    j.end_object();
+    j.end_object();
+    j.key("files").begin_array();
+    for (const ScanFile& f : report.files) {
+        uint64_t looped = 0, bytes = 0;
+        std::map<uint32_t, uint64_t> rates;
+        for (const ScanStream& st : f.streams) { looped += st.looped; bytes += st.data_bytes; ++rates[st.sample_rate]; }
+        j.begin_object();
+        j.field("path", Utf8(f.path.lexically_relative(report.root))).field("kind", ScanKindName(f.kind)).field("size", f.size);
+        j.field("streams", static_cast<uint64_t>(f.streams.size())).field("looped", looped).field("data_bytes", bytes);
+        j.key("sample_rates").begin_object();
+        for (const auto& r : rates) j.field(std::to_string(r.first), r.second);
+        j.end_object();
+        if (!f.error.empty()) j.field("error", f.error);
+        j.end_object();
+    }
+    j.end_array();
+    j.end_object();
+    return j.save(path);
+}
+
+// One row per stream; fields holding commas or quotes are quoted.
+inline bool WriteCorpusCsv(const CorpusReport& report, const std::filesystem::path& path) {
+    auto quote = [](const std::string& v) {
+        if (v.find_first_of(",\"\r\n") == std::string::npos) return v;
+        std::string q = "\"";
+        for (char c : v) { if (c == '"') q += '"'; q += c; }
+        return q + "\"";
+    };
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    f << "path,kind,index,name,format,channels,sample_rate,samples,seconds,looped,loop_start,loop_end,data_bytes\n";
+    for (const ScanFile& file : report.files) {
+        const std::string rel = quote(scan_detail::Utf8(file.path.lexically_relative(report.root)));
+        for (const ScanStream& s : file.streams) {
+            char secs[32];
+            snprintf(secs, sizeof(secs), "%.3f", s.sample_rate ? static_cast<double>(s.samples) / s.sample_rate : 0.0);
+            f << rel << ',' << ScanKindName(file.kind) << ',' << s.index << ',' << quote(s.name) << ',' << s.format << ','
+              << s.channels << ',' << s.sample_rate << ',' << s.samples << ',' << secs << ',' << (s.looped ? 1 : 0) << ','
+              << s.loop_start << ',' << s.loop_end << ',' << s.data_bytes << '\n';
+        }
+    }
+    return static_cast<bool>(f);
+}
@@ -0,0 +1,71 @@
+#pragma once
+// DspAdpcm.h
+// One-frame GameCube DSP ADPCM codec. A frame is 8 bytes: a header byte
+// (predictor index << 4 | shift) and 14 signed nibbles, one per sample. Decoding a
+// frame needs the two previous output samples (the history) and the stream's table of
+// eight coefficient pairs; the encoder tries every predictor/shift pair and keeps the one
+// with the smallest squared error, exactly as DS2Tool's EncodeChannelADPCM always has.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+constexpr int DSP_FRAME_BYTES = 8;
+constexpr int DSP_FRAME_SAMPLES = 14;
+
+inline int16_t DspClamp16(int32_t v) { return static_cast<int16_t>(v < -32768 ? -32768 : v > 32767 ? 32767 : v); }
+
+// Decodes the first 'count' samples of a frame into 'out' (may be null) and advances the history.
+inline void DecodeDspFrame(const uint8_t* frame, const int16_t coefs[16], int16_t& hist1, int16_t& hist2, int16_t* out, int count = DSP_FRAME_SAMPLES) {
+    const int pred = (std::min)((frame[0] >> 4) & 0x0F, 7);
+    const int32_t scale = 1 << (frame[0] & 0x0F);
+    const int32_t c1 = coefs[pred * 2], c2 = coefs[pred * 2 + 1];
+    for (int n = 0; n < count; ++n) {
+        int32_t nib = (n & 1) ? (frame[1 + (n >> 1)] & 0x0F) : (frame[1 + (n >> 1)] >> 4);
+        if (nib & 8) nib -= 16;
+        const int16_t s = DspClamp16((((nib * scale) << 11) + c1 * hist1 + c2 * hist2 + 1024) >> 11);
+        hist2 = hist1; hist1 = s;
+        if (out) out[n] = s;
+    }
+}
+
+// Encodes 'count' (1..14) samples into one frame; unused nibbles are zero. Advances the
+// history to the decoder's output and returns the frame's squared error.
+inline double EncodeDspFrame(const int16_t* pcm, int count, const int16_t coefs[16], int16_t& hist1, int16_t& hist2, uint8_t out[DSP_FRAME_BYTES]) {
+    int8_t best[DSP_FRAME_SAMPLES] = {}, trial[DSP_FRAME_SAMPLES];
+    int best_pred = 0, best_shift = 0;
+    int64_t best_err = -1;
+    for (int pred = 0; pred < 8; ++pred) {
+        const int32_t c1 = coefs[pred * 2], c2 = coefs[pred * 2 + 1];
+        for (int shift = 0; shift < 12; ++shift) {
+            int16_t h1 = hist1, h2 = hist2;
+            const int32_t scale = 1 << shift;
+            const int32_t half = scale << 10;
+            int64_t err = 0;
+            int n = 0;
+            for (; n < count; ++n) {
+                const int32_t predic = c1 * h1 + c2 * h2;
+                const int32_t diff = (static_cast<int32_t>(pcm[n]) << 11) - predic;
+                // diff / (scale << 11) rounded half away from zero; the int8 narrowing wraps
+                // like the double -> int8 cast the encoder has always used.
+                const int32_t q = diff >= 0 ? (diff + half) >> (shift + 11) : -((half - diff) >> (shift + 11));
+                int8_t nib = static_cast<int8_t>(q);
+                nib = (std::max)(static_cast<int8_t>(-8), (std::min)(static_cast<int8_t>(7), nib));
+                trial[n] = nib;
+                const int16_t s = DspClamp16(((static_cast<int32_t>(nib) * scale << 11) + predic + 1024) >> 11);
+                const int64_t e = static_cast<int32_t>(pcm[n]) - s;
+                err += e * e;
+                h2 = h1; h1 = s;
+                if (best_err >= 0 && err >= best_err) break;   // can no longer win
+            }
+            if (n == count && (best_err < 0 || err < best_err)) {
+                best_err = err; best_pred = pred; best_shift = shift;
+                memcpy(best, trial, count);
+            }
+        }
+    }
+    out[0] = static_cast<uint8_t>((best_pred << 4) | (best_shift & 0x0F));
+    for (int n = 0; n < DSP_FRAME_SAMPLES; n += 2) out[1 + n / 2] = static_cast<uint8_t>(((best[n] & 0x0F) << 4) | (best[n + 1] & 0x0F));
+    DecodeDspFrame(out, coefs, hist1, hist2, nullptr, count);
+    return static_cast<double>(best_err);
+}
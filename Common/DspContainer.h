@@ -0,0 +1,202 @@
+#pragma once
+// DspContainer.h
+// Lossless remuxing between the GameCube ADPCM containers used by the tools:
+//   DSP      - one 0x60-byte channel header + ADPCM payload (mono)
+//   DS2      - two channel headers (0xC0) + left payload + right payload (stereo)
+//   SPT/SPD  - SPT: count, count x 0x1C "part1" records, count x 0x2E "part2" records
+//              (DSP header bytes 0x1C..0x4A); SPD: the payloads, each 8-byte aligned
+// The ADPCM frames are copied untouched - only headers, offsets and addresses are
+// rewritten - so a conversion costs one read and one write of the payload bytes.
+//
+// Addresses follow ExtractSptSpd: SPT addresses are absolute nibble addresses into the
+// SPD and the end address is the last nibble (inclusive); DSP loop addresses are the same
+// nibble addresses relative to the start of the stream.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "BeLayout.h"
+#include "Trace.h"
+
+constexpr uint32_t DSP_HEADER_BYTES = sizeof(DspHeader);
+constexpr uint32_t DS2_HEADER_BYTES = 2 * sizeof(DspHeader);
+constexpr uint32_t SPT_PART1_BYTES = sizeof(SptPart1);
+constexpr uint32_t SPT_PART2_BYTES = sizeof(SptPart2);
+constexpr uint32_t SPT_HEADER_BYTES = sizeof(SptFileHeader);
+constexpr uint32_t SPT_PART2_AT = offsetof(DspHeader, coefs);   // where part2 sits inside a DSP header
+
+namespace dsp_detail {
+inline uint32_t align8(uint32_t v) { return (v + 7) & ~7u; }
+} // namespace dsp_detail
+
+// One channel: its header (normalised to the standalone-DSP layout) and a view of its
+// ADPCM bytes. 'data' points into the caller's buffer or mapping.
+struct DspStream {
+    uint8_t header[DSP_HEADER_BYTES] = {};
+    const uint8_t* data = nullptr;
+    uint32_t size = 0;
+
+    // The header in host order; callers reading several fields load it once.
+    DspHeader fields() const { DspHeader h; BeLoad(header, h); return h; }
+    void set_fields(const DspHeader& h) { BeStore(h, header); }
+
+    uint32_t samples() const { return fields().num_samples; }
+    uint32_t nibbles() const { return fields().num_nibbles; }
+    uint32_t sample_rate() const { return fields().sample_rate; }
+    uint16_t loop_flag() const { return fields().loop_flag; }
+    uint32_t loop_start() const { return fields().loop_start; }
+    uint32_t loop_end() const { return fields().loop_end; }
+};
+
+// Payload bytes a channel header asks for.
+inline uint32_t DspPayloadBytes(const DspHeader& h) {
+    const uint32_t from_samples = (h.num_samples + 13) / 14 * 8;
+    return h.num_nibbles ? (std::max)((h.num_nibbles + 1) / 2, from_samples) : from_samples;
+}
+
+// A standalone DSP. The payload starts at the header's data-offset field when it is
+// set (DS2Tool files) and right after the header otherwise (SPT extracts, other tools);
+// a payload cut short by the file is kept as far as it goes.
+inline bool ParseDsp(const uint8_t* file, size_t len, DspStream& out) {
+    if (!file || len < DSP_HEADER_BYTES) return false;
+    DspHeader h;
+    BeLoad(file, h);
+    uint32_t offset = h.data_offset;
+    if (offset < DSP_HEADER_BYTES || offset >= len) offset = DSP_HEADER_BYTES;
+    out.data = file + offset;
+    out.size = static_cast<uint32_t>((std::min)(static_cast<size_t>(DspPayloadBytes(h)), len - offset));
+    h.data_size = out.size;
+    h.data_offset = DSP_HEADER_BYTES;
+    out.set_fields(h);
+    return out.size > 0;
+}
+
+inline bool ParseDs2(const uint8_t* file, size_t len, DspStream& left, DspStream& right) {
+    if (!file || len < DS2_HEADER_BYTES) return false;
+    DspStream* ch[2] = { &left, &right };
+    for (int c = 0; c < 2; ++c) {
+        DspHeader h;
+        BeLoad(file + c * DSP_HEADER_BYTES, h);
+        const uint32_t offset = h.data_offset;
+        if (offset < DS2_HEADER_BYTES || offset >= len) return false;
+        uint32_t size = h.data_size;
+        if (size == 0) size = DspPayloadBytes(h);
+        size = static_cast<uint32_t>((std::min)(static_cast<size_t>(size), len - offset));
+        ch[c]->data = file + offset; ch[c]->size = size;
+        h.data_size = size;
+        h.data_offset = DSP_HEADER_BYTES;
+        ch[c]->set_fields(h);
+    }
+    return left.size > 0 && right.size > 0;
+}
+
+// Rebuilds one DSP stream per SPT entry, with payloads viewed inside 'spd'.
+inline bool ParseSptSpd(const uint8_t* spt, size_t spt_len, const uint8_t* spd, size_t spd_len, std::vector<DspStream>& out) {
+    TRACE_SCOPE_CAT("ParseSptSpd", "container");
+    using namespace dsp_detail;
+    out.clear();
+    if (!spt || spt_len < SPT_HEADER_BYTES) return false;
+    SptFileHeader fh;
+    BeLoad(spt, fh);
+    const uint32_t count = fh.count;
+    if (count > (spt_len - SPT_HEADER_BYTES) / (SPT_PART1_BYTES + SPT_PART2_BYTES)) return false;
+    out.resize(count);
+    uint32_t start = 0;   // byte offset of the stream in the SPD
+    for (uint32_t i = 0; i < count; ++i) {
+        SptPart1 p1;
+        BeLoad(spt + SPT_HEADER_BYTES + i * SPT_PART1_BYTES, p1);
+        const uint8_t* p2 = spt + SPT_HEADER_BYTES + count * SPT_PART1_BYTES + i * SPT_PART2_BYTES;
+        const uint32_t end = p1.end_address;                       // last nibble, absolute
+        const uint32_t stop = end / 2 + 1;                         // one past the last byte
+        if (stop <= start || stop > spd_len) { out.clear(); return false; }
+        const uint32_t nibbles = end + 1 - start * 2;
+        const uint32_t frames = (nibbles + 15) / 16;
+        DspStream& s = out[i];
+        s.data = spd + start;
+        s.size = static_cast<uint32_t>((std::min)(static_cast<size_t>(align8(stop)), spd_len)) - start;   // whole 8-byte frames
+        DspHeader h{};
+        h.num_samples = nibbles - 2 * frames;
+        h.num_nibbles = nibbles;
+        h.sample_rate = p1.sample_rate;
+        h.loop_flag = static_cast<uint16_t>(p1.loop_flag & 1);
+        h.loop_start = p1.loop_start - start * 2;
+        h.loop_end = p1.loop_end - start * 2;
+        h.current_address = 2;
+        h.data_size = s.size;
+        h.data_offset = DSP_HEADER_BYTES;
+        s.set_fields(h);
+        memcpy(s.header + SPT_PART2_AT, p2, SPT_PART2_BYTES);     // big-endian on both sides
+        start = align8(stop);
+    }
+    return true;
+}
+
+inline bool WriteDspFile(const std::filesystem::path& path, const DspStream& s) {
+    TRACE_SCOPE_CAT("WriteDspFile", "container");
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    f.write(reinterpret_cast<const char*>(s.header), DSP_HEADER_BYTES);
+    f.write(reinterpret_cast<const char*>(s.data), s.size);
+    return static_cast<bool>(f);
+}
+
+// Both channels must agree on length and rate (the DS2 decoder requires it).
+inline bool WriteDs2File(const std::filesystem::path& path, const DspStream& left, const DspStream& right) {
+    TRACE_SCOPE_CAT("WriteDs2File", "container");
+    DspHeader l = left.fields(), r = right.fields();
+    if (l.num_samples != r.num_samples || l.sample_rate != r.sample_rate) return false;
+    l.data_size = left.size;
+    l.data_offset = DS2_HEADER_BYTES;
+    r.data_size = right.size;
+    r.data_offset = DS2_HEADER_BYTES + left.size;
+    uint8_t h[DS2_HEADER_BYTES];
+    BeStore(l, h);
+    BeStore(r, h + DSP_HEADER_BYTES);
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    f.write(reinterpret_cast<const char*>(h), sizeof(h));
+    f.write(reinterpret_cast<const char*>(left.data), left.size);
+    f.write(reinterpret_cast<const char*>(right.data), right.size);
+    return static_cast<bool>(f);
+}
+
+inline bool WriteSptSpd(const std::filesystem::path& spt_path, const std::filesystem::path& spd_path, const std::vector<DspStream>& streams) {
+    TRACE_SCOPE_CAT("WriteSptSpd", "container");
+    using namespace dsp_detail;
+    std::vector<uint8_t> spt(SPT_HEADER_BYTES + streams.size() * (SPT_PART1_BYTES + SPT_PART2_BYTES), 0);
+    BeStore(SptFileHeader{ static_cast<uint32_t>(streams.size()) }, spt.data());
+    std::ofstream spd(spd_path, std::ios::binary | std::ios::trunc);
+    if (!spd) return false;
+    static const char pad[8] = {};
+    uint32_t start = 0;
+    for (size_t i = 0; i < streams.size(); ++i) {
+        const DspStream& s = streams[i];
+        const DspHeader h = s.fields();
+        uint8_t* p2 = spt.data() + SPT_HEADER_BYTES + streams.size() * SPT_PART1_BYTES + i * SPT_PART2_BYTES;
+        // SPT keeps no sample count, so the end address has to carry it: 2 header nibbles per
+        // 14-sample frame plus one nibble per sample, as in a standard DSP header.
+        const uint32_t exact = h.num_samples + 2 * ((h.num_samples + 13) / 14);
+        const uint32_t nibbles = (h.num_samples && exact <= s.size * 2) ? exact : s.size * 2;
+        SptPart1 p1{};
+        p1.loop_flag = h.loop_flag ? 1 : 0;
+        p1.sample_rate = h.sample_rate;
+        p1.loop_start = h.loop_start + start * 2;
+        p1.loop_end = h.loop_end + start * 2;
+        p1.end_address = start * 2 + nibbles - 1;
+        BeStore(p1, spt.data() + SPT_HEADER_BYTES + i * SPT_PART1_BYTES);
+        memcpy(p2, s.header + SPT_PART2_AT, SPT_PART2_BYTES);
+        spd.write(reinterpret_cast<const char*>(s.data), s.size);
+        spd.write(pad, align8(s.size) - s.size);
+        start += align8(s.size);
+    }
+    if (!spd) return false;
+    std::ofstream f(spt_path, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    f.write(reinterpret_cast<const char*>(spt.data()), static_cast<std::streamsize>(spt.size()));
+    return static_cast<bool>(f);
+}
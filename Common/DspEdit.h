@@ -0,0 +1,315 @@
+#pragma once
+// DspEdit.h
+// Trim, cut and join DSP ADPCM streams without a decode/re-encode round trip.
+//
+// A DspClip is a channel header plus a list of runs of 8-byte frames. Runs point either
+// into the source streams (written out verbatim) or into the few frames an edit had to
+// re-encode, which the clip owns. Edits land on 14-sample frame boundaries:
+//   - Trim keeps frames [first / 14, ...) and stores the decoder history at the new first
+//     frame in the header (0x3E..0x42), so nothing is re-encoded at all.
+//   - Append re-encodes the frames of the second clip only while the decoder history
+//     coming out of the first clip differs from the history the second clip was encoded
+//     with; once the two agree every later frame decodes identically and is copied as-is.
+//     A partial last frame of the first clip keeps its samples and fills its unused
+//     nibbles with a ramp into the second clip. Clips with different coefficient tables
+//     cannot share frames, so the second one is then re-encoded in full with the first
+//     one's table.
+//     Histories usually meet within a few frames, but nothing guarantees it. After
+//     MAX_CONVERGE_FRAMES without a match Append stops comparing and re-encodes the rest
+//     of the second clip with the full search, and counts the edit in fallback_edits so
+//     the caller can report it.
+//   - Cut is a Trim of each side followed by an Append.
+// The history at an arbitrary frame needs every earlier frame decoded. So the first edit
+// that looks past frame 64 of a stream indexes it once: a decode-only pass over the whole
+// stream (about the cost of decoding it, without writing PCM), keeping 4 bytes per 64
+// frames. Later edits decode at most 63 frames per lookup.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "DspAdpcm.h"
+#include "DspContainer.h"
+#include "Trace.h"
+
+class DspClip {
+public:
+    struct Run {
+        const uint8_t* data;
+        uint32_t frames;
+    };
+
+    static constexpr uint32_t INDEX_FRAMES = 64;
+    static constexpr uint32_t MAX_CONVERGE_FRAMES = 1024;  // 14336 samples; joins usually meet within a few hundred frames
+
+    uint8_t header[DSP_HEADER_BYTES] = {};
+    std::vector<Run> runs;
+    std::vector<std::shared_ptr<const std::vector<uint8_t>>> owned;   // re-encoded frames the runs may point into
+    uint32_t reencoded_frames = 0;
+    uint32_t fallback_edits = 0;   // appends that hit MAX_CONVERGE_FRAMES
+
+    // History going into the last frame, when the edit that made the clip already knew it.
+    bool last_hist_known = false;
+    int16_t last_hist1 = 0, last_hist2 = 0;
+
+    // History before every INDEX_FRAMES-th frame (pairs), built on first use.
+    mutable std::shared_ptr<const std::vector<int16_t>> history_index;
+
+    DspClip() = default;
+
+    // The whole payload of a parsed stream; 'stream' must outlive the clip.
+    explicit DspClip(const DspStream& stream) {
+        memcpy(header, stream.header, DSP_HEADER_BYTES);
+        const uint32_t frames = (std::min)(frames_for(samples()), stream.size / DSP_FRAME_BYTES);
+        if (frames < frames_for(samples())) set_samples(frames * DSP_FRAME_SAMPLES);
+        if (frames) runs.push_back({ stream.data, frames });
+    }
+
+    // The header in host order, as on DspStream.
+    DspHeader fields() const { DspHeader h; BeLoad(header, h); return h; }
+    void set_fields(const DspHeader& h) { BeStore(h, header); }
+
+    uint32_t samples() const { return fields().num_samples; }
+    uint32_t sample_rate() const { return fields().sample_rate; }
+    uint32_t frame_count() const { uint32_t n = 0; for (const Run& r : runs) n += r.frames; return n; }
+    uint32_t payload_bytes() const { return frame_count() * DSP_FRAME_BYTES; }
+    int16_t initial_hist1() const { return fields().initial_hist1; }
+    int16_t initial_hist2() const { return fields().initial_hist2; }
+
+    void coefs(int16_t out[16]) const { const DspHeader h = fields(); memcpy(out, h.coefs, sizeof(h.coefs)); }
+    bool same_coefs(const DspClip& o) const {
+        return memcmp(header + offsetof(DspHeader, coefs), o.header + offsetof(DspHeader, coefs), sizeof(DspHeader::coefs)) == 0;
+    }
+
+    // Frame i, walking the runs (clips hold a handful of runs).
+    const uint8_t* frame(uint32_t i) const {
+        for (const Run& r : runs) {
+            if (i < r.frames) return r.data + static_cast<size_t>(i) * DSP_FRAME_BYTES;
+            i -= r.frames;
+        }
+        return nullptr;
+    }
+
+    // Sample count plus the matching nibble count (2 header nibbles per frame) and data size.
+    void set_samples(uint32_t n) {
+        DspHeader h = fields();
+        h.num_samples = n;
+        h.num_nibbles = n ? n + 2 * frames_for(n) : 0;
+        h.data_size = frames_for(n) * DSP_FRAME_BYTES;
+        h.data_offset = DSP_HEADER_BYTES;
+        set_fields(h);
+    }
+
+    static uint32_t frames_for(uint32_t samples) { return (samples + DSP_FRAME_SAMPLES - 1) / DSP_FRAME_SAMPLES; }
+
+    // Appends frames, merging with the previous run when they are contiguous.
+    void add_run(const uint8_t* data, uint32_t frames) {
+        if (!frames) return;
+        if (!runs.empty() && runs.back().data + static_cast<size_t>(runs.back().frames) * DSP_FRAME_BYTES == data) runs.back().frames += frames;
+        else runs.push_back({ data, frames });
+    }
+
+    // Frames [first, end) of 'src', which must stay alive (its owned frames are shared).
+    void add_frames(const DspClip& src, uint32_t first, uint32_t end) {
+        uint32_t i = 0;
+        for (const Run& r : src.runs) {
+            const uint32_t lo = (std::max)(i, first), hi = (std::min)(i + r.frames, end);
+            if (lo < hi) add_run(r.data + static_cast<size_t>(lo - i) * DSP_FRAME_BYTES, hi - lo);
+            i += r.frames;
+        }
+    }
+};
+
+// Decoder history (last two samples) going into frame 'index' (0..frame_count()).
+inline void DspHistoryAt(const DspClip& c, uint32_t index, int16_t& h1, int16_t& h2) {
+    int16_t coefs[16]; c.coefs(coefs);
+    const uint32_t frames = c.frame_count();
+    uint32_t at = 0;
+    h1 = c.initial_hist1(); h2 = c.initial_hist2();
+    if (c.last_hist_known && frames && index + 1 >= frames) {
+        at = frames - 1; h1 = c.last_hist1; h2 = c.last_hist2;
+    } else if (index >= DspClip::INDEX_FRAMES) {
+        if (!c.history_index) {
+            auto idx = std::make_shared<std::vector<int16_t>>();
+            idx->reserve(2 * (frames / DspClip::INDEX_FRAMES + 1));
+            int16_t a = h1, b = h2;
+            uint32_t i = 0;
+            for (const DspClip::Run& r : c.runs) {
+                for (uint32_t f = 0; f < r.frames; ++f, ++i) {
+                    if (i % DspClip::INDEX_FRAMES == 0) { idx->push_back(a); idx->push_back(b); }
+                    DecodeDspFrame(r.data + static_cast<size_t>(f) * DSP_FRAME_BYTES, coefs, a, b, nullptr);
+                }
+            }
+            c.history_index = std::move(idx);
+        }
+        const uint32_t slot = (std::min)(index, frames - 1) / DspClip::INDEX_FRAMES;
+        at = slot * DspClip::INDEX_FRAMES;
+        h1 = (*c.history_index)[slot * 2]; h2 = (*c.history_index)[slot * 2 + 1];
+    }
+    for (; at < index && at < frames; ++at) DecodeDspFrame(c.frame(at), coefs, h1, h2, nullptr);
+}
+
+// Keeps samples [first, end) with 'first' rounded down to a frame boundary. The loop is kept
+// when it lies inside the result, dropped otherwise.
+inline bool DspTrim(const DspClip& in, uint32_t first, uint32_t end, DspClip& out) {
+    TRACE_SCOPE_CAT("DspTrim", "codec");
+    end = (std::min)(end, in.samples());
+    const uint32_t start_frame = first / DSP_FRAME_SAMPLES, skipped = start_frame * DSP_FRAME_SAMPLES;
+    if (end <= skipped) return false;
+    const uint32_t end_frame = DspClip::frames_for(end);
+
+    DspClip r;
+    memcpy(r.header, in.header, DSP_HEADER_BYTES);
+    r.owned = in.owned;
+    r.add_frames(in, start_frame, end_frame);
+    r.set_samples(end - skipped);
+
+    DspHeader h = r.fields();
+    h.initial_ps = r.frame(0)[0];
+    DspHistoryAt(in, start_frame, h.initial_hist1, h.initial_hist2);
+    DspHistoryAt(in, end_frame - 1, r.last_hist1, r.last_hist2);
+    r.last_hist_known = true;
+
+    const DspHeader src = in.fields();
+    const uint32_t shift = start_frame * 16, last_nibble = shift + h.num_nibbles - 1;
+    if (src.loop_flag && src.loop_start >= shift && src.loop_end <= last_nibble && src.loop_start < src.loop_end) {
+        h.loop_start = src.loop_start - shift;
+        h.loop_end = src.loop_end - shift;
+    } else {
+        h.loop_flag = 0;
+    }
+    r.set_fields(h);
+    out = std::move(r);
+    return true;
+}
+
+// Appends 'b' to 'a' (see the top of the file). Both must have the same sample rate.
+inline bool DspAppend(DspClip& a, const DspClip& b) {
+    TRACE_SCOPE_CAT("DspAppend", "codec");
+    if (b.samples() == 0) return true;
+    if (a.samples() == 0) { a = b; return true; }
+    if (a.sample_rate() != b.sample_rate()) return false;
+    int16_t coefs_a[16], coefs_b[16];
+    a.coefs(coefs_a); b.coefs(coefs_b);
+
+    uint32_t a_samples = a.samples();
+    const uint32_t a_frames = DspClip::frames_for(a_samples), tail = a_samples % DSP_FRAME_SAMPLES;
+    std::vector<uint8_t> patch;
+    int16_t h1, h2;
+    if (tail) {
+        // Keep the frame's header and its first 'tail' nibbles; pick the unused ones to ramp
+        // from a's last sample to b's first.
+        int16_t bh1 = b.initial_hist1(), bh2 = b.initial_hist2(), first_b[DSP_FRAME_SAMPLES];
+        DecodeDspFrame(b.frame(0), coefs_b, bh1, bh2, first_b);
+        patch.assign(a.frame(a_frames - 1), a.frame(a_frames - 1) + DSP_FRAME_BYTES);
+        DspHistoryAt(a, a_frames - 1, h1, h2);
+        DecodeDspFrame(patch.data(), coefs_a, h1, h2, nullptr, tail);
+        const int32_t last = h1;
+        const int pred = (std::min)(patch[0] >> 4, 7);
+        const int32_t scale = 1 << (patch[0] & 0x0F), c1 = coefs_a[pred * 2], c2 = coefs_a[pred * 2 + 1];
+        const int32_t steps = DSP_FRAME_SAMPLES - tail + 1;
+        for (uint32_t n = tail; n < DSP_FRAME_SAMPLES; ++n) {
+            const int32_t target = last + (first_b[0] - last) * static_cast<int32_t>(n - tail + 1) / steps;
+            const int32_t predic = c1 * h1 + c2 * h2;
+            const int32_t nib = (std::max)(-8, (std::min)(7, static_cast<int32_t>(std::lround(static_cast<double>((target << 11) - predic) / (scale << 11)))));
+            uint8_t& byte = patch[1 + n / 2];
+            byte = (n & 1) ? static_cast<uint8_t>((byte & 0xF0) | (nib & 0x0F)) : static_cast<uint8_t>((byte & 0x0F) | ((nib & 0x0F) << 4));
+            const int16_t s = DspClamp16((((nib * scale) << 11) + predic + 1024) >> 11);
+            h2 = h1; h1 = s;
+        }
+        ++a.reencoded_frames;
+        a_samples += DSP_FRAME_SAMPLES - tail;
+    } else {
+        DspHistoryAt(a, a_frames, h1, h2);
+    }
+
+    // Re-encode b's frames until the histories meet, or all of them past the cap.
+    const uint32_t b_samples = b.samples(), b_frames = DspClip::frames_for(b_samples);
+    const bool shared = a.same_coefs(b);
+    int16_t bh1 = b.initial_hist1(), bh2 = b.initial_hist2(), last1 = h1, last2 = h2;
+    uint32_t j = 0;
+    bool fell_back = false;
+    for (; j < b_frames; ++j) {
+        const bool converging = shared && j < DspClip::MAX_CONVERGE_FRAMES;
+        if (converging && h1 == bh1 && h2 == bh2) break;
+        if (shared && !converging) fell_back = true;
+        last1 = h1; last2 = h2;
+        const uint8_t* orig = b.frame(j);
+        const int count = static_cast<int>((std::min)(b_samples - j * DSP_FRAME_SAMPLES, static_cast<uint32_t>(DSP_FRAME_SAMPLES)));
+        int16_t target[DSP_FRAME_SAMPLES];
+        DecodeDspFrame(orig, coefs_b, bh1, bh2, target);
+        // From a drifted history the original frame is often as close (or exact), so the full
+        // predictor/shift search only runs when it is not.
+        uint8_t enc[DSP_FRAME_BYTES] = {};
+        int16_t e1 = h1, e2 = h2;
+        double orig_err = -1;
+        if (converging) {
+            int16_t got[DSP_FRAME_SAMPLES];
+            DecodeDspFrame(orig, coefs_a, e1, e2, got, count);
+            orig_err = 0;
+            for (int n = 0; n < count; ++n) orig_err += static_cast<double>(got[n] - target[n]) * (got[n] - target[n]);
+            memcpy(enc, orig, DSP_FRAME_BYTES);
+        }
+        if (orig_err != 0) {
+            uint8_t search[DSP_FRAME_BYTES];
+            int16_t s1 = h1, s2 = h2;
+            const double search_err = EncodeDspFrame(target, count, coefs_a, s1, s2, search);
+            if (orig_err < 0 || search_err < orig_err) { memcpy(enc, search, DSP_FRAME_BYTES); e1 = s1; e2 = s2; }
+        }
+        patch.insert(patch.end(), enc, enc + DSP_FRAME_BYTES);
+        h1 = e1; h2 = e2;
+    }
+
+    DspClip r;
+    memcpy(r.header, a.header, DSP_HEADER_BYTES);
+    r.owned = a.owned;
+    r.owned.insert(r.owned.end(), b.owned.begin(), b.owned.end());
+    r.reencoded_frames = a.reencoded_frames + b.reencoded_frames + j;
+    r.fallback_edits = a.fallback_edits + b.fallback_edits + (fell_back ? 1 : 0);
+    r.add_frames(a, 0, tail ? a_frames - 1 : a_frames);
+    if (!patch.empty()) {
+        auto store = std::make_shared<const std::vector<uint8_t>>(std::move(patch));
+        r.owned.push_back(store);
+        r.add_run(store->data(), static_cast<uint32_t>(store->size() / DSP_FRAME_BYTES));
+    }
+    r.add_frames(b, j, b_frames);
+    r.set_samples(a_samples + b_samples);
+    DspHeader h = r.fields();
+    h.initial_ps = r.frame(0)[0];
+    r.set_fields(h);
+    r.last_hist_known = true;
+    if (j == b_frames) { r.last_hist1 = last1; r.last_hist2 = last2; }
+    else DspHistoryAt(b, b_frames - 1, r.last_hist1, r.last_hist2);   // b's own frames decode unchanged from here
+    a = std::move(r);
+    return true;
+}
+
+// Removes samples [first, end), both rounded down to frame boundaries.
+inline bool DspCut(const DspClip& in, uint32_t first, uint32_t end, DspClip& out) {
+    first -= first % DSP_FRAME_SAMPLES;
+    end -= end % DSP_FRAME_SAMPLES;
+    if (end <= first || first >= in.samples()) return false;
+    DspClip head, rest;
+    if (first > 0 && !DspTrim(in, 0, first, head)) return false;
+    if (end < in.samples() && !DspTrim(in, end, in.samples(), rest)) return false;
+    DspHeader h = head.fields();
+    h.loop_flag = 0;
+    head.set_fields(h);
+    if (!DspAppend(head, rest)) return false;
+    out = std::move(head);
+    return true;
+}
+
+inline bool WriteDspClip(const std::filesystem::path& path, const DspClip& c) {
+    TRACE_SCOPE_CAT("WriteDspClip", "container");
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    f.write(reinterpret_cast<const char*>(c.header), DSP_HEADER_BYTES);
+    for (const DspClip::Run& r : c.runs) f.write(reinterpret_cast<const char*>(r.data), static_cast<std::streamsize>(r.frames) * DSP_FRAME_BYTES);
+    return static_cast<bool>(f);
+}
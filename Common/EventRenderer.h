@@ -0,0 +1,136 @@
+#pragma once
+// EventRenderer.h
+// Renders EventMaps rows of a parsed .flo to audio. A row is first planned into one or
+// more variants - a Simple or Compound event is one variant holding every component at
+// its link delay (seconds); a Random event gives one variant per choice, its SimpleEvent
+// links when it has any and else its SoundDataFile links - and each variant is then
+// mixed from decoded sources handed out by the caller (normally through a shared
+// PcmCache). The bus takes the highest sample rate and channel count among its sources;
+// mismatching sources are converted before mixing.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "FloParser.h"
+#include "FloResolve.h"
+#include "Mixer.h"
+#include "PcmCache.h"
+#include "Trace.h"
+#include "WavWriter.h"
+
+namespace flo {
+
+struct RenderPart {
+    int sdf_id = 0;
+    float delay = 0.0f;     // seconds from the start of the event
+};
+
+struct RenderVariant {
+    std::vector<RenderPart> parts;
+};
+
+// Plans maps row 'row'. Random/Compound rows whose typed target is missing try the
+// other kind, matching how WavRename expands mislabelled rows. Links to undeclared
+// SimpleEvents are dropped. Returns false when nothing playable remains.
+inline bool PlanEventMap(const Model& m, const IdTables& ids, size_t row, std::vector<RenderVariant>& out) {
+    TRACE_SCOPE_CAT("PlanEventMap", "flo");
+    out.clear();
+    auto part_for = [&](const LinkedEvents& ev, uint32_t k, RenderPart& p) {
+        if (ev.link_arity[k] == 0) return false;
+        if (ev.link_arity[k] == 1) { p.sdf_id = ev.link_a[k]; p.delay = 0.0f; return true; }
+        int r = IdTables::find(ids.simple, ev.link_b[k]);
+        if (r < 0) return false;
+        p.sdf_id = m.simple.sdf_id[r]; p.delay = (std::max)(0.0f, ev.link_delay[k]);
+        return true;
+    };
+    auto plan_random = [&](int ref) {
+        int r = IdTables::find(ids.random, ref);
+        if (r < 0) return;
+        const uint32_t end = m.random.first[r] + m.random.count[r];
+        bool any_simple = false;   // then only the SimpleEvent choices are played, as in ResolveEventMaps
+        for (uint32_t k = m.random.first[r]; !any_simple && k < end; ++k) any_simple = m.random.link_arity[k] >= 2;
+        for (uint32_t k = m.random.first[r]; k < end; ++k) {
+            RenderPart p;
+            if (any_simple && m.random.link_arity[k] == 1) continue;
+            if (part_for(m.random, k, p)) { p.delay = 0.0f; out.push_back({ { p } }); }
+        }
+    };
+    auto plan_compound = [&](int ref) {
+        int r = IdTables::find(ids.compound, ref);
+        if (r < 0) return;
+        RenderVariant v;
+        for (uint32_t k = m.compound.first[r]; k < m.compound.first[r] + m.compound.count[r]; ++k) {
+            RenderPart p;
+            if (part_for(m.compound, k, p)) v.parts.push_back(p);
+        }
+        if (!v.parts.empty()) out.push_back(std::move(v));
+    };
+
+    const int ref = m.maps.ref[row];
+    switch (m.maps.type[row]) {
+    case 0: {
+        int r = IdTables::find(ids.simple, ref);
+        if (r >= 0) out.push_back({ { RenderPart{ m.simple.sdf_id[r], 0.0f } } });
+    } break;
+    case 1: plan_random(ref); if (out.empty()) plan_compound(ref); break;
+    case 2: plan_compound(ref); if (out.empty()) plan_random(ref); break;
+    default: break;
+    }
+    return !out.empty();
+}
+
+// Mixes one variant. source(sdf_id) returns the decoded sound or nullptr; parts whose
+// source is missing are skipped and counted in 'missing'.
+template <class Source>
+bool MixVariant(const RenderVariant& v, Source&& source, PcmBuffer& out, size_t* missing = nullptr) {
+    TRACE_SCOPE_CAT("MixVariant", "flo");
+    out = PcmBuffer();
+    std::vector<PcmPtr> pcm(v.parts.size());
+    for (size_t i = 0; i < v.parts.size(); ++i) {
+        pcm[i] = source(v.parts[i].sdf_id);
+        if (!pcm[i] || pcm[i]->frames() == 0) { pcm[i] = nullptr; if (missing) ++*missing; continue; }
+        out.sample_rate = (std::max)(out.sample_rate, pcm[i]->sample_rate);
+        out.channels = (std::max)(out.channels, pcm[i]->channels);
+    }
+    if (out.channels == 0) return false;
+
+    // Place every part first so the bus is allocated once.
+    std::vector<size_t> offset(v.parts.size(), 0);
+    size_t total = 0;
+    for (size_t i = 0; i < v.parts.size(); ++i) {
+        if (!pcm[i]) continue;
+        offset[i] = static_cast<size_t>(std::llround(static_cast<double>(v.parts[i].delay) * out.sample_rate));
+        const double ratio = static_cast<double>(out.sample_rate) / pcm[i]->sample_rate;
+        total = (std::max)(total, offset[i] + static_cast<size_t>(std::ceil(pcm[i]->frames() * ratio)));
+    }
+
+    std::vector<float> bus(total * out.channels, 0.0f);
+    std::vector<int16_t> converted;
+    for (size_t i = 0; i < v.parts.size(); ++i) {
+        if (!pcm[i]) continue;
+        const std::vector<int16_t>* src = &pcm[i]->samples;
+        if (pcm[i]->sample_rate != out.sample_rate || pcm[i]->channels != out.channels) {
+            ConvertPcm(*pcm[i], out.sample_rate, out.channels, converted);
+            src = &converted;
+        }
+        const size_t at = offset[i] * out.channels;
+        MixAdd(bus.data() + at, src->data(), (std::min)(src->size(), bus.size() - at));
+    }
+    out.samples.resize(bus.size());
+    BusToPcm16(bus.data(), out.samples.data(), bus.size());
+    return true;
+}
+
+// Writes a 16-bit PCM WAV (canonical 44-byte header below 4 GB).
+inline bool WritePcmWav(const std::filesystem::path& path, const PcmBuffer& pcm) {
+    TRACE_SCOPE_CAT("WritePcmWav", "io");
+    return WriteWavFile(path, pcm.samples.data(), pcm.samples.size(), pcm.sample_rate, pcm.channels);
+}
+
+} // namespace flo
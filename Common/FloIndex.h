@@ -0,0 +1,302 @@
+#pragma once
+// FloIndex.h
+// Binary sidecar cache ("level.flo.idx") for a parsed and resolved .flo.
+//
+// The sidecar holds every column of the flo::Model, the block spans, the EventMaps
+// expansion (FloResolve.h) and an intern table of the distinct strings. Strings are
+// stored as (offset, length) into the .flo text, so a reload maps both files, checks
+// the source size, mtime and content hash, bulk-copies the columns and points the
+// string views back into the mapped .flo - no tokenizing and no id lookups.
+//
+// The format is native little-endian and versioned; anything unexpected (wrong
+// version, stale source, truncated file, columns that do not fit together) simply
+// falls back to a full parse.
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <memory>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "FloParser.h"
+#include "FloResolve.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include "Trace.h"
+
+namespace flo {
+
+constexpr uint32_t INDEX_VERSION = 2;   // 2: Random events prefer their SimpleEvent links
+
+inline std::filesystem::path IndexPathFor(const std::filesystem::path& floPath) {
+    std::filesystem::path p = floPath;
+    p += ".idx";
+    return p;
+}
+
+namespace detail {
+
+struct IndexHeader {
+    char magic[8];              // "FLOIDX\0\0"
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t source_size;
+    int64_t source_mtime;       // filesystem clock ticks
+    uint64_t source_hash;       // Hash64 of the whole .flo, BOM included
+    uint32_t text_offset;       // 3 when the .flo starts with a UTF-8 BOM
+    uint32_t flags;             // bit 0: has_event_maps
+    uint32_t string_count;
+    uint32_t reserved;
+    uint32_t blocks[BLK_COUNT][6];
+};
+static_assert(std::is_trivially_copyable<IndexHeader>::value, "IndexHeader is written raw");
+
+constexpr char INDEX_MAGIC[8] = { 'F', 'L', 'O', 'I', 'D', 'X', 0, 0 };
+constexpr uint32_t IDX_HAS_EVENT_MAPS = 1u;
+
+// Every serialized column, in file order. Shared by the writer and the reader so the
+// two cannot drift apart.
+template <class M, class X, class F>
+void VisitColumns(M& m, X& x, F& f) {
+    f(m.bundles.id); f(m.bundles.type); f(m.bundles.path);
+    f(m.sdf.id); f(m.sdf.type); f(m.sdf.filename);
+    f(m.simple.id); f(m.simple.sdf_id); f(m.simple.param_set); f(m.simple.pan);
+    for (auto* ev : { &m.random, &m.compound }) {
+        f(ev->id); f(ev->first); f(ev->count);
+        f(ev->link_a); f(ev->link_b); f(ev->link_delay); f(ev->link_arity);
+    }
+    f(m.maps.sub); f(m.maps.id); f(m.maps.type); f(m.maps.ref); f(m.maps.name);
+    f(m.sps.sub); f(m.sps.id); f(m.sps.first); f(m.sps.count); f(m.sps.fields);
+    f(x.first); f(x.count); f(x.status); f(x.simple_id); f(x.sdf_id); f(x.sdf_row);
+}
+
+inline bool SourceStamp(const std::filesystem::path& p, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    size = static_cast<uint64_t>(std::filesystem::file_size(p, ec));
+    if (ec) return false;
+    auto t = std::filesystem::last_write_time(p, ec);
+    if (ec) return false;
+    mtime = static_cast<int64_t>(t.time_since_epoch().count());
+    return true;
+}
+
+// Collects the distinct strings of a model (first pass of the writer).
+struct StringInterner {
+    std::string_view text;
+    std::unordered_map<std::string_view, uint32_t> ids;
+    std::vector<uint32_t> table;    // offset, length pairs into text
+
+    template <class T> void operator()(const std::vector<T>&) {}
+    void operator()(const std::vector<std::string_view>& col) {
+        for (std::string_view s : col) {
+            if (ids.emplace(s, static_cast<uint32_t>(ids.size())).second) {
+                table.push_back(s.empty() ? 0u : static_cast<uint32_t>(s.data() - text.data()));
+                table.push_back(static_cast<uint32_t>(s.size()));
+            }
+        }
+    }
+};
+
+struct ColumnWriter {
+    std::ofstream& os;
+    const StringInterner& strings;
+
+    void pad() { static const char zeros[8] = {}; auto at = static_cast<uint64_t>(os.tellp()); if (at % 8) os.write(zeros, 8 - at % 8); }
+    template <class T> void operator()(const std::vector<T>& col) {
+        uint64_t n = col.size();
+        os.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        if (n) os.write(reinterpret_cast<const char*>(col.data()), static_cast<std::streamsize>(n * sizeof(T)));
+        pad();
+    }
+    void operator()(const std::vector<std::string_view>& col) {
+        std::vector<uint32_t> ids(col.size());
+        for (size_t i = 0; i < col.size(); ++i) ids[i] = strings.ids.at(col[i]);
+        (*this)(ids);
+    }
+};
+
+struct ColumnReader {
+    const uint8_t* base;
+    size_t size;
+    size_t pos;
+    std::string_view text;
+    const uint32_t* table;      // string_count offset/length pairs, validated against text
+    uint32_t string_count;
+    bool ok = true;
+
+    bool take_count(uint64_t& n, size_t elem) {
+        if (!ok || pos + 8 > size) return ok = false;
+        memcpy(&n, base + pos, 8); pos += 8;
+        if (n > (size - pos) / elem) return ok = false;
+        return true;
+    }
+    void skip_pad() { pos = (pos + 7) & ~size_t(7); if (pos > size) ok = false; }
+
+    template <class T> void operator()(std::vector<T>& col) {
+        uint64_t n = 0;
+        if (!take_count(n, sizeof(T))) return;
+        col.resize(static_cast<size_t>(n));
+        if (n) memcpy(col.data(), base + pos, static_cast<size_t>(n) * sizeof(T));
+        pos += static_cast<size_t>(n) * sizeof(T);
+        skip_pad();
+    }
+    void operator()(std::vector<std::string_view>& col) {
+        uint64_t n = 0;
+        if (!take_count(n, sizeof(uint32_t))) return;
+        col.resize(static_cast<size_t>(n));
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t id; memcpy(&id, base + pos + i * 4, 4);
+            if (id >= string_count) { ok = false; return; }
+            col[i] = text.substr(table[id * 2], table[id * 2 + 1]);
+        }
+        pos += static_cast<size_t>(n) * 4;
+        skip_pad();
+    }
+};
+
+// Checks what the tools index with, so a damaged or foreign sidecar cannot send them out
+// of bounds: parallel columns of equal length, every (first, count) range inside its
+// array and every sdf_row a model.sdf row or one of the ROW_* markers.
+inline bool ColumnsConsistent(const Model& m, const Expansion& x) {
+    auto same = [](size_t n, std::initializer_list<size_t> sizes) {
+        for (size_t s : sizes) if (s != n) return false;
+        return true;
+    };
+    auto ranges = [](const std::vector<uint32_t>& first, const std::vector<uint32_t>& count, size_t end) {
+        for (size_t i = 0; i < first.size(); ++i) if (first[i] > end || count[i] > end - first[i]) return false;
+        return true;
+    };
+    if (!same(m.bundles.id.size(), { m.bundles.type.size(), m.bundles.path.size() })) return false;
+    if (!same(m.sdf.id.size(), { m.sdf.type.size(), m.sdf.filename.size() })) return false;
+    if (!same(m.simple.id.size(), { m.simple.sdf_id.size(), m.simple.param_set.size(), m.simple.pan.size() })) return false;
+    for (const LinkedEvents* ev : { &m.random, &m.compound }) {
+        if (!same(ev->id.size(), { ev->first.size(), ev->count.size() })) return false;
+        if (!same(ev->link_a.size(), { ev->link_b.size(), ev->link_delay.size(), ev->link_arity.size() })) return false;
+        if (!ranges(ev->first, ev->count, ev->link_a.size())) return false;
+    }
+    if (!same(m.maps.id.size(), { m.maps.sub.size(), m.maps.type.size(), m.maps.ref.size(), m.maps.name.size() })) return false;
+    if (!same(m.sps.id.size(), { m.sps.sub.size(), m.sps.first.size(), m.sps.count.size() })) return false;
+    if (!ranges(m.sps.first, m.sps.count, m.sps.fields.size())) return false;
+    if (!same(m.maps.size(), { x.first.size(), x.count.size(), x.status.size() })) return false;
+    if (!same(x.steps(), { x.simple_id.size(), x.sdf_row.size() })) return false;
+    if (!ranges(x.first, x.count, x.steps())) return false;
+    for (int r : x.sdf_row) {
+        if (r == ROW_SDF_MISSING || r == ROW_SIMPLE_MISSING) continue;
+        if (r < 0 || static_cast<size_t>(r) >= m.sdf.size()) return false;
+    }
+    return true;
+}
+
+} // namespace detail
+
+// Writes the sidecar for a model produced by ParseFile (model.source must be set).
+// Returns false if the file could not be written; callers treat that as "no cache".
+inline bool WriteIndex(const std::filesystem::path& floPath, const Model& m, const Expansion& x) {
+    TRACE_SCOPE_CAT("WriteIndex", "flo");
+    using namespace detail;
+    if (!m.source || !m.source->is_open()) return false;
+    IndexHeader h{};
+    memcpy(h.magic, INDEX_MAGIC, sizeof(h.magic));
+    h.version = INDEX_VERSION;
+    h.header_size = sizeof(IndexHeader);
+    if (!SourceStamp(floPath, h.source_size, h.source_mtime) || h.source_size != m.source->size()) return false;
+    h.source_hash = Hash64(m.source->data(), m.source->size());
+    h.text_offset = static_cast<uint32_t>(m.text.data() ? m.text.data() - reinterpret_cast<const char*>(m.source->data()) : 0);
+    h.flags = m.has_event_maps ? IDX_HAS_EVENT_MAPS : 0u;
+    for (int b = 0; b < BLK_COUNT; ++b) {
+        const BlockSpan& s = m.blocks[b];
+        uint32_t* o = h.blocks[b];
+        o[0] = s.present ? 1u : 0u; o[1] = static_cast<uint32_t>(s.declared);
+        o[2] = s.header_begin; o[3] = s.count_begin; o[4] = s.count_end; o[5] = s.body_end;
+    }
+
+    StringInterner strings;
+    strings.text = m.text;
+    VisitColumns(m, x, strings);
+    h.string_count = static_cast<uint32_t>(strings.ids.size());
+
+    const std::filesystem::path idxPath = IndexPathFor(floPath);
+    std::filesystem::path tmpPath = idxPath;
+    tmpPath += ".tmp";
+    {
+        std::ofstream os(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!os) return false;
+        os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        ColumnWriter w{ os, strings };
+        w(strings.table);
+        VisitColumns(m, x, w);
+        if (!os) { os.close(); std::error_code ec; std::filesystem::remove(tmpPath, ec); return false; }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, idxPath, ec);
+    if (ec) { std::filesystem::remove(tmpPath, ec); return false; }
+    return true;
+}
+
+// Loads a model from a valid sidecar. Returns false (leaving 'm' cleared) when there is
+// no sidecar or it does not match the current .flo.
+inline bool LoadIndex(const std::filesystem::path& floPath, Model& m, Expansion& x) {
+    TRACE_SCOPE_CAT("LoadIndex", "flo");
+    using namespace detail;
+    m.clear(); x.clear();
+    uint64_t size = 0; int64_t mtime = 0;
+    if (!SourceStamp(floPath, size, mtime)) return false;
+
+    MappedFile idx(IndexPathFor(floPath));
+    if (!idx.is_open() || idx.size() < sizeof(IndexHeader)) return false;
+    IndexHeader h;
+    memcpy(&h, idx.data(), sizeof(h));
+    if (memcmp(h.magic, INDEX_MAGIC, sizeof(h.magic)) != 0 || h.version != INDEX_VERSION ||
+        h.header_size != sizeof(IndexHeader) || h.source_size != size || h.source_mtime != mtime) return false;
+
+    auto src = std::make_shared<MappedFile>(floPath);
+    if (!src->is_open() || src->size() != size || h.text_offset > size) return false;
+    if (Hash64(src->data(), src->size()) != h.source_hash) return false;
+    std::string_view text = src->view().substr(h.text_offset);
+
+    // String table first; every entry must lie inside the text.
+    ColumnReader r{ idx.data(), idx.size(), sizeof(IndexHeader), text, nullptr, 0 };
+    std::vector<uint32_t> table;
+    r(table);
+    if (!r.ok || table.size() != static_cast<size_t>(h.string_count) * 2) return false;
+    for (uint32_t i = 0; i < h.string_count; ++i) {
+        if (table[i * 2] > text.size() || table[i * 2 + 1] > text.size() - table[i * 2]) return false;
+    }
+    r.table = table.data();
+    r.string_count = h.string_count;
+    VisitColumns(m, x, r);
+    if (!r.ok || !ColumnsConsistent(m, x)) { m.clear(); x.clear(); return false; }
+
+    for (int b = 0; b < BLK_COUNT; ++b) {
+        const uint32_t* o = h.blocks[b];
+        BlockSpan& s = m.blocks[b];
+        s.present = o[0] != 0; s.declared = static_cast<int>(o[1]);
+        s.header_begin = o[2]; s.count_begin = o[3]; s.count_end = o[4]; s.body_end = o[5];
+        s.parsed = s.declared;  // sidecars are only written for clean parses
+        if (s.present && (s.count_begin > s.count_end || s.count_end > s.body_end || s.body_end > text.size())) { m.clear(); x.clear(); return false; }
+    }
+    m.has_event_maps = (h.flags & IDX_HAS_EVENT_MAPS) != 0;
+    m.source = std::move(src);
+    m.text = text;
+    return true;
+}
+
+// Sidecar if it is current, otherwise a full parse + resolve (and a fresh sidecar when
+// the parse was clean, so warnings keep showing until the file is fixed).
+inline bool LoadOrParse(const std::filesystem::path& floPath, Model& m, Expansion& x, bool* fromCache = nullptr) {
+    TRACE_SCOPE_CAT("LoadOrParse", "flo");
+    if (fromCache) *fromCache = false;
+    if (LoadIndex(floPath, m, x)) { if (fromCache) *fromCache = true; return true; }
+    if (!ParseFile(floPath, m)) return false;
+    ResolveEventMaps(m, x);
+    if (m.warnings.empty()) WriteIndex(floPath, m, x);
+    return true;
+}
+
+} // namespace flo
@@ -0,0 +1,424 @@
+#pragma once
+// FloParser.h
+// Single-pass parser for Gladius .flo sound-event files, shared by FloGui and WavRename.
+//
+// The file is memory-mapped and tokenized in place: every name in the model is a
+// std::string_view into the mapped UTF-8 text and every number is read with
+// std::from_chars. Sections are stored as struct-of-arrays (one vector per column)
+// so the tools can walk ids, links and names without per-entry allocations.
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Trace.h"
+
+namespace flo {
+
+// EventMaps / SoundParameterSets subsections, in file order.
+enum SubSection : uint8_t { SUB_PRE = 0, SUB_PAN = 1, SUB_POS = 2, SUB_COUNT = 3 };
+
+// Every counted block the parser knows about.
+enum Block : uint8_t {
+    BLK_BUNDLES, BLK_SDF, BLK_SIMPLE, BLK_RANDOM, BLK_COMPOUND,
+    BLK_MAP_PRE, BLK_MAP_PAN, BLK_MAP_POS,
+    BLK_SPS_PRE, BLK_SPS_PAN, BLK_SPS_POS,
+    BLK_COUNT
+};
+
+// Where a counted block lives in the source text. Lets a writer copy the file
+// verbatim and only touch the count token and the end of the block.
+struct BlockSpan {
+    bool present = false;
+    int declared = 0;           // count as written in the file
+    int parsed = 0;             // entries actually read; fewer than declared if the block ended early
+    uint32_t header_begin = 0;  // start of the header line ("SimpleEvents", "Pre", ...)
+    uint32_t count_begin = 0;   // [count_begin, count_end) is the count token
+    uint32_t count_end = 0;
+    uint32_t body_end = 0;      // just past the line break of the last entry line
+};
+
+struct Bundles {
+    std::vector<int> id;
+    std::vector<std::string_view> type, path;
+    size_t size() const { return id.size(); }
+};
+
+struct SoundDataFiles {
+    std::vector<int> id;
+    std::vector<std::string_view> type, filename;
+    size_t size() const { return id.size(); }
+};
+
+struct SimpleEvents {
+    std::vector<int> id, sdf_id, param_set, pan;
+    size_t size() const { return id.size(); }
+};
+
+// RandomEvents and CompoundEvents share one layout: a head row per event and a flat
+// array of link rows. Link rows are "a, b[, delay]"; a row with a single value
+// (arity 1) names a SoundDataFile directly instead of a SimpleEvent.
+struct LinkedEvents {
+    std::vector<int> id;
+    std::vector<uint32_t> first, count;   // range into the link_* arrays
+    std::vector<int> link_a, link_b;
+    std::vector<float> link_delay;
+    std::vector<uint8_t> link_arity;
+    size_t size() const { return id.size(); }
+};
+
+struct EventMaps {
+    std::vector<uint8_t> sub;             // SubSection
+    std::vector<int> id, type, ref;
+    std::vector<std::string_view> name;
+    size_t size() const { return id.size(); }
+};
+
+struct ParameterSets {
+    std::vector<uint8_t> sub;             // SubSection
+    std::vector<int> id;
+    std::vector<uint32_t> first, count;   // range into fields
+    std::vector<int> fields;
+    size_t size() const { return id.size(); }
+};
+
+struct Model {
+    std::shared_ptr<const MappedFile> source;  // keeps the string_views alive
+    std::string_view text;
+
+    Bundles bundles;
+    SoundDataFiles sdf;
+    SimpleEvents simple;
+    LinkedEvents random, compound;
+    EventMaps maps;
+    ParameterSets sps;
+
+    BlockSpan blocks[BLK_COUNT];
+    bool has_event_maps = false;
+    std::vector<std::string> warnings;
+
+    void clear() { *this = Model(); }
+};
+
+inline const char* SubSectionName(uint8_t s) {
+    switch (s) { case SUB_PRE: return "Pre"; case SUB_PAN: return "Pan"; case SUB_POS: return "Pos"; }
+    return "";
+}
+
+// --- Tokenizer helpers ---
+
+inline std::string_view TrimView(std::string_view s) {
+    size_t a = 0, b = s.size();
+    while (a < b && (s[a] == ' ' || s[a] == '\t' || s[a] == '\r' || s[a] == '\n')) ++a;
+    while (b > a && (s[b - 1] == ' ' || s[b - 1] == '\t' || s[b - 1] == '\r' || s[b - 1] == '\n')) --b;
+    return s.substr(a, b - a);
+}
+
+inline bool ParseInt(std::string_view s, int& out) {
+    s = TrimView(s);
+    if (!s.empty() && s.front() == '+') s.remove_prefix(1);
+    if (s.empty()) return false;
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc();
+}
+
+inline bool ParseFloat(std::string_view s, float& out) {
+    s = TrimView(s);
+    if (!s.empty() && s.front() == '+') s.remove_prefix(1);
+    if (s.empty()) return false;
+    auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+    return r.ec == std::errc();
+}
+
+// Splits off the next comma-separated field. Returns false once the line is exhausted.
+inline bool NextField(std::string_view& rest, std::string_view& field) {
+    if (rest.data() == nullptr) return false;
+    size_t comma = rest.find(',');
+    if (comma == std::string_view::npos) { field = TrimView(rest); rest = std::string_view(); return true; }
+    field = TrimView(rest.substr(0, comma));
+    rest = rest.substr(comma + 1);
+    return true;
+}
+
+// "prefix*Name_Rest" -> "Name_Rest". Names without '*' are returned unchanged.
+inline std::string_view NameAfterStar(std::string_view name) {
+    size_t star = name.find('*');
+    return star == std::string_view::npos ? name : name.substr(star + 1);
+}
+
+// UTF-8 -> UTF-16/32 wstring, replacing malformed sequences with U+FFFD.
+inline std::wstring Widen(std::string_view s) {
+    std::wstring out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size();) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        uint32_t cp = 0xFFFD; size_t len = 1;
+        if (c < 0x80) { cp = c; }
+        else if ((c >> 5) == 0x6 && i + 1 < s.size()) { cp = ((c & 0x1F) << 6) | (s[i + 1] & 0x3F); len = 2; }
+        else if ((c >> 4) == 0xE && i + 2 < s.size()) { cp = ((c & 0x0F) << 12) | ((s[i + 1] & 0x3F) << 6) | (s[i + 2] & 0x3F); len = 3; }
+        else if ((c >> 3) == 0x1E && i + 3 < s.size()) { cp = ((c & 0x07) << 18) | ((s[i + 1] & 0x3F) << 12) | ((s[i + 2] & 0x3F) << 6) | (s[i + 3] & 0x3F); len = 4; }
+        i += len;
+        if (sizeof(wchar_t) == 2 && cp > 0xFFFF) {
+            cp -= 0x10000;
+            out.push_back(static_cast<wchar_t>(0xD800 + (cp >> 10)));
+            out.push_back(static_cast<wchar_t>(0xDC00 + (cp & 0x3FF)));
+        }
+        else {
+            out.push_back(static_cast<wchar_t>(cp));
+        }
+    }
+    return out;
+}
+
+// --- Parser ---
+
+namespace detail {
+
+struct LineCursor {
+    std::string_view text;
+    size_t pos = 0;
+
+    // Yields the next line without its line break; end is the offset past the break.
+    bool next(std::string_view& line, size_t& begin, size_t& end) {
+        if (pos >= text.size()) return false;
+        begin = pos;
+        size_t nl = text.find('\n', pos);
+        size_t stop = (nl == std::string_view::npos) ? text.size() : nl;
+        end = (nl == std::string_view::npos) ? text.size() : nl + 1;
+        line = text.substr(begin, stop - begin);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        pos = end;
+        return true;
+    }
+
+    // Next line that is not blank after trimming.
+    bool next_nonblank(std::string_view& trimmed, size_t& begin, size_t& end) {
+        std::string_view raw;
+        while (next(raw, begin, end)) {
+            trimmed = TrimView(raw);
+            if (!trimmed.empty()) return true;
+        }
+        return false;
+    }
+};
+
+enum Keyword { KW_NONE, KW_BUNDLES, KW_SDF, KW_SIMPLE, KW_RANDOM, KW_COMPOUND, KW_SPS, KW_MAPS, KW_PRE, KW_PAN, KW_POS };
+
+inline Keyword MatchKeyword(std::string_view t) {
+    switch (t.size()) {
+    case 3:
+        if (t == "Pre") return KW_PRE;
+        if (t == "Pan") return KW_PAN;
+        if (t == "Pos") return KW_POS;
+        break;
+    case 9: if (t == "EventMaps") return KW_MAPS; break;
+    case 12: if (t == "SimpleEvents") return KW_SIMPLE; if (t == "RandomEvents") return KW_RANDOM; break;
+    case 14: if (t == "SoundDataFiles") return KW_SDF; if (t == "CompoundEvents") return KW_COMPOUND; break;
+    case 16: if (t == "SoundDataBundles") return KW_BUNDLES; break;
+    case 18: if (t == "SoundParameterSets") return KW_SPS; break;
+    }
+    return KW_NONE;
+}
+
+inline bool LooksLikeHeader(std::string_view t) {
+    return !t.empty() && !(t[0] == '-' || t[0] == '+' || (t[0] >= '0' && t[0] <= '9')) && MatchKeyword(t) != KW_NONE;
+}
+
+} // namespace detail
+
+// Parses .flo text in one forward pass. The views in 'out' point into 'text', so the
+// caller must keep the buffer alive (ParseFile does this through Model::source).
+inline bool ParseText(std::string_view text, Model& out) {
+    TRACE_SCOPE_CAT("ParseText", "flo");
+    using namespace detail;
+    std::shared_ptr<const MappedFile> keep = std::move(out.source);
+    out.clear();
+    out.source = std::move(keep);
+    if (text.size() >= 3 && static_cast<unsigned char>(text[0]) == 0xEF &&
+        static_cast<unsigned char>(text[1]) == 0xBB && static_cast<unsigned char>(text[2]) == 0xBF) {
+        text.remove_prefix(3);
+    }
+    if (text.size() > 0xFFFFFFFFu) { out.warnings.push_back("File too large for .flo parser"); return false; }
+    out.text = text;
+
+    const char* const base = text.data();
+    auto offset_of = [base](std::string_view v) { return static_cast<uint32_t>(v.data() - base); };
+
+    LineCursor cur{ text };
+    Keyword parent = KW_NONE;          // KW_MAPS or KW_SPS while inside those sections
+    int block = -1, remaining = 0;
+    std::string_view t; size_t lb = 0, le = 0;
+    size_t entry_end = 0;              // end of the last line consumed by the open block
+    bool pending = false;              // a header line was read while filling a block
+
+    auto open_block = [&](int blk) -> bool {
+        BlockSpan& span = out.blocks[blk];
+        span = BlockSpan();
+        span.header_begin = static_cast<uint32_t>(lb);
+        std::string_view cnt; size_t cb = 0, ce = 0;
+        if (!cur.next_nonblank(cnt, cb, ce) || !ParseInt(cnt, span.declared)) {
+            out.warnings.push_back(std::string("Expected count after '") + std::string(t) + "'");
+            if (!cnt.empty() && LooksLikeHeader(cnt)) { t = cnt; lb = cb; le = ce; pending = true; }
+            return false;
+        }
+        if (span.declared < 0) span.declared = 0;
+        span.present = true;
+        span.count_begin = offset_of(cnt);
+        span.count_end = span.count_begin + static_cast<uint32_t>(cnt.size());
+        span.body_end = static_cast<uint32_t>(ce);
+        entry_end = ce;
+        block = blk; remaining = span.declared;
+        return true;
+    };
+
+    // Every entry takes at least two bytes (a digit and a newline), so a corrupt count can
+    // not reserve more than the rest of the file could hold.
+    auto reserve_for = [&](int blk, int n) {
+        size_t r = (std::min)(static_cast<size_t>(n), (text.size() - entry_end) / 2);
+        switch (blk) {
+        case BLK_BUNDLES: out.bundles.id.reserve(r); out.bundles.type.reserve(r); out.bundles.path.reserve(r); break;
+        case BLK_SDF: out.sdf.id.reserve(r); out.sdf.type.reserve(r); out.sdf.filename.reserve(r); break;
+        case BLK_SIMPLE: out.simple.id.reserve(r); out.simple.sdf_id.reserve(r); out.simple.param_set.reserve(r); out.simple.pan.reserve(r); break;
+        case BLK_MAP_PRE: case BLK_MAP_PAN: case BLK_MAP_POS: {
+            size_t n2 = out.maps.size() + r;
+            out.maps.sub.reserve(n2); out.maps.id.reserve(n2); out.maps.type.reserve(n2); out.maps.ref.reserve(n2); out.maps.name.reserve(n2);
+        } break;
+        }
+    };
+
+    // Reads one Random/Compound event: head row "id, n" (or "id" then "n"), then n link rows.
+    auto read_linked = [&](LinkedEvents& ev, std::string_view head) {
+        std::string_view rest = head, f;
+        int id = 0, n = 0;
+        NextField(rest, f); ParseInt(f, id);
+        if (!NextField(rest, f) || f.empty()) {
+            std::string_view cnt; size_t cb = 0, ce = 0;
+            if (cur.next_nonblank(cnt, cb, ce)) { ParseInt(cnt, n); entry_end = ce; }
+        }
+        else {
+            ParseInt(f, n);
+        }
+        if (n < 0) n = 0;
+        ev.id.push_back(id);
+        ev.first.push_back(static_cast<uint32_t>(ev.link_a.size()));
+        uint32_t got = 0;
+        for (int i = 0; i < n; ++i) {
+            std::string_view ln; size_t cb = 0, ce = 0;
+            if (!cur.next_nonblank(ln, cb, ce)) break;
+            if (LooksLikeHeader(ln)) { t = ln; lb = cb; le = ce; pending = true; break; }
+            entry_end = ce;
+            std::string_view r = ln, v;
+            int a = 0, b = 0; float delay = 0.0f; uint8_t arity = 0;
+            if (NextField(r, v) && ParseInt(v, a)) arity = 1;
+            if (NextField(r, v) && ParseInt(v, b)) arity = 2;
+            if (arity == 2 && NextField(r, v) && ParseFloat(v, delay)) arity = 3;
+            ev.link_a.push_back(a); ev.link_b.push_back(b);
+            ev.link_delay.push_back(delay); ev.link_arity.push_back(arity);
+            ++got;
+        }
+        ev.count.push_back(got);
+    };
+
+    auto close_block = [&]() {
+        if (block >= 0) {
+            out.blocks[block].body_end = static_cast<uint32_t>(entry_end);
+            out.blocks[block].parsed = out.blocks[block].declared - remaining;
+        }
+        block = -1; remaining = 0;
+    };
+
+    for (;;) {
+        if (!pending && !cur.next_nonblank(t, lb, le)) break;
+        pending = false;
+
+        if (remaining > 0) {
+            if (LooksLikeHeader(t)) {
+                out.warnings.push_back(std::string("Block ended early before '") + std::string(t) + "'");
+                close_block();
+            }
+            else {
+                entry_end = le;
+                std::string_view rest = t, f0, f1;
+                switch (block) {
+                case BLK_BUNDLES: {
+                    int id = 0; NextField(rest, f0); ParseInt(f0, id);
+                    NextField(rest, f1);
+                    out.bundles.id.push_back(id); out.bundles.type.push_back(f1); out.bundles.path.push_back(TrimView(rest));
+                } break;
+                case BLK_SDF: {
+                    int id = 0; NextField(rest, f0); ParseInt(f0, id);
+                    NextField(rest, f1);
+                    out.sdf.id.push_back(id); out.sdf.type.push_back(f1); out.sdf.filename.push_back(TrimView(rest));
+                } break;
+                case BLK_SIMPLE: {
+                    int v[4] = { 0, 0, 0, 0 };
+                    for (int k = 0; k < 4 && NextField(rest, f0); ++k) ParseInt(f0, v[k]);
+                    out.simple.id.push_back(v[0]); out.simple.sdf_id.push_back(v[1]);
+                    out.simple.param_set.push_back(v[2]); out.simple.pan.push_back(v[3]);
+                } break;
+                case BLK_RANDOM: read_linked(out.random, t); break;
+                case BLK_COMPOUND: read_linked(out.compound, t); break;
+                case BLK_MAP_PRE: case BLK_MAP_PAN: case BLK_MAP_POS: {
+                    int v[3] = { 0, 0, 0 };
+                    for (int k = 0; k < 3 && NextField(rest, f0); ++k) ParseInt(f0, v[k]);
+                    out.maps.sub.push_back(static_cast<uint8_t>(block - BLK_MAP_PRE));
+                    out.maps.id.push_back(v[0]); out.maps.type.push_back(v[1]); out.maps.ref.push_back(v[2]);
+                    out.maps.name.push_back(TrimView(rest));
+                } break;
+                case BLK_SPS_PRE: case BLK_SPS_PAN: case BLK_SPS_POS: {
+                    int id = 0; NextField(rest, f0); ParseInt(f0, id);
+                    out.sps.sub.push_back(static_cast<uint8_t>(block - BLK_SPS_PRE));
+                    out.sps.id.push_back(id);
+                    out.sps.first.push_back(static_cast<uint32_t>(out.sps.fields.size()));
+                    uint32_t nf = 0; int val = 0;
+                    while (NextField(rest, f1)) { if (ParseInt(f1, val)) { out.sps.fields.push_back(val); ++nf; } }
+                    out.sps.count.push_back(nf);
+                } break;
+                }
+                if (--remaining == 0 || pending) close_block();
+                continue;
+            }
+        }
+
+        Keyword kw = MatchKeyword(t);
+        int blk = -1;
+        switch (kw) {
+        case KW_NONE: continue;
+        case KW_MAPS: parent = KW_MAPS; out.has_event_maps = true; continue;
+        case KW_SPS: parent = KW_SPS; continue;
+        case KW_BUNDLES: parent = KW_NONE; blk = BLK_BUNDLES; break;
+        case KW_SDF: parent = KW_NONE; blk = BLK_SDF; break;
+        case KW_SIMPLE: parent = KW_NONE; blk = BLK_SIMPLE; break;
+        case KW_RANDOM: parent = KW_NONE; blk = BLK_RANDOM; break;
+        case KW_COMPOUND: parent = KW_NONE; blk = BLK_COMPOUND; break;
+        case KW_PRE: case KW_PAN: case KW_POS: {
+            int sub = kw - KW_PRE;
+            if (parent == KW_MAPS) blk = BLK_MAP_PRE + sub;
+            else if (parent == KW_SPS) blk = BLK_SPS_PRE + sub;
+            else { out.warnings.push_back(std::string("Subsection '") + std::string(t) + "' without a parent header"); continue; }
+        } break;
+        }
+        if (open_block(blk)) {
+            reserve_for(blk, out.blocks[blk].declared);
+            if (remaining == 0) block = -1;
+        }
+    }
+    if (remaining > 0) { out.warnings.push_back("File ended before all declared entries were read"); close_block(); }
+    return true;
+}
+
+// Maps the file and parses it. The mapping is owned by out.source.
+inline bool ParseFile(const std::filesystem::path& path, Model& out) {
+    auto mf = std::make_shared<MappedFile>();
+    if (!mf->open(path)) { out.clear(); out.warnings.push_back("Could not open .flo file"); return false; }
+    out.source = mf;
+    return ParseText(mf->view(), out);
+}
+
+} // namespace flo
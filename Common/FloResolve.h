@@ -0,0 +1,110 @@
+#pragma once
+// FloResolve.h
+// Expands every EventMaps row of a parsed .flo down to the SoundDataFiles it plays.
+//
+// Ids are looked up through hash tables built once per model, so resolving a whole
+// file is linear in the number of links instead of rows x entries.
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "FloParser.h"
+
+namespace flo {
+
+// Per-row outcome of the expansion.
+enum ExpandStatus : uint8_t {
+    EXP_OK = 0,             // at least one step was produced
+    EXP_UNKNOWN_TYPE = 1,   // link type is not 0 (Simple), 1 (Random) or 2 (Compound)
+    EXP_TARGET_MISSING = 2, // the referenced Random/Compound event is absent or has no links
+};
+
+// sdf_row values that do not index model.sdf.
+constexpr int ROW_SDF_MISSING = -1;     // sdf_id is not declared in SoundDataFiles
+constexpr int ROW_SIMPLE_MISSING = -2;  // simple_id is not declared in SimpleEvents (sdf_id is meaningless)
+
+// One step per link, in file order. Rows index model.maps; steps are a flat array.
+struct Expansion {
+    std::vector<uint32_t> first, count;   // per maps row, range into the step arrays
+    std::vector<uint8_t> status;          // per maps row, ExpandStatus
+    std::vector<int> simple_id;           // -1 when the link names a SoundDataFile directly
+    std::vector<int> sdf_id;
+    std::vector<int> sdf_row;             // index into model.sdf or ROW_*
+    size_t size() const { return first.size(); }
+    size_t steps() const { return sdf_id.size(); }
+    void clear() { *this = Expansion(); }
+};
+
+// id -> row lookups over a model. Later rows win when an id is declared twice.
+struct IdTables {
+    std::unordered_map<int, int> sdf, simple, random, compound;
+
+    void build(const Model& m) {
+        auto fill = [](std::unordered_map<int, int>& t, const std::vector<int>& ids) {
+            t.clear(); t.reserve(ids.size());
+            for (size_t i = 0; i < ids.size(); ++i) t[ids[i]] = static_cast<int>(i);
+        };
+        fill(sdf, m.sdf.id); fill(simple, m.simple.id);
+        fill(random, m.random.id); fill(compound, m.compound.id);
+    }
+
+    static int find(const std::unordered_map<int, int>& t, int id) {
+        auto it = t.find(id);
+        return it == t.end() ? -1 : it->second;
+    }
+};
+
+inline void ResolveEventMaps(const Model& m, const IdTables& ids, Expansion& out) {
+    out.clear();
+    const size_t rows = m.maps.size();
+    out.first.resize(rows); out.count.resize(rows); out.status.resize(rows);
+    out.simple_id.reserve(rows); out.sdf_id.reserve(rows); out.sdf_row.reserve(rows);
+
+    auto push_simple = [&](int se) {
+        int r = IdTables::find(ids.simple, se);
+        if (r < 0) { out.simple_id.push_back(se); out.sdf_id.push_back(0); out.sdf_row.push_back(ROW_SIMPLE_MISSING); return; }
+        int sdf = m.simple.sdf_id[r];
+        int sr = IdTables::find(ids.sdf, sdf);
+        out.simple_id.push_back(se); out.sdf_id.push_back(sdf); out.sdf_row.push_back(sr < 0 ? ROW_SDF_MISSING : sr);
+    };
+    auto push_sdf = [&](int sdf) {
+        int sr = IdTables::find(ids.sdf, sdf);
+        out.simple_id.push_back(-1); out.sdf_id.push_back(sdf); out.sdf_row.push_back(sr < 0 ? ROW_SDF_MISSING : sr);
+    };
+    // A Compound event plays every link. A Random event that lists any SimpleEvents picks
+    // among those only; its direct SoundDataFile links count only when it has none.
+    auto push_linked = [&](const LinkedEvents& ev, int r, bool simple_first) {
+        const uint32_t end = ev.first[r] + ev.count[r];
+        bool any_simple = false;
+        for (uint32_t k = ev.first[r]; simple_first && !any_simple && k < end; ++k) any_simple = ev.link_arity[k] >= 2;
+        for (uint32_t k = ev.first[r]; k < end; ++k) {
+            if (ev.link_arity[k] == 0) continue;
+            if (ev.link_arity[k] == 1) { if (!any_simple) push_sdf(ev.link_a[k]); }
+            else push_simple(ev.link_b[k]);
+        }
+    };
+
+    for (size_t i = 0; i < rows; ++i) {
+        out.first[i] = static_cast<uint32_t>(out.sdf_id.size());
+        const int ref = m.maps.ref[i];
+        uint8_t st = EXP_OK;
+        switch (m.maps.type[i]) {
+        case 0: push_simple(ref); break;   // a missing SimpleEvent shows up as a ROW_SIMPLE_MISSING step
+        case 1: { int r = IdTables::find(ids.random, ref); if (r >= 0) push_linked(m.random, r, true); } break;
+        case 2: { int r = IdTables::find(ids.compound, ref); if (r >= 0) push_linked(m.compound, r, false); } break;
+        default: st = EXP_UNKNOWN_TYPE; break;
+        }
+        out.count[i] = static_cast<uint32_t>(out.sdf_id.size()) - out.first[i];
+        if (st == EXP_OK && out.count[i] == 0) st = EXP_TARGET_MISSING;
+        out.status[i] = st;
+    }
+}
+
+inline void ResolveEventMaps(const Model& m, Expansion& out) {
+    IdTables ids;
+    ids.build(m);
+    ResolveEventMaps(m, ids, out);
+}
+
+} // namespace flo
@@ -0,0 +1,111 @@
+#pragma once
+// FloWriter.h
+// Single forward pass .flo writer. Pending new entry lines are gathered per block and
+// the source is streamed once: untouched byte ranges are copied verbatim, every block
+// that gains lines gets its count token rewritten (any width; entries read plus lines
+// added, so a block that ended early is counted as it stands) and the new lines are
+// emitted right after its last entry. Cost is linear in file size + added lines.
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "FloParser.h"
+
+namespace flo {
+
+inline const char* BlockName(int b) {
+    switch (b) {
+    case BLK_BUNDLES: return "SoundDataBundles";
+    case BLK_SDF: return "SoundDataFiles";
+    case BLK_SIMPLE: return "SimpleEvents";
+    case BLK_RANDOM: return "RandomEvents";
+    case BLK_COMPOUND: return "CompoundEvents";
+    case BLK_MAP_PRE: return "EventMaps/Pre";
+    case BLK_MAP_PAN: return "EventMaps/Pan";
+    case BLK_MAP_POS: return "EventMaps/Pos";
+    case BLK_SPS_PRE: return "SoundParameterSets/Pre";
+    case BLK_SPS_PAN: return "SoundParameterSets/Pan";
+    case BLK_SPS_POS: return "SoundParameterSets/Pos";
+    }
+    return "?";
+}
+
+// New entry lines per block, appended after the block's existing entries in the order
+// given. Each line should carry its own line break ("...\r\n").
+struct Appends {
+    std::vector<std::string> lines[BLK_COUNT];
+
+    void add(Block b, std::string line) { lines[b].push_back(std::move(line)); }
+    bool empty() const {
+        for (const auto& l : lines) if (!l.empty()) return false;
+        return true;
+    }
+};
+
+// Streams m.text (plus any bytes before it, e.g. a BOM) to 'os' with the appends applied.
+inline bool WriteWithAppends(const Model& m, const Appends& a, std::ostream& os, std::string& error) {
+    std::vector<int> touched;
+    for (int b = 0; b < BLK_COUNT; ++b) {
+        if (a.lines[b].empty()) continue;
+        if (!m.blocks[b].present) { error = std::string("Section '") + BlockName(b) + "' was not found in the file."; return false; }
+        touched.push_back(b);
+    }
+    std::sort(touched.begin(), touched.end(), [&](int x, int y) { return m.blocks[x].count_begin < m.blocks[y].count_begin; });
+
+    auto put = [&os](const char* p, size_t n) { os.write(p, static_cast<std::streamsize>(n)); };
+    if (m.source && m.source->data() && m.text.data()) {
+        const char* file = reinterpret_cast<const char*>(m.source->data());
+        put(file, static_cast<size_t>(m.text.data() - file));   // BOM
+    }
+    const char* text = m.text.data();
+    size_t cursor = 0;
+    for (int b : touched) {
+        const BlockSpan& s = m.blocks[b];
+        if (s.count_begin < cursor || s.body_end < s.count_end || s.body_end > m.text.size()) {
+            error = std::string("Section '") + BlockName(b) + "' overlaps another section.";
+            return false;
+        }
+        put(text + cursor, s.count_begin - cursor);
+        const std::string count = std::to_string(s.parsed + static_cast<int>(a.lines[b].size()));
+        put(count.data(), count.size());
+        put(text + s.count_end, s.body_end - s.count_end);
+        if (s.body_end > 0 && text[s.body_end - 1] != '\n') put("\r\n", 2);   // last entry had no line break
+        for (const std::string& line : a.lines[b]) put(line.data(), line.size());
+        cursor = s.body_end;
+    }
+    put(text + cursor, m.text.size() - cursor);
+    if (!os) { error = "Write failed."; return false; }
+    return true;
+}
+
+// Parses 'src', writes the result to a temporary file next to 'dst' and then replaces
+// 'dst' with it, so saving over the open file works and a failed save leaves it intact.
+inline bool SaveWithAppends(const std::filesystem::path& src, const std::filesystem::path& dst, const Appends& a, std::string& error) {
+    std::filesystem::path tmp = dst;
+    tmp += ".tmp";
+    {
+        Model m;
+        if (!ParseFile(src, m)) { error = "Could not read the original .flo file."; return false; }
+        std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+        if (!os) { error = "Could not create the output file."; return false; }
+        bool ok = WriteWithAppends(m, a, os, error);
+        os.close();
+        if (!ok || !os) {
+            if (ok) error = "Write failed.";
+            std::error_code ec; std::filesystem::remove(tmp, ec);
+            return false;
+        }
+    } // the source mapping is released here, before it may be replaced
+    std::error_code ec;
+    std::filesystem::rename(tmp, dst, ec);
+    if (ec) { error = "Could not replace the output file: " + ec.message(); std::filesystem::remove(tmp, ec); return false; }
+    return true;
+}
+
+} // namespace flo
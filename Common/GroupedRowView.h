@@ -0,0 +1,123 @@
+#pragma once
+// GroupedRowView.h
+// Headless row model for a filtered, sorted table (no Win32 - a virtual ListView binds
+// to size() / row_at()).
+//
+// Rows are dense ids in the order they were added, each tagged with a group id once.
+// For each display order the rows are split into per-group buckets in one pass over the
+// order (the first time a group is shown), so switching groups afterwards shows a bucket
+// as it is and "All" reads the display order directly - neither copies nor sorts. An
+// optional match set (e.g. search hits) is marked once per set_match() and narrows
+// either one in a single pass over its rows.
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class GroupedRowView {
+public:
+    static constexpr uint32_t ALL = 0xFFFFFFFFu;
+
+    void clear() {
+        m_groupOf.clear(); m_buckets.clear(); m_groupList.clear();
+        m_order = nullptr; m_ordered.clear(); m_orderedValid = false;
+        m_visible.clear(); m_shown = nullptr;
+        m_group = ALL; m_match = nullptr; m_matchMark.clear(); m_matchStamp = 0;
+    }
+
+    // Appends the next row (id = row_count() before the call).
+    void add_row(uint32_t group) {
+        const uint32_t row = static_cast<uint32_t>(m_groupOf.size());
+        m_groupOf.push_back(group);
+        auto& bucket = m_buckets[group];
+        if (bucket.empty()) m_groupList.push_back(group);
+        bucket.push_back(row);
+        m_orderedValid = false;
+    }
+
+    size_t row_count() const { return m_groupOf.size(); }
+    uint32_t group_of(uint32_t row) const { return m_groupOf[row]; }
+
+    // Groups in first-seen order.
+    const std::vector<uint32_t>& groups() const { return m_groupList; }
+
+    // Rows of one group in add order (empty for an unknown group).
+    const std::vector<uint32_t>& group_rows(uint32_t group) const {
+        static const std::vector<uint32_t> none;
+        auto it = m_buckets.find(group);
+        return it == m_buckets.end() ? none : it->second;
+    }
+
+    // Display order: a permutation of every row. The vector must outlive the view or be
+    // replaced by another set_order(); call it again after the permutation changed.
+    void set_order(const std::vector<uint32_t>& order) {
+        m_order = &order;
+        m_orderedValid = false;
+        rebuild();
+    }
+
+    // ALL shows every row.
+    void set_group(uint32_t group) {
+        m_group = group;
+        rebuild();
+    }
+
+    uint32_t group() const { return m_group; }
+
+    // Only rows in 'rows' are shown; nullptr shows every row of the group. The vector must
+    // outlive the view or be replaced; call it again after its contents changed.
+    void set_match(const std::vector<uint32_t>* rows) {
+        m_match = rows;
+        if (rows) {
+            if (++m_matchStamp == 0) { m_matchMark.assign(m_matchMark.size(), 0); m_matchStamp = 1; }
+            m_matchMark.resize(m_groupOf.size(), 0);
+            for (uint32_t r : *rows) if (r < m_matchMark.size()) m_matchMark[r] = m_matchStamp;
+        }
+        rebuild();
+    }
+
+    size_t size() const { return m_order ? rows().size() : 0; }
+
+    // Row id shown at display index i (i < size()).
+    uint32_t row_at(size_t i) const { return rows()[i]; }
+
+private:
+    const std::vector<uint32_t>& rows() const { return m_shown ? *m_shown : m_visible; }
+    bool matches(uint32_t row) const { return row < m_matchMark.size() && m_matchMark[row] == m_matchStamp; }
+
+    // Splits the display order into per-group buckets, once per order.
+    void build_ordered() {
+        if (m_orderedValid) return;
+        for (auto& kv : m_ordered) kv.second.clear();
+        for (uint32_t row : *m_order) m_ordered[m_groupOf[row]].push_back(row);
+        m_orderedValid = true;
+    }
+
+    void rebuild() {
+        m_visible.clear();
+        m_shown = nullptr;
+        if (!m_order) return;
+        const std::vector<uint32_t>* src = m_order;
+        if (m_group != ALL) {
+            if (m_buckets.find(m_group) == m_buckets.end()) return;
+            build_ordered();
+            src = &m_ordered[m_group];
+        }
+        if (!m_match) { m_shown = src; return; }
+        for (uint32_t row : *src) if (matches(row)) m_visible.push_back(row);
+    }
+
+    std::vector<uint32_t> m_groupOf;                              // row -> group
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_buckets;  // group -> rows, add order
+    std::vector<uint32_t> m_groupList;
+    const std::vector<uint32_t>* m_order = nullptr;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_ordered;  // group -> rows, display order
+    bool m_orderedValid = false;
+    std::vector<uint32_t> m_visible;                              // filtered rows, in display order
+    const std::vector<uint32_t>* m_shown = nullptr;               // *m_order or a bucket shown as is; else m_visible
+    uint32_t m_group = ALL;
+    const std::vector<uint32_t>* m_match = nullptr;
+    std::vector<uint32_t> m_matchMark;                            // row -> stamp of the last set_match it was in
+    uint32_t m_matchStamp = 0;
+};
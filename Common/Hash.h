@@ -0,0 +1,52 @@
+#pragma once
+// Hash.h
+// 64-bit content hash (XXH64 algorithm) used to validate sidecar caches against
+// their source files. Not cryptographic; it only has to notice edits.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace hash_detail {
+
+constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+inline uint64_t rotl(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+inline uint64_t read64(const uint8_t* p) { uint64_t v; memcpy(&v, p, 8); return v; }   // little-endian hosts only
+inline uint32_t read32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+inline uint64_t round(uint64_t acc, uint64_t in) { acc += in * P2; acc = rotl(acc, 31); return acc * P1; }
+inline uint64_t merge(uint64_t acc, uint64_t v) { acc ^= round(0, v); return acc * P1 + P4; }
+
+} // namespace hash_detail
+
+inline uint64_t Hash64(const void* data, size_t len, uint64_t seed = 0) {
+    using namespace hash_detail;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* const end = p + len;
+    uint64_t h;
+    if (len >= 32) {
+        // Four independent lanes keep the multiplier pipelines busy.
+        uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+        const uint8_t* const limit = end - 32;
+        do {
+            v1 = round(v1, read64(p)); v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16)); v4 = round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge(h, v1); h = merge(h, v2); h = merge(h, v3); h = merge(h, v4);
+    }
+    else {
+        h = seed + P5;
+    }
+    h += static_cast<uint64_t>(len);
+    for (; p + 8 <= end; p += 8) { h ^= round(0, read64(p)); h = rotl(h, 27) * P1 + P4; }
+    if (p + 4 <= end) { h ^= static_cast<uint64_t>(read32(p)) * P1; h = rotl(h, 23) * P2 + P3; p += 4; }
+    for (; p < end; ++p) { h ^= (*p) * P5; h = rotl(h, 11) * P1; }
+    h ^= h >> 33; h *= P2; h ^= h >> 29; h *= P3; h ^= h >> 32;
+    return h;
+}
@@ -0,0 +1,115 @@
+#pragma once
+// JsonWriter.h
+// Small streaming JSON writer for the tools' reports. Objects and arrays are opened and
+// closed explicitly, commas and two-space indentation are handled here, strings are
+// escaped (UTF-8 passes through; control characters become \u00XX). Non-finite numbers
+// are written as null.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+class JsonWriter {
+public:
+    JsonWriter& begin_object() { open('{'); return *this; }
+    JsonWriter& end_object() { close('}'); return *this; }
+    JsonWriter& begin_array() { open('['); return *this; }
+    JsonWriter& end_array() { close(']'); return *this; }
+
+    // Object member name; the next value / begin_* call is its value.
+    JsonWriter& key(std::string_view name) {
+        separate();
+        string(name);
+        m_out += ": ";
+        m_after_key = true;
+        return *this;
+    }
+
+    JsonWriter& value(std::string_view s) { separate(); string(s); return *this; }
+    JsonWriter& value(const char* s) { return value(std::string_view(s)); }
+    JsonWriter& value(const std::string& s) { return value(std::string_view(s)); }
+    JsonWriter& value(bool b) { separate(); m_out += b ? "true" : "false"; return *this; }
+    JsonWriter& value(double d) {
+        separate();
+        if (!std::isfinite(d)) { m_out += "null"; return *this; }
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.6g", d);
+        m_out += buf;
+        return *this;
+    }
+    // Fixed-point, for values whose magnitude would lose digits under %.6g (timestamps).
+    JsonWriter& value(double d, int decimals) {
+        separate();
+        if (!std::isfinite(d)) { m_out += "null"; return *this; }
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", decimals, d);
+        m_out += buf;
+        return *this;
+    }
+    template <class T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    JsonWriter& value(T v) {
+        separate();
+        if constexpr (std::is_signed_v<T>) m_out += std::to_string(static_cast<long long>(v));
+        else m_out += std::to_string(static_cast<unsigned long long>(v));
+        return *this;
+    }
+    JsonWriter& null() { separate(); m_out += "null"; return *this; }
+
+    // key(name).value(v) in one call.
+    template <class T> JsonWriter& field(std::string_view name, const T& v) { key(name); return value(v); }
+
+    const std::string& str() const { return m_out; }
+
+    bool save(const std::filesystem::path& path) const {
+        std::ofstream f(path, std::ios::binary | std::ios::trunc);
+        if (!f) return false;
+        f.write(m_out.data(), static_cast<std::streamsize>(m_out.size()));
+        f.put('\n');
+        return static_cast<bool>(f);
+    }
+
+private:
+    void open(char c) { separate(); m_out += c; m_first.push_back(true); }
+    void close(char c) {
+        const bool empty = !m_first.empty() && m_first.back();
+        if (!m_first.empty()) m_first.pop_back();
+        if (!empty) newline();
+        m_out += c;
+    }
+    // Comma and line break before a new element (not before a value that follows its key).
+    void separate() {
+        if (m_after_key) { m_after_key = false; return; }
+        if (m_first.empty()) return;
+        if (!m_first.back()) m_out += ',';
+        m_first.back() = false;
+        newline();
+    }
+    void newline() { m_out += '\n'; m_out.append(m_first.size() * 2, ' '); }
+    void string(std::string_view s) {
+        m_out += '"';
+        for (const char ch : s) {
+            const unsigned char c = static_cast<unsigned char>(ch);
+            switch (c) {
+            case '"': m_out += "\\\""; break;
+            case '\\': m_out += "\\\\"; break;
+            case '\n': m_out += "\\n"; break;
+            case '\r': m_out += "\\r"; break;
+            case '\t': m_out += "\\t"; break;
+            default:
+                if (c < 0x20) { char buf[8]; snprintf(buf, sizeof(buf), "\\u%04x", c); m_out += buf; }
+                else m_out += ch;
+            }
+        }
+        m_out += '"';
+    }
+
+    std::string m_out;
+    std::vector<bool> m_first;   // per open container: no element written yet
+    bool m_after_key = false;
+};
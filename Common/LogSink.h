@@ -0,0 +1,192 @@
+#pragma once
+// LogSink.h
+// Asynchronous log for batch runs. push() is callable from any thread and costs one
+// allocation and one compare-and-swap: records go onto a lock-free multi-producer stack
+// that a single sink thread takes whole (one exchange), puts back in push order and
+// writes out in batches - appended to a file (UTF-8), to stdout, and/or collected for
+// the UI. The UI never gets a call per line: the sink tells it (ui_notify, e.g. a
+// PostMessage) at most once per ui_interval_ms that text is waiting, and the UI thread
+// picks everything up with take_ui() in one go.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct LogTargets {
+    std::filesystem::path file;              // appended to; empty = no file
+    bool console = false;                    // stdout
+    std::function<void()> ui_notify;         // called on the sink thread when UI text is waiting
+    unsigned ui_interval_ms = 100;
+};
+
+namespace log_detail {
+struct Record {
+    Record* next;
+    std::wstring text;
+};
+
+// wchar_t text (UTF-16 on Windows, UTF-32 elsewhere) as UTF-8.
+inline void AppendUtf8(std::string& out, const std::wstring& s) {
+    for (size_t i = 0; i < s.size(); ++i) {
+        uint32_t c = static_cast<uint32_t>(s[i]);
+        if (c >= 0xD800 && c < 0xDC00 && i + 1 < s.size()) {
+            const uint32_t lo = static_cast<uint32_t>(s[i + 1]);
+            if (lo >= 0xDC00 && lo < 0xE000) { c = 0x10000 + ((c - 0xD800) << 10) + (lo - 0xDC00); ++i; }
+        }
+        if (c < 0x80) out += static_cast<char>(c);
+        else if (c < 0x800) { out += static_cast<char>(0xC0 | (c >> 6)); out += static_cast<char>(0x80 | (c & 0x3F)); }
+        else if (c < 0x10000) { out += static_cast<char>(0xE0 | (c >> 12)); out += static_cast<char>(0x80 | ((c >> 6) & 0x3F)); out += static_cast<char>(0x80 | (c & 0x3F)); }
+        else { out += static_cast<char>(0xF0 | (c >> 18)); out += static_cast<char>(0x80 | ((c >> 12) & 0x3F)); out += static_cast<char>(0x80 | ((c >> 6) & 0x3F)); out += static_cast<char>(0x80 | (c & 0x3F)); }
+    }
+}
+
+#ifdef _WIN32
+constexpr const wchar_t* NEWLINE_W = L"\r\n";
+constexpr const char* NEWLINE = "\r\n";
+#else
+constexpr const wchar_t* NEWLINE_W = L"\n";
+constexpr const char* NEWLINE = "\n";
+#endif
+} // namespace log_detail
+
+class LogSink {
+public:
+    static constexpr unsigned IDLE_MS = 10;   // sink poll interval while the queue is empty
+
+    LogSink() = default;
+    ~LogSink() {
+        stop();
+        for (log_detail::Record* r = m_head.exchange(nullptr); r;) { log_detail::Record* next = r->next; delete r; r = next; }
+    }
+    LogSink(const LogSink&) = delete;
+    LogSink& operator=(const LogSink&) = delete;
+
+    // Starts the sink thread. Returns false if the log file cannot be opened (the other
+    // targets still run).
+    bool start(LogTargets targets) {
+        stop();
+        m_targets = std::move(targets);
+        bool ok = true;
+        if (!m_targets.file.empty()) {
+#ifdef _WIN32
+            m_file = _wfopen(m_targets.file.c_str(), L"ab");
+#else
+            m_file = fopen(m_targets.file.c_str(), "ab");
+#endif
+            ok = m_file != nullptr;
+        }
+        m_running.store(true, std::memory_order_release);
+        m_thread = std::thread([this] { run(); });
+        return ok;
+    }
+
+    // Writes out everything pushed so far, then ends the sink thread.
+    void stop() {
+        if (!m_thread.joinable()) return;
+        m_running.store(false, std::memory_order_release);
+        m_thread.join();
+        if (m_file) { fclose(m_file); m_file = nullptr; }
+    }
+
+    // One line, from any thread. Before start() / after stop() the line is kept and
+    // written once the sink runs again.
+    void push(std::wstring line) {
+        log_detail::Record* r = new log_detail::Record{ nullptr, std::move(line) };
+        m_pushed.fetch_add(1, std::memory_order_relaxed);
+        r->next = m_head.load(std::memory_order_relaxed);
+        while (!m_head.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    // Waits until every line pushed before the call has reached the targets.
+    void flush() {
+        const uint64_t target = m_pushed.load(std::memory_order_relaxed);
+        if (!m_thread.joinable()) return;
+        while (m_written.load(std::memory_order_acquire) < target) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // UI text collected since the last call (lines joined with the platform newline).
+    // With only_if_due, nothing is taken until ui_interval_ms has passed since the last
+    // take - for UI threads that poll between work items instead of waiting for ui_notify.
+    bool take_ui(std::wstring& out, bool only_if_due = false) {
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(m_ui_lock);
+        if (only_if_due && now - m_ui_taken < std::chrono::milliseconds(m_targets.ui_interval_ms)) return false;
+        m_ui_taken = now;
+        m_ui_posted = false;
+        out.clear();
+        out.swap(m_ui_text);
+        return !out.empty();
+    }
+
+    uint64_t lines() const { return m_pushed.load(std::memory_order_relaxed); }
+
+private:
+    void run() {
+        std::string bytes;
+        for (;;) {
+            const bool running = m_running.load(std::memory_order_acquire);
+            log_detail::Record* list = m_head.exchange(nullptr, std::memory_order_acquire);
+            if (list) write_batch(list, bytes);
+            notify_ui();
+            if (!list) {
+                if (!running) break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MS));
+            }
+        }
+        if (m_file) fflush(m_file);
+    }
+
+    // The stack holds the newest record first: reverse it, then write the batch in order.
+    void write_batch(log_detail::Record* list, std::string& bytes) {
+        log_detail::Record* ordered = nullptr;
+        while (list) { log_detail::Record* next = list->next; list->next = ordered; ordered = list; list = next; }
+        const bool ui = static_cast<bool>(m_targets.ui_notify);
+        const bool narrow = m_file || m_targets.console;
+        bytes.clear();
+        std::wstring text;
+        uint64_t count = 0;
+        for (log_detail::Record* r = ordered; r;) {
+            if (narrow) { log_detail::AppendUtf8(bytes, r->text); bytes += log_detail::NEWLINE; }
+            if (ui) { text += r->text; text += log_detail::NEWLINE_W; }
+            log_detail::Record* next = r->next;
+            delete r;
+            r = next;
+            ++count;
+        }
+        if (m_file) { fwrite(bytes.data(), 1, bytes.size(), m_file); fflush(m_file); }
+        if (m_targets.console) { fwrite(bytes.data(), 1, bytes.size(), stdout); fflush(stdout); }
+        if (ui) { std::lock_guard<std::mutex> lock(m_ui_lock); m_ui_text += text; }
+        m_written.fetch_add(count, std::memory_order_release);
+    }
+
+    // One notification per interval at most, and none while the last one is unanswered.
+    void notify_ui() {
+        if (!m_targets.ui_notify) return;
+        const auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(m_ui_lock);
+            if (m_ui_text.empty() || m_ui_posted || now - m_ui_notified < std::chrono::milliseconds(m_targets.ui_interval_ms)) return;
+            m_ui_posted = true;
+            m_ui_notified = now;
+        }
+        m_targets.ui_notify();
+    }
+
+    LogTargets m_targets;
+    FILE* m_file = nullptr;
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+    std::atomic<log_detail::Record*> m_head{ nullptr };
+    std::atomic<uint64_t> m_pushed{ 0 }, m_written{ 0 };
+
+    std::mutex m_ui_lock;                    // sink thread <-> UI thread only, never producers
+    std::wstring m_ui_text;
+    bool m_ui_posted = false;
+    std::chrono::steady_clock::time_point m_ui_notified{}, m_ui_taken{};
+};
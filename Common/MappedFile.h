@@ -0,0 +1,101 @@
+#pragma once
+// MappedFile.h
+// Read-only memory-mapped view of a whole file, shared by the tools.
+// The view stays valid for as long as the MappedFile object lives.
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path& path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { swap(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept { if (this != &other) { close(); swap(other); } return *this; }
+
+    // Maps the file read-only. An existing but empty file opens successfully with size() == 0.
+    bool open(const std::filesystem::path& path) {
+        close();
+#ifdef _WIN32
+        m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (m_file == INVALID_HANDLE_VALUE) { m_file = NULL; return false; }
+        LARGE_INTEGER sz{};
+        if (!GetFileSizeEx(m_file, &sz)) { close(); return false; }
+        m_size = static_cast<size_t>(sz.QuadPart);
+        m_open = true;
+        if (m_size == 0) return true;
+        m_mapping = CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!m_mapping) { close(); return false; }
+        m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_data) { close(); return false; }
+#else
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        if (m_fd < 0) return false;
+        struct stat st {};
+        if (fstat(m_fd, &st) != 0) { close(); return false; }
+        m_size = static_cast<size_t>(st.st_size);
+        m_open = true;
+        if (m_size == 0) return true;
+        void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (p == MAP_FAILED) { close(); return false; }
+        m_data = static_cast<const uint8_t*>(p);
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (m_data) UnmapViewOfFile(m_data);
+        if (m_mapping) CloseHandle(m_mapping);
+        if (m_file) CloseHandle(m_file);
+        m_mapping = NULL; m_file = NULL;
+#else
+        if (m_data) munmap(const_cast<uint8_t*>(m_data), m_size);
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+#endif
+        m_data = nullptr; m_size = 0; m_open = false;
+    }
+
+    bool is_open() const { return m_open; }
+    const uint8_t* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    std::string_view view() const { return m_data ? std::string_view(reinterpret_cast<const char*>(m_data), m_size) : std::string_view(); }
+
+private:
+    void swap(MappedFile& o) noexcept {
+        std::swap(m_data, o.m_data); std::swap(m_size, o.m_size); std::swap(m_open, o.m_open);
+#ifdef _WIN32
+        std::swap(m_file, o.m_file); std::swap(m_mapping, o.m_mapping);
+#else
+        std::swap(m_fd, o.m_fd);
+#endif
+    }
+
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+#ifdef _WIN32
+    HANDLE m_file = NULL;
+    HANDLE m_mapping = NULL;
+#else
+    int m_fd = -1;
+#endif
+};
@@ -0,0 +1,71 @@
+#pragma once
+// PcmCache.h
+// Decoded audio shared between renders. A sound is decoded once per key (normally a
+// Hash64 of its encoded bytes) and handed out as an immutable shared buffer, so every
+// event that plays it - on any thread - reuses the same samples. Two threads asking for
+// the same key at once decode it only once; the second waits for the first.
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// 16-bit PCM, channels interleaved.
+struct PcmBuffer {
+    uint32_t sample_rate = 0;
+    uint16_t channels = 0;
+    std::vector<int16_t> samples;
+
+    size_t frames() const { return channels ? samples.size() / channels : 0; }
+};
+
+using PcmPtr = std::shared_ptr<const PcmBuffer>;
+
+class PcmCache {
+public:
+    // Returns the buffer cached for 'key', or runs decode(PcmBuffer&) -> bool to make it.
+    // A failed decode yields nullptr and is remembered, so a bad source is tried once. If
+    // decode throws, the exception reaches this caller and the key is remembered as failed.
+    template <class Decode> PcmPtr get(uint64_t key, Decode&& decode) {
+        std::promise<PcmPtr> promise;
+        std::shared_future<PcmPtr> pending;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_entries.find(key);
+            if (it != m_entries.end()) { ++m_hits; pending = it->second; }
+            else { ++m_misses; m_entries.emplace(key, promise.get_future().share()); }
+        }
+        if (pending.valid()) return pending.get();
+
+        PcmPtr result;
+        try {
+            auto pcm = std::make_shared<PcmBuffer>();
+            if (decode(*pcm)) result = std::move(pcm);
+        }
+        catch (...) {
+            promise.set_value(nullptr);   // waiters and later lookups see a failed decode
+            throw;
+        }
+        if (result) { std::lock_guard<std::mutex> lock(m_mutex); m_bytes += result->samples.size() * sizeof(int16_t); }
+        promise.set_value(result);
+        return result;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear(); m_bytes = 0; m_hits = m_misses = 0;
+    }
+
+    size_t size() const { std::lock_guard<std::mutex> lock(m_mutex); return m_entries.size(); }
+    size_t bytes() const { std::lock_guard<std::mutex> lock(m_mutex); return m_bytes; }
+    size_t hits() const { std::lock_guard<std::mutex> lock(m_mutex); return m_hits; }
+    size_t misses() const { std::lock_guard<std::mutex> lock(m_mutex); return m_misses; }
+
+private:
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint64_t, std::shared_future<PcmPtr>> m_entries;
+    size_t m_bytes = 0, m_hits = 0, m_misses = 0;
+};
@@ -0,0 +1,262 @@
+#pragma once
+// PcmDiskCache.h
+// Content-addressed on-disk cache of decoded audio, shared by every tool on the machine.
+//
+// An entry is named by Key(header, payload) - a Hash64 of the encoded bytes, so renamed
+// or copied files still hit and an edited file simply misses. Each entry is one file:
+// a 32-byte little-endian header followed by the interleaved 16-bit samples, so a hit
+// is a hash plus a memory map. Entries are evicted least-recently-used once the folder
+// grows past its size cap; recency is the file's write time, refreshed on use.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Hash.h"
+#include "MappedFile.h"
+#include "PcmCache.h"
+
+// A cache hit, served straight from the mapped entry file.
+class CachedPcm {
+public:
+    uint32_t sample_rate() const { return m_rate; }
+    uint16_t channels() const { return m_channels; }
+    uint64_t frames() const { return m_frames; }
+    size_t sample_count() const { return static_cast<size_t>(m_frames * m_channels); }
+    const int16_t* samples() const { return reinterpret_cast<const int16_t*>(m_file.data() + HEADER_SIZE); }
+
+    void copy_to(PcmBuffer& out) const {
+        out.sample_rate = m_rate; out.channels = m_channels;
+        out.samples.assign(samples(), samples() + sample_count());
+    }
+
+    static constexpr size_t HEADER_SIZE = 32;
+
+private:
+    friend class PcmDiskCache;
+    MappedFile m_file;
+    uint32_t m_rate = 0;
+    uint16_t m_channels = 0;
+    uint64_t m_frames = 0;
+};
+
+class PcmDiskCache {
+public:
+    static constexpr uint64_t DEFAULT_CAP = 1ull << 30;   // 1 GiB
+    static constexpr uint32_t VERSION = 1;
+
+    // Key for an encoded sound: its header bytes (format, coefficients, ...) and its payload.
+    // Bump KEY_SEED when a decoder's output changes so stale entries stop matching.
+    static uint64_t Key(const void* header, size_t header_len, const void* payload, size_t payload_len) {
+        return Hash64(payload, payload_len, Hash64(header, header_len, KEY_SEED));
+    }
+
+    // %LOCALAPPDATA%\GladiusTools\PcmCache on Windows, $XDG_CACHE_HOME (or ~/.cache)/gladius-tools/pcm elsewhere.
+    static std::filesystem::path DefaultDir() {
+        std::error_code ec;
+#ifdef _WIN32
+        wchar_t base[MAX_PATH];
+        DWORD n = GetEnvironmentVariableW(L"LOCALAPPDATA", base, MAX_PATH);
+        if (n > 0 && n < MAX_PATH) return std::filesystem::path(base) / L"GladiusTools" / L"PcmCache";
+#else
+        if (const char* xdg = getenv("XDG_CACHE_HOME")) return std::filesystem::path(xdg) / "gladius-tools" / "pcm";
+        if (const char* home = getenv("HOME")) return std::filesystem::path(home) / ".cache" / "gladius-tools" / "pcm";
+#endif
+        return std::filesystem::temp_directory_path(ec) / "GladiusPcmCache";
+    }
+
+    // The per-process instance every decoder goes through, opened on first use.
+    static PcmDiskCache& Shared() {
+        static PcmDiskCache cache(DefaultDir());
+        return cache;
+    }
+
+    PcmDiskCache() = default;
+    explicit PcmDiskCache(const std::filesystem::path& dir, uint64_t cap = DEFAULT_CAP) { open(dir, cap); }
+    PcmDiskCache(const PcmDiskCache&) = delete;
+    PcmDiskCache& operator=(const PcmDiskCache&) = delete;
+
+    // Creates the folder if needed and indexes the entries already in it.
+    bool open(const std::filesystem::path& dir, uint64_t cap = DEFAULT_CAP) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dir = dir; m_cap = cap; m_entries.clear(); m_total = 0; m_ok = false;
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (!std::filesystem::is_directory(dir, ec)) return false;
+        for (auto it = std::filesystem::directory_iterator(dir, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+            uint64_t key;
+            if (!parse_name(it->path(), key)) continue;
+            Entry e;
+            e.bytes = it->file_size(ec); if (ec) { ec.clear(); continue; }
+            e.used = it->last_write_time(ec); if (ec) { ec.clear(); continue; }
+            m_entries[key] = e; m_total += e.bytes;
+        }
+        m_ok = true;
+        trim_locked();
+        return true;
+    }
+
+    bool is_open() const { return m_ok; }
+    uint64_t cap() const { return m_cap; }
+    uint64_t total_bytes() const { std::lock_guard<std::mutex> lock(m_mutex); return m_total; }
+    size_t entry_count() const { std::lock_guard<std::mutex> lock(m_mutex); return m_entries.size(); }
+
+    // Maps the entry for 'key'. False on a miss or a damaged entry (which is dropped).
+    // Entries written by another process since open() are picked up here too.
+    bool find(uint64_t key, CachedPcm& out) {
+        if (!m_ok) return false;
+        const std::filesystem::path path = path_for(key);
+        if (!out.m_file.open(path)) { forget(key, false); return false; }
+        if (!read_header(out, key)) { out.m_file.close(); forget(key, true); return false; }
+        touch(key, path, out.m_file.size());
+        return true;
+    }
+
+    // Stores decoded samples under 'key'. The entry is written to a temporary file and renamed
+    // into place, so readers never see a partial entry.
+    bool store(uint64_t key, uint32_t rate, uint16_t channels, const int16_t* samples, size_t count) {
+        if (!m_ok || channels == 0) return false;
+        uint8_t h[CachedPcm::HEADER_SIZE] = { 'G', 'P', 'C', 'M' };
+        const uint64_t frames = count / channels;
+        put(h + 4, VERSION, 4); put(h + 8, key, 8); put(h + 16, rate, 4); put(h + 20, channels, 2); put(h + 24, frames, 8);
+
+        const std::filesystem::path path = path_for(key);
+        std::filesystem::path tmp = path;
+        tmp += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+            static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count())) + ".tmp";
+        {
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            if (!f) return false;
+            f.write(reinterpret_cast<const char*>(h), sizeof(h));
+            f.write(reinterpret_cast<const char*>(samples), static_cast<std::streamsize>(frames * channels * sizeof(int16_t)));
+            if (!f) { f.close(); std::error_code ec; std::filesystem::remove(tmp, ec); return false; }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);   // atomic; fails harmlessly if the entry is in use
+        if (ec) { std::filesystem::remove(tmp, ec); return false; }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Entry& e = m_entries[key];
+        m_total -= e.bytes;
+        e.bytes = sizeof(h) + frames * channels * sizeof(int16_t);
+        e.used = std::filesystem::file_time_type::clock::now();
+        m_total += e.bytes;
+        trim_locked();
+        return true;
+    }
+
+    bool store(uint64_t key, const PcmBuffer& pcm) {
+        return store(key, pcm.sample_rate, pcm.channels, pcm.samples.data(), pcm.samples.size());
+    }
+
+    // Fills 'out' from the cache, or runs decode(PcmBuffer&) -> bool and caches its result.
+    template <class Decode> bool load_or_decode(uint64_t key, PcmBuffer& out, Decode&& decode) {
+        CachedPcm hit;
+        if (find(key, hit)) { hit.copy_to(out); return true; }
+        if (!decode(out)) return false;
+        store(key, out);
+        return true;
+    }
+
+private:
+    static constexpr uint64_t KEY_SEED = 0x47504D43'00000001ull;   // "GPCM" + decoder generation
+    static constexpr int64_t TOUCH_AFTER_SECONDS = 60;
+
+    struct Entry {
+        uint64_t bytes = 0;
+        std::filesystem::file_time_type used{};
+    };
+
+    static void put(uint8_t* p, uint64_t v, int n) { for (int i = 0; i < n; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i)); }
+    static uint64_t get(const uint8_t* p, int n) { uint64_t v = 0; for (int i = n - 1; i >= 0; --i) v = (v << 8) | p[i]; return v; }
+
+    std::filesystem::path path_for(uint64_t key) const {
+        char name[24];
+        snprintf(name, sizeof(name), "%016llx.pcm", static_cast<unsigned long long>(key));
+        return m_dir / name;
+    }
+
+    static bool parse_name(const std::filesystem::path& p, uint64_t& key) {
+        const std::string name = p.filename().string();
+        if (name.size() != 20 || name.compare(16, 4, ".pcm") != 0) return false;
+        key = 0;
+        for (int i = 0; i < 16; ++i) {
+            const char c = name[i];
+            const int d = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+            if (d < 0) return false;
+            key = (key << 4) | static_cast<uint64_t>(d);
+        }
+        return true;
+    }
+
+    static bool read_header(CachedPcm& c, uint64_t key) {
+        const uint8_t* h = c.m_file.data();
+        if (c.m_file.size() < CachedPcm::HEADER_SIZE || memcmp(h, "GPCM", 4) != 0) return false;
+        if (get(h + 4, 4) != VERSION || get(h + 8, 8) != key) return false;
+        c.m_rate = static_cast<uint32_t>(get(h + 16, 4));
+        c.m_channels = static_cast<uint16_t>(get(h + 20, 2));
+        c.m_frames = get(h + 24, 8);
+        return c.m_channels != 0 && c.m_file.size() == CachedPcm::HEADER_SIZE + c.m_frames * c.m_channels * sizeof(int16_t);
+    }
+
+    // Refreshes recency, at most once a minute per entry so hot hits stay syscall-free.
+    void touch(uint64_t key, const std::filesystem::path& path, uint64_t bytes) {
+        const auto now = std::filesystem::file_time_type::clock::now();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_entries.find(key);
+            if (it == m_entries.end()) { m_entries[key].bytes = bytes; m_total += bytes; it = m_entries.find(key); }
+            else if (now - it->second.used < std::chrono::seconds(TOUCH_AFTER_SECONDS)) return;
+            it->second.used = now;
+        }
+        std::error_code ec;
+        std::filesystem::last_write_time(path, now, ec);
+    }
+
+    void forget(uint64_t key, bool remove_file) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_entries.find(key);
+            if (it != m_entries.end()) { m_total -= it->second.bytes; m_entries.erase(it); }
+        }
+        std::error_code ec;
+        if (remove_file) std::filesystem::remove(path_for(key), ec);
+    }
+
+    // Drops the oldest entries until the folder is back under 90% of the cap.
+    void trim_locked() {
+        if (m_total <= m_cap) return;
+        std::vector<std::pair<std::filesystem::file_time_type, uint64_t>> order;
+        order.reserve(m_entries.size());
+        for (const auto& kv : m_entries) order.emplace_back(kv.second.used, kv.first);
+        std::sort(order.begin(), order.end());
+        const uint64_t target = m_cap / 10 * 9;
+        std::error_code ec;
+        for (const auto& o : order) {
+            if (m_total <= target) break;
+            std::filesystem::remove(path_for(o.second), ec);   // an entry mapped elsewhere stays until next open
+            auto it = m_entries.find(o.second);
+            m_total -= it->second.bytes;
+            m_entries.erase(it);
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    std::filesystem::path m_dir;
+    uint64_t m_cap = DEFAULT_CAP;
+    uint64_t m_total = 0;
+    bool m_ok = false;
+    std::unordered_map<uint64_t, Entry> m_entries;
+};
@@ -0,0 +1,139 @@
+#pragma once
+// PeakPyramid.h
+// Multi-resolution waveform summary of one channel: min / max / RMS per bucket of 256,
+// 4096 and 65536 samples. The builder is fed sample by sample from inside a decode loop
+// (a compare, a compare and a multiply-add per sample); coarser levels are folded from
+// finished 256-sample buckets, never from samples. A .peaks sidecar next to a decoded
+// file lets a UI draw any zoom level without decoding again.
+//
+// Sidecar layout (little-endian): "PEAK", u32 version, u32 sample_rate, u16 channels,
+// u16 level_count, u64 frames; then per channel, per level: u32 bucket_size, u32 count,
+// count x i16 min, count x i16 max, count x u16 rms.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+struct PeakLevel {
+    uint32_t bucket_size = 0;
+    std::vector<int16_t> min, max;
+    std::vector<uint16_t> rms;
+    size_t size() const { return min.size(); }
+};
+
+class PeakPyramid {
+public:
+    static constexpr int LEVELS = 3;
+    static constexpr uint32_t BUCKET[LEVELS] = { 256, 4096, 65536 };
+
+    PeakPyramid() { reset(); }
+
+    void reset() {
+        for (int l = 0; l < LEVELS; ++l) { m_levels[l] = PeakLevel(); m_levels[l].bucket_size = BUCKET[l]; m_acc[l] = Acc(); }
+        m_frames = 0;
+    }
+
+    // Per-sample hook for decode loops.
+    void add(int16_t s) {
+        Acc& a = m_acc[0];
+        if (s < a.lo) a.lo = s;
+        if (s > a.hi) a.hi = s;
+        a.sq += static_cast<int64_t>(s) * s;
+        if (++a.n == BUCKET[0]) close(0);
+    }
+
+    // Channel 'channel' of an interleaved buffer.
+    void add(const int16_t* samples, size_t frames, unsigned channels = 1, unsigned channel = 0) {
+        for (size_t i = 0; i < frames; ++i) add(samples[i * channels + channel]);
+    }
+
+    // Flushes the partial buckets at the end of the stream.
+    void finish() {
+        for (int l = 0; l < LEVELS; ++l) if (m_acc[l].n) close(l);
+    }
+
+    const PeakLevel& level(int l) const { return m_levels[l]; }
+    uint64_t frames() const { return m_frames; }
+
+private:
+    struct Acc {
+        int16_t lo = 32767, hi = -32768;
+        int64_t sq = 0;
+        uint32_t n = 0;    // samples folded in so far
+    };
+
+    void close(int l) {
+        Acc& a = m_acc[l];
+        PeakLevel& out = m_levels[l];
+        out.min.push_back(a.lo); out.max.push_back(a.hi);
+        out.rms.push_back(static_cast<uint16_t>(std::lround(std::sqrt(static_cast<double>(a.sq) / a.n))));
+        if (l == 0) m_frames += a.n;
+        if (l + 1 < LEVELS) {
+            Acc& up = m_acc[l + 1];
+            if (a.lo < up.lo) up.lo = a.lo;
+            if (a.hi > up.hi) up.hi = a.hi;
+            up.sq += a.sq; up.n += a.n;
+            if (up.n == BUCKET[l + 1]) close(l + 1);
+        }
+        a = Acc();
+    }
+
+    PeakLevel m_levels[LEVELS];
+    Acc m_acc[LEVELS];
+    uint64_t m_frames = 0;
+};
+
+inline std::filesystem::path PeakSidecarPath(const std::filesystem::path& output) {
+    std::filesystem::path p = output;
+    p.replace_extension(".peaks");
+    return p;
+}
+
+// One pyramid per channel, all finished.
+inline bool WritePeakSidecar(const std::filesystem::path& path, const std::vector<PeakPyramid>& channels, uint32_t sample_rate) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f || channels.empty()) return false;
+    auto put = [&f](uint64_t v, int n) { for (int i = 0; i < n; ++i) f.put(static_cast<char>(v >> (8 * i))); };
+    auto put_array = [&f](const void* p, size_t bytes) { f.write(static_cast<const char*>(p), static_cast<std::streamsize>(bytes)); };   // little-endian hosts
+    f.write("PEAK", 4);
+    put(1, 4); put(sample_rate, 4); put(channels.size(), 2); put(PeakPyramid::LEVELS, 2); put(channels[0].frames(), 8);
+    for (const PeakPyramid& c : channels) {
+        for (int l = 0; l < PeakPyramid::LEVELS; ++l) {
+            const PeakLevel& lv = c.level(l);
+            put(lv.bucket_size, 4); put(lv.size(), 4);
+            put_array(lv.min.data(), lv.size() * 2); put_array(lv.max.data(), lv.size() * 2); put_array(lv.rms.data(), lv.size() * 2);
+        }
+    }
+    return static_cast<bool>(f);
+}
+
+// Reads a sidecar back: out[channel][level].
+inline bool ReadPeakSidecar(const std::filesystem::path& path, std::vector<std::vector<PeakLevel>>& out, uint32_t& sample_rate, uint64_t& frames) {
+    out.clear();
+    std::ifstream f(path, std::ios::binary);
+    char magic[4];
+    if (!f.read(magic, 4) || memcmp(magic, "PEAK", 4) != 0) return false;
+    auto get = [&f](int n) { uint64_t v = 0; for (int i = 0; i < n; ++i) v |= static_cast<uint64_t>(static_cast<uint8_t>(f.get())) << (8 * i); return v; };
+    auto get_array = [&f](void* p, size_t bytes) { f.read(static_cast<char*>(p), static_cast<std::streamsize>(bytes)); };
+    if (get(4) != 1) return false;
+    sample_rate = static_cast<uint32_t>(get(4));
+    const size_t channels = static_cast<size_t>(get(2)), levels = static_cast<size_t>(get(2));
+    frames = get(8);
+    if (!f || channels == 0 || levels > 16) return false;
+    out.resize(channels, std::vector<PeakLevel>(levels));
+    for (auto& c : out) {
+        for (PeakLevel& lv : c) {
+            lv.bucket_size = static_cast<uint32_t>(get(4));
+            const size_t n = static_cast<size_t>(get(4));
+            if (!f || n > frames + 1) { out.clear(); return false; }
+            lv.min.resize(n); lv.max.resize(n); lv.rms.resize(n);
+            get_array(lv.min.data(), n * 2); get_array(lv.max.data(), n * 2); get_array(lv.rms.data(), n * 2);
+        }
+    }
+    if (!f) { out.clear(); return false; }
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+// ProcessStats.h
+// Process-wide resource figures for batch summaries: peak and current resident memory
+// (working set on Windows). Zero when the platform does not report a figure.
+
+#include <cstdint>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "Psapi.lib")
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+inline uint64_t PeakRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc{};
+    return GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)) ? static_cast<uint64_t>(pmc.PeakWorkingSetSize) : 0;
+#else
+    struct rusage ru {};
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<uint64_t>(ru.ru_maxrss);           // bytes
+#else
+    return static_cast<uint64_t>(ru.ru_maxrss) * 1024;    // KiB
+#endif
+#endif
+}
+
+inline uint64_t CurrentRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc{};
+    return GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)) ? static_cast<uint64_t>(pmc.WorkingSetSize) : 0;
+#elif defined(__linux__)
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long long pages = 0, resident = 0;
+    const bool ok = fscanf(f, "%llu %llu", &pages, &resident) == 2;
+    fclose(f);
+    return ok ? resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,154 @@
+#pragma once
+// Resampler.h
+// Polyphase windowed-sinc sample-rate converter for mono 16-bit streams. The ratio is
+// reduced to L/M (e.g. 44100 -> 32000 is 320/441); output sample k sits at input position
+// k * M / L, and its L-phase filter row is a Kaiser-windowed sinc cut off just below the
+// lower of the two Nyquist rates. Each output is one dot product over the row, 4 taps per
+// step with SSE2 (scalar elsewhere). Input can be pushed in blocks of any size, so a
+// reader can feed an encoder without the resampled signal ever being stored in full.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "Mixer.h"
+#include "Trace.h"
+
+enum class ResampleQuality { Fast, Balanced, Best };
+
+struct ResamplePreset {
+    int taps;        // filter length at unity ratio (grows when downsampling)
+    double cutoff;   // passband edge as a fraction of the lower Nyquist rate
+    double beta;     // Kaiser window shape: higher = more stopband rejection
+};
+
+inline ResamplePreset GetResamplePreset(ResampleQuality q) {
+    switch (q) {
+    case ResampleQuality::Fast: return { 8, 0.85, 5.0 };
+    case ResampleQuality::Balanced: return { 24, 0.92, 7.5 };
+    default: return { 64, 0.96, 10.0 };
+    }
+}
+
+class PolyphaseResampler {
+public:
+    static constexpr uint32_t MAX_PHASES = 4096;   // finer ratios share the nearest row
+
+    PolyphaseResampler(uint32_t src_rate, uint32_t dst_rate, ResampleQuality quality = ResampleQuality::Balanced) {
+        const uint32_t g = std::gcd(src_rate, dst_rate);
+        m_up = dst_rate / g; m_down = src_rate / g;
+        m_phases = (std::min)(m_up, MAX_PHASES);
+        const ResamplePreset p = GetResamplePreset(quality);
+        const double scale = (std::min)(1.0, static_cast<double>(m_up) / m_down);   // < 1 when downsampling
+        m_taps = (static_cast<int>(std::ceil(p.taps / scale)) + 3) & ~3;
+        const double fc = p.cutoff * scale, half = m_taps / 2.0;
+        m_table.assign(static_cast<size_t>(m_phases) * m_taps, 0.0f);
+        for (uint32_t ph = 0; ph < m_phases; ++ph) {
+            const double frac = static_cast<double>(ph) / m_phases;
+            float* row = &m_table[static_cast<size_t>(ph) * m_taps];
+            double sum = 0;
+            for (int j = 0; j < m_taps; ++j) {
+                const double d = half - 1 + frac - j;              // distance from the output point, in input samples
+                const double x = d / half;
+                const double w = std::fabs(x) >= 1 ? 0 : bessel_i0(p.beta * std::sqrt(1 - x * x)) / bessel_i0(p.beta);
+                const double s = d == 0 ? 1 : std::sin(M_PI_VALUE * fc * d) / (M_PI_VALUE * fc * d);
+                row[j] = static_cast<float>(fc * s * w);
+                sum += row[j];
+            }
+            for (int j = 0; j < m_taps; ++j) row[j] = static_cast<float>(row[j] / sum);   // unity DC gain per phase
+        }
+        m_buf.assign(m_taps / 2 - 1, 0.0f);                         // so output 0 lines up with input 0
+    }
+
+    uint32_t up() const { return m_up; }
+    uint32_t down() const { return m_down; }
+    int taps() const { return m_taps; }
+
+    // Output length for 'frames' input samples.
+    static uint64_t OutputLength(uint64_t frames, uint32_t src_rate, uint32_t dst_rate) {
+        return (frames * dst_rate + src_rate - 1) / src_rate;
+    }
+
+    // Pushes 'n' samples and appends every output sample they complete.
+    void process(const int16_t* in, size_t n, std::vector<int16_t>& out) {
+        const size_t at = m_buf.size();
+        m_buf.resize(at + n);
+        for (size_t i = 0; i < n; ++i) m_buf[at + i] = in[i];
+        m_in += n;
+        run(out, m_in);
+    }
+
+    // Drains the filter tail: the total output is OutputLength(pushed samples).
+    void flush(std::vector<int16_t>& out) {
+        m_buf.resize(m_buf.size() + m_taps, 0.0f);
+        run(out, m_in);
+    }
+
+private:
+    static constexpr double M_PI_VALUE = 3.14159265358979323846;
+
+    static double bessel_i0(double x) {
+        double sum = 1, term = 1;
+        for (int k = 1; k < 50 && term > 1e-12 * sum; ++k) { term *= (x / (2 * k)) * (x / (2 * k)); sum += term; }
+        return sum;
+    }
+
+    static float dot(const float* a, const float* b, int n) {
+        int i = 0;
+        float total = 0;
+#ifdef MIXER_SSE2
+        __m128 acc = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4) acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+        total = _mm_cvtss_f32(acc);
+#endif
+        for (; i < n; ++i) total += a[i] * b[i];
+        return total;
+    }
+
+    // Emits outputs whose window fits in the buffer, up to OutputLength(input_total).
+    void run(std::vector<int16_t>& out, uint64_t input_total) {
+        const uint64_t limit = OutputLength(input_total, m_down, m_up);
+        float block[256];
+        int filled = 0;
+        auto emit = [&] { const size_t at = out.size(); out.resize(at + filled); BusToPcm16(block, out.data() + at, filled); filled = 0; };
+        for (; m_out < limit; ++m_out) {
+            const uint64_t pos = m_out * m_down;                     // in 1/L input samples
+            const uint64_t base = pos / m_up - m_dropped;            // window start in m_buf
+            if (base + m_taps > m_buf.size()) break;
+            const uint32_t phase = static_cast<uint32_t>((pos % m_up) * m_phases / m_up);
+            block[filled++] = dot(&m_table[static_cast<size_t>(phase) * m_taps], &m_buf[base], m_taps);
+            if (filled == 256) emit();
+        }
+        if (filled) emit();
+        // Drop input no later output can reach.
+        const uint64_t keep_from = (m_out * m_down) / m_up - m_dropped;
+        if (keep_from > 4096 && keep_from <= m_buf.size()) {
+            m_buf.erase(m_buf.begin(), m_buf.begin() + static_cast<ptrdiff_t>(keep_from));
+            m_dropped += keep_from;
+        }
+    }
+
+    uint32_t m_up = 1, m_down = 1, m_phases = 1;
+    int m_taps = 4;
+    std::vector<float> m_table;
+    std::vector<float> m_buf;      // input window, starting at input sample m_dropped - (taps/2 - 1)
+    uint64_t m_dropped = 0, m_in = 0, m_out = 0;
+};
+
+// Whole-buffer convenience: 'in' at src_rate -> returned at dst_rate.
+inline std::vector<int16_t> Resample(const int16_t* in, size_t n, uint32_t src_rate, uint32_t dst_rate, ResampleQuality quality = ResampleQuality::Balanced) {
+    TRACE_SCOPE_CAT("Resample", "codec");
+    std::vector<int16_t> out;
+    if (src_rate == dst_rate || src_rate == 0 || dst_rate == 0) { out.assign(in, in + n); return out; }
+    PolyphaseResampler r(src_rate, dst_rate, quality);
+    out.reserve(static_cast<size_t>(PolyphaseResampler::OutputLength(n, src_rate, dst_rate)));
+    const size_t block = 16384;
+    for (size_t i = 0; i < n; i += block) r.process(in + i, (std::min)(block, n - i), out);
+    r.flush(out);
+    return out;
+}
@@ -0,0 +1,97 @@
+#pragma once
+// Riff.h
+// Zero-copy RIFF chunk walker over an in-memory or mapped span. Each step reads one
+// 8-byte chunk header and jumps over the body (padded to even size), so finding a chunk
+// costs O(chunks), not O(bytes), and never matches a FourCC inside another chunk's data.
+//
+// Bounds are taken from the span, not from the RIFF size field: XBB entry headers and
+// truncated files carry stale sizes. A chunk that runs past the end of the span is still
+// returned (it is always the last one) with 'avail' cut to the bytes that are present,
+// which is how an XBB header ends on a data chunk whose audio lives in the XSB.
+// RF64 files are read through their ds64 chunk.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+struct RiffChunk {
+    const uint8_t* header = nullptr;   // the chunk's FourCC
+    const uint8_t* data = nullptr;     // first body byte
+    uint64_t size = 0;                 // declared body size (ds64-resolved for RF64)
+    size_t avail = 0;                  // body bytes present in the span, <= size
+    size_t offset = 0;                 // of 'header' from the start of the span
+
+    bool is(const char fourcc[4]) const { return header && memcmp(header, fourcc, 4) == 0; }
+    bool complete() const { return avail == size; }
+    // Offset one past the chunk header, i.e. where the body starts.
+    size_t data_offset() const { return offset + 8; }
+};
+
+class RiffReader {
+public:
+    RiffReader(const uint8_t* data, size_t len) : m_data(data), m_len(len) {
+        if (!data || len < 12) return;
+        m_rf64 = memcmp(data, "RF64", 4) == 0;
+        if (!m_rf64 && memcmp(data, "RIFF", 4) != 0) return;
+        memcpy(m_form, data + 8, 4);
+        m_valid = true;
+        if (m_rf64) {
+            RiffChunk c;
+            if (next_at(12, c) && c.is("ds64") && c.avail >= 24) m_ds64_data = le64(c.data + 8);
+        }
+    }
+
+    bool valid() const { return m_valid; }
+    bool rf64() const { return m_rf64; }
+    bool form_is(const char fourcc[4]) const { return m_valid && memcmp(m_form, fourcc, 4) == 0; }
+
+    // Chunk after 'prev' (or the first chunk when prev.header is null). False at the end.
+    bool next(RiffChunk& c) const {
+        if (!m_valid) return false;
+        if (!c.header) return next_at(12, c);
+        if (!c.complete()) return false;
+        return next_at(c.data_offset() + static_cast<size_t>(c.size) + static_cast<size_t>(c.size & 1), c);
+    }
+
+    // First chunk with this FourCC.
+    bool find(const char fourcc[4], RiffChunk& out) const {
+        RiffChunk c;
+        while (next(c)) if (c.is(fourcc)) { out = c; return true; }
+        return false;
+    }
+
+private:
+    static uint32_t le32(const uint8_t* p) { return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24); }
+    static uint64_t le64(const uint8_t* p) { return le32(p) | (static_cast<uint64_t>(le32(p + 4)) << 32); }
+
+    bool next_at(size_t pos, RiffChunk& c) const {
+        if (pos > m_len || m_len - pos < 8) return false;
+        c.header = m_data + pos;
+        c.offset = pos;
+        c.data = c.header + 8;
+        c.size = le32(c.header + 4);
+        if (m_rf64 && c.size == 0xFFFFFFFFu && c.is("data") && m_ds64_data) c.size = m_ds64_data;
+        const size_t left = m_len - pos - 8;
+        c.avail = c.size < left ? static_cast<size_t>(c.size) : left;
+        return true;
+    }
+
+    const uint8_t* m_data;
+    size_t m_len;
+    char m_form[4] = {};
+    bool m_valid = false, m_rf64 = false;
+    uint64_t m_ds64_data = 0;
+};
+
+// Rewrites a RIFF image's data-chunk size in place and sets the RIFF size to cover the
+// image. False when there is no data chunk header inside the span.
+inline bool RiffPatchDataSize(uint8_t* riff, size_t len, uint32_t data_len) {
+    RiffReader r(riff, len);
+    RiffChunk data;
+    if (!r.valid() || r.rf64() || !r.find("data", data)) return false;
+    uint8_t* p = riff + data.offset + 4;
+    p[0] = uint8_t(data_len); p[1] = uint8_t(data_len >> 8); p[2] = uint8_t(data_len >> 16); p[3] = uint8_t(data_len >> 24);
+    const uint32_t riff_size = static_cast<uint32_t>(len - 8);
+    riff[4] = uint8_t(riff_size); riff[5] = uint8_t(riff_size >> 8); riff[6] = uint8_t(riff_size >> 16); riff[7] = uint8_t(riff_size >> 24);
+    return true;
+}
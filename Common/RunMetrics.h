@@ -0,0 +1,285 @@
+#pragma once
+// RunMetrics.h
+// Machine-readable summary of one batch run, written as JSON next to the batch output:
+// files and bytes in/out, samples/sec, per-file latency percentiles (p50/p95/p99), time
+// per stage, peak RSS, thread utilisation and failures per error class.
+//
+// A RunFile times one unit of work (a file, a bank, a rendered row) on the calling
+// thread; RunStageTimer adds the time of one stage to the RunFile active on that thread
+// (or to an explicit run). Each thread counts into its own slot - found through a
+// thread_local cache, created under a lock only the first time a thread joins a run -
+// so the per-file path takes no locks and touches no shared cache lines. Latencies go
+// into a log-linear histogram (8 buckets per power of two, within 12.5%), so
+// percentiles cost nothing per file and need no stored samples.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "JsonWriter.h"
+#include "ProcessStats.h"
+
+enum class RunStage { Walk, Read, Parse, Decode, Encode, Resample, Mix, Write, Count };
+enum class RunError { None, Open, Format, Decode, Encode, Write, Other, Count };
+
+inline const char* RunStageName(RunStage s) {
+    switch (s) {
+    case RunStage::Walk: return "walk";
+    case RunStage::Read: return "read";
+    case RunStage::Parse: return "parse";
+    case RunStage::Decode: return "decode";
+    case RunStage::Encode: return "encode";
+    case RunStage::Resample: return "resample";
+    case RunStage::Mix: return "mix";
+    case RunStage::Write: return "write";
+    default: return "?";
+    }
+}
+
+inline const char* RunErrorName(RunError e) {
+    switch (e) {
+    case RunError::None: return "none";
+    case RunError::Open: return "open";
+    case RunError::Format: return "format";
+    case RunError::Decode: return "decode";
+    case RunError::Encode: return "encode";
+    case RunError::Write: return "write";
+    case RunError::Other: return "other";
+    default: return "?";
+    }
+}
+
+namespace metrics_detail {
+constexpr size_t STAGES = static_cast<size_t>(RunStage::Count);
+constexpr size_t ERRORS = static_cast<size_t>(RunError::Count);
+constexpr size_t BUCKETS = 8 + 61 * 8;   // 0..7 exact, then 8 per octave up to 2^64 ns
+
+inline uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline size_t Bucket(uint64_t ns) {
+    if (ns < 8) return static_cast<size_t>(ns);
+    unsigned e = 0;
+    for (uint64_t v = ns; v >>= 1;) ++e;
+    return (e - 2) * 8 + static_cast<size_t>((ns >> (e - 3)) & 7);
+}
+inline uint64_t BucketLow(size_t b) {
+    if (b < 8) return b;
+    const unsigned e = static_cast<unsigned>(b / 8) + 2;
+    return (8 + b % 8) << (e - 3);
+}
+inline uint64_t BucketWidth(size_t b) { return b < 8 ? 1 : uint64_t(1) << (b / 8 - 1); }
+
+// Single-writer counter: only the owning thread adds, the summary reads.
+struct Counter {
+    std::atomic<uint64_t> v{ 0 };
+    void add(uint64_t n) { v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    void raise(uint64_t n) { if (n > get()) v.store(n, std::memory_order_relaxed); }
+    uint64_t get() const { return v.load(std::memory_order_relaxed); }
+};
+
+struct alignas(64) Slot {
+    std::thread::id thread;
+    Counter files, failed, bytes_in, bytes_out, samples, busy_ns, latency_max;
+    Counter stage_ns[STAGES], stage_calls[STAGES], errors[ERRORS];
+    Counter latency[BUCKETS];
+};
+
+inline uint64_t NextRunId() { static std::atomic<uint64_t> id{ 0 }; return id.fetch_add(1, std::memory_order_relaxed) + 1; }
+} // namespace metrics_detail
+
+// Totals over every thread of a run.
+struct RunTotals {
+    uint64_t files = 0, failed = 0, bytes_in = 0, bytes_out = 0, samples = 0, busy_ns = 0, latency_max_ns = 0;
+    uint64_t stage_ns[metrics_detail::STAGES] = {}, stage_calls[metrics_detail::STAGES] = {};
+    uint64_t errors[metrics_detail::ERRORS] = {};
+    std::vector<uint64_t> latency = std::vector<uint64_t>(metrics_detail::BUCKETS);
+    std::vector<uint64_t> thread_busy_ns;
+
+    // Per-file latency at quantile q (0..1): the middle of the bucket holding it.
+    uint64_t percentile_ns(double q) const {
+        uint64_t total = 0;
+        for (uint64_t c : latency) total += c;
+        if (!total) return 0;
+        const uint64_t rank = (std::max)(uint64_t(1), static_cast<uint64_t>(q * static_cast<double>(total) + 0.999999));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < latency.size(); ++b) {
+            seen += latency[b];
+            if (seen >= rank) return (std::min)(metrics_detail::BucketLow(b) + metrics_detail::BucketWidth(b) / 2, latency_max_ns);
+        }
+        return latency_max_ns;
+    }
+};
+
+class RunMetrics {
+public:
+    RunMetrics(std::string tool, std::string operation)
+        : m_tool(std::move(tool)), m_operation(std::move(operation)), m_id(metrics_detail::NextRunId()), m_start_ns(metrics_detail::NowNs()) {}
+    RunMetrics(const RunMetrics&) = delete;
+    RunMetrics& operator=(const RunMetrics&) = delete;
+
+    // Marks the end of the run; the summary uses the wall time up to here (or up to now).
+    void finish() { m_end_ns = metrics_detail::NowNs(); }
+    double seconds() const { return ((m_end_ns ? m_end_ns : metrics_detail::NowNs()) - m_start_ns) / 1e9; }
+
+    // <dir>\run_metrics_<operation>.json, so the passes of one batch each keep their own file.
+    std::filesystem::path json_path(const std::filesystem::path& dir) const { return dir / ("run_metrics_" + m_operation + ".json"); }
+
+    // The calling thread's counters for this run.
+    metrics_detail::Slot& local() {
+        struct Cache { uint64_t run = 0; metrics_detail::Slot* slot = nullptr; };
+        thread_local Cache cache;
+        if (cache.run == m_id) return *cache.slot;
+        std::lock_guard<std::mutex> lock(m_lock);
+        const std::thread::id self = std::this_thread::get_id();
+        metrics_detail::Slot* slot = nullptr;
+        for (auto& s : m_slots) if (s->thread == self) slot = s.get();
+        if (!slot) {
+            m_slots.push_back(std::make_unique<metrics_detail::Slot>());
+            slot = m_slots.back().get();
+            slot->thread = self;
+        }
+        cache = { m_id, slot };
+        return *slot;
+    }
+
+    RunTotals totals() const {
+        RunTotals t;
+        std::lock_guard<std::mutex> lock(m_lock);
+        for (const auto& s : m_slots) {
+            t.files += s->files.get(); t.failed += s->failed.get();
+            t.bytes_in += s->bytes_in.get(); t.bytes_out += s->bytes_out.get(); t.samples += s->samples.get();
+            t.busy_ns += s->busy_ns.get(); t.latency_max_ns = (std::max)(t.latency_max_ns, s->latency_max.get());
+            for (size_t i = 0; i < metrics_detail::STAGES; ++i) { t.stage_ns[i] += s->stage_ns[i].get(); t.stage_calls[i] += s->stage_calls[i].get(); }
+            for (size_t i = 0; i < metrics_detail::ERRORS; ++i) t.errors[i] += s->errors[i].get();
+            for (size_t i = 0; i < metrics_detail::BUCKETS; ++i) t.latency[i] += s->latency[i].get();
+            if (s->files.get()) t.thread_busy_ns.push_back(s->busy_ns.get());   // threads that ran files
+        }
+        return t;
+    }
+
+    bool write_json(const std::filesystem::path& path) const {
+        const RunTotals t = totals();
+        const double secs = seconds();
+        const double per_sec = secs > 0 ? 1.0 / secs : 0.0;
+        const auto ms = [](uint64_t ns) { return ns / 1e6; };
+        JsonWriter j;
+        j.begin_object();
+        j.field("tool", m_tool).field("operation", m_operation).field("wall_seconds", secs);
+        j.key("files").begin_object().field("total", t.files).field("ok", t.files - t.failed).field("failed", t.failed).end_object();
+        j.key("bytes").begin_object().field("in", t.bytes_in).field("out", t.bytes_out).end_object();
+        j.key("throughput").begin_object();
+        j.field("files_per_sec", t.files * per_sec).field("bytes_in_per_sec", t.bytes_in * per_sec).field("bytes_out_per_sec", t.bytes_out * per_sec);
+        j.field("samples", t.samples).field("samples_per_sec", t.samples * per_sec);
+        j.end_object();
+        j.key("latency_ms").begin_object();
+        j.field("mean", t.files ? ms(t.busy_ns) / t.files : 0.0);
+        j.field("p50", ms(t.percentile_ns(0.50))).field("p95", ms(t.percentile_ns(0.95))).field("p99", ms(t.percentile_ns(0.99)));
+        j.field("max", ms(t.latency_max_ns));
+        j.end_object();
+        j.key("stages").begin_object();
+        for (size_t i = 0; i < metrics_detail::STAGES; ++i) {
+            if (!t.stage_calls[i]) continue;
+            j.key(RunStageName(static_cast<RunStage>(i))).begin_object().field("ms", ms(t.stage_ns[i])).field("calls", t.stage_calls[i]).end_object();
+        }
+        j.end_object();
+        j.key("errors").begin_object();
+        for (size_t i = 1; i < metrics_detail::ERRORS; ++i) j.field(RunErrorName(static_cast<RunError>(i)), t.errors[i]);
+        j.end_object();
+        j.key("memory").begin_object().field("peak_rss_bytes", PeakRssBytes()).end_object();
+        const double wall_ns = secs * 1e9;
+        j.key("threads").begin_object();
+        j.field("count", t.thread_busy_ns.size());
+        j.field("utilization", wall_ns > 0 && !t.thread_busy_ns.empty() ? t.busy_ns / (wall_ns * t.thread_busy_ns.size()) : 0.0);
+        j.key("busy_ms").begin_array();
+        for (uint64_t b : t.thread_busy_ns) j.value(ms(b));
+        j.end_array();
+        j.end_object();
+        j.end_object();
+        return j.save(path);
+    }
+
+private:
+    std::string m_tool, m_operation;
+    uint64_t m_id;
+    uint64_t m_start_ns, m_end_ns = 0;
+    mutable std::mutex m_lock;   // guards m_slots: first use per thread, and the summary
+    std::vector<std::unique_ptr<metrics_detail::Slot>> m_slots;
+};
+
+// One unit of work of a run, timed from construction to destruction on the calling thread.
+// A file counts as failed once fail() is called; the first error class given sticks.
+class RunFile {
+public:
+    explicit RunFile(RunMetrics& run) : m_slot(run.local()), m_prev(Active()), m_start(metrics_detail::NowNs()) { Active() = this; }
+    ~RunFile() {
+        const uint64_t ns = metrics_detail::NowNs() - m_start;
+        m_slot.files.add(1);
+        m_slot.busy_ns.add(ns);
+        m_slot.latency[metrics_detail::Bucket(ns)].add(1);
+        m_slot.latency_max.raise(ns);
+        if (m_error != RunError::None) {
+            m_slot.failed.add(1);
+            m_slot.errors[static_cast<size_t>(m_error)].add(1);
+        }
+        Active() = m_prev;
+    }
+    RunFile(const RunFile&) = delete;
+    RunFile& operator=(const RunFile&) = delete;
+
+    void bytes_in(uint64_t n) { m_slot.bytes_in.add(n); }
+    void bytes_out(uint64_t n) { m_slot.bytes_out.add(n); }
+    void samples(uint64_t n) { m_slot.samples.add(n); }
+    void fail(RunError e = RunError::Other) { if (m_error == RunError::None) m_error = e == RunError::None ? RunError::Other : e; }
+    bool failed() const { return m_error != RunError::None; }
+
+    void add_stage(RunStage s, uint64_t ns) { AddStage(m_slot, s, ns); }
+    static void AddStage(metrics_detail::Slot& slot, RunStage s, uint64_t ns) {
+        slot.stage_ns[static_cast<size_t>(s)].add(ns);
+        slot.stage_calls[static_cast<size_t>(s)].add(1);
+    }
+
+    // The RunFile open on this thread, if any.
+    static RunFile* Current() { return Active(); }
+
+private:
+    static RunFile*& Active() { thread_local RunFile* active = nullptr; return active; }
+
+    metrics_detail::Slot& m_slot;
+    RunFile* m_prev;
+    uint64_t m_start;
+    RunError m_error = RunError::None;
+};
+
+// Time spent in one stage, added to the current RunFile of this thread (nothing when no
+// file is open) or to the given run directly.
+class RunStageTimer {
+public:
+    explicit RunStageTimer(RunStage stage) : m_stage(stage), m_file(RunFile::Current()), m_start(m_file ? metrics_detail::NowNs() : 0) {}
+    RunStageTimer(RunMetrics& run, RunStage stage) : m_stage(stage), m_slot(&run.local()), m_start(metrics_detail::NowNs()) {}
+    ~RunStageTimer() {
+        if (m_file) m_file->add_stage(m_stage, metrics_detail::NowNs() - m_start);
+        else if (m_slot) RunFile::AddStage(*m_slot, m_stage, metrics_detail::NowNs() - m_start);
+    }
+    RunStageTimer(const RunStageTimer&) = delete;
+    RunStageTimer& operator=(const RunStageTimer&) = delete;
+
+private:
+    RunStage m_stage;
+    RunFile* m_file = nullptr;
+    metrics_detail::Slot* m_slot = nullptr;
+    uint64_t m_start;
+};
+
+// Error class / sample count for the file being processed on this thread, from code that
+// does not hold the RunFile itself.
+inline void RunFail(RunError e) { if (RunFile* f = RunFile::Current()) f->fail(e); }
+inline void RunSamples(uint64_t n) { if (RunFile* f = RunFile::Current()) f->samples(n); }
@@ -0,0 +1,276 @@
+#pragma once
+// SoundArchive.h
+// One read-only view over the sound banks the tools handle:
+//   DSH / D2H - name + DSP header(s) per entry; the audio is the named .dsp / .ds2 file
+//               next to the bank
+//   SPT / SPD - entry table in the SPT, ADPCM in the SPD; an entry reads as a DSP file
+//   XBB / XSB - RIFF header per entry, audio inline in the XBB or in the XSB; an entry
+//               reads as a WAV file (the bytes BatchExtractAll writes)
+//
+// open() only maps the files. The entry table is walked on the first entries() call and
+// holds pointers into the mappings, so iterating it copies nothing. open_entry() returns
+// an ArchiveStream of at most two spans - a header (rebuilt for SPT and XBB) and the
+// payload view - so reading one sound touches that sound's bytes and nothing else.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BeLayout.h"
+#include "DspContainer.h"
+#include "MappedFile.h"
+#include "Riff.h"
+#include "Trace.h"
+
+enum class ArchiveKind { None, Dsh, D2h, Spt, Xbb };
+
+// Zero-copy description of one entry. Pointers stay valid while the archive is open.
+struct ArchiveEntry {
+    uint32_t index = 0;
+    std::string_view name;              // DSH/D2H: stored file name, else empty
+    const uint8_t* header = nullptr;    // stored header: DSP header(s) / RIFF header / rebuilt SPT DSP header
+    uint32_t header_len = 0;
+    const uint8_t* data = nullptr;      // payload inside the bank's mappings (SPT/XBB); null for DSH/D2H
+    uint32_t data_len = 0;
+    bool inline_data = false;           // XBB: audio sits inside the XBB entry itself
+};
+
+// Sequential reader over an entry: head() then body(), both views.
+class ArchiveStream {
+public:
+    uint64_t size() const { return head_size() + m_body_len; }
+    uint64_t tell() const { return m_pos; }
+    bool seek(uint64_t pos) { if (pos > size()) return false; m_pos = pos; return true; }
+
+    // Copies up to 'n' bytes from the cursor; returns how many.
+    size_t read(void* dst, size_t n) {
+        uint8_t* out = static_cast<uint8_t*>(dst);
+        size_t done = 0;
+        const uint64_t hs = head_size();
+        if (m_pos < hs) {
+            const size_t k = static_cast<size_t>((std::min)(static_cast<uint64_t>(n), hs - m_pos));
+            memcpy(out, head_data() + m_pos, k);
+            done += k; m_pos += k;
+        }
+        if (done < n && m_pos >= hs && m_pos < size()) {
+            const size_t k = static_cast<size_t>((std::min)(static_cast<uint64_t>(n - done), size() - m_pos));
+            memcpy(out + done, m_body + (m_pos - hs), k);
+            done += k; m_pos += k;
+        }
+        return done;
+    }
+
+    std::string_view head() const { return { reinterpret_cast<const char*>(head_data()), static_cast<size_t>(head_size()) }; }
+    std::string_view body() const { return { reinterpret_cast<const char*>(m_body), m_body_len }; }
+
+private:
+    friend class SoundArchive;
+    void reset() {
+        m_head = nullptr; m_head_len = 0; m_owned.clear();
+        m_body = nullptr; m_body_len = 0; m_file.reset(); m_pos = 0;
+    }
+    const uint8_t* head_data() const { return m_owned.empty() ? m_head : m_owned.data(); }
+    uint64_t head_size() const { return m_owned.empty() ? m_head_len : m_owned.size(); }
+
+    const uint8_t* m_head = nullptr;
+    size_t m_head_len = 0;
+    std::vector<uint8_t> m_owned;                // rebuilt header (XBB)
+    const uint8_t* m_body = nullptr;
+    size_t m_body_len = 0;
+    std::shared_ptr<const MappedFile> m_file;    // DSH/D2H: the entry's own file
+    uint64_t m_pos = 0;
+};
+
+class SoundArchive {
+public:
+    // Kind from the extension; the companion (.spd / .xsb) defaults to the same stem.
+    bool open(const std::filesystem::path& bank, const std::filesystem::path& companion = {}) {
+        close();
+        std::wstring ext = bank.extension().wstring();
+        for (auto& c : ext) if (c >= L'A' && c <= L'Z') c = static_cast<wchar_t>(c - L'A' + L'a');
+        if (ext == L".dsh") m_kind = ArchiveKind::Dsh;
+        else if (ext == L".d2h") m_kind = ArchiveKind::D2h;
+        else if (ext == L".spt") m_kind = ArchiveKind::Spt;
+        else if (ext == L".xbb") m_kind = ArchiveKind::Xbb;
+        else return false;
+        if (!m_bank.open(bank)) { m_kind = ArchiveKind::None; return false; }
+        m_dir = bank.parent_path();
+        std::filesystem::path other = companion;
+        if (other.empty() && (m_kind == ArchiveKind::Spt || m_kind == ArchiveKind::Xbb)) {
+            other = bank;
+            other.replace_extension(m_kind == ArchiveKind::Spt ? L".spd" : L".xsb");
+        }
+        // The SPD holds every SPT stream; an XBB without its XSB still has its inline entries.
+        if (!other.empty() && !m_companion.open(other) && m_kind == ArchiveKind::Spt) { close(); return false; }
+        return true;
+    }
+
+    void close() {
+        m_bank.close(); m_companion.close();
+        m_kind = ArchiveKind::None; m_parsed = false; m_ok = false;
+        m_entries.clear(); m_spt.clear();
+    }
+
+    ArchiveKind kind() const { return m_kind; }
+    bool is_open() const { return m_kind != ArchiveKind::None; }
+
+    // The entry table, walked on first use. Empty if the table is unreadable (see valid()).
+    const std::vector<ArchiveEntry>& entries() { parse(); return m_entries; }
+    bool valid() { parse(); return m_ok; }
+    size_t size() { return entries().size(); }
+
+    // The file name an extract-everything run gives entry i (and that find() accepts).
+    std::string entry_name(size_t i) {
+        const std::vector<ArchiveEntry>& e = entries();
+        if (i >= e.size()) return {};
+        char buf[32];
+        switch (m_kind) {
+        case ArchiveKind::Spt: snprintf(buf, sizeof(buf), "%03d.dsp", static_cast<int>(i)); return buf;
+        case ArchiveKind::Xbb: snprintf(buf, sizeof(buf), "track_%03u.wav", static_cast<unsigned>(i)); return buf;
+        default: return std::string(e[i].name);
+        }
+    }
+
+    bool find(std::string_view name, size_t& index) {
+        for (size_t i = 0; i < size(); ++i) if (entry_name(i) == name) { index = i; return true; }
+        return false;
+    }
+
+    // 'out' is reset first; reusing one stream across entries keeps its header buffer.
+    bool open_entry(size_t i, ArchiveStream& out) {
+        TRACE_SCOPE_CAT("SoundArchive::open_entry", "container");
+        out.reset();
+        const std::vector<ArchiveEntry>& all = entries();
+        if (i >= all.size() || !all[i].header) return false;
+        const ArchiveEntry& e = all[i];
+        switch (m_kind) {
+        case ArchiveKind::Dsh:
+        case ArchiveKind::D2h: {
+            auto file = std::make_shared<MappedFile>(m_dir / std::filesystem::u8path(e.name));
+            if (!file->is_open()) return false;
+            out.m_body = file->data(); out.m_body_len = file->size();
+            out.m_file = std::move(file);
+            return true;
+        }
+        case ArchiveKind::Spt:
+            out.m_head = e.header; out.m_head_len = e.header_len;
+            out.m_body = e.data; out.m_body_len = e.data_len;
+            return true;
+        case ArchiveKind::Xbb: {
+            // Inline audio sits right after its data chunk header; streamed audio follows the whole header.
+            RiffChunk data;
+            const size_t keep = e.inline_data && RiffReader(e.header, e.header_len).find("data", data) ? data.data_offset() : e.header_len;
+            if (keep < 12) return false;
+            out.m_owned.assign(e.header, e.header + keep);
+            RiffPatchDataSize(out.m_owned.data(), out.m_owned.size(), e.data_len);
+            const uint32_t riff = static_cast<uint32_t>(out.m_owned.size() + e.data_len - 8);
+            memcpy(out.m_owned.data() + 4, &riff, 4);
+            out.m_body = e.data; out.m_body_len = e.data ? e.data_len : 0;
+            return true;
+        }
+        default: return false;
+        }
+    }
+
+    bool open_entry(std::string_view name, ArchiveStream& out) {
+        size_t i;
+        return find(name, i) && open_entry(i, out);
+    }
+
+private:
+    static uint32_t le32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }   // little-endian hosts, as the tools
+
+    void parse() {
+        TRACE_SCOPE_CAT("SoundArchive::parse", "container");
+        if (m_parsed || m_kind == ArchiveKind::None) return;
+        m_parsed = true;
+        const uint8_t* p = m_bank.data();
+        const size_t len = m_bank.size();
+        switch (m_kind) {
+        case ArchiveKind::Dsh: m_ok = parse_header_bank(p, len, sizeof(DshEntry)); break;
+        case ArchiveKind::D2h: m_ok = parse_header_bank(p, len, sizeof(D2hEntry)); break;
+        case ArchiveKind::Spt:
+            m_ok = ParseSptSpd(p, len, m_companion.data(), m_companion.size(), m_spt);
+            for (size_t i = 0; i < m_spt.size(); ++i) {
+                ArchiveEntry e;
+                e.index = static_cast<uint32_t>(i);
+                e.header = m_spt[i].header; e.header_len = DSP_HEADER_BYTES;
+                e.data = m_spt[i].data; e.data_len = m_spt[i].size;
+                m_entries.push_back(e);
+            }
+            break;
+        case ArchiveKind::Xbb: m_ok = parse_xbb(p, len); break;
+        default: break;
+        }
+    }
+
+    bool parse_header_bank(const uint8_t* p, size_t len, size_t entry_bytes) {
+        if (len < DSH_FILE_HEADER_BYTES) return false;
+        DshFileHeader head;
+        BeLoad(p, head);
+        const uint32_t count = head.count;
+        if (count > (len - DSH_FILE_HEADER_BYTES) / entry_bytes) return false;
+        m_entries.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint8_t* at = p + DSH_FILE_HEADER_BYTES + i * entry_bytes;
+            ArchiveEntry& e = m_entries[i];
+            e.index = i;
+            e.name = std::string_view(reinterpret_cast<const char*>(at), strnlen(reinterpret_cast<const char*>(at), DSH_NAME_BYTES));
+            e.header = at + DSH_NAME_BYTES; e.header_len = static_cast<uint32_t>(entry_bytes - DSH_NAME_BYTES);
+        }
+        return true;
+    }
+
+    // Entry i is SDF id i: unreadable entries stay in the table as blanks.
+    bool parse_xbb(const uint8_t* x, size_t size) {
+        if (size < 8) return false;
+        const uint32_t count = le32(x + 4);
+        uint64_t cursor = 8;
+        for (uint32_t i = 0; i < count; ++i) {
+            ArchiveEntry e{};
+            e.index = i;
+            if (cursor + 8 > size) break;
+            const uint32_t header_len = le32(x + cursor + 4);
+            if (header_len == 0 || cursor + header_len + 8 > size) { m_entries.push_back(e); cursor += 8; continue; }
+            e.header = x + cursor; e.header_len = header_len;
+            const uint32_t xsb_offset = le32(x + cursor + header_len), xsb_len = le32(x + cursor + header_len + 4);
+            RiffChunk data;
+            uint32_t header_data_len = 0;
+            bool is_inline = false;
+            if (RiffReader(e.header, header_len).find("data", data)) {
+                header_data_len = static_cast<uint32_t>(data.size);
+                const uint64_t data_end = static_cast<uint64_t>(data.data_offset()) + header_data_len;
+                is_inline = header_data_len > 0 && header_data_len < 0xF0000000 && (data_end == header_len || data_end == static_cast<uint64_t>(header_len) + 8);
+            }
+            if (is_inline) { e.data = data.data; e.data_len = header_data_len; e.inline_data = true; }
+            else if (m_companion.data() && xsb_len > 0 && static_cast<uint64_t>(xsb_offset) + xsb_len <= m_companion.size()) { e.data = m_companion.data() + xsb_offset; e.data_len = xsb_len; }
+            m_entries.push_back(e);
+            cursor += header_len + 8;
+        }
+        return true;
+    }
+
+    ArchiveKind m_kind = ArchiveKind::None;
+    MappedFile m_bank, m_companion;
+    std::filesystem::path m_dir;
+    bool m_parsed = false, m_ok = false;
+    std::vector<ArchiveEntry> m_entries;
+    std::vector<DspStream> m_spt;    // rebuilt DSP headers + SPD views
+};
+
+// Writes an entry out as a standalone file (.dsp / .ds2 / .wav).
+inline bool WriteArchiveStream(const std::filesystem::path& path, const ArchiveStream& s) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    f.write(s.head().data(), static_cast<std::streamsize>(s.head().size()));
+    f.write(s.body().data(), static_cast<std::streamsize>(s.body().size()));
+    return static_cast<bool>(f);
+}
@@ -0,0 +1,80 @@
+#pragma once
+// StringPool.h
+// Arena-backed string intern pool. Each distinct string is stored once, NUL-terminated,
+// in large blocks and named by a dense uint32_t id, so models can keep 4-byte ids
+// instead of owning std::wstring copies. Views and c_str() pointers stay valid until
+// clear(). Id 0 is always the empty string.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+template <class CharT>
+class BasicStringPool {
+public:
+    using view_type = std::basic_string_view<CharT>;
+    static constexpr uint32_t npos = 0xFFFFFFFFu;
+    static constexpr uint32_t empty_id = 0;
+
+    BasicStringPool() { clear(); }
+    BasicStringPool(const BasicStringPool&) = delete;
+    BasicStringPool& operator=(const BasicStringPool&) = delete;
+
+    // Returns the id of 's', storing a copy the first time it is seen.
+    uint32_t intern(view_type s) {
+        auto it = m_ids.find(s);
+        if (it != m_ids.end()) return it->second;
+        view_type stored = store(s);
+        uint32_t id = static_cast<uint32_t>(m_views.size());
+        m_views.push_back(stored);
+        m_ids.emplace(stored, id);
+        return id;
+    }
+
+    // Id of 's' if it was interned, npos otherwise. Never allocates.
+    uint32_t find(view_type s) const {
+        auto it = m_ids.find(s);
+        return it == m_ids.end() ? npos : it->second;
+    }
+
+    view_type view(uint32_t id) const { return m_views[id]; }
+    const CharT* c_str(uint32_t id) const { return m_views[id].data(); }
+    size_t size() const { return m_views.size(); }
+    size_t arena_bytes() const { return m_reserved * sizeof(CharT); }
+
+    void clear() {
+        m_ids.clear(); m_views.clear(); m_blocks.clear();
+        m_used = m_cap = m_reserved = 0;
+        intern(view_type());
+    }
+
+private:
+    static constexpr size_t BLOCK_CHARS = 16384;
+
+    view_type store(view_type s) {
+        const size_t need = s.size() + 1;
+        if (m_blocks.empty() || m_used + need > m_cap) {
+            m_cap = need > BLOCK_CHARS ? need : BLOCK_CHARS;
+            m_blocks.emplace_back(new CharT[m_cap]);
+            m_reserved += m_cap;
+            m_used = 0;
+        }
+        CharT* p = m_blocks.back().get() + m_used;
+        if (!s.empty()) memcpy(p, s.data(), s.size() * sizeof(CharT));
+        p[s.size()] = CharT();
+        m_used += need;
+        return view_type(p, s.size());
+    }
+
+    std::vector<std::unique_ptr<CharT[]>> m_blocks;
+    size_t m_used = 0, m_cap = 0, m_reserved = 0;
+    std::vector<view_type> m_views;
+    std::unordered_map<view_type, uint32_t> m_ids;
+};
+
+using StringPool = BasicStringPool<char>;
+using WStringPool = BasicStringPool<wchar_t>;
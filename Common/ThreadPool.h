@@ -0,0 +1,80 @@
+#pragma once
+// ThreadPool.h
+// Fixed set of worker threads draining a FIFO of jobs. parallel_for() hands out loop
+// indices one at a time, so uneven jobs (a long compound event next to a short click)
+// still keep every worker busy.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    // 0 threads = one per hardware thread.
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0) threads = (std::max)(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; ++i) m_workers.emplace_back([this, i] { run(i); });
+    }
+
+    ~ThreadPool() {
+        { std::lock_guard<std::mutex> lock(m_mutex); m_stop = true; }
+        m_wake.notify_all();
+        for (auto& t : m_workers) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(m_workers.size()); }
+
+    // Queues job(worker), where worker is the index of the thread running it.
+    void submit(std::function<void(unsigned)> job) {
+        { std::lock_guard<std::mutex> lock(m_mutex); m_jobs.push_back(std::move(job)); ++m_pending; }
+        m_wake.notify_one();
+    }
+
+    // Blocks until every submitted job has finished.
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_pending == 0; });
+    }
+
+    // Runs fn(index, worker) for index in [0, count) and returns when all are done.
+    template <class F> void parallel_for(size_t count, F&& fn) {
+        std::atomic<size_t> next{ 0 };
+        const unsigned lanes = static_cast<unsigned>((std::min)(count, m_workers.size()));
+        for (unsigned l = 0; l < lanes; ++l)
+            submit([&](unsigned worker) { for (size_t i; (i = next.fetch_add(1)) < count;) fn(i, worker); });
+        wait();
+    }
+
+private:
+    void run(unsigned worker) {
+        for (;;) {
+            std::function<void(unsigned)> job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+                if (m_jobs.empty()) return;   // stopping
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+            job(worker);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_pending == 0) m_idle.notify_all();
+        }
+    }
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void(unsigned)>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_wake, m_idle;
+    size_t m_pending = 0;
+    bool m_stop = false;
+};
@@ -0,0 +1,152 @@
+#pragma once
+// Trace.h
+// Scoped timing spans written as Chrome trace events (open the file in chrome://tracing
+// or ui.perfetto.dev). TRACE_SCOPE("name") times the rest of the enclosing block. While
+// tracing is off a span costs one relaxed atomic load and a branch; while it is on, each
+// thread appends complete ("X") events to its own buffer and TraceWrite() merges them,
+// one timeline row per thread. Span names and categories must be string literals.
+//
+// The tools hold a TraceSession in WinMain: when GLADIUS_TRACE names a file, tracing is
+// on for the whole run and the trace is written there on exit.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "JsonWriter.h"
+
+namespace trace_detail {
+struct Event {
+    const char* name;
+    const char* cat;
+    uint64_t start_ns;
+    uint64_t dur_ns;
+};
+
+struct ThreadBuffer {
+    std::mutex lock;            // only contended while TraceStart/TraceWrite run
+    std::vector<Event> events;
+    uint32_t tid = 0;
+};
+
+struct Registry {
+    std::atomic<bool> on{ false };
+    std::mutex lock;
+    std::vector<std::shared_ptr<ThreadBuffer>> threads;   // outlive their threads
+    uint64_t epoch_ns = 0;
+};
+
+inline Registry& Global() { static Registry r; return r; }
+
+inline uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+inline ThreadBuffer& Local() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        auto b = std::make_shared<ThreadBuffer>();
+        Registry& r = Global();
+        std::lock_guard<std::mutex> lock(r.lock);
+        b->tid = static_cast<uint32_t>(r.threads.size()) + 1;
+        r.threads.push_back(b);
+        return b;
+    }();
+    return *buffer;
+}
+} // namespace trace_detail
+
+inline bool TraceEnabled() { return trace_detail::Global().on.load(std::memory_order_relaxed); }
+
+// Drops any earlier events and starts recording.
+inline void TraceStart() {
+    trace_detail::Registry& r = trace_detail::Global();
+    std::lock_guard<std::mutex> lock(r.lock);
+    for (auto& t : r.threads) { std::lock_guard<std::mutex> tl(t->lock); t->events.clear(); }
+    r.epoch_ns = trace_detail::NowNs();
+    r.on.store(true, std::memory_order_relaxed);
+}
+
+inline void TraceStop() { trace_detail::Global().on.store(false, std::memory_order_relaxed); }
+
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, const char* cat = "tools") : m_name(TraceEnabled() ? name : nullptr), m_cat(cat) {
+        if (m_name) m_start = trace_detail::NowNs();
+    }
+    ~TraceSpan() {
+        if (!m_name) return;
+        const uint64_t end = trace_detail::NowNs();
+        trace_detail::ThreadBuffer& b = trace_detail::Local();
+        std::lock_guard<std::mutex> lock(b.lock);
+        b.events.push_back({ m_name, m_cat, m_start, end - m_start });
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_name;
+    const char* m_cat;
+    uint64_t m_start = 0;
+};
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_SCOPE(name) TraceSpan TRACE_JOIN(trace_span_, __LINE__)(name)
+#define TRACE_SCOPE_CAT(name, cat) TraceSpan TRACE_JOIN(trace_span_, __LINE__)(name, cat)
+
+// Every recorded event as {"traceEvents": [...]}, times in microseconds from TraceStart().
+inline bool TraceWrite(const std::filesystem::path& path) {
+    trace_detail::Registry& r = trace_detail::Global();
+    JsonWriter w;
+    w.begin_object().field("displayTimeUnit", "ms").key("traceEvents").begin_array();
+    std::lock_guard<std::mutex> lock(r.lock);
+    for (auto& t : r.threads) {
+        std::lock_guard<std::mutex> tl(t->lock);
+        if (t->events.empty()) continue;
+        const std::string thread_name = "thread " + std::to_string(t->tid);
+        w.begin_object().field("name", "thread_name").field("ph", "M").field("pid", 1).field("tid", t->tid)
+            .key("args").begin_object().field("name", thread_name).end_object().end_object();
+        for (const trace_detail::Event& e : t->events) {
+            const uint64_t rel = e.start_ns > r.epoch_ns ? e.start_ns - r.epoch_ns : 0;
+            w.begin_object().field("name", e.name).field("cat", e.cat).field("ph", "X").field("pid", 1).field("tid", t->tid);
+            w.key("ts").value(rel / 1000.0, 3).key("dur").value(e.dur_ns / 1000.0, 3).end_object();
+        }
+    }
+    w.end_array().end_object();
+    return w.save(path);
+}
+
+// Tracing for one tool run, switched on by the GLADIUS_TRACE environment variable.
+class TraceSession {
+public:
+    TraceSession() {
+#ifdef _WIN32
+        wchar_t buf[MAX_PATH];
+        const DWORD n = GetEnvironmentVariableW(L"GLADIUS_TRACE", buf, MAX_PATH);
+        if (n > 0 && n < MAX_PATH) m_path = buf;
+#else
+        if (const char* p = getenv("GLADIUS_TRACE")) m_path = p;
+#endif
+        if (!m_path.empty()) TraceStart();
+    }
+    ~TraceSession() {
+        if (m_path.empty()) return;
+        TraceStop();
+        TraceWrite(m_path);
+    }
+    TraceSession(const TraceSession&) = delete;
+    TraceSession& operator=(const TraceSession&) = delete;
+
+private:
+    std::filesystem::path m_path;
+};
@@ -0,0 +1,131 @@
+#pragma once
+// TrigramIndex.h
+// Case-insensitive substring search over short per-row texts (event names, filenames).
+//
+// Every row's text is case-folded once and cut into overlapping 3-character keys; each
+// key keeps the sorted list of rows containing it. A query intersects the lists of its
+// own trigrams, smallest first, and then confirms the few surviving rows with a plain
+// find() on the folded text. Queries shorter than 3 characters have no trigram and
+// scan the folded texts instead.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cwctype>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class TrigramIndex {
+public:
+    void clear() {
+        m_postings.clear(); m_chars.clear(); m_begin.clear(); m_length.clear();
+    }
+
+    size_t row_count() const { return m_begin.size(); }
+
+    // Sets (or replaces) the searchable text of a row. Several fields can be joined with
+    // FIELD_SEPARATOR so a match never spans two of them.
+    void set(uint32_t row, std::wstring_view text) {
+        if (row < m_begin.size()) unlink(row);
+        else { m_begin.resize(row + 1, 0); m_length.resize(row + 1, 0); }
+        m_begin[row] = static_cast<uint32_t>(m_chars.size());   // old text stays behind as garbage
+        for (wchar_t c : text) m_chars.push_back(fold(c));
+        m_length[row] = static_cast<uint32_t>(text.size());
+        for_each_key(folded(row), [&](uint64_t key) {
+            std::vector<uint32_t>& list = m_postings[key];
+            if (list.empty() || list.back() < row) list.push_back(row);
+            else {
+                auto it = std::lower_bound(list.begin(), list.end(), row);
+                if (it == list.end() || *it != row) list.insert(it, row);
+            }
+        });
+    }
+
+    // Rows whose text contains 'query' (case-insensitive), ascending. An empty query
+    // matches every row.
+    std::vector<uint32_t> search(std::wstring_view query) const {
+        std::wstring q(query);
+        for (auto& c : q) c = fold(c);
+        std::vector<uint32_t> out;
+        if (q.size() < 3) {
+            for (uint32_t row = 0; row < m_begin.size(); ++row)
+                if (folded(row).find(q) != std::wstring_view::npos) out.push_back(row);
+            return out;
+        }
+
+        std::vector<uint64_t> keys;
+        for_each_key(q, [&](uint64_t key) { keys.push_back(key); });
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (uint64_t key : keys) {
+            auto it = m_postings.find(key);
+            if (it == m_postings.end() || it->second.empty()) return out;
+            lists.push_back(&it->second);
+        }
+        if (lists.empty()) {    // every window straddles a field separator
+            for (uint32_t row = 0; row < m_begin.size(); ++row)
+                if (folded(row).find(q) != std::wstring_view::npos) out.push_back(row);
+            return out;
+        }
+        std::sort(lists.begin(), lists.end(), [](auto* a, auto* b) { return a->size() < b->size(); });
+        // A single trigram with no separator in it needs no confirmation.
+        const bool exact = (q.size() == 3 && lists.size() == 1);
+
+        // Walk the shortest list; probe the others with a forward-only galloping search.
+        std::vector<size_t> cursor(lists.size(), 0);
+        for (uint32_t row : *lists[0]) {
+            bool all = true;
+            for (size_t i = 1; i < lists.size() && all; ++i) {
+                cursor[i] = gallop(*lists[i], cursor[i], row);
+                all = (cursor[i] < lists[i]->size() && (*lists[i])[cursor[i]] == row);
+            }
+            if (all && (exact || folded(row).find(q) != std::wstring_view::npos)) out.push_back(row);
+        }
+        return out;
+    }
+
+    size_t key_count() const { return m_postings.size(); }
+
+    static constexpr wchar_t FIELD_SEPARATOR = L'\x1';
+
+private:
+    static wchar_t fold(wchar_t c) { return static_cast<wchar_t>(towlower(c)); }
+
+    // First index >= from whose value is >= row: doubling steps, then a binary search.
+    static size_t gallop(const std::vector<uint32_t>& list, size_t from, uint32_t row) {
+        size_t step = 1, hi = from;
+        while (hi < list.size() && list[hi] < row) { from = hi + 1; hi += step; step *= 2; }
+        if (hi > list.size()) hi = list.size();
+        return static_cast<size_t>(std::lower_bound(list.begin() + from, list.begin() + hi, row) - list.begin());
+    }
+
+    std::wstring_view folded(uint32_t row) const {
+        return std::wstring_view(m_chars.data() + m_begin[row], m_length[row]);
+    }
+
+    // 21 bits per character covers all of Unicode for 32-bit wchar_t.
+    template <class F> static void for_each_key(std::wstring_view s, F&& f) {
+        for (size_t i = 0; i + 3 <= s.size(); ++i) {
+            if (s[i] == FIELD_SEPARATOR || s[i + 1] == FIELD_SEPARATOR || s[i + 2] == FIELD_SEPARATOR) continue;
+            f((static_cast<uint64_t>(s[i] & 0x1FFFFF) << 42) | (static_cast<uint64_t>(s[i + 1] & 0x1FFFFF) << 21) |
+                static_cast<uint64_t>(s[i + 2] & 0x1FFFFF));
+        }
+    }
+
+    void unlink(uint32_t row) {
+        std::wstring old(folded(row));
+        for_each_key(old, [&](uint64_t key) {
+            auto it = m_postings.find(key);
+            if (it == m_postings.end()) return;
+            auto pos = std::lower_bound(it->second.begin(), it->second.end(), row);
+            if (pos != it->second.end() && *pos == row) it->second.erase(pos);
+        });
+    }
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_postings; // trigram -> rows, ascending
+    std::vector<wchar_t> m_chars;                                   // folded texts, back to back
+    std::vector<uint32_t> m_begin, m_length;                        // per row, into m_chars
+};
@@ -0,0 +1,340 @@
+#pragma once
+// WavIngest.h
+// Reads RIFF/WAVE sample data into planar 16-bit channel buffers. Accepts PCM (8-bit
+// unsigned, 16/24/32-bit signed), IEEE float (32/64-bit) and WAVE_FORMAT_EXTENSIBLE
+// wrappers of both. The data chunk is walked in blocks of BLOCK_FRAMES: each block is
+// converted to a float scratch buffer in 16-bit units (SSE2 for the 8/16/32-bit and
+// float layouts), folded to the requested channel count by a small gain matrix in one
+// pass over the block's frames that fills every output channel (stereo sources are
+// deinterleaved four frames at a time with SSE2), then optionally TPDF-dithered and
+// saturated straight into the caller's buffers.
+//
+// Channel folding: keeping the channel count copies; mono -> stereo duplicates; more
+// channels fold by the speaker mask (centre and surrounds at -3 dB, LFE dropped), with
+// each output row scaled back to unity gain so a full-scale mix never clips.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Mixer.h"
+#include "Riff.h"
+#include "Trace.h"
+
+constexpr uint16_t WAVE_FORMAT_PCM_TAG = 0x0001;
+constexpr uint16_t WAVE_FORMAT_FLOAT_TAG = 0x0003;
+constexpr uint16_t WAVE_FORMAT_EXTENSIBLE_TAG = 0xFFFE;
+
+struct WavFormat {
+    uint16_t format = 0;            // WAVE_FORMAT_PCM_TAG or WAVE_FORMAT_FLOAT_TAG after unwrapping
+    uint16_t channels = 0;
+    uint32_t sample_rate = 0;
+    uint16_t bits = 0;              // container bits per sample
+    uint16_t block_align = 0;
+    uint32_t channel_mask = 0;      // EXTENSIBLE speaker mask, 0 when absent
+    const uint8_t* data = nullptr;  // first frame of the data chunk
+    size_t frames = 0;              // whole frames present in the file
+
+    bool is_float() const { return format == WAVE_FORMAT_FLOAT_TAG; }
+    // True when conversion to 16-bit throws bits away (dither is worth applying).
+    bool wider_than_16() const { return is_float() || bits > 16; }
+};
+
+enum class WavDither { None, Tpdf };
+
+namespace wav_detail {
+inline uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+inline uint32_t le32(const uint8_t* p) { return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24); }
+
+constexpr size_t BLOCK_FRAMES = 4096;
+
+// Speaker bits of WAVEFORMATEXTENSIBLE.dwChannelMask.
+enum : uint32_t {
+    SPK_FL = 0x1, SPK_FR = 0x2, SPK_FC = 0x4, SPK_LFE = 0x8, SPK_BL = 0x10, SPK_BR = 0x20,
+    SPK_FLC = 0x40, SPK_FRC = 0x80, SPK_BC = 0x100, SPK_SL = 0x200, SPK_SR = 0x400
+};
+
+// Mask the common layouts use when the file does not carry one.
+inline uint32_t DefaultMask(uint16_t channels) {
+    switch (channels) {
+    case 1: return SPK_FC;
+    case 2: return SPK_FL | SPK_FR;
+    case 3: return SPK_FL | SPK_FR | SPK_FC;
+    case 4: return SPK_FL | SPK_FR | SPK_BL | SPK_BR;
+    case 5: return SPK_FL | SPK_FR | SPK_FC | SPK_BL | SPK_BR;
+    case 6: return SPK_FL | SPK_FR | SPK_FC | SPK_LFE | SPK_BL | SPK_BR;
+    case 8: return SPK_FL | SPK_FR | SPK_FC | SPK_LFE | SPK_BL | SPK_BR | SPK_SL | SPK_SR;
+    default: return 0;
+    }
+}
+
+// gains[o * channels + c]: contribution of source channel c to output o.
+inline std::vector<float> FoldMatrix(const WavFormat& fmt, uint16_t out_channels) {
+    const uint16_t n = fmt.channels;
+    std::vector<float> m(static_cast<size_t>(out_channels) * n, 0.0f);
+    if (out_channels == n) { for (uint16_t c = 0; c < n; ++c) m[c * n + c] = 1.0f; return m; }
+    if (n == 1) { for (uint16_t o = 0; o < out_channels; ++o) m[o] = 1.0f; return m; }
+    // Stereo fold by speaker position; unknown speakers go to both sides.
+    std::vector<float> st(2 * static_cast<size_t>(n), 0.0f);
+    const uint32_t mask = fmt.channel_mask ? fmt.channel_mask : DefaultMask(n);
+    const float h = 0.70710678f;
+    uint32_t bit = 1;
+    for (uint16_t c = 0; c < n; ++c) {
+        while (bit && !(mask & bit)) bit <<= 1;
+        const uint32_t spk = bit;
+        if (bit) bit <<= 1;
+        float l = h, r = h;                                              // centre-like / unknown
+        if (spk == SPK_FL || spk == SPK_FLC) { l = 1; r = 0; }
+        else if (spk == SPK_FR || spk == SPK_FRC) { l = 0; r = 1; }
+        else if (spk == SPK_BL || spk == SPK_SL) { l = h; r = 0; }
+        else if (spk == SPK_BR || spk == SPK_SR) { l = 0; r = h; }
+        else if (spk == SPK_LFE) { l = 0; r = 0; }
+        else if (mask == 0 && c < 2) { l = c == 0 ? 1.0f : 0.0f; r = 1 - l; }   // unmasked: first two are L/R
+        st[c] = l; st[n + c] = r;
+    }
+    for (int o = 0; o < 2; ++o) {
+        float sum = 0;
+        for (uint16_t c = 0; c < n; ++c) sum += st[o * n + c];
+        if (sum > 1) for (uint16_t c = 0; c < n; ++c) st[o * n + c] /= sum;
+    }
+    if (out_channels == 2) return st;
+    for (uint16_t c = 0; c < n; ++c) m[c] = 0.5f * (st[c] + st[n + c]);   // mono: mid of the stereo fold
+    return m;
+}
+
+// 'count' interleaved samples -> float in 16-bit units.
+inline void ToFloat(const WavFormat& fmt, const uint8_t* src, float* dst, size_t count) {
+    size_t i = 0;
+    if (fmt.is_float() && fmt.bits == 32) {
+#ifdef MIXER_SSE2
+        const __m128 k = _mm_set1_ps(32768.0f);
+        for (; i + 4 <= count; i += 4) _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(reinterpret_cast<const float*>(src) + i), k));
+#endif
+        for (; i < count; ++i) { float v; memcpy(&v, src + i * 4, 4); dst[i] = v * 32768.0f; }
+    }
+    else if (fmt.is_float()) {
+        for (; i < count; ++i) { double v; memcpy(&v, src + i * 8, 8); dst[i] = static_cast<float>(v * 32768.0); }
+    }
+    else if (fmt.bits == 16) {
+#ifdef MIXER_SSE2
+        for (; i + 8 <= count; i += 8) {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+            _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)));
+            _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16)));
+        }
+#endif
+        for (; i < count; ++i) dst[i] = static_cast<int16_t>(le16(src + i * 2));
+    }
+    else if (fmt.bits == 8) {
+#ifdef MIXER_SSE2
+        const __m128i zero = _mm_setzero_si128(), bias = _mm_set1_epi16(128);
+        for (; i + 8 <= count; i += 8) {
+            __m128i b = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)), zero), bias);
+            b = _mm_slli_epi16(b, 8);
+            _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16)));
+            _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(b, b), 16)));
+        }
+#endif
+        for (; i < count; ++i) dst[i] = static_cast<float>((static_cast<int>(src[i]) - 128) * 256);
+    }
+    else if (fmt.bits == 24) {
+        // Three bytes per sample: assemble into the top of an int32 (sign comes for free).
+        for (; i < count; ++i) {
+            const uint8_t* p = src + i * 3;
+            const int32_t v = static_cast<int32_t>((uint32_t(p[0]) << 8) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 24));
+            dst[i] = static_cast<float>(v) * (1.0f / 65536.0f);
+        }
+    }
+    else {   // 32-bit integer
+#ifdef MIXER_SSE2
+        const __m128 k = _mm_set1_ps(1.0f / 65536.0f);
+        for (; i + 4 <= count; i += 4) _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4))), k));
+#endif
+        for (; i < count; ++i) dst[i] = static_cast<float>(static_cast<int32_t>(le32(src + i * 4))) * (1.0f / 65536.0f);
+    }
+}
+
+// Triangular (two-uniform) dither of +-1 LSB, then clamp to the int16 range.
+class TpdfDither {
+public:
+    void apply(float* bus, size_t n) {
+        for (size_t i = 0; i < n; ++i) bus[i] += uniform() - uniform();
+    }
+private:
+    float uniform() {   // xorshift32 -> [0, 1)
+        m_state ^= m_state << 13; m_state ^= m_state >> 17; m_state ^= m_state << 5;
+        return static_cast<float>(m_state >> 8) * (1.0f / 16777216.0f);
+    }
+    uint32_t m_state = 0x9E3779B9u;
+};
+
+// Nonzero gains of the fold matrix in source-channel order. A picked channel is a single
+// unity tap, and 0 + x * 1 == x, so copies stay exact.
+struct FoldTap {
+    uint16_t channel, output;
+    float gain;
+};
+
+inline std::vector<FoldTap> FoldTaps(const std::vector<float>& m, uint16_t n, uint16_t out_channels) {
+    std::vector<FoldTap> taps;
+    for (uint16_t c = 0; c < n; ++c)
+        for (uint16_t o = 0; o < out_channels; ++o)
+            if (m[o * n + c] != 0) taps.push_back({ c, o, m[o * n + c] });
+    return taps;
+}
+
+#ifdef MIXER_SSE2
+// Four frames per step for one or two outputs: each source channel is loaded into one
+// register (a plain load for mono, two shuffles for stereo, a gather otherwise) and added
+// into the accumulators it feeds. Returns the frames done; the caller finishes the rest.
+template <int OUT>
+inline size_t FoldBlockSse2(const float* inter, uint16_t n, size_t count, const std::vector<FoldTap>& taps, float* bus) {
+    size_t i = 0;
+    bool copies = taps.size() == OUT && (OUT == 1 || taps[0].output != taps[1].output);   // every output is one source channel as-is
+    for (const FoldTap& t : taps) copies = copies && t.gain == 1.0f;
+    if (copies && n <= 2) {
+        for (; i + 4 <= count; i += 4) {
+            const float* s = inter + i * n;
+            __m128 ch[2];
+            if (n == 1) ch[0] = _mm_loadu_ps(s);
+            else {
+                const __m128 lo = _mm_loadu_ps(s), hi = _mm_loadu_ps(s + 4);
+                ch[0] = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+                ch[1] = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+            }
+            for (const FoldTap& t : taps) _mm_storeu_ps(bus + t.output * BLOCK_FRAMES + i, ch[t.channel]);
+        }
+        return i;
+    }
+    constexpr size_t MAX_TAPS = 64;
+    if (taps.size() > MAX_TAPS) return 0;
+    __m128 gain[MAX_TAPS];
+    for (size_t t = 0; t < taps.size(); ++t) gain[t] = _mm_set1_ps(taps[t].gain);
+    for (; i + 4 <= count; i += 4) {
+        const float* s = inter + i * n;
+        __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps(), v = _mm_setzero_ps(), left = v, right = v;
+        if (n == 2) {
+            const __m128 lo = _mm_loadu_ps(s), hi = _mm_loadu_ps(s + 4);
+            left = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+            right = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        }
+        int loaded = -1;
+        for (size_t t = 0; t < taps.size(); ++t) {
+            const int c = taps[t].channel;
+            if (c != loaded) {
+                loaded = c;
+                if (n == 1) v = _mm_loadu_ps(s);
+                else if (n == 2) v = c == 0 ? left : right;
+                else v = _mm_setr_ps(s[c], s[n + c], s[2 * n + c], s[3 * n + c]);
+            }
+            const __m128 p = _mm_mul_ps(v, gain[t]);
+            if (OUT == 1 || taps[t].output == 0) acc0 = _mm_add_ps(acc0, p);
+            else acc1 = _mm_add_ps(acc1, p);
+        }
+        _mm_storeu_ps(bus + i, acc0);
+        if (OUT == 2) _mm_storeu_ps(bus + BLOCK_FRAMES + i, acc1);
+    }
+    return i;
+}
+#endif
+
+// Deinterleaves and folds 'count' frames of 'inter' into out_channels planar rows of
+// 'bus' (stride BLOCK_FRAMES) in one pass over the frames. Taps are summed in channel
+// order on both paths, so they give the same floats.
+inline void FoldBlock(const float* inter, uint16_t n, size_t count, const std::vector<FoldTap>& taps, uint16_t out_channels, float* bus) {
+    size_t i = 0;
+#ifdef MIXER_SSE2
+    if (out_channels == 1) i = FoldBlockSse2<1>(inter, n, count, taps, bus);
+    else if (out_channels == 2) i = FoldBlockSse2<2>(inter, n, count, taps, bus);
+#endif
+    for (; i < count; ++i) {
+        const float* s = inter + i * n;
+        for (uint16_t o = 0; o < out_channels; ++o) bus[o * BLOCK_FRAMES + i] = 0;
+        for (const FoldTap& t : taps) bus[t.output * BLOCK_FRAMES + i] += s[t.channel] * t.gain;
+    }
+}
+
+inline void Clamp16(float* bus, size_t n) {
+    size_t i = 0;
+#ifdef MIXER_SSE2
+    const __m128 lo = _mm_set1_ps(-32768.0f), hi = _mm_set1_ps(32767.0f);
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(bus + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(bus + i), lo), hi));
+#endif
+    for (; i < n; ++i) bus[i] = (std::min)(32767.0f, (std::max)(-32768.0f, bus[i]));
+}
+} // namespace wav_detail
+
+// Parses the header of a mapped/loaded WAV (RIFF or RF64) with the shared chunk walker;
+// a data chunk cut short by the end of the file keeps the frames that are there.
+inline bool ParseWavFormat(const uint8_t* file, size_t len, WavFormat& fmt) {
+    TRACE_SCOPE_CAT("ParseWavFormat", "container");
+    using namespace wav_detail;
+    fmt = WavFormat();
+    RiffReader riff(file, len);
+    if (!riff.form_is("WAVE")) return false;
+    bool have_fmt = false;
+    RiffChunk c;
+    while (riff.next(c)) {
+        if (c.is("fmt ")) {
+            if (c.avail < 16) return false;
+            const uint8_t* body = c.data;
+            fmt.format = le16(body);
+            fmt.channels = le16(body + 2);
+            fmt.sample_rate = le32(body + 4);
+            fmt.block_align = le16(body + 12);
+            fmt.bits = le16(body + 14);
+            if (fmt.format == WAVE_FORMAT_EXTENSIBLE_TAG) {
+                if (c.avail < 40) return false;
+                fmt.channel_mask = le32(body + 20);
+                fmt.format = le16(body + 24);                        // first two bytes of the sub-format GUID
+            }
+            have_fmt = true;
+        }
+        else if (c.is("data")) {
+            if (!have_fmt) return false;
+            const bool pcm_ok = fmt.format == WAVE_FORMAT_PCM_TAG && (fmt.bits == 8 || fmt.bits == 16 || fmt.bits == 24 || fmt.bits == 32);
+            const bool float_ok = fmt.format == WAVE_FORMAT_FLOAT_TAG && (fmt.bits == 32 || fmt.bits == 64);
+            if ((!pcm_ok && !float_ok) || fmt.channels == 0 || fmt.block_align != fmt.channels * (fmt.bits / 8)) return false;
+            fmt.data = c.data;
+            fmt.frames = c.avail / fmt.block_align;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Converts every frame of 'fmt' into out_channels planar buffers (out[o] has room for
+// fmt.frames samples). Dither is applied only to sources wider than 16 bits or when
+// channels are folded, so 16-bit material passed through unchanged stays bit-exact.
+inline void ReadWavPlanar(const WavFormat& fmt, uint16_t out_channels, int16_t* const* out, WavDither dither = WavDither::None) {
+    TRACE_SCOPE_CAT("ReadWavPlanar", "codec");
+    using namespace wav_detail;
+    if (!fmt.data || fmt.frames == 0 || out_channels == 0) return;
+    const uint16_t n = fmt.channels;
+    const std::vector<float> m = FoldMatrix(fmt, out_channels);
+    // A row with a single unity gain is a plain channel pick (no mixing, no new bits).
+    bool folded = false;
+    for (uint16_t o = 0; o < out_channels; ++o) {
+        int nonzero = 0, at = -1;
+        for (uint16_t c = 0; c < n; ++c) if (m[o * n + c] != 0) { ++nonzero; at = c; }
+        if (nonzero != 1 || m[o * n + at] != 1.0f) folded = true;
+    }
+    const bool use_dither = dither == WavDither::Tpdf && (fmt.wider_than_16() || folded);
+    const std::vector<FoldTap> taps = FoldTaps(m, n, out_channels);
+    TpdfDither tpdf;
+    std::vector<float> inter(BLOCK_FRAMES * n), bus(BLOCK_FRAMES * out_channels);
+    for (size_t first = 0; first < fmt.frames; first += BLOCK_FRAMES) {
+        const size_t count = (std::min)(BLOCK_FRAMES, fmt.frames - first);
+        ToFloat(fmt, fmt.data + first * fmt.block_align, inter.data(), count * n);
+        FoldBlock(inter.data(), n, count, taps, out_channels, bus.data());
+        for (uint16_t o = 0; o < out_channels; ++o) {
+            float* b = bus.data() + o * BLOCK_FRAMES;
+            if (use_dither) tpdf.apply(b, count);
+            Clamp16(b, count);
+            BusToPcm16(b, out[o] + first, count);
+        }
+    }
+}
@@ -0,0 +1,209 @@
+#pragma once
+// WavWriter.h
+// Streaming 16-bit PCM WAV writer shared by the decoders and renderers. Samples are
+// appended in blocks of any size through a 1 MiB buffer; the header is built in memory
+// and written once, first as a placeholder and then patched on close().
+//
+// When the caller states the total up front and it fits in 32 bits, the file gets the
+// canonical 44-byte header and is preallocated to its final size. Otherwise a 36-byte
+// JUNK chunk is reserved after "WAVE": if the data ends up past 4 GB, close() turns it
+// into a ds64 chunk and the file into RF64 (EBU Tech 3306); if not, it stays a plain
+// RIFF file with a JUNK chunk that readers skip.
+//
+// WAVWRITER_MAX_RIFF_DATA (bytes of sample data a plain RIFF file may hold) can be
+// defined lower before the include so tests reach the RF64 path without writing 4 GB.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef WAVWRITER_MAX_RIFF_DATA
+#define WAVWRITER_MAX_RIFF_DATA (0xFFFFFFFFull - 36 - 36)   // 32-bit RIFF size minus the rest of the header and JUNK
+#endif
+
+class WavWriter {
+public:
+    static constexpr size_t BUFFER_BYTES = 1 << 20;
+
+    WavWriter() = default;
+    ~WavWriter() { close(); }
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    // expected_frames: the final length when known (0 = unknown, RF64-capable header).
+    bool open(const std::filesystem::path& path, uint32_t sample_rate, uint16_t channels, uint64_t expected_frames = 0) {
+        close();
+        if (channels == 0 || sample_rate == 0) return false;
+        m_rate = sample_rate; m_channels = channels;
+        const uint64_t expected_bytes = expected_frames * channels * 2;
+        m_reserve_ds64 = expected_frames == 0 || expected_bytes > MAX_RIFF_DATA;
+        m_header_bytes = m_reserve_ds64 ? 44 + JUNK_BYTES : 44;
+        if (!open_file(path)) return false;
+        if (!m_reserve_ds64) preallocate(m_header_bytes + expected_bytes);
+        m_buffer.reserve(BUFFER_BYTES);
+        m_buffer.resize(m_header_bytes);                        // placeholder, rewritten on close
+        build_header(m_buffer.data(), 0);
+        m_data_bytes = 0; m_ok = true;
+        return true;
+    }
+
+    bool is_open() const { return file_open(); }
+    uint64_t frames() const { return m_data_bytes / (2ull * m_channels); }
+
+    // Appends interleaved samples ('count' = frames * channels).
+    bool write(const int16_t* samples, size_t count) {
+        if (!file_open() || !m_ok) return false;
+        const size_t bytes = count * sizeof(int16_t);
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(samples);   // little-endian hosts
+        m_data_bytes += bytes;
+        if (m_buffer.size() + bytes <= BUFFER_BYTES) { m_buffer.insert(m_buffer.end(), p, p + bytes); return true; }
+        if (!flush()) return false;
+        if (bytes >= BUFFER_BYTES) return m_ok = write_raw(p, bytes);   // big blocks skip the copy
+        m_buffer.insert(m_buffer.end(), p, p + bytes);
+        return true;
+    }
+    bool write(const std::vector<int16_t>& samples) { return write(samples.data(), samples.size()); }
+
+    // Flushes, trims the preallocation and patches the sizes. False if any write failed,
+    // or if a canonical header was promised and the data outgrew 4 GB.
+    bool close() {
+        if (!file_open()) return false;
+        bool ok = flush() && m_ok;
+        const bool rf64 = m_data_bytes > MAX_RIFF_DATA;
+        if (rf64 && !m_reserve_ds64) ok = false;
+        uint8_t header[44 + JUNK_BYTES];
+        build_header(header, m_data_bytes);
+        ok = ok && write_at(0, header, m_header_bytes);
+        ok = ok && truncate_to(m_header_bytes + m_data_bytes + (m_data_bytes & 1));
+        close_file();
+        m_buffer.clear(); m_buffer.shrink_to_fit();
+        return ok;
+    }
+
+private:
+    static constexpr uint32_t JUNK_BYTES = 36;                   // 8-byte chunk header + ds64 body (28)
+    static constexpr uint64_t MAX_RIFF_DATA = WAVWRITER_MAX_RIFF_DATA;
+    static_assert(MAX_RIFF_DATA <= 0xFFFFFFFFull - 36 - JUNK_BYTES, "a plain RIFF size field must still fit");
+
+    static void put16(uint8_t* p, uint32_t v) { p[0] = uint8_t(v); p[1] = uint8_t(v >> 8); }
+    static void put32(uint8_t* p, uint32_t v) { put16(p, v & 0xFFFF); put16(p + 2, v >> 16); }
+    static void put64(uint8_t* p, uint64_t v) { put32(p, uint32_t(v)); put32(p + 4, uint32_t(v >> 32)); }
+
+    void build_header(uint8_t* h, uint64_t data_bytes) const {
+        const bool rf64 = m_reserve_ds64 && data_bytes > MAX_RIFF_DATA;
+        const uint64_t riff_bytes = m_header_bytes - 8 + data_bytes + (data_bytes & 1);
+        memset(h, 0, m_header_bytes);
+        memcpy(h, rf64 ? "RF64" : "RIFF", 4);
+        put32(h + 4, rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(riff_bytes));
+        memcpy(h + 8, "WAVE", 4);
+        uint8_t* p = h + 12;
+        if (m_reserve_ds64) {
+            memcpy(p, rf64 ? "ds64" : "JUNK", 4);
+            put32(p + 4, JUNK_BYTES - 8);
+            if (rf64) { put64(p + 8, riff_bytes); put64(p + 16, data_bytes); put64(p + 24, frames_of(data_bytes)); }
+            p += JUNK_BYTES;
+        }
+        memcpy(p, "fmt ", 4); put32(p + 4, 16);
+        put16(p + 8, 1); put16(p + 10, m_channels); put32(p + 12, m_rate);
+        put32(p + 16, m_rate * m_channels * 2u); put16(p + 20, m_channels * 2u); put16(p + 22, 16);
+        memcpy(p + 24, "data", 4);
+        put32(p + 28, rf64 ? 0xFFFFFFFFu : static_cast<uint32_t>(data_bytes));
+    }
+    uint64_t frames_of(uint64_t bytes) const { return bytes / (2ull * m_channels); }
+
+    bool flush() {
+        if (m_buffer.empty()) return true;
+        const bool ok = write_raw(m_buffer.data(), m_buffer.size());
+        m_buffer.clear();
+        if (!ok) m_ok = false;
+        return ok;
+    }
+
+#ifdef _WIN32
+    bool open_file(const std::filesystem::path& path) {
+        m_file = CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (m_file == INVALID_HANDLE_VALUE) { m_file = NULL; return false; }
+        return true;
+    }
+    bool file_open() const { return m_file != NULL; }
+    void close_file() { CloseHandle(m_file); m_file = NULL; }
+    bool preallocate(uint64_t bytes) {
+        LARGE_INTEGER end, zero{};
+        end.QuadPart = static_cast<LONGLONG>(bytes);
+        const bool ok = SetFilePointerEx(m_file, end, NULL, FILE_BEGIN) && SetEndOfFile(m_file);
+        return SetFilePointerEx(m_file, zero, NULL, FILE_BEGIN) && ok;
+    }
+    bool write_raw(const uint8_t* p, size_t bytes) {
+        while (bytes) {
+            DWORD done = 0;
+            const DWORD chunk = static_cast<DWORD>((std::min)(bytes, static_cast<size_t>(1) << 30));
+            if (!WriteFile(m_file, p, chunk, &done, NULL) || done == 0) return false;
+            p += done; bytes -= done;
+        }
+        return true;
+    }
+    bool write_at(uint64_t offset, const uint8_t* p, size_t bytes) {
+        LARGE_INTEGER at;
+        at.QuadPart = static_cast<LONGLONG>(offset);
+        return SetFilePointerEx(m_file, at, NULL, FILE_BEGIN) && write_raw(p, bytes);
+    }
+    bool truncate_to(uint64_t bytes) {
+        LARGE_INTEGER at;
+        at.QuadPart = static_cast<LONGLONG>(bytes);
+        return SetFilePointerEx(m_file, at, NULL, FILE_BEGIN) && SetEndOfFile(m_file);
+    }
+    HANDLE m_file = NULL;
+#else
+    bool open_file(const std::filesystem::path& path) {
+        m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        return m_fd >= 0;
+    }
+    bool file_open() const { return m_fd >= 0; }
+    void close_file() { ::close(m_fd); m_fd = -1; }
+    bool preallocate(uint64_t bytes) { return ftruncate(m_fd, static_cast<off_t>(bytes)) == 0; }
+    bool write_raw(const uint8_t* p, size_t bytes) {
+        while (bytes) {
+            const ssize_t done = ::write(m_fd, p, bytes);
+            if (done <= 0) return false;
+            p += done; bytes -= static_cast<size_t>(done);
+        }
+        return true;
+    }
+    bool write_at(uint64_t offset, const uint8_t* p, size_t bytes) {
+        while (bytes) {
+            const ssize_t done = ::pwrite(m_fd, p, bytes, static_cast<off_t>(offset));
+            if (done <= 0) return false;
+            p += done; offset += static_cast<uint64_t>(done); bytes -= static_cast<size_t>(done);
+        }
+        return true;
+    }
+    bool truncate_to(uint64_t bytes) { return ftruncate(m_fd, static_cast<off_t>(bytes)) == 0; }
+    int m_fd = -1;
+#endif
+
+    uint32_t m_rate = 0;
+    uint16_t m_channels = 0;
+    bool m_reserve_ds64 = false, m_ok = false;
+    uint32_t m_header_bytes = 44;
+    uint64_t m_data_bytes = 0;
+    std::vector<uint8_t> m_buffer;
+};
+
+// Whole-buffer convenience: interleaved 'samples' ('count' = frames * channels).
+inline bool WriteWavFile(const std::filesystem::path& path, const int16_t* samples, size_t count, uint32_t sample_rate, uint16_t channels) {
+    WavWriter w;
+    if (!w.open(path, sample_rate, channels, channels ? count / channels : 0)) return false;
+    w.write(samples, count);
+    return w.close();
+}
@@ -0,0 +1,92 @@
+#pragma once
+// XboxAdpcm.h
+// Decoder for the Xbox IMA ADPCM payloads stored in XBB/XSB banks (WAVE format tag
+// 0x0069). Each block holds, per channel, a 4-byte header (first sample + step index)
+// followed by 32 bytes of nibbles; channels alternate every 4 bytes. A block is
+// 36 * channels bytes and yields 64 samples per channel.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "PcmCache.h"
+#include "Trace.h"
+
+constexpr uint16_t WAVE_FORMAT_PCM = 0x0001;
+constexpr uint16_t WAVE_FORMAT_XBOX_ADPCM = 0x0069;
+
+namespace xadpcm_detail {
+
+constexpr int16_t STEPS[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+constexpr int8_t INDEX_STEP[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+
+inline int16_t expand(int nibble, int& predictor, int& index) {
+    const int step = STEPS[index];
+    int diff = step >> 3;
+    if (nibble & 4) diff += step;
+    if (nibble & 2) diff += step >> 1;
+    if (nibble & 1) diff += step >> 2;
+    predictor += (nibble & 8) ? -diff : diff;
+    predictor = (std::min)(32767, (std::max)(-32768, predictor));
+    index = (std::min)(88, (std::max)(0, index + INDEX_STEP[nibble]));
+    return static_cast<int16_t>(predictor);
+}
+
+} // namespace xadpcm_detail
+
+// Appends the interleaved samples of every whole block in [data, data + len).
+inline void DecodeXboxAdpcm(const uint8_t* data, size_t len, uint16_t channels, std::vector<int16_t>& out) {
+    using namespace xadpcm_detail;
+    if (channels == 0) return;
+    const size_t block = 36u * channels;
+    const size_t blocks = len / block;
+    size_t at = out.size();
+    out.resize(at + blocks * 64u * channels);
+    int predictor[8] = {}, index[8] = {};
+    for (size_t b = 0; b < blocks; ++b, at += 64u * channels) {
+        const uint8_t* p = data + b * block;
+        for (uint16_t c = 0; c < channels && c < 8; ++c) {
+            predictor[c] = static_cast<int16_t>(p[c * 4] | (p[c * 4 + 1] << 8));
+            index[c] = (std::min)(88, static_cast<int>(p[c * 4 + 2]));
+        }
+        const uint8_t* nib = p + 4u * channels;
+        for (int group = 0; group < 8; ++group) {          // 8 samples per channel per group
+            for (uint16_t c = 0; c < channels; ++c, nib += 4) {
+                if (c >= 8) continue;
+                int16_t* dst = &out[at + (group * 8u) * channels + c];
+                for (int k = 0; k < 4; ++k) {
+                    dst[(2 * k) * channels] = expand(nib[k] & 0x0F, predictor[c], index[c]);
+                    dst[(2 * k + 1) * channels] = expand(nib[k] >> 4, predictor[c], index[c]);
+                }
+            }
+        }
+    }
+}
+
+// Decodes a RIFF "fmt " chunk body plus its "data" bytes. Handles 16-bit PCM and Xbox
+// ADPCM; anything else returns false.
+inline bool DecodeWaveData(const uint8_t* fmt, size_t fmt_len, const uint8_t* data, size_t len, PcmBuffer& out) {
+    TRACE_SCOPE_CAT("DecodeWaveData", "codec");
+    if (fmt_len < 16) return false;
+    auto u16 = [&](size_t o) { return static_cast<uint16_t>(fmt[o] | (fmt[o + 1] << 8)); };
+    const uint16_t tag = u16(0), channels = u16(2), bits = u16(14);
+    uint32_t rate = 0; memcpy(&rate, fmt + 4, 4);
+    if (channels == 0 || rate == 0) return false;
+    out.sample_rate = rate; out.channels = channels; out.samples.clear();
+    if (tag == WAVE_FORMAT_XBOX_ADPCM) { DecodeXboxAdpcm(data, len, channels, out.samples); return true; }
+    if (tag == WAVE_FORMAT_PCM && bits == 16) {
+        const size_t n = len / 2 / channels * channels;
+        out.samples.resize(n);
+        if (n) memcpy(out.samples.data(), data, n * 2);
+        return true;
+    }
+    return false;
+}
@@ -7,16 +7,28 @@
 #include <sstream>
 #include <set>
 #include <tuple>
+#include <unordered_map>
 #include <cstring> // For strlen, strcmp
 #include <cstdio>  // For snprintf
+#include <cwctype> // For towlower
+#include <numeric> // For iota
 #include <stdexcept> // For std::stoi exceptions
 
+#include "../Common/FloIndex.h"
+#include "../Common/FloParser.h"
+#include "../Common/FloWriter.h"
+#include "../Common/GroupedRowView.h"
+#include "../Common/StringPool.h"
+#include "../Common/Trace.h"
+#include "../Common/TrigramIndex.h"
+
 #pragma comment(lib, "comctl32.lib")
 
 // Control IDs
 constexpr int ID_MENU_OPEN = 201;
 constexpr int ID_LIST_EVENTS = 101;
 constexpr int ID_COMBO_FILTER = 202;
+constexpr int IDC_EDIT_SEARCH = 203;
 
 // EventMap Entry Controls
 constexpr int IDC_EDIT_ID = 301;
@@ -57,6 +69,7 @@ enum class EventLinkType {
 struct EventLink {
     int param_1; // The first integer on the link line (e.g., 0)
     int simple_event_id; // The second integer (the actual link)
+    bool names_sdf = false; // Single-value link line: param_1 is a SoundDataFile ID, not a SimpleEvent link
 };
 
 // Random Event structure
@@ -75,7 +88,7 @@ struct CompoundEvent {
 struct SoundDataFileEntry {
     int id;
     std::wstring type_char; // 'c', 'b', etc.
-    std::wstring filename;
+    uint32_t filename_id = 0; // g_strings id of the filename
     bool is_newly_added = false; // To help SaveFlo identify new entries
 };
 
@@ -97,16 +110,18 @@ struct SoundDataBundle {
 
 
 // Event structure (for EventMaps) - Modified for multiple filenames
+// Strings live once in g_strings; entries only keep their ids and display text is built on demand.
 struct SoundEventEntry {
     int event_id;
     int link_type_val;     // The 2nd value on the line (0=Simple, 1=Random, 2=Compound)
     int linked_id;           // The 3rd value (ID of Simple/Random/Compound event)
-    std::wstring event_name;
-    std::wstring section; // "Pre" or "Pos"
+    uint32_t name_id = 0;  // g_strings id of the full EventMap name
+    uint32_t group_id = 0; // g_strings id of the filter group ("Prefix*Group_Rest" -> "Group")
+    uint8_t section = flo::SUB_PRE; // flo::SUB_PRE or flo::SUB_POS
 
     EventLinkType link_type = EventLinkType::Unknown; // To be determined after all parsing
-    // MODIFIED: Store multiple filenames
-    std::vector<std::wstring> sound_data_filenames;
+    // g_strings ids of the resolved filename(s), or of the "N/A (...)" note explaining a broken link
+    std::vector<uint32_t> file_ids;
     bool is_newly_added = false; // To help SaveFlo identify new EventMap entries
 };
 
@@ -119,6 +134,7 @@ HINSTANCE g_hInst;
 HWND      g_hMainWnd;
 HWND      g_hListEvents;
 HWND      g_hComboFilter;
+HWND      g_hEditSearch;
 // Labels for top row display
 HWND      g_hLblEventMappingsTitle; // New
 HWND      g_hLabelPre;
@@ -154,7 +170,7 @@ HWND      g_hEditSeBundleIdx;
 HWND      g_hBtnAddSoundSimple;
 
 
-std::vector<SoundEventEntry> g_events;
+std::vector<SoundEventEntry> g_events; // File order, append-only: the list shows it through a sorted view
 std::vector<SoundDataFileEntry> g_soundDataFiles;
 std::vector<SimpleEventEntry> g_simpleEvents;
 std::vector<RandomEvent> g_randomEvents;
@@ -162,7 +178,15 @@ std::vector<CompoundEvent> g_compoundEvents;
 std::vector<SoundDataBundle> g_soundDataBundles;
 
 
-std::wstring g_filterName;
+// Interned names, filenames and notes for the loaded document (cleared on load)
+WStringPool g_strings;
+
+// Rows shown by the (owner-data) list: g_events indices filtered by group (g_strings id,
+// GroupedRowView::ALL for "All") in the current sort order
+GroupedRowView g_view;
+// Event names + resolved filenames by g_events index, for the search box
+TrigramIndex g_search;
+std::vector<uint32_t> g_searchHits; // rows matching the search box (used while it is not empty)
 // Counts displayed and used for identifying *new* entries for saving
 int g_preTotalEventMapEntries = 0;
 int g_posTotalEventMapEntries = 0;
@@ -192,100 +216,318 @@ static std::wstring Trim(const std::wstring& s) {
     return s.substr(start, end - start + 1);
 }
 
-// Trim whitespace (string)
-static std::string TrimA(const std::string& s) {
-    const char* ws = " \t\r\n";
-    auto start = s.find_first_not_of(ws);
-    if (start == std::string::npos) return "";
-    auto end = s.find_last_not_of(ws);
-    return s.substr(start, end - start + 1);
+static const wchar_t* SectionLabel(uint8_t section) {
+    return section == flo::SUB_PRE ? L"Pre" : L"Pos";
 }
 
-// --- Helper Function: Find specific SDF filename by ID ---
-std::wstring FindSdfFilename(int sdf_id) {
-    for (const auto& sdf : g_soundDataFiles) {
-        if (sdf.id == sdf_id) {
-            return sdf.filename;
-        }
+// "Prefix*Group_Rest" -> id of "Group" (names without '*' or '_' use the whole remainder)
+static uint32_t GroupIdFor(std::wstring_view name) {
+    size_t pos = name.find(L'*');
+    std::wstring_view sub = (pos != std::wstring_view::npos) ? name.substr(pos + 1) : name;
+    size_t us = sub.find(L'_');
+    return g_strings.intern((us != std::wstring_view::npos) ? sub.substr(0, us) : sub);
+}
+
+// Sound File(s) column text, built when the row is shown
+static std::wstring JoinFilenames(const SoundEventEntry& e) {
+    if (e.file_ids.empty()) return L"N/A";
+    std::wstring out;
+    for (size_t i = 0; i < e.file_ids.size(); ++i) {
+        if (i) out += L", "; // Add comma separator
+        out += g_strings.view(e.file_ids[i]);
     }
-    return L""; // Return empty string if not found
+    return out;
 }
 
-// --- Helper Function: Find specific SimpleEvent by ID ---
-const SimpleEventEntry* FindSimpleEvent(int se_id) {
-    for (const auto& se : g_simpleEvents) {
-        if (se.id == se_id) {
-            return &se;
-        }
+static uint32_t InternNote(const std::wstring& note) {
+    return g_strings.intern(note);
+}
+
+// What the search box matches: the event name and each resolved filename (notes included)
+static std::wstring SearchTextFor(const SoundEventEntry& e) {
+    std::wstring text(g_strings.view(e.name_id));
+    for (uint32_t id : e.file_ids) {
+        text += TrigramIndex::FIELD_SEPARATOR;
+        text += g_strings.view(id);
     }
-    return nullptr; // Return null if not found
+    return text;
 }
 
+// --- Link Graph ---
+// id -> index tables over the g_ vectors, plus reverse edges keyed by the *target* id
+// (SDF -> SimpleEvents -> Random/Compound -> EventMaps). Edges are recorded even when the
+// target does not exist yet, so adding the missing entry later finds the events waiting on it.
+// When an ID is declared twice the later entry wins (same as the .flo.idx expansion).
+struct LinkGraph {
+    std::unordered_map<int, size_t> sdfIndex, simpleIndex, randomIndex, compoundIndex;
+    std::unordered_map<int, std::vector<int>> simplesBySdf;            // SDF id -> SimpleEvent ids playing it
+    std::unordered_map<int, std::vector<uint64_t>> linkedBySimple;     // SimpleEvent id -> Random/Compound target keys
+    std::unordered_map<int, std::vector<uint64_t>> linkedBySdf;        // SDF id -> Random/Compound target keys naming it directly
+    std::unordered_map<uint64_t, std::vector<size_t>> eventsByTarget;  // (link type, linked id) -> g_events indices
+};
+LinkGraph g_graph;
 
-// --- Corrected Helper Function: GetSoundFilenamesForEventMap ---
-// Returns a vector of filenames associated with the event
-std::vector<std::wstring> GetSoundFilenamesForEventMap(const SoundEventEntry& event) {
-    std::vector<std::wstring> filenames;
-    std::vector<int> simpleEventIdsToFind; // Store IDs to look up
+static uint64_t TargetKey(int link_type_val, int linked_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(link_type_val)) << 32) | static_cast<uint32_t>(linked_id);
+}
 
-    if (event.link_type == EventLinkType::Simple) {
-        // --- Path A ---
-        // The 'linked_id' *is* the SimpleEvent ID.
-        simpleEventIdsToFind.push_back(event.linked_id);
+static void GraphAddSdf(size_t idx) {
+    g_graph.sdfIndex[g_soundDataFiles[idx].id] = idx;
+}
 
+static void GraphAddSimple(size_t idx) {
+    const SimpleEventEntry& se = g_simpleEvents[idx];
+    g_graph.simpleIndex[se.id] = idx;
+    g_graph.simplesBySdf[se.sound_data_file_id].push_back(se.id);
+}
+
+static void GraphAddLinked(int link_type_val, int id, const std::vector<EventLink>& links) {
+    const uint64_t key = TargetKey(link_type_val, id);
+    for (const auto& link : links) {
+        if (link.names_sdf) g_graph.linkedBySdf[link.param_1].push_back(key);
+        else g_graph.linkedBySimple[link.simple_event_id].push_back(key);
     }
-    else if (event.link_type == EventLinkType::Random) {
-        // --- Path B (Random) ---
-        // Find the RandomEvent using the EventMap's 'linked_id'.
-        for (const auto& randomEvent : g_randomEvents) {
-            if (randomEvent.id == event.linked_id) {
-                // Collect *all* SimpleEvent IDs from *inside* the RandomEvent's links.
-                for (const auto& link : randomEvent.links) {
-                    simpleEventIdsToFind.push_back(link.simple_event_id);
-                }
-                break; // Found the Random Event
-            }
+}
+
+static void GraphAddEvent(size_t idx) {
+    const SoundEventEntry& e = g_events[idx];
+    g_graph.eventsByTarget[TargetKey(e.link_type_val, e.linked_id)].push_back(idx);
+}
+
+static void RebuildLinkGraph() {
+    g_graph = LinkGraph();
+    g_graph.sdfIndex.reserve(g_soundDataFiles.size());
+    g_graph.simpleIndex.reserve(g_simpleEvents.size());
+    for (size_t i = 0; i < g_soundDataFiles.size(); ++i) GraphAddSdf(i);
+    for (size_t i = 0; i < g_simpleEvents.size(); ++i) GraphAddSimple(i);
+    for (size_t i = 0; i < g_randomEvents.size(); ++i) {
+        g_graph.randomIndex[g_randomEvents[i].id] = i;
+        GraphAddLinked(static_cast<int>(EventLinkType::Random), g_randomEvents[i].id, g_randomEvents[i].links);
+    }
+    for (size_t i = 0; i < g_compoundEvents.size(); ++i) {
+        g_graph.compoundIndex[g_compoundEvents[i].id] = i;
+        GraphAddLinked(static_cast<int>(EventLinkType::Compound), g_compoundEvents[i].id, g_compoundEvents[i].links);
+    }
+    for (size_t i = 0; i < g_events.size(); ++i) GraphAddEvent(i);
+}
+
+// Collects the g_events indices of every EventMap entry that can reach the given SimpleEvent / SDF id.
+static void CollectEventsForTarget(uint64_t key, std::vector<size_t>& events) {
+    auto it = g_graph.eventsByTarget.find(key);
+    if (it != g_graph.eventsByTarget.end()) events.insert(events.end(), it->second.begin(), it->second.end());
+}
+
+static void CollectEventsForSimple(int se_id, std::vector<size_t>& events) {
+    CollectEventsForTarget(TargetKey(static_cast<int>(EventLinkType::Simple), se_id), events);
+    auto it = g_graph.linkedBySimple.find(se_id);
+    if (it != g_graph.linkedBySimple.end())
+        for (uint64_t key : it->second) CollectEventsForTarget(key, events);
+}
+
+static void CollectEventsForSdf(int sdf_id, std::vector<size_t>& events) {
+    auto it = g_graph.simplesBySdf.find(sdf_id);
+    if (it != g_graph.simplesBySdf.end())
+        for (int se_id : it->second) CollectEventsForSimple(se_id, events);
+    auto it2 = g_graph.linkedBySdf.find(sdf_id);
+    if (it2 != g_graph.linkedBySdf.end())
+        for (uint64_t key : it2->second) CollectEventsForTarget(key, events);
+}
+
+// --- Sorted View ---
+// g_events is never reordered. Each (column, direction) gets an index permutation that is
+// built the first time it is shown and then kept: clicking back to a column is a lookup,
+// and AddEvent inserts the new index into every cached permutation by binary search.
+// Names and first filenames are compared through case-folded copies interned once, so
+// no comparison runs _wcsicmp.
+struct EventSortKey {
+    uint32_t name = 0; // g_foldedStrings ids
+    uint32_t file = 0;
+};
+WStringPool g_foldedStrings;
+std::vector<uint32_t> g_foldedOf;           // g_strings id -> g_foldedStrings id (npos until needed)
+std::vector<EventSortKey> g_sortKeys;       // parallel to g_events
+const int SORT_COLUMNS = 6;
+std::vector<uint32_t> g_sortCache[SORT_COLUMNS][2]; // [column][ascending]; empty = not built yet
+
+static uint32_t FoldedId(uint32_t id) {
+    if (id >= g_foldedOf.size()) g_foldedOf.resize(g_strings.size(), WStringPool::npos);
+    uint32_t& folded = g_foldedOf[id];
+    if (folded == WStringPool::npos) {
+        std::wstring s(g_strings.view(id));
+        for (auto& c : s) c = static_cast<wchar_t>(towlower(c));
+        folded = g_foldedStrings.intern(s);
+    }
+    return folded;
+}
+
+static EventSortKey MakeSortKey(const SoundEventEntry& e) {
+    EventSortKey k;
+    k.name = FoldedId(e.name_id);
+    k.file = FoldedId(e.file_ids.empty() ? WStringPool::empty_id : e.file_ids[0]); // first filename if several
+    return k;
+}
+
+static void ClearSortCache() {
+    for (auto& column : g_sortCache) for (auto& order : column) order.clear();
+}
+
+// Called after ParseFloFile: keys for every row, no permutation built yet.
+static void ResetSortedView() {
+    g_foldedStrings.clear();
+    g_foldedOf.assign(g_strings.size(), WStringPool::npos);
+    g_sortKeys.clear();
+    g_sortKeys.reserve(g_events.size());
+    for (const auto& e : g_events) g_sortKeys.push_back(MakeSortKey(e));
+    ClearSortCache();
+}
+
+static int CompareInt(int a, int b) { return (a > b) - (a < b); }
+
+// Row order for a column. "Pre" always comes before "Pos" unless sorting by Section (5);
+// equal rows keep file order in both directions.
+static bool EventLess(uint32_t ia, uint32_t ib, int column, bool ascending) {
+    const SoundEventEntry& a = g_events[ia];
+    const SoundEventEntry& b = g_events[ib];
+    if (column != 5 && a.section != b.section) return a.section < b.section;
+    int c = 0;
+    switch (column) {
+    case 0: c = CompareInt(a.event_id, b.event_id); break;
+    case 1: c = CompareInt(a.link_type_val, b.link_type_val); break;
+    case 2: c = CompareInt(a.linked_id, b.linked_id); break;
+    case 3: c = wcscmp(g_foldedStrings.c_str(g_sortKeys[ia].name), g_foldedStrings.c_str(g_sortKeys[ib].name)); break;
+    case 4: c = wcscmp(g_foldedStrings.c_str(g_sortKeys[ia].file), g_foldedStrings.c_str(g_sortKeys[ib].file)); break;
+    case 5:
+        c = CompareInt(a.section, b.section);
+        if (c == 0) c = CompareInt(a.event_id, b.event_id);
+        break;
+    }
+    if (c != 0) return ascending ? c < 0 : c > 0;
+    return ia < ib;
+}
+
+static void BuildOrder(int column, bool ascending, std::vector<uint32_t>& order) {
+    order.resize(g_events.size());
+    std::iota(order.begin(), order.end(), 0u);
+    if (column != 3 && column != 4) {
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return EventLess(a, b, column, ascending); });
+        return;
+    }
+    // Rank the distinct folded strings once, then sort rows by integer rank
+    std::vector<uint32_t> key(g_events.size());
+    for (size_t i = 0; i < key.size(); ++i) key[i] = (column == 3) ? g_sortKeys[i].name : g_sortKeys[i].file;
+    std::vector<uint32_t> distinct(key);
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    std::sort(distinct.begin(), distinct.end(), [](uint32_t a, uint32_t b) {
+        return wcscmp(g_foldedStrings.c_str(a), g_foldedStrings.c_str(b)) < 0;
+        });
+    std::vector<uint32_t> rank(g_foldedStrings.size());
+    for (size_t r = 0; r < distinct.size(); ++r) rank[distinct[r]] = static_cast<uint32_t>(r);
+    for (auto& k : key) k = rank[k];
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        if (g_events[a].section != g_events[b].section) return g_events[a].section < g_events[b].section;
+        if (key[a] != key[b]) return ascending ? key[a] < key[b] : key[a] > key[b];
+        return a < b;
+        });
+}
+
+// Rows in display order for the current sort column (no column = Pre then Pos, then by ID,
+// which is the Event ID ascending order).
+static const std::vector<uint32_t>& SortedOrder() {
+    const int column = g_sortColumn < 0 ? 0 : g_sortColumn;
+    const bool ascending = g_sortColumn < 0 ? true : g_sortAscending;
+    std::vector<uint32_t>& order = g_sortCache[column][ascending ? 1 : 0];
+    if (order.size() != g_events.size()) BuildOrder(column, ascending, order);
+    return order;
+}
+
+// Keeps the cached permutations valid after g_events.push_back.
+static void SortedViewAddEvent(size_t idx) {
+    g_sortKeys.push_back(MakeSortKey(g_events[idx]));
+    const uint32_t row = static_cast<uint32_t>(idx);
+    for (int column = 0; column < SORT_COLUMNS; ++column) {
+        for (int asc = 0; asc < 2; ++asc) {
+            std::vector<uint32_t>& order = g_sortCache[column][asc];
+            if (order.size() != idx) { order.clear(); continue; } // not built (or stale): build on demand
+            order.insert(std::upper_bound(order.begin(), order.end(), row,
+                [&](uint32_t a, uint32_t b) { return EventLess(a, b, column, asc != 0); }), row);
         }
     }
+}
+
+// An event's resolved filename(s) changed; only the Sound File(s) orders depend on them.
+static void SortedViewFileChanged(size_t idx) {
+    const uint32_t file = MakeSortKey(g_events[idx]).file;
+    if (g_sortKeys[idx].file == file) return;
+    g_sortKeys[idx].file = file;
+    g_sortCache[4][0].clear();
+    g_sortCache[4][1].clear();
+}
+
+// --- Helper Function: Find specific SDF filename by ID ---
+// Returns the g_strings id of the filename, or WStringPool::empty_id if not found
+uint32_t FindSdfFilename(int sdf_id) {
+    auto it = g_graph.sdfIndex.find(sdf_id);
+    if (it == g_graph.sdfIndex.end()) return WStringPool::empty_id;
+    return g_soundDataFiles[it->second].filename_id;
+}
+
+// --- Helper Function: Find specific SimpleEvent by ID ---
+const SimpleEventEntry* FindSimpleEvent(int se_id) {
+    auto it = g_graph.simpleIndex.find(se_id);
+    if (it == g_graph.simpleIndex.end()) return nullptr; // Return null if not found
+    return &g_simpleEvents[it->second];
+}
+
+
+// --- Corrected Helper Function: GetSoundFilenamesForEventMap ---
+// Returns the g_strings ids of the filenames associated with the event (hash lookups through g_graph)
+std::vector<uint32_t> GetSoundFilenamesForEventMap(const SoundEventEntry& event) {
+    std::vector<uint32_t> filenames;
+    const std::vector<EventLink>* links = nullptr; // Random/Compound link lines
+    EventLink simpleLink{ 0, event.linked_id };     // Path A: the 'linked_id' *is* the SimpleEvent ID
+
+    if (event.link_type == EventLinkType::Random) {
+        // --- Path B (Random) --- Find the RandomEvent using the EventMap's 'linked_id'.
+        auto it = g_graph.randomIndex.find(event.linked_id);
+        if (it != g_graph.randomIndex.end()) links = &g_randomEvents[it->second].links;
+    }
     else if (event.link_type == EventLinkType::Compound) {
-        // --- Path B (Compound) ---
-        // Find the CompoundEvent using the EventMap's 'linked_id'.
-        for (const auto& compoundEvent : g_compoundEvents) {
-            if (compoundEvent.id == event.linked_id) {
-                // Collect *all* SimpleEvent IDs from *inside* the CompoundEvent's links.
-                for (const auto& link : compoundEvent.links) {
-                    simpleEventIdsToFind.push_back(link.simple_event_id);
-                }
-                break; // Found the Compound Event
-            }
-        }
+        // --- Path B (Compound) --- Find the CompoundEvent using the EventMap's 'linked_id'.
+        auto it = g_graph.compoundIndex.find(event.linked_id);
+        if (it != g_graph.compoundIndex.end()) links = &g_compoundEvents[it->second].links;
     }
-    else {
-        filenames.push_back(L"N/A (Unknown Link Type)");
+    else if (event.link_type != EventLinkType::Simple) {
+        filenames.push_back(InternNote(L"N/A (Unknown Link Type)"));
         return filenames;
     }
 
     // Handle cases where the initial link target wasn't found or was empty
-    if (simpleEventIdsToFind.empty()) {
-        if (event.link_type == EventLinkType::Simple)
-            filenames.push_back(L"N/A (SimpleEvent Missing?)");
-        else
-            filenames.push_back(L"N/A (Complex Link Target Invalid/Empty)");
+    if (event.link_type != EventLinkType::Simple && (links == nullptr || links->empty())) {
+        filenames.push_back(InternNote(L"N/A (Complex Link Target Invalid/Empty)"));
         return filenames;
     }
 
-    // Now, iterate through the collected SimpleEvent IDs
-    for (int se_id : simpleEventIdsToFind) {
+    // Now, iterate through the collected links
+    const EventLink* first = links ? links->data() : &simpleLink;
+    const EventLink* last = links ? links->data() + links->size() : &simpleLink + 1;
+    for (const EventLink* link = first; link != last; ++link) {
+        if (link->names_sdf) {
+            uint32_t filename = FindSdfFilename(link->param_1);
+            filenames.push_back(filename == WStringPool::empty_id ? InternNote(L"N/A (SDF Invalid: ID " + std::to_wstring(link->param_1) + L")") : filename);
+            continue;
+        }
+        const int se_id = link->simple_event_id;
         const SimpleEventEntry* simpleEvent = FindSimpleEvent(se_id);
         if (simpleEvent == nullptr) {
-            filenames.push_back(L"N/A (SimpleEvent Link Invalid: ID " + std::to_wstring(se_id) + L")");
+            filenames.push_back(InternNote(L"N/A (SimpleEvent Link Invalid: ID " + std::to_wstring(se_id) + L")"));
             continue; // Skip to next ID if this one is bad
         }
 
         // Find the SoundDataFile filename using the SimpleEvent's sound_data_file_id
-        std::wstring filename = FindSdfFilename(simpleEvent->sound_data_file_id);
-        if (filename.empty()) {
-            filenames.push_back(L"N/A (SDF Invalid: ID " + std::to_wstring(simpleEvent->sound_data_file_id) + L")");
+        uint32_t filename = FindSdfFilename(simpleEvent->sound_data_file_id);
+        if (filename == WStringPool::empty_id) {
+            filenames.push_back(InternNote(L"N/A (SDF Invalid: ID " + std::to_wstring(simpleEvent->sound_data_file_id) + L")"));
         }
         else {
             filenames.push_back(filename); // Add the found filename
@@ -294,19 +536,48 @@ std::vector<std::wstring> GetSoundFilenamesForEventMap(const SoundEventEntry& ev
 
     // If after all lookups, the list is still empty (e.g., all links were invalid)
     if (filenames.empty()) {
-        filenames.push_back(L"N/A (All Links Invalid?)");
+        filenames.push_back(InternNote(L"N/A (All Links Invalid?)"));
     }
 
     return filenames;
 }
 
 
-// Parse .flo
+// Filename ids for one EventMaps row of a resolved model (same wording as GetSoundFilenamesForEventMap).
+// sdfFilenameIds[r] is the g_strings id of model.sdf.filename[r].
+static std::vector<uint32_t> FilenamesFromExpansion(const flo::Expansion& x, const std::vector<uint32_t>& sdfFilenameIds, size_t row) {
+    std::vector<uint32_t> filenames;
+    if (x.status[row] == flo::EXP_UNKNOWN_TYPE) {
+        filenames.push_back(InternNote(L"N/A (Unknown Link Type)"));
+        return filenames;
+    }
+    if (x.status[row] == flo::EXP_TARGET_MISSING) {
+        filenames.push_back(InternNote(L"N/A (Complex Link Target Invalid/Empty)"));
+        return filenames;
+    }
+    filenames.reserve(x.count[row]);
+    for (uint32_t k = x.first[row]; k < x.first[row] + x.count[row]; ++k) {
+        if (x.sdf_row[k] == flo::ROW_SIMPLE_MISSING) {
+            filenames.push_back(InternNote(L"N/A (SimpleEvent Link Invalid: ID " + std::to_wstring(x.simple_id[k]) + L")"));
+        }
+        else if (x.sdf_row[k] == flo::ROW_SDF_MISSING || sdfFilenameIds[x.sdf_row[k]] == WStringPool::empty_id) {
+            filenames.push_back(InternNote(L"N/A (SDF Invalid: ID " + std::to_wstring(x.sdf_id[k]) + L")"));
+        }
+        else {
+            filenames.push_back(sdfFilenameIds[x.sdf_row[k]]);
+        }
+    }
+    return filenames;
+}
+
+
+// Parse .flo (memory-mapped .flo.idx sidecar when current, otherwise a single pass over
+// the memory-mapped file, see Common/FloIndex.h and Common/FloParser.h)
 static bool ParseFloFile(const std::wstring& path) {
-    std::wifstream in(path);
-    if (!in) return false;
-    std::vector<std::wstring> lines;
-    for (std::wstring line; std::getline(in, line); ) lines.push_back(line);
+    flo::Model model;
+    flo::Expansion expansion;
+    if (!flo::LoadOrParse(path, model, expansion)) return false;
+    if (!model.has_event_maps) return false; // Leave the current document untouched
 
     // Clear all global data vectors
     g_events.clear();
@@ -315,350 +586,160 @@ static bool ParseFloFile(const std::wstring& path) {
     g_randomEvents.clear();
     g_compoundEvents.clear();
     g_soundDataBundles.clear(); // Clear bundles
+    g_strings.clear();
+
+    // Counts as declared in the file (shown in the labels and used for identifying new entries)
+    g_loadedSoundDataFileCount = model.blocks[flo::BLK_SDF].declared;
+    g_loadedSimpleEventCount = model.blocks[flo::BLK_SIMPLE].declared;
+    g_loadedRandomEventCount = model.blocks[flo::BLK_RANDOM].declared;
+    g_loadedCompoundEventCount = model.blocks[flo::BLK_COMPOUND].declared;
+    g_loadedPreEventMapCount = model.blocks[flo::BLK_MAP_PRE].declared;
+    g_loadedPanCount = model.blocks[flo::BLK_MAP_PAN].declared;
+    g_loadedPosEventMapCount = model.blocks[flo::BLK_MAP_POS].declared;
+    g_preTotalEventMapEntries = g_loadedPreEventMapCount;
+    g_posTotalEventMapEntries = g_loadedPosEventMapCount;
 
-
-    g_preTotalEventMapEntries = g_posTotalEventMapEntries = 0;
-    g_loadedPreEventMapCount = g_loadedPosEventMapCount = 0;
-    g_loadedSoundDataFileCount = 0;
-    g_loadedSimpleEventCount = 0;
-    g_loadedRandomEventCount = 0;   // Reset new counts
-    g_loadedCompoundEventCount = 0; // Reset new counts
-    g_loadedPanCount = 0;           // Reset PAN count
-
-
-    // Parse SoundDataBundles section
-    int idxSDB = -1;
-    for (int i = 0; i < (int)lines.size(); ++i) {
-        if (Trim(lines[i]) == L"SoundDataBundles") { idxSDB = i; break; }
+    // --- SoundDataBundles ---
+    g_soundDataBundles.reserve(model.bundles.size());
+    for (size_t i = 0; i < model.bundles.size(); ++i) {
+        g_soundDataBundles.push_back({ model.bundles.id[i], flo::Widen(model.bundles.type[i]), flo::Widen(model.bundles.path[i]) });
     }
-    if (idxSDB >= 0 && idxSDB + 1 < (int)lines.size()) {
-        std::wstring countLineSDB = Trim(lines[idxSDB + 1]);
-        if (!countLineSDB.empty()) {
-            try {
-                int bundleCount = _wtoi(countLineSDB.c_str());
-                for (int j = 0; j < bundleCount; ++j) {
-                    int li = idxSDB + 2 + j;
-                    if (li >= (int)lines.size()) break;
-                    std::wstringstream ss(lines[li]);
-                    SoundDataBundle sdb_entry; std::wstring tok;
-                    std::getline(ss, tok, L','); sdb_entry.id = _wtoi(Trim(tok).c_str());
-                    std::getline(ss, tok, L','); sdb_entry.type = Trim(tok);
-                    std::getline(ss, tok);      sdb_entry.path = Trim(tok);
-                    g_soundDataBundles.push_back(sdb_entry);
-                }
-            }
-            catch (const std::exception&) { /* ignore */ }
-        }
-    }
-
 
-    // --- Parse SoundDataFiles section ---
-    int idxSDF = -1;
-    for (int i = 0; i < (int)lines.size(); ++i) {
-        if (Trim(lines[i]) == L"SoundDataFiles") { idxSDF = i; break; }
-    }
-    if (idxSDF >= 0 && idxSDF + 1 < (int)lines.size()) {
-        std::wstring countLineSDF = Trim(lines[idxSDF + 1]);
-        if (!countLineSDF.empty()) {
-            try {
-                g_loadedSoundDataFileCount = _wtoi(countLineSDF.c_str());
-                if (g_loadedSoundDataFileCount < 0) g_loadedSoundDataFileCount = 0;
-                for (int j = 0; j < g_loadedSoundDataFileCount; ++j) {
-                    int li = idxSDF + 2 + j;
-                    if (li >= (int)lines.size()) break;
-                    std::wstringstream ss(lines[li]);
-                    SoundDataFileEntry sdf_entry; std::wstring tok;
-                    std::getline(ss, tok, L','); sdf_entry.id = _wtoi(Trim(tok).c_str());
-                    std::getline(ss, tok, L','); sdf_entry.type_char = Trim(tok);
-                    std::getline(ss, tok);      sdf_entry.filename = Trim(tok);
-                    sdf_entry.is_newly_added = false;
-                    g_soundDataFiles.push_back(sdf_entry);
-                }
-            }
-            catch (const std::exception&) { g_loadedSoundDataFileCount = 0; }
-        }
+    // --- SoundDataFiles ---
+    g_soundDataFiles.reserve(model.sdf.size());
+    std::vector<uint32_t> sdfFilenameIds(model.sdf.size());
+    for (size_t i = 0; i < model.sdf.size(); ++i) {
+        SoundDataFileEntry sdf_entry;
+        sdf_entry.id = model.sdf.id[i];
+        sdf_entry.type_char = flo::Widen(model.sdf.type[i]);
+        sdf_entry.filename_id = sdfFilenameIds[i] = g_strings.intern(flo::Widen(model.sdf.filename[i]));
+        g_soundDataFiles.push_back(std::move(sdf_entry));
     }
 
-    // --- Parse SimpleEvents section ---
-    int idxSE = -1;
-    for (int i = 0; i < (int)lines.size(); ++i) {
-        if (Trim(lines[i]) == L"SimpleEvents") { idxSE = i; break; }
-    }
-    if (idxSE >= 0 && idxSE + 1 < (int)lines.size()) {
-        std::wstring countLineSE = Trim(lines[idxSE + 1]);
-        if (!countLineSE.empty()) {
-            try {
-                g_loadedSimpleEventCount = _wtoi(countLineSE.c_str());
-                if (g_loadedSimpleEventCount < 0) g_loadedSimpleEventCount = 0;
-                for (int j = 0; j < g_loadedSimpleEventCount; ++j) {
-                    int li = idxSE + 2 + j;
-                    if (li >= (int)lines.size()) break;
-                    std::wstringstream ss(lines[li]);
-                    SimpleEventEntry se_entry; std::wstring tok;
-                    std::getline(ss, tok, L','); se_entry.id = _wtoi(Trim(tok).c_str());
-                    std::getline(ss, tok, L','); se_entry.sound_data_file_id = _wtoi(Trim(tok).c_str());
-                    std::getline(ss, tok, L','); se_entry.type = _wtoi(Trim(tok).c_str());
-                    std::getline(ss, tok, L','); se_entry.linked_event_id = _wtoi(Trim(tok).c_str());
-                    se_entry.is_newly_added = false;
-                    g_simpleEvents.push_back(se_entry);
-                }
-            }
-            catch (const std::exception&) { g_loadedSimpleEventCount = 0; }
-        }
+    // --- SimpleEvents ---
+    g_simpleEvents.reserve(model.simple.size());
+    for (size_t i = 0; i < model.simple.size(); ++i) {
+        SimpleEventEntry se_entry;
+        se_entry.id = model.simple.id[i];
+        se_entry.sound_data_file_id = model.simple.sdf_id[i];
+        se_entry.type = model.simple.param_set[i];
+        se_entry.linked_event_id = model.simple.pan[i];
+        g_simpleEvents.push_back(se_entry);
     }
 
-    // --- Helper lambda for parsing Random/Compound Events ---
-    auto parseEventLinks = [&](int startIndex, int count, std::vector<EventLink>& links) {
-        int linesRead = 0;
-        for (int j = 0; j < count; ++j) {
-            int li = startIndex + j;
-            if (li >= (int)lines.size()) break;
-            std::wstringstream ss(lines[li]);
-            EventLink link; std::wstring tok;
-            // Handle potential extra values on Compound link lines (like the trailing ", 0")
-            std::getline(ss, tok, L','); link.param_1 = _wtoi(Trim(tok).c_str());
-            std::getline(ss, tok, L','); link.simple_event_id = _wtoi(Trim(tok).c_str());
-            // Ignore any further tokens on the line for now
-            links.push_back(link);
-            linesRead++;
+    // --- RandomEvents / CompoundEvents (link rows are "param_1, simple_event_id[, ...]") ---
+    auto copyLinks = [](const flo::LinkedEvents& src, size_t i, std::vector<EventLink>& links) {
+        links.reserve(src.count[i]);
+        for (uint32_t k = src.first[i]; k < src.first[i] + src.count[i]; ++k) {
+            if (src.link_arity[k] == 0) continue;   // empty slot, skipped like the resolver and renderer do
+            links.push_back({ src.link_a[k], src.link_b[k], src.link_arity[k] == 1 });
         }
-        return linesRead;
         };
-
-    // --- Parse RandomEvents ---
-    int idxRE = -1;
-    for (int i = 0; i < (int)lines.size(); ++i) {
-        if (Trim(lines[i]) == L"RandomEvents") { idxRE = i; break; }
-    }
-    if (idxRE >= 0 && idxRE + 1 < (int)lines.size()) {
-        // Store Random count
-        g_loadedRandomEventCount = _wtoi(Trim(lines[idxRE + 1]).c_str());
-        if (g_loadedRandomEventCount < 0) g_loadedRandomEventCount = 0;
-
-        int currentLineIndex = idxRE + 2;
-        for (int i = 0; i < g_loadedRandomEventCount; ++i) { // Use stored count
-            if (currentLineIndex >= (int)lines.size()) break;
-            std::wstringstream ss(lines[currentLineIndex]);
-            RandomEvent re; std::wstring tok;
-            std::getline(ss, tok, L','); re.id = _wtoi(Trim(tok).c_str());
-            std::getline(ss, tok, L','); int linkCount = _wtoi(Trim(tok).c_str());
-            currentLineIndex++; // Move to the first link line
-            int linksRead = parseEventLinks(currentLineIndex, linkCount, re.links);
-            g_randomEvents.push_back(re);
-            currentLineIndex += linksRead; // Advance past the link lines
-        }
-    }
-
-    // --- Parse CompoundEvents ---
-    int idxCE = -1;
-    for (int i = 0; i < (int)lines.size(); ++i) {
-        if (Trim(lines[i]) == L"CompoundEvents") { idxCE = i; break; }
-    }
-    if (idxCE >= 0 && idxCE + 1 < (int)lines.size()) {
-        // Store Compound count
-        g_loadedCompoundEventCount = _wtoi(Trim(lines[idxCE + 1]).c_str());
-        if (g_loadedCompoundEventCount < 0) g_loadedCompoundEventCount = 0;
-
-        int currentLineIndex = idxCE + 2;
-        for (int i = 0; i < g_loadedCompoundEventCount; ++i) { // Use stored count
-            if (currentLineIndex >= (int)lines.size()) break;
-            std::wstringstream ss(lines[currentLineIndex]);
-            CompoundEvent ce; std::wstring tok;
-            std::getline(ss, tok, L','); ce.id = _wtoi(Trim(tok).c_str());
-            std::getline(ss, tok, L','); int linkCount = _wtoi(Trim(tok).c_str());
-            currentLineIndex++; // Move to the first link line
-            int linksRead = parseEventLinks(currentLineIndex, linkCount, ce.links);
-            g_compoundEvents.push_back(ce);
-            currentLineIndex += linksRead; // Advance past the link lines
-        }
+    g_randomEvents.reserve(model.random.size());
+    for (size_t i = 0; i < model.random.size(); ++i) {
+        RandomEvent re; re.id = model.random.id[i];
+        copyLinks(model.random, i, re.links);
+        g_randomEvents.push_back(std::move(re));
     }
-
-
-    // --- Locate EventMaps ---
-    int idxMaps = -1;
-    for (int i = 0; i < (int)lines.size(); ++i) {
-        if (Trim(lines[i]) == L"EventMaps") { idxMaps = i; break; }
+    g_compoundEvents.reserve(model.compound.size());
+    for (size_t i = 0; i < model.compound.size(); ++i) {
+        CompoundEvent ce; ce.id = model.compound.id[i];
+        copyLinks(model.compound, i, ce.links);
+        g_compoundEvents.push_back(std::move(ce));
     }
-    if (idxMaps < 0) return false;
-
-    // --- Parse EventMap Sections (Pre, PAN, Pos) ---
-    // Helper lambda modified slightly
-    auto parseEventMapSubSection = [&](const std::wstring& name, int& loadedCountVariable) {
-        int idx = -1;
-        for (int i = idxMaps + 1; i < (int)lines.size(); ++i) {
-            // Find the *first* occurrence of the name *after* EventMaps start
-            if (Trim(lines[i]) == name) { idx = i; break; }
-        }
-        if (idx < 0 || idx + 1 >= (int)lines.size()) {
-            loadedCountVariable = 0; // Ensure count is 0 if section not found
-            return;
-        }
 
-        std::wstring countLineSection = Trim(lines[idx + 1]);
-        if (countLineSection.empty()) {
-            loadedCountVariable = 0; // Ensure count is 0 if line is empty
-            return;
-        }
-        try {
-            loadedCountVariable = _wtoi(countLineSection.c_str());
-            if (loadedCountVariable < 0) loadedCountVariable = 0;
-
-            // Only parse entries for Pre and Pos
-            if (name == L"Pre" || name == L"Pos") {
-                if (name == L"Pre") g_preTotalEventMapEntries = loadedCountVariable;
-                if (name == L"Pos") g_posTotalEventMapEntries = loadedCountVariable;
-
-                for (int j = 0; j < loadedCountVariable; ++j) {
-                    int li = idx + 2 + j;
-                    if (li >= (int)lines.size()) break;
-                    std::wstringstream ss(lines[li]);
-                    SoundEventEntry e; std::wstring tok;
-                    std::getline(ss, tok, L','); e.event_id = _wtoi(Trim(tok).c_str());
-                    std::getline(ss, tok, L','); e.link_type_val = _wtoi(Trim(tok).c_str()); // Read link type value
-                    std::getline(ss, tok, L','); e.linked_id = _wtoi(Trim(tok).c_str());
-                    std::getline(ss, tok); e.event_name = Trim(tok);
-                    e.section = name; // Set section based on current parsing context
-                    e.is_newly_added = false;
-
-                    // Link Resolution (set enum type)
-                    switch (e.link_type_val) {
-                    case 0: e.link_type = EventLinkType::Simple; break;
-                    case 1: e.link_type = EventLinkType::Random; break;
-                    case 2: e.link_type = EventLinkType::Compound; break;
-                    default: e.link_type = EventLinkType::Unknown; break;
-                    }
-                    g_events.push_back(e);
-                }
-            }
+    // --- EventMaps (Pre and Pos rows are listed; Pan is only counted) ---
+    g_events.reserve(model.maps.size());
+    for (size_t i = 0; i < model.maps.size(); ++i) {
+        if (model.maps.sub[i] == flo::SUB_PAN) continue;
+        SoundEventEntry e;
+        e.event_id = model.maps.id[i];
+        e.link_type_val = model.maps.type[i];
+        e.linked_id = model.maps.ref[i];
+        e.name_id = g_strings.intern(flo::Widen(model.maps.name[i]));
+        e.group_id = GroupIdFor(g_strings.view(e.name_id));
+        e.section = model.maps.sub[i];
+        e.is_newly_added = false;
+
+        // Link Resolution (set enum type)
+        switch (e.link_type_val) {
+        case 0: e.link_type = EventLinkType::Simple; break;
+        case 1: e.link_type = EventLinkType::Random; break;
+        case 2: e.link_type = EventLinkType::Compound; break;
+        default: e.link_type = EventLinkType::Unknown; break;
         }
-        catch (const std::exception&) { loadedCountVariable = 0; /* ignore parse error for count */ }
-        };
-
-    // Parse each subsection and store counts
-    parseEventMapSubSection(L"Pre", g_loadedPreEventMapCount);
-    parseEventMapSubSection(L"Pan", g_loadedPanCount); // Parse Pan count
-    parseEventMapSubSection(L"Pos", g_loadedPosEventMapCount);
-
-
-    // --- Filename Lookup (after all parsing is done) ---
-    for (auto& e : g_events) {
-        // Now that the link type is correctly set, find the filename(s)
-        e.sound_data_filenames = GetSoundFilenamesForEventMap(e);
+        // Filename(s) come from the expansion resolved with (or cached alongside) the model
+        e.file_ids = FilenamesFromExpansion(expansion, sdfFilenameIds, i);
+        g_events.push_back(std::move(e));
     }
-    // --- End Filename Lookup ---
-
-
-    std::stable_sort(g_events.begin(), g_events.end(), [](const SoundEventEntry& a, const SoundEventEntry& b) {
-        if (a.section == L"Pre" && b.section == L"Pos") return true;
-        if (a.section == L"Pos" && b.section == L"Pre") return false;
-        return a.event_id < b.event_id;
-        });
 
+    RebuildLinkGraph();
+    ResetSortedView();
+    g_view.clear();
+    for (const auto& e : g_events) g_view.add_row(e.group_id);
+    g_search.clear();
+    for (size_t i = 0; i < g_events.size(); ++i) g_search.set(static_cast<uint32_t>(i), SearchTextFor(g_events[i]));
     return true;
 }
 
 
-// Sort g_events based on g_sortColumn and g_sortAscending
-static void SortEvents() {
-    if (g_sortColumn < 0) return; // No column selected for sorting
+// --- List View ---
+// The list is LVS_OWNERDATA: it only holds a row count and asks for the text of the rows
+// it actually paints (LVN_GETDISPINFO), so showing 100k events costs nothing up front.
 
-    std::sort(g_events.begin(), g_events.end(), [](const SoundEventEntry& a, const SoundEventEntry& b) {
-        int comparisonResult = 0;
-        // Ensure "Pre" always comes before "Pos" as a primary sort key if not sorting by section
-        if (g_sortColumn != 5) { // 5 is the "Section" column
-            if (a.section == L"Pre" && b.section == L"Pos") return g_sortAscending ? true : true; // Pre always first
-            if (a.section == L"Pos" && b.section == L"Pre") return g_sortAscending ? false : false; // Pos always last
-        }
-
-        switch (g_sortColumn) {
-        case 0: // Event ID
-            if (a.event_id < b.event_id) comparisonResult = -1;
-            else if (a.event_id > b.event_id) comparisonResult = 1;
-            break;
-        case 1: // Link Type
-            if (a.link_type_val < b.link_type_val) comparisonResult = -1;
-            else if (a.link_type_val > b.link_type_val) comparisonResult = 1;
-            break;
-        case 2: // Linked ID
-            if (a.linked_id < b.linked_id) comparisonResult = -1;
-            else if (a.linked_id > b.linked_id) comparisonResult = 1;
-            break;
-        case 3: // Event Name
-            comparisonResult = _wcsicmp(a.event_name.c_str(), b.event_name.c_str()); // Case-insensitive
-            break;
-        case 4: // Sound File(s) - Compare based on the first filename if multiple exist
-        {
-            std::wstring fileA = a.sound_data_filenames.empty() ? L"" : a.sound_data_filenames[0];
-            std::wstring fileB = b.sound_data_filenames.empty() ? L"" : b.sound_data_filenames[0];
-            comparisonResult = _wcsicmp(fileA.c_str(), fileB.c_str());
-        }
-        break;
-        case 5: // Section
-            comparisonResult = a.section.compare(b.section); // Pre vs Pos
-            if (comparisonResult == 0) { // If same section, then by event_id
-                if (a.event_id < b.event_id) comparisonResult = -1;
-                else if (a.event_id > b.event_id) comparisonResult = 1;
-            }
-            break;
-        }
-        return g_sortAscending ? (comparisonResult < 0) : (comparisonResult > 0);
-        });
+// Sets the row count after the filter changed; the order is unchanged.
+static void ShowViewRows() {
+    ListView_SetItemCountEx(g_hListEvents, static_cast<int>(g_view.size()), 0);
+    InvalidateRect(g_hListEvents, NULL, FALSE);
 }
 
-
-// Populate ListView - Modified to handle multiple filenames
+// After a load, a sort column change or an edit that may have moved rows.
 static void PopulateList() {
-    ListView_DeleteAllItems(g_hListEvents);
-    LVITEMW item{}; item.mask = LVIF_TEXT;
-    int row = 0;
-    for (auto& e : g_events) {
-        if (!g_filterName.empty() && g_filterName != L"All") {
-            auto pos = e.event_name.find(L'*');
-            std::wstring sub = (pos != std::wstring::npos) ? e.event_name.substr(pos + 1) : e.event_name;
-            auto us = sub.find(L'_');
-            std::wstring grp = (us != std::wstring::npos) ? sub.substr(0, us) : sub;
-            if (grp != g_filterName) continue;
-        }
-        item.iItem = row;
-        wchar_t buf[256]; // Buffer for numeric conversions
-
-        wsprintfW(buf, L"%d", e.event_id);
-        item.pszText = buf;
-        ListView_InsertItem(g_hListEvents, &item);
-
-        wsprintfW(buf, L"%d", e.link_type_val);
-        ListView_SetItemText(g_hListEvents, row, 1, buf);
-
-        wsprintfW(buf, L"%d", e.linked_id);
-        ListView_SetItemText(g_hListEvents, row, 2, buf);
-
-        ListView_SetItemText(g_hListEvents, row, 3, (LPWSTR)e.event_name.c_str());
-
-        // --- Format Sound File(s) Column ---
-        std::wstring filenames_display;
-        if (e.sound_data_filenames.empty()) {
-            filenames_display = L"N/A";
-        }
-        else {
-            for (size_t i = 0; i < e.sound_data_filenames.size(); ++i) {
-                filenames_display += e.sound_data_filenames[i];
-                if (i < e.sound_data_filenames.size() - 1) {
-                    filenames_display += L", "; // Add comma separator
-                }
-            }
-        }
-        // Use a larger buffer temporarily for longer filename lists
-        wchar_t filenameBuf[1024]; // Increased buffer size
-        wcsncpy_s(filenameBuf, 1024, filenames_display.c_str(), _TRUNCATE);
-        ListView_SetItemText(g_hListEvents, row, 4, filenameBuf);
-        // --- End Formatting ---
+    g_view.set_order(SortedOrder());
+    ShowViewRows();
+}
 
-        ListView_SetItemText(g_hListEvents, row, 5, (LPWSTR)e.section.c_str());
+// Narrows the view to rows whose name or filename contains the search box text.
+static void ApplySearch() {
+    wchar_t buf[256] = {};
+    GetWindowTextW(g_hEditSearch, buf, 256);
+    if (buf[0] == L'\0') {
+        g_searchHits.clear();
+        g_view.set_match(nullptr);
+        return;
+    }
+    g_searchHits = g_search.search(buf);
+    g_view.set_match(&g_searchHits);
+}
 
-        row++;
+static void FillDispInfo(NMLVDISPINFOW* di) {
+    LVITEMW& item = di->item;
+    if (!(item.mask & LVIF_TEXT) || !item.pszText || item.cchTextMax <= 0) return;
+    if (item.iItem < 0 || static_cast<size_t>(item.iItem) >= g_view.size()) return;
+    const SoundEventEntry& e = g_events[g_view.row_at(item.iItem)];
+    switch (item.iSubItem) {
+    case 0: _snwprintf_s(item.pszText, item.cchTextMax, _TRUNCATE, L"%d", e.event_id); break;
+    case 1: _snwprintf_s(item.pszText, item.cchTextMax, _TRUNCATE, L"%d", e.link_type_val); break;
+    case 2: _snwprintf_s(item.pszText, item.cchTextMax, _TRUNCATE, L"%d", e.linked_id); break;
+    case 3: wcsncpy_s(item.pszText, item.cchTextMax, g_strings.c_str(e.name_id), _TRUNCATE); break;
+    case 4: wcsncpy_s(item.pszText, item.cchTextMax, JoinFilenames(e).c_str(), _TRUNCATE); break; // Multiple filenames joined
+    case 5: wcsncpy_s(item.pszText, item.cchTextMax, SectionLabel(e.section), _TRUNCATE); break;
+    default: item.pszText[0] = L'\0'; break;
     }
 }
 
+// Refills the group filter with "All" and every group's name (sorted), selecting 'keep'
+// when it is still listed and "All" otherwise.
+static void FillFilterCombo(const std::wstring& keep) {
+    std::set<std::wstring_view> names{ L"All" };
+    for (uint32_t id : g_view.groups()) names.insert(g_strings.view(id));
+    SendMessageW(g_hComboFilter, CB_RESETCONTENT, 0, 0);
+    for (auto& n : names)
+        SendMessageW(g_hComboFilter, CB_ADDSTRING, 0, (LPARAM)std::wstring(n).c_str());
+    const LRESULT at = SendMessageW(g_hComboFilter, CB_FINDSTRINGEXACT, (WPARAM)-1, (LPARAM)keep.c_str());
+    SendMessageW(g_hComboFilter, CB_SETCURSEL, at == CB_ERR ? 0 : at, 0);
+}
+
 // Open and Load
 static void OpenAndLoadFlo(HWND hwnd) {
     OPENFILENAMEW ofn{ sizeof(ofn) };
@@ -671,21 +752,11 @@ static void OpenAndLoadFlo(HWND hwnd) {
     if (GetOpenFileNameW(&ofn) && ParseFloFile(file)) {
         g_loadedPath = file;
         SetWindowTextW(g_hMainWnd, (L"FLO Event Editor - " + g_loadedPath).c_str());
-        std::set<std::wstring> names{ L"All" };
-        for (auto& e : g_events) {
-            auto pos = e.event_name.find(L'*');
-            std::wstring sub = (pos != std::wstring::npos) ? e.event_name.substr(pos + 1) : e.event_name;
-            auto us = sub.find(L'_');
-            names.insert((us != std::wstring::npos) ? sub.substr(0, us) : sub);
-        }
-        SendMessageW(g_hComboFilter, CB_RESETCONTENT, 0, 0);
-        for (auto& n : names)
-            SendMessageW(g_hComboFilter, CB_ADDSTRING, 0, (LPARAM)n.c_str());
-        SendMessageW(g_hComboFilter, CB_SETCURSEL, 0, 0);
-        g_filterName = L"All";
-
-        g_sortColumn = -1;
-        SortEvents(); // Apply default sort (Pre then Pos, then by ID)
+        FillFilterCombo(L"All");
+        g_view.set_group(GroupedRowView::ALL);
+        SetWindowTextW(g_hEditSearch, L""); // EN_CHANGE clears the search
+
+        g_sortColumn = -1; // Default order: Pre then Pos, then by ID
         PopulateList();
 
         // Update counts and bundle labels
@@ -726,11 +797,12 @@ static void AddEvent() {
     GetWindowTextW(g_hEditID, num_buf, 64); e.event_id = _wtoi(num_buf);
     GetWindowTextW(g_hEditLinkType, num_buf, 64); e.link_type_val = _wtoi(num_buf);
     GetWindowTextW(g_hEditLinkedId, num_buf, 64); e.linked_id = _wtoi(num_buf);
-    GetWindowTextW(g_hEditName, name_buf, 256); e.event_name = Trim(name_buf);
+    GetWindowTextW(g_hEditName, name_buf, 256); e.name_id = g_strings.intern(Trim(name_buf));
+    e.group_id = GroupIdFor(g_strings.view(e.name_id));
 
     int sel = SendMessageW(g_hComboSection, CB_GETCURSEL, 0, 0);
     SendMessageW(g_hComboSection, CB_GETLBTEXT, sel, (LPARAM)num_buf);
-    e.section = Trim(num_buf);
+    e.section = (Trim(num_buf) == L"Pre") ? flo::SUB_PRE : flo::SUB_POS;
     e.is_newly_added = true;
 
     // Set link_type from value (Corrected Mapping)
@@ -741,26 +813,35 @@ static void AddEvent() {
     default: e.link_type = EventLinkType::Unknown; break;
     }
     // And try to find the filename(s)
-    e.sound_data_filenames = GetSoundFilenamesForEventMap(e);
-
-    auto it_insert = g_events.end();
-    if (e.section == L"Pre") {
-        it_insert = std::find_if(g_events.begin(), g_events.end(), [](const SoundEventEntry& ev) {
-            return ev.section == L"Pos";
-            });
-        g_loadedPreEventMapCount++; // Increment loaded count too
-    }
-    else {
-        g_loadedPosEventMapCount++; // Increment loaded count too
+    e.file_ids = GetSoundFilenamesForEventMap(e);
+
+    if (e.section == flo::SUB_PRE) g_loadedPreEventMapCount++; // Increment loaded count too
+    else g_loadedPosEventMapCount++;
+    // Appended: the sorted view places it, SaveFlo writes it to its section
+    g_events.push_back(e);
+    GraphAddEvent(g_events.size() - 1);
+    SortedViewAddEvent(g_events.size() - 1);
+    const size_t groupCount = g_view.groups().size();
+    g_view.add_row(e.group_id);
+    if (g_view.groups().size() != groupCount) {
+        // A new group: list it in the filter, keeping the current choice selected
+        std::wstring current = L"All";
+        const LRESULT cur = SendMessageW(g_hComboFilter, CB_GETCURSEL, 0, 0);
+        const LRESULT len = cur == CB_ERR ? CB_ERR : SendMessageW(g_hComboFilter, CB_GETLBTEXTLEN, cur, 0);
+        if (len != CB_ERR) {
+            current.assign((size_t)len + 1, L'\0');
+            SendMessageW(g_hComboFilter, CB_GETLBTEXT, cur, (LPARAM)current.data());
+            current.resize((size_t)len);
+        }
+        FillFilterCombo(current);
     }
-    g_events.insert(it_insert, e);
+    g_search.set(static_cast<uint32_t>(g_events.size() - 1), SearchTextFor(e));
+    ApplySearch(); // The new row may match the current search
 
     // Update total counts (used potentially elsewhere, though display uses loaded counts)
     g_preTotalEventMapEntries = g_loadedPreEventMapCount;
     g_posTotalEventMapEntries = g_loadedPosEventMapCount;
 
-
-    SortEvents();
     PopulateList();
 
     // Update display counts
@@ -777,7 +858,7 @@ static void AddSoundAndSimpleEvent() {
 
     GetWindowTextW(g_hEditSdfId, buf, 64); sdf_e.id = _wtoi(buf);
     GetWindowTextW(g_hEditSdfTypeChar, buf, 64); sdf_e.type_char = Trim(buf);
-    GetWindowTextW(g_hEditSdfFilename, buf, 256); sdf_e.filename = Trim(buf);
+    GetWindowTextW(g_hEditSdfFilename, buf, 256); std::wstring filename = Trim(buf);
     sdf_e.is_newly_added = true;
 
     se_e.id = sdf_e.id; // Usually SimpleEvent ID matches the SDF ID when adding
@@ -787,48 +868,48 @@ static void AddSoundAndSimpleEvent() {
     se_e.is_newly_added = true;
 
 
-    if (sdf_e.type_char.empty() || sdf_e.filename.empty()) {
+    if (sdf_e.type_char.empty() || filename.empty()) {
         MessageBoxW(g_hMainWnd, L"SDF Type and Filename cannot be empty.", L"Input Error", MB_OK | MB_ICONWARNING);
         return;
     }
-    for (const auto& existing_sdf : g_soundDataFiles) {
-        if (existing_sdf.id == sdf_e.id) {
-            MessageBoxW(g_hMainWnd, (L"SoundDataFile ID " + std::to_wstring(sdf_e.id) + L" already exists.").c_str(), L"Input Error", MB_OK | MB_ICONWARNING);
-            return;
-        }
+    if (g_graph.sdfIndex.count(sdf_e.id)) {
+        MessageBoxW(g_hMainWnd, (L"SoundDataFile ID " + std::to_wstring(sdf_e.id) + L" already exists.").c_str(), L"Input Error", MB_OK | MB_ICONWARNING);
+        return;
     }
-    for (const auto& existing_se : g_simpleEvents) {
-        if (existing_se.id == se_e.id) {
-            MessageBoxW(g_hMainWnd, (L"SimpleEvent ID " + std::to_wstring(se_e.id) + L" already exists.").c_str(), L"Input Error", MB_OK | MB_ICONWARNING);
-            return;
-        }
+    if (g_graph.simpleIndex.count(se_e.id)) {
+        MessageBoxW(g_hMainWnd, (L"SimpleEvent ID " + std::to_wstring(se_e.id) + L" already exists.").c_str(), L"Input Error", MB_OK | MB_ICONWARNING);
+        return;
     }
 
+    sdf_e.filename_id = g_strings.intern(filename);
     g_soundDataFiles.push_back(sdf_e);
     g_simpleEvents.push_back(se_e);
+    GraphAddSdf(g_soundDataFiles.size() - 1);
+    GraphAddSimple(g_simpleEvents.size() - 1);
     g_loadedSimpleEventCount++; // Increment simple count
 
-    // If we add a new SDF/SE pair, we need to re-evaluate potentially affected EventMap entries
+    // Re-resolve only the EventMap entries that can reach the new SDF or SimpleEvent
+    // (directly, or through a Random/Compound event that links them)
+    std::vector<size_t> affected;
+    CollectEventsForSdf(sdf_e.id, affected);
+    CollectEventsForSimple(se_e.id, affected);
+    std::sort(affected.begin(), affected.end());
+    affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
     bool list_updated = false;
-    for (auto& ev : g_events) {
-        // Only re-evaluate if it was previously invalid or if it links to the new SimpleEvent
-        bool was_invalid = ev.sound_data_filenames.empty() || (ev.sound_data_filenames.size() == 1 && ev.sound_data_filenames[0].find(L"N/A") != std::wstring::npos);
-        bool links_to_new_simple = (ev.link_type == EventLinkType::Simple && ev.linked_id == se_e.id);
-        // We also need to check if a Complex event links to this new SimpleEvent,
-        // but that requires iterating through Random/Compound events, which is complex here.
-        // For simplicity, we only explicitly re-check direct links or previously invalid ones.
-
-        if (was_invalid || links_to_new_simple)
-        {
-            std::vector<std::wstring> old_filenames = ev.sound_data_filenames;
-            ev.sound_data_filenames = GetSoundFilenamesForEventMap(ev);
-            if (ev.sound_data_filenames != old_filenames) { // Basic check if vector content changed
-                list_updated = true;
-            }
+    for (size_t idx : affected) {
+        SoundEventEntry& ev = g_events[idx];
+        std::vector<uint32_t> filenames = GetSoundFilenamesForEventMap(ev);
+        if (filenames != ev.file_ids) { // Basic check if vector content changed
+            ev.file_ids = std::move(filenames);
+            SortedViewFileChanged(idx);
+            g_search.set(static_cast<uint32_t>(idx), SearchTextFor(ev));
+            list_updated = true;
         }
     }
 
     if (list_updated) {
+        ApplySearch();
         PopulateList(); // Re-populate to show newly resolved names
     }
 
@@ -836,7 +917,7 @@ static void AddSoundAndSimpleEvent() {
     wsprintfW(buf, L"Simple: %d", g_loadedSimpleEventCount); SetWindowTextW(g_hLabelSimpleCount, buf);
 
     std::wstring msg = L"Added SoundDataFile ID: " + std::to_wstring(sdf_e.id) +
-        L" (" + sdf_e.filename + L") and its SimpleEvent (ID: " + std::to_wstring(se_e.id) + L").\n" +
+        L" (" + filename + L") and its SimpleEvent (ID: " + std::to_wstring(se_e.id) + L").\n" +
         L"Remember to Save .flo to persist these changes.";
     MessageBoxW(g_hMainWnd, msg.c_str(), L"Entry Added", MB_OK | MB_ICONINFORMATION);
 
@@ -848,135 +929,6 @@ static void AddSoundAndSimpleEvent() {
 }
 
 
-// --- Patch helper: find nth marker ---
-size_t FindNthMarker(const std::vector<char>& data, const char* marker, int n) {
-    size_t pos = 0;
-    int found = 0;
-    size_t marker_len = strlen(marker);
-    if (marker_len == 0) return std::string::npos;
-
-    while (pos < data.size()) {
-        auto it = std::search(data.begin() + pos, data.end(), marker, marker + marker_len);
-        if (it == data.end()) return std::string::npos;
-        pos = it - data.begin();
-        found++;
-        if (found == n) return pos;
-        pos += 1; // Move past the first char of the found marker to find subsequent ones
-    }
-    return std::string::npos;
-}
-
-// --- Patch and insert line (updates count) ---
-bool PatchInsertLineInSection(std::vector<char>& data,
-    const char* section_marker, // e.g. "SoundDataFiles\r\n"
-    int which_occurrence,
-    const std::string& new_line_to_insert) // new_line_to_insert should end with \r\n
-{
-    size_t section_marker_len = strlen(section_marker);
-    size_t section_pos = FindNthMarker(data, section_marker, which_occurrence);
-    if (section_pos == std::string::npos) return false;
-
-    size_t count_val_pos = section_pos + section_marker_len;
-    const char rn[] = "\r\n";
-    auto count_line_end_it = std::search(data.begin() + count_val_pos, data.end(), rn, rn + 2);
-    if (count_line_end_it == data.end()) return false;
-
-    size_t count_line_content_end = count_line_end_it - data.begin();
-    size_t count_line_full_end = count_line_content_end + 2;
-
-    std::string count_line_content_str(data.begin() + count_val_pos, data.begin() + count_line_content_end);
-    int current_item_count = 0;
-    try {
-        std::string trimmed_count_str = TrimA(count_line_content_str);
-        if (!trimmed_count_str.empty()) {
-            current_item_count = std::stoi(trimmed_count_str);
-        }
-    }
-    catch (const std::exception&) { return false; }
-
-    if (current_item_count < 0) current_item_count = 0;
-
-    size_t insert_pos = count_line_full_end;
-    for (int i = 0; i < current_item_count; ++i) {
-        auto next_item_line_end_it = std::search(data.begin() + insert_pos, data.end(), rn, rn + 2);
-        if (next_item_line_end_it == data.end()) {
-            insert_pos = data.size();
-            // Check if file ends with CRLF before inserting new one
-            if (data.size() < 2 || data[data.size() - 2] != '\r' || data[data.size() - 1] != '\n') {
-                // Append CRLF if not present at the very end
-                if (!data.empty()) data.insert(data.end(), rn, rn + 2);
-            }
-            // Ensure insert_pos is updated after potentially adding CRLF
-            insert_pos = data.size();
-            break;
-        }
-        insert_pos = (next_item_line_end_it - data.begin()) + 2;
-    }
-
-    // Insert the new data line *before* updating the count
-    data.insert(data.begin() + insert_pos, new_line_to_insert.begin(), new_line_to_insert.end());
-
-    // Now, update the count
-    current_item_count++;
-    std::string new_count_value_str = std::to_string(current_item_count);
-    std::string original_count_line_padding;
-    size_t first_char = count_line_content_str.find_first_not_of(" \t");
-    if (first_char != std::string::npos && first_char > 0) {
-        original_count_line_padding = count_line_content_str.substr(0, first_char);
-    }
-    else if (!count_line_content_str.empty() && (count_line_content_str[0] == ' ' || count_line_content_str[0] == '\t')) {
-        original_count_line_padding = count_line_content_str.substr(0, 1); // Preserve single space/tab
-    }
-
-    std::string new_full_count_line_str = original_count_line_padding + new_count_value_str;
-
-    // Adjust length to match original, only if it's shorter and if original had trailing space
-    size_t original_content_len = count_line_content_end - count_val_pos;
-    if (new_full_count_line_str.length() < original_content_len) {
-        std::string padding(original_content_len - new_full_count_line_str.length(), ' ');
-        new_full_count_line_str += padding;
-    }
-    else if (new_full_count_line_str.length() > original_content_len) {
-        // This is the CRITICAL BUG FIX area. We need to insert space, not just overwrite.
-        // But the current patching is too fragile for this.
-        // For now, let's *truncate* like before, knowing it's wrong, to avoid index errors.
-        new_full_count_line_str.resize(original_content_len); // Still potentially wrong, but avoids crash
-    }
-
-
-    // Find the count position again *relative to the new data size*
-    size_t new_section_pos = FindNthMarker(data, section_marker, which_occurrence);
-    if (new_section_pos == std::string::npos) return false;
-    size_t new_count_val_pos = new_section_pos + section_marker_len;
-    auto new_count_line_end_it = std::search(data.begin() + new_count_val_pos, data.end(), rn, rn + 2);
-    if (new_count_line_end_it == data.end()) return false;
-    size_t new_count_line_content_end = new_count_line_end_it - data.begin();
-
-    // Ensure we don't write past the original line ending if truncating
-    if (new_count_val_pos + new_full_count_line_str.length() > new_count_line_content_end) {
-        // This condition handles potential overflow if truncation happens
-        // It should ideally not be needed if length calculation is perfect
-        new_full_count_line_str.resize(new_count_line_content_end - new_count_val_pos);
-    }
-
-
-    // Replace the old count line content with the new one
-    // Check bounds before erasing
-    if (data.begin() + new_count_val_pos <= data.end() && data.begin() + new_count_line_content_end <= data.end()) {
-        data.erase(data.begin() + new_count_val_pos, data.begin() + new_count_line_content_end);
-        // Check bounds before inserting
-        if (data.begin() + new_count_val_pos <= data.end()) {
-            data.insert(data.begin() + new_count_val_pos, new_full_count_line_str.begin(), new_full_count_line_str.end());
-        }
-        else { return false; } // Insert position invalid
-    }
-    else { return false; } // Erase positions invalid
-
-
-    return true;
-}
-
-
 // Format EventMap line
 std::string SerializeEventMapLine(int id, int link_type, int linked_id, const std::wstring& nameW) {
     std::string name_utf8;
@@ -1027,9 +979,6 @@ static void SaveFlo(HWND hwnd) {
         return;
     }
 
-    MessageBoxW(hwnd, L"Warning: The current save mechanism modifies the original file directly by patching. This is inherently risky and can corrupt the file if the structure is unexpected or if counts change significantly (e.g., 9 to 10, 99 to 100).\n\nA safer approach would rewrite the entire file. Proceed with caution.", L"Save Warning", MB_OK | MB_ICONWARNING);
-
-
     OPENFILENAMEW ofn{ sizeof(ofn) };
     wchar_t outFile[MAX_PATH];
     wcsncpy_s(outFile, MAX_PATH, g_loadedPath.c_str(), _TRUNCATE);
@@ -1041,100 +990,29 @@ static void SaveFlo(HWND hwnd) {
     ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
     if (!GetSaveFileNameW(&ofn)) return;
 
-    std::ifstream inFileStream(g_loadedPath, std::ios::binary);
-    if (!inFileStream) {
-        MessageBoxW(hwnd, (L"Failed to open original file for reading: " + g_loadedPath).c_str(), L"Save Error", MB_OK | MB_ICONERROR);
-        return;
-    }
-    std::vector<char> data((std::istreambuf_iterator<char>(inFileStream)), std::istreambuf_iterator<char>());
-    inFileStream.close();
-
-    const int sdf_occurrence = 1;
-    const int se_occurrence = 1;
-    // Need to correctly identify occurrences for Pre/Pos within EventMaps
-    // Find "EventMaps", then find "Pre", then find the *next* "Pre"
-    // This is fragile. Let's assume standard structure for now.
-    const int pre_eventmap_occurrence = 1; // First "Pre" after "EventMaps"
-    const int pos_eventmap_occurrence = 1; // First "Pos" after the "Pre" section
-
-    // 1. Patch SoundDataFiles
+    // Gather every pending line, then stream the original file once (Common/FloWriter.h):
+    // untouched bytes are copied verbatim and each touched section gets its count rewritten
+    // and its new lines appended after its last entry.
+    flo::Appends appends;
     for (const auto& sdf_entry : g_soundDataFiles) {
-        if (sdf_entry.is_newly_added) {
-            std::string new_sdf_line = SerializeSoundDataFileLine(sdf_entry.id, sdf_entry.type_char, sdf_entry.filename);
-            if (!PatchInsertLineInSection(data, "SoundDataFiles\r\n", sdf_occurrence, new_sdf_line)) {
-                MessageBoxW(hwnd, L"Failed to patch 'SoundDataFiles' section. Save aborted.", L"Save Error", MB_OK | MB_ICONERROR);
-                return;
-            }
-        }
+        if (sdf_entry.is_newly_added)
+            appends.add(flo::BLK_SDF, SerializeSoundDataFileLine(sdf_entry.id, sdf_entry.type_char, std::wstring(g_strings.view(sdf_entry.filename_id))));
     }
-
-    // 2. Patch SimpleEvents
     for (const auto& se_entry : g_simpleEvents) {
-        if (se_entry.is_newly_added) {
-            std::string new_se_line = SerializeSimpleEventLine(se_entry.id, se_entry.sound_data_file_id, se_entry.type, se_entry.linked_event_id);
-            if (!PatchInsertLineInSection(data, "SimpleEvents\r\n", se_occurrence, new_se_line)) {
-                MessageBoxW(hwnd, L"Failed to patch 'SimpleEvents' section. Save aborted.", L"Save Error", MB_OK | MB_ICONERROR);
-                return;
-            }
-        }
-    }
-
-    // 3. Patch EventMaps (Pre/Pos)
-    // We need to handle Pre and Pos patching separately to ensure correct occurrence counting
-
-    // Patch Pre
-    for (const auto& event_entry : g_events) {
-        if (event_entry.is_newly_added && event_entry.section == L"Pre") {
-            std::string new_em_line = SerializeEventMapLine(event_entry.event_id, event_entry.link_type_val, event_entry.linked_id, event_entry.event_name);
-            // We need to find the correct "Pre" marker *within* "EventMaps"
-            // This requires finding "EventMaps" first, then the first "Pre" *after* that.
-            size_t eventMapsPos = FindNthMarker(data, "EventMaps\r\n", 1);
-            if (eventMapsPos == std::string::npos) { MessageBoxW(hwnd, L"Cannot find 'EventMaps' section for Pre patching.", L"Save Error", MB_OK | MB_ICONERROR); return; }
-
-            size_t preMarkerPos = std::string::npos;
-            size_t searchStartPos = eventMapsPos;
-            const char* preMarker = "Pre\r\n";
-            while (searchStartPos < data.size()) {
-                auto it = std::search(data.begin() + searchStartPos, data.end(), preMarker, preMarker + strlen(preMarker));
-                if (it == data.end()) break;
-                preMarkerPos = it - data.begin();
-                break; // Found the first "Pre" after "EventMaps"
-            }
-
-            if (preMarkerPos == std::string::npos) { MessageBoxW(hwnd, L"Cannot find 'Pre' section within 'EventMaps'.", L"Save Error", MB_OK | MB_ICONERROR); return; }
-
-            // Now call PatchInsertLineInSection using the *absolute position* found
-            // The Patch function itself uses FindNthMarker which might find the wrong "Pre"
-            // TODO: Refactor PatchInsertLineInSection to accept a starting position or handle context better.
-            // For now, sticking with potentially fragile occurrence-based patching:
-            if (!PatchInsertLineInSection(data, "Pre\r\n", pre_eventmap_occurrence, new_em_line)) {
-                MessageBoxW(hwnd, L"Failed to patch 'Pre' EventMap section. Save aborted.", L"Save Error", MB_OK | MB_ICONERROR);
-                return;
-            }
-        }
+        if (se_entry.is_newly_added)
+            appends.add(flo::BLK_SIMPLE, SerializeSimpleEventLine(se_entry.id, se_entry.sound_data_file_id, se_entry.type, se_entry.linked_event_id));
     }
-
-    // Patch Pos
     for (const auto& event_entry : g_events) {
-        if (event_entry.is_newly_added && event_entry.section == L"Pos") {
-            std::string new_em_line = SerializeEventMapLine(event_entry.event_id, event_entry.link_type_val, event_entry.linked_id, event_entry.event_name);
-            // Similar logic needed to find the correct "Pos" occurrence after "EventMaps"->"Pre"
-            // Sticking with fragile occurrence for now:
-            if (!PatchInsertLineInSection(data, "Pos\r\n", pos_eventmap_occurrence, new_em_line)) {
-                MessageBoxW(hwnd, L"Failed to patch 'Pos' EventMap section. Save aborted.", L"Save Error", MB_OK | MB_ICONERROR);
-                return;
-            }
-        }
+        if (event_entry.is_newly_added)
+            appends.add(event_entry.section == flo::SUB_PRE ? flo::BLK_MAP_PRE : flo::BLK_MAP_POS,
+                SerializeEventMapLine(event_entry.event_id, event_entry.link_type_val, event_entry.linked_id, std::wstring(g_strings.view(event_entry.name_id))));
     }
 
-
-    std::ofstream outF(outFile, std::ios::binary | std::ios::trunc);
-    if (!outF) {
-        MessageBoxW(hwnd, (L"Failed to open output file for writing: " + std::wstring(outFile)).c_str(), L"Save Error", MB_OK | MB_ICONERROR);
+    std::string error;
+    if (!flo::SaveWithAppends(g_loadedPath, outFile, appends, error)) {
+        MessageBoxW(hwnd, (L"Save aborted: " + flo::Widen(error)).c_str(), L"Save Error", MB_OK | MB_ICONERROR);
         return;
     }
-    outF.write(data.data(), data.size());
-    outF.close();
 
     g_loadedPath = outFile;
     SetWindowTextW(g_hMainWnd, (L"FLO Event Editor - " + g_loadedPath).c_str());
@@ -1151,8 +1029,8 @@ static void SaveFlo(HWND hwnd) {
     g_loadedPreEventMapCount = 0;
     g_loadedPosEventMapCount = 0;
     for (const auto& ev : g_events) {
-        if (ev.section == L"Pre") g_loadedPreEventMapCount++;
-        else if (ev.section == L"Pos") g_loadedPosEventMapCount++;
+        if (ev.section == flo::SUB_PRE) g_loadedPreEventMapCount++;
+        else if (ev.section == flo::SUB_POS) g_loadedPosEventMapCount++;
     }
     // Update total counts as well
     g_preTotalEventMapEntries = g_loadedPreEventMapCount;
@@ -1163,7 +1041,7 @@ static void SaveFlo(HWND hwnd) {
     g_loadedCompoundEventCount = g_compoundEvents.size();
 
 
-    MessageBoxW(hwnd, L"File saved successfully.\n(Note: Count updates during save may be inaccurate.)", L"Save Success", MB_OK | MB_ICONINFORMATION);
+    MessageBoxW(hwnd, L"File saved successfully.", L"Save Success", MB_OK | MB_ICONINFORMATION);
 }
 
 void CreateInputControls(HWND hwnd, const RECT& rc_parent) {
@@ -1387,12 +1265,17 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         if (filter_x < current_x + spacing) filter_x = current_x + spacing; // Prevent overlap
         g_hComboFilter = CreateWindowExW(0, WC_COMBOBOXW, NULL, WS_CHILD | WS_VISIBLE | CBS_DROPDOWNLIST | WS_VSCROLL | WS_TABSTOP,
             filter_x, top_y, combo_w, 200, hwnd, (HMENU)ID_COMBO_FILTER, g_hInst, NULL);
+        // Search box (left of the filter)
+        int search_w = 180;
+        g_hEditSearch = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"", WS_CHILD | WS_VISIBLE | ES_AUTOHSCROLL | WS_TABSTOP,
+            filter_x - spacing - search_w, top_y, search_w, label_h + 2, hwnd, (HMENU)IDC_EDIT_SEARCH, g_hInst, NULL);
+        SendMessageW(g_hEditSearch, EM_SETCUEBANNER, FALSE, (LPARAM)L"Search name / file...");
 
 
         int list_y = top_y + label_h + 10; // Y position for the list view, below bundles/filter
 
         g_hListEvents = CreateWindowExW(0, WC_LISTVIEWW, NULL,
-            WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_SINGLESEL | WS_BORDER | WS_TABSTOP,
+            WS_CHILD | WS_VISIBLE | LVS_REPORT | LVS_OWNERDATA | LVS_SINGLESEL | WS_BORDER | WS_TABSTOP,
             10, list_y, rc.right - 20, 300, // Position list view below new labels
             hwnd, (HMENU)ID_LIST_EVENTS, g_hInst, NULL);
         ListView_SetExtendedListViewStyle(g_hListEvents, LVS_EX_FULLROWSELECT | LVS_EX_GRIDLINES | LVS_EX_HEADERDRAGDROP);
@@ -1455,8 +1338,9 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         current_x = 10;
         // Calculate available width for bundles, excluding filter combo box
         int combo_w = 200;
+        int search_w = 180;
         int filter_margin = 10;
-        int width_for_bundles_area = rc.right - 20 - combo_w - filter_margin; // Space left of filter
+        int width_for_bundles_area = rc.right - 20 - combo_w - filter_margin - search_w - spacing; // Space left of search + filter
         int bundle_label_w = (width_for_bundles_area > (2 * spacing)) ? (width_for_bundles_area - (2 * spacing)) / 3 : 150; // Divide remaining space by 3
         if (bundle_label_w < 150) bundle_label_w = 150; // Minimum width
 
@@ -1466,7 +1350,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         MoveWindow(g_hLabelBundle2, current_x, top_y, bundle_label_w, label_h, TRUE);
         current_x += bundle_label_w + spacing;
         // Ensure third label's width isn't negative or zero and fits before filter
-        int third_label_max_width = rc.right - 10 - combo_w - filter_margin - current_x;
+        int third_label_max_width = rc.right - 10 - combo_w - filter_margin - search_w - spacing - current_x;
         int third_label_width = bundle_label_w;
         if (third_label_width > third_label_max_width) third_label_width = third_label_max_width;
         if (third_label_width < 50) third_label_width = 0; // Hide if too small
@@ -1475,6 +1359,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         // Filter ComboBox (Positioned at the end of the second row)
         int filter_x = rc.right - 10 - combo_w; // Align to the right
         MoveWindow(g_hComboFilter, filter_x, top_y, combo_w, 200, TRUE); // Height includes dropdown
+        MoveWindow(g_hEditSearch, filter_x - spacing - search_w, top_y, search_w, label_h + 2, TRUE);
 
 
         // --- Reposition List View ---
@@ -1489,6 +1374,10 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         break;
     }
     case WM_NOTIFY:
+        if (((LPNMHDR)lParam)->hwndFrom == g_hListEvents && ((LPNMHDR)lParam)->code == LVN_GETDISPINFOW) {
+            FillDispInfo((NMLVDISPINFOW*)lParam);
+            break;
+        }
         if (((LPNMHDR)lParam)->hwndFrom == g_hListEvents && ((LPNMHDR)lParam)->code == LVN_COLUMNCLICK) {
             LPNMLISTVIEW pnmv = (LPNMLISTVIEW)lParam;
             int clickedColumn = pnmv->iSubItem;
@@ -1499,8 +1388,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
                 g_sortColumn = clickedColumn;
                 g_sortAscending = true;
             }
-            SortEvents();
-            PopulateList();
+            PopulateList(); // Cached order per column/direction, built on first use
 
             // Add sort indicator arrow
             HWND hHeader = ListView_GetHeader(g_hListEvents);
@@ -1535,6 +1423,11 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             SetWindowTextW(g_hEditLinkType, L"0");
         }
 
+        if (HIWORD(wParam) == EN_CHANGE && (HWND)lParam == g_hEditSearch) {
+            ApplySearch();
+            ShowViewRows();
+        }
+
         switch (LOWORD(wParam)) {
         case ID_MENU_OPEN: OpenAndLoadFlo(hwnd); break;
         case ID_COMBO_FILTER:
@@ -1542,9 +1435,8 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
                 wchar_t buf[128] = {};
                 int sel = SendMessageW(g_hComboFilter, CB_GETCURSEL, 0, 0);
                 SendMessageW(g_hComboFilter, CB_GETLBTEXT, sel, (LPARAM)buf);
-                g_filterName = buf;
-                SortEvents(); // Re-sort if filter changes
-                PopulateList();
+                g_view.set_group((wcscmp(buf, L"All") == 0) ? GroupedRowView::ALL : g_strings.find(buf));
+                ShowViewRows(); // Only the selected group's rows are touched
             }
             break;
         case IDC_BTN_ADD: AddEvent(); break;
@@ -1563,6 +1455,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 
 // Entry point
 int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow) {
+    TraceSession trace;
     g_hInst = hInstance;
     INITCOMMONCONTROLSEX ic{ sizeof(ic),ICC_WIN95_CLASSES | ICC_LISTVIEW_CLASSES };
     InitCommonControlsEx(&ic);
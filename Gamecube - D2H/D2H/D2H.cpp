@@ -9,23 +9,17 @@
 #include <vector>
 #include <string>
 
-// Big-endian helpers
-static inline unsigned int get32be(const unsigned char* p) {
-    return (unsigned int)p[0] << 24 | (unsigned int)p[1] << 16 |
-        (unsigned int)p[2] << 8 | (unsigned int)p[3];
-}
-static inline void put32be(unsigned char* p, unsigned int v) {
-    p[0] = (v >> 24) & 0xFF;
-    p[1] = (v >> 16) & 0xFF;
-    p[2] = (v >> 8) & 0xFF;
-    p[3] = v & 0xFF;
-}
+#include "../../Common/AsyncIo.h"
+#include "../../Common/BeLayout.h"
+#include "../../Common/RunMetrics.h"
+#include "../../Common/Trace.h"
 
 // File layout constants
 #define FILE_HEADER_SIZE   0x20
 #define NAME_REGION_SIZE   0x100
 #define DS2_HEADER_SIZE    0xC0
 #define ENTRY_SIZE         (NAME_REGION_SIZE + DS2_HEADER_SIZE)
+static_assert(ENTRY_SIZE == sizeof(D2hEntry) && FILE_HEADER_SIZE == DSH_FILE_HEADER_BYTES, "D2H layout (Common/BeLayout.h)");
 
 // Globals
 static HWND        g_hList = NULL;
@@ -91,9 +85,11 @@ void ExtractD2h(HWND hwnd) {
         return;
     }
 
-    unsigned char buf4[4];
-    fread(buf4, 1, 4, d2h);
-    unsigned int count = get32be(buf4);
+    unsigned char headBuf[FILE_HEADER_SIZE] = { 0 };
+    fread(headBuf, 1, FILE_HEADER_SIZE, d2h);
+    DshFileHeader head;
+    BeLoad(headBuf, head);
+    unsigned int count = head.count;
     fwprintf(txt, L"Entry Count: %u\n\n", count);
 
     fseek(d2h, FILE_HEADER_SIZE, SEEK_SET);
@@ -105,17 +101,13 @@ void ExtractD2h(HWND hwnd) {
         size_t nlen = strnlen((char*)entry, NAME_REGION_SIZE);
         memcpy(name8, entry, nlen);
         fwprintf(txt, L"Entry %u: %hs\n", i + 1, name8);
-        unsigned char* meta = entry + NAME_REGION_SIZE;
-        unsigned int samples = get32be(meta);
-        unsigned int nibCnt = get32be(meta + 4);
-        unsigned int rate = get32be(meta + 8);
-        unsigned short loopF = (meta[12] << 8) | meta[13];
-        unsigned int loopStart = get32be(meta + 16);
-        unsigned int loopEnd = get32be(meta + 20);
+        D2hEntry e;
+        BeLoad(entry, e);
+        const DspHeader& meta = e.left;
         fwprintf(txt,
             L"  Samples: %u\n  NibbleCount: %u\n  Rate: %u\n"
             L"  LoopFlag: %u\n  LoopStart: %u\n  LoopEnd: %u\n\n",
-            samples, nibCnt, rate, loopF, loopStart, loopEnd
+            meta.num_samples, meta.num_nibbles, meta.sample_rate, (unsigned int)meta.loop_flag, meta.loop_start, meta.loop_end
         );
     }
     free(entry);
@@ -158,14 +150,28 @@ void RepackD2h(HWND hwnd) {
     }
 
     // Write header: count + padding
-    unsigned char buf4[4];
-    put32be(buf4, (unsigned int)g_ds2Files.size());
-    fwrite(buf4, 1, 4, f);
-    for (int i = 4; i < FILE_HEADER_SIZE; i++) fputc(0, f);
+    DshFileHeader head = {};
+    head.count = (unsigned int)g_ds2Files.size();
+    unsigned char headBuf[FILE_HEADER_SIZE];
+    BeStore(head, headBuf);
+    fwrite(headBuf, 1, FILE_HEADER_SIZE, f);
+
+    // Every DS2 header is read in one batch, then the entries are written in drop order
+    RunMetrics metrics("D2H", "repack");
+    std::vector<IoRead> headers(g_ds2Files.size());
+    for (size_t i = 0; i < g_ds2Files.size(); i++) {
+        headers[i].path = g_ds2Files[i];
+        headers[i].length = DS2_HEADER_SIZE;
+    }
+    AsyncIo io;
+    {
+        RunStageTimer readTime(metrics, RunStage::Read);
+        io.read(headers, IoHint::Random);
+    }
 
-    // Write entries in drop order
     unsigned char* entry = (unsigned char*)malloc(ENTRY_SIZE);
     for (size_t i = 0; i < g_ds2Files.size(); i++) {
+        RunFile file(metrics);
         memset(entry, 0, ENTRY_SIZE);
 
         // Filename region
@@ -184,22 +190,27 @@ void RepackD2h(HWND hwnd) {
         if (len > NAME_REGION_SIZE) len = NAME_REGION_SIZE;
         memcpy(entry, name8, len);
 
-        // DS2 metadata
-        FILE* ds2 = nullptr;
-        if (_wfopen_s(&ds2, fullpath.c_str(), L"rb") != 0) {
-            ds2 = nullptr; // Ensure ds2 is null if the file couldn't be opened
-        }
-        if (ds2) {
-            fread(entry + NAME_REGION_SIZE, 1, DS2_HEADER_SIZE, ds2);
-            fclose(ds2);
+        // DS2 metadata (zeroed where the file is missing or short)
+        if (!headers[i].ok()) file.fail(RunError::Open);
+        else if (headers[i].data.size() < DS2_HEADER_SIZE) file.fail(RunError::Format);
+        file.bytes_in(headers[i].data.size());
+        if (headers[i].ok() && !headers[i].data.empty()) {
+            memcpy(entry + NAME_REGION_SIZE, headers[i].data.data(), headers[i].data.size());
         }
 
-        fwrite(entry, 1, ENTRY_SIZE, f);
+        RunStageTimer writeTime(RunStage::Write);
+        if (fwrite(entry, 1, ENTRY_SIZE, f) == ENTRY_SIZE) file.bytes_out(ENTRY_SIZE);
+        else file.fail(RunError::Write);
     }
     free(entry);
     fclose(f);
 
-    MessageBoxW(hwnd, L"Repacked D2H complete", L"Done", MB_OK);
+    // Metrics go next to the .d2h as run_metrics_repack.json
+    metrics.finish();
+    const std::filesystem::path metricsPath = metrics.json_path(std::filesystem::path(outPath).parent_path());
+    const std::wstring metricsName = metricsPath.filename().wstring();
+    const std::wstring done = L"Repacked D2H complete" + (metrics.write_json(metricsPath) ? L"\nMetrics: " + metricsName : L"\n(" + metricsName + L" could not be written)");
+    MessageBoxW(hwnd, done.c_str(), L"Done", MB_OK);
 
     g_ds2Files.clear();
     SendMessageW(g_hList, LB_RESETCONTENT, 0, 0);
@@ -243,6 +254,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 }
 
 int WINAPI WinMain(HINSTANCE hInst, HINSTANCE, LPSTR, int nCmdShow) {
+    TraceSession trace;
     const wchar_t CLASS[] = L"D2hToolWindow";
     WNDCLASSW wc = { };
     wc.lpfnWndProc = WindowProc;
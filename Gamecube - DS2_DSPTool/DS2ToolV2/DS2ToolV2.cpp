@@ -12,6 +12,22 @@
 #include <algorithm> 
 #include <sstream>    
 
+#include "../../Common/BeLayout.h"
+#include "../../Common/BufferPool.h"
+#include "../../Common/CorpusScan.h"
+#include "../../Common/DspAdpcm.h"
+#include "../../Common/DspContainer.h"
+#include "../../Common/DspEdit.h"
+#include "../../Common/MappedFile.h"
+#include "../../Common/PcmDiskCache.h"
+#include "../../Common/PeakPyramid.h"
+#include "../../Common/ProcessStats.h"
+#include "../../Common/Resampler.h"
+#include "../../Common/RunMetrics.h"
+#include "../../Common/Trace.h"
+#include "../../Common/WavIngest.h"
+#include "../../Common/WavWriter.h"
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -25,10 +41,18 @@ bool DecodeDS2toWav(const String& ds2Path, const String& wavPath);
 bool EncodeWavToDS2(const String& wavPath, const String& ds2Path);
 
 // DSP (Mono) functions
-// MODIFIED: Function signature now accepts a window handle for pop-up messages
+// DecodeMonoDspToWav reports errors in message boxes owned by hwndParent
 bool DecodeMonoDspToWav(const String& dspPath, const String& wavPath, HWND hwndParent);
 bool EncodeWavToMonoDsp(const String& wavPath, const String& dspPath);
 
+// Remux (ADPCM copied as-is, no re-encode)
+bool SplitDs2ToDspPair(const String& ds2Path, const String& dspBasePath);
+bool JoinDspPairToDs2(const String& leftDspPath, const String& ds2Path);
+
+// Edit (ADPCM frames kept, only frames at the joins re-encoded)
+bool TrimMonoDsp(const String& dspPath, const String& outPath, double fromSeconds, double toSeconds);
+bool AppendMonoDsp(const String& firstPath, const String& secondPath, const String& outPath);
+
 
 constexpr int IDC_BTN_DEC_DS2_SINGLE = 101;
 constexpr int IDC_BTN_ENC_DS2_SINGLE = 102;
@@ -39,115 +63,101 @@ constexpr int IDC_BTN_DEC_DSP_SINGLE = 106;
 constexpr int IDC_BTN_ENC_DSP_SINGLE = 107;
 constexpr int IDC_BTN_DEC_DSP_BATCH = 108;
 constexpr int IDC_BTN_ENC_DSP_BATCH = 109;
+constexpr int IDC_BTN_SPLIT_DS2 = 110;
+constexpr int IDC_BTN_JOIN_DSP = 111;
+constexpr int IDC_EDIT_TRIM_FROM = 112;
+constexpr int IDC_EDIT_TRIM_TO = 113;
+constexpr int IDC_BTN_TRIM_DSP = 114;
+constexpr int IDC_BTN_APPEND_DSP = 115;
+constexpr int IDC_COMBO_ENC_RATE = 116;
+constexpr int IDC_COMBO_ENC_QUALITY = 117;
+constexpr int IDC_BTN_SCAN_CORPUS = 118;
 
 HINSTANCE hInst;
 
-// Big-endian readers/writers and clamp16 (unchanged)
-inline uint16_t read_u16_be(const uint8_t* buf) { return (uint16_t)((buf[0] << 8) | buf[1]); }
-inline int16_t  read_s16_be(const uint8_t* buf) { return (int16_t)((buf[0] << 8) | buf[1]); }
-inline uint32_t read_u32_be(const uint8_t* buf) { return (uint32_t)((buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3]); }
-inline void write_u16_be(uint8_t* buf, uint16_t val) { buf[0] = static_cast<uint8_t>((val >> 8) & 0xFF); buf[1] = static_cast<uint8_t>(val & 0xFF); }
-inline void write_s16_be(uint8_t* buf, int16_t val) { write_u16_be(buf, static_cast<uint16_t>(val)); }
-inline void write_u32_be(uint8_t* buf, uint32_t val) { buf[0] = static_cast<uint8_t>((val >> 24) & 0xFF); buf[1] = static_cast<uint8_t>((val >> 16) & 0xFF); buf[2] = static_cast<uint8_t>((val >> 8) & 0xFF); buf[3] = static_cast<uint8_t>(val & 0xFF); }
+// Encode sample rate (0 = keep the WAV's own rate) and resampler preset, set from the UI.
+uint32_t g_encodeRate = 0;
+ResampleQuality g_resampleQuality = ResampleQuality::Balanced;
+const uint32_t kEncodeRates[] = { 0, 48000, 44100, 32000, 22050, 16000 };
+
 inline int32_t clamp16(int32_t v) { return v < -32768 ? -32768 : v > 32767 ? 32767 : v; }
 
-// WriteWav function (unchanged)
-void WriteWav(const String& path, const std::vector<int16_t>& pcm_data, int sampleRate, uint16_t num_channels_to_write) {
-    std::ofstream f(path, std::ios::binary);
-    if (!f.is_open()) return;
-    uint16_t bits = 16;
-    uint32_t dataBytes = static_cast<uint32_t>(pcm_data.size()) * sizeof(int16_t);
-    uint32_t byteRate = sampleRate * num_channels_to_write * (bits / 8);
-    uint16_t blockAlign = num_channels_to_write * (bits / 8);
-    f.write("RIFF", 4);
-    uint32_t riffSize = 36 + dataBytes;
-    f.write(reinterpret_cast<char*>(&riffSize), 4);
-    f.write("WAVE", 4);
-    f.write("fmt ", 4);
-    uint32_t fmtLen = 16; f.write(reinterpret_cast<char*>(&fmtLen), 4);
-    uint16_t audioFmt = 1; f.write(reinterpret_cast<char*>(&audioFmt), 2);
-    f.write(reinterpret_cast<char*>(&num_channels_to_write), 2);
-    f.write(reinterpret_cast<char*>(&sampleRate), 4);
-    f.write(reinterpret_cast<char*>(&byteRate), 4);
-    f.write(reinterpret_cast<char*>(&blockAlign), 2);
-    f.write(reinterpret_cast<char*>(&bits), 2);
-    f.write("data", 4);
-    f.write(reinterpret_cast<char*>(&dataBytes), 4);
-    f.write(reinterpret_cast<const char*>(pcm_data.data()), dataBytes);
-    f.close();
+// WriteWav function (also writes straight from a mapped PcmDiskCache entry)
+bool WriteWav(const String& path, const int16_t* pcm_data, size_t sample_count, int sampleRate, uint16_t num_channels_to_write) {
+    return WriteWavFile(path, pcm_data, sample_count, static_cast<uint32_t>(sampleRate), num_channels_to_write);
+}
+bool WriteWav(const String& path, const std::vector<int16_t>& pcm_data, int sampleRate, uint16_t num_channels_to_write) {
+    return WriteWav(path, pcm_data.data(), pcm_data.size(), sampleRate, num_channels_to_write);
 }
 
-// DspChannelHeader struct (unchanged)
-struct DspChannelHeader {
-    uint8_t raw[0x60];
-    DspChannelHeader() { std::memset(raw, 0, sizeof(raw)); }
-    void set_num_samples(uint32_t val) { write_u32_be(raw + 0x00, val); }
-    uint32_t get_num_samples() const { return read_u32_be(raw + 0x00); }
-    void set_num_adpcm_nibbles(uint32_t val) { write_u32_be(raw + 0x04, val); }
-    uint32_t get_num_adpcm_nibbles() const { return read_u32_be(raw + 0x04); }
-    void set_sample_rate(uint32_t val) { write_u32_be(raw + 0x08, val); }
-    uint32_t get_sample_rate() const { return read_u32_be(raw + 0x08); }
-    void set_loop_flag(uint16_t val) { write_u16_be(raw + 0x0C, val); }
-    uint16_t get_loop_flag() const { return read_u16_be(raw + 0x0C); }
-    void set_format_info(uint16_t val) { write_u16_be(raw + 0x0E, val); }
-    uint16_t get_format_info() const { return read_u16_be(raw + 0x0E); }
-    void set_loop_start_nibble_addr(uint32_t val) { write_u32_be(raw + 0x10, val); }
-    void set_loop_end_sample_addr(uint32_t val) { write_u32_be(raw + 0x14, val); }
-    void set_current_adpcm_addr(uint32_t val) { write_u32_be(raw + 0x18, val); }
-    void set_coeffs(const int16_t coeffs_in[16]) { for (int i = 0; i < 16; ++i) write_s16_be(raw + 0x1C + i * 2, coeffs_in[i]); }
-    void get_coeffs(int16_t coeffs_out[16]) const { for (int i = 0; i < 16; ++i) coeffs_out[i] = read_s16_be(raw + 0x1C + i * 2); }
-    void set_gain(uint16_t val) { write_u16_be(raw + 0x3C, val); }
-    void set_initial_pred_scale(uint16_t val) { write_u16_be(raw + 0x3E, val); }
-    uint16_t get_initial_pred_scale() const { return read_u16_be(raw + 0x3E); }
-    void set_initial_hist1(int16_t val) { write_s16_be(raw + 0x40, val); }
-    int16_t get_initial_hist1() const { return read_s16_be(raw + 0x40); }
-    void set_initial_hist2(int16_t val) { write_s16_be(raw + 0x42, val); }
-    int16_t get_initial_hist2() const { return read_s16_be(raw + 0x42); }
-    void set_loop_pred_scale(uint16_t val) { write_u16_be(raw + 0x44, val); }
-    void set_loop_hist1(int16_t val) { write_s16_be(raw + 0x46, val); }
-    void set_loop_hist2(int16_t val) { write_s16_be(raw + 0x48, val); }
-    void set_unknown_constants() { write_u16_be(raw + 0x4A, 0x5E3D); write_u16_be(raw + 0x4C, 0x0000); }
-    void set_adpcm_data_size_bytes(uint32_t val) { write_u32_be(raw + 0x58, val); }
-    uint32_t get_adpcm_data_size_bytes() const { return read_u32_be(raw + 0x58); }
-    void set_offset_to_adpcm_data(uint32_t val) { write_u32_be(raw + 0x5C, val); }
-    uint32_t get_offset_to_adpcm_data() const { return read_u32_be(raw + 0x5C); }
-};
+// DSP channel headers are DspHeader (Common/BeLayout.h): decoded with one BeLoad, written
+// with one BeStore. This is the header DS2Tool writes for a freshly encoded, non-looping channel.
+DspHeader MakeEncodedHeader(uint32_t totalSamples, uint32_t sampleRate, const int16_t coefs[16], uint16_t firstPredScale, uint32_t adpcmBytes, uint32_t adpcmOffset) {
+    DspHeader h{};
+    h.num_samples = totalSamples; h.num_nibbles = ((totalSamples + 13) / 14) * 16;
+    h.sample_rate = sampleRate; h.loop_end = totalSamples;
+    std::copy(coefs, coefs + 16, h.coefs);
+    h.initial_ps = firstPredScale;
+    h.reserved[0] = 0x5E3D;
+    h.data_size = adpcmBytes; h.data_offset = adpcmOffset;
+    return h;
+}
+void WriteDspHeader(std::ofstream& out, const DspHeader& h) {
+    uint8_t raw[sizeof(DspHeader)];
+    BeStore(h, raw);
+    out.write(reinterpret_cast<const char*>(raw), sizeof(raw));
+}
 
-// DecodeDS2toWav (unchanged)
 bool DecodeDS2toWav(const String& ds2Path, const String& wavPath) {
+    TRACE_SCOPE_CAT("DecodeDS2toWav", "batch");
     std::ifstream in(ds2Path, std::ios::binary | std::ios::ate);
-    if (!in) return false;
+    if (!in) { RunFail(RunError::Open); return false; }
     size_t fileSize = static_cast<size_t>(in.tellg());
-    if (fileSize < 0xC0) return false;
+    if (fileSize < 0xC0) { RunFail(RunError::Format); return false; }
     in.seekg(0);
-    DspChannelHeader leftHeader, rightHeader;
-    if (!in.read(reinterpret_cast<char*>(leftHeader.raw), sizeof(leftHeader.raw))) return false;
-    if (!in.read(reinterpret_cast<char*>(rightHeader.raw), sizeof(rightHeader.raw))) return false;
-    uint32_t totalSamplesL = leftHeader.get_num_samples();
-    uint32_t totalSamplesR = rightHeader.get_num_samples();
-    if (totalSamplesL == 0 || totalSamplesL != totalSamplesR) { return false; }
-    uint32_t sampleRateL = leftHeader.get_sample_rate();
-    uint32_t sampleRateR = rightHeader.get_sample_rate();
-    if (sampleRateL == 0 || sampleRateL != sampleRateR) { return false; }
-    int16_t coefL[16], coefR[16];
-    leftHeader.get_coeffs(coefL); rightHeader.get_coeffs(coefR);
-    int16_t hist1L = leftHeader.get_initial_hist1(); int16_t hist2L = leftHeader.get_initial_hist2();
-    int16_t hist1R = rightHeader.get_initial_hist1(); int16_t hist2R = rightHeader.get_initial_hist2();
-    uint32_t offsetL_ADPCM = leftHeader.get_offset_to_adpcm_data();
-    uint32_t offsetR_ADPCM = rightHeader.get_offset_to_adpcm_data();
+    uint8_t rawHeaders[2 * sizeof(DspHeader)];
+    if (!in.read(reinterpret_cast<char*>(rawHeaders), sizeof(rawHeaders))) { RunFail(RunError::Format); return false; }
+    DspHeader leftHeader, rightHeader;
+    BeLoad(rawHeaders, leftHeader); BeLoad(rawHeaders + sizeof(DspHeader), rightHeader);
+    uint32_t totalSamplesL = leftHeader.num_samples;
+    uint32_t totalSamplesR = rightHeader.num_samples;
+    if (totalSamplesL == 0 || totalSamplesL != totalSamplesR) { RunFail(RunError::Format); return false; }
+    uint32_t sampleRateL = leftHeader.sample_rate;
+    uint32_t sampleRateR = rightHeader.sample_rate;
+    if (sampleRateL == 0 || sampleRateL != sampleRateR) { RunFail(RunError::Format); return false; }
+    const int16_t* coefL = leftHeader.coefs; const int16_t* coefR = rightHeader.coefs;
+    int16_t hist1L = leftHeader.initial_hist1; int16_t hist2L = leftHeader.initial_hist2;
+    int16_t hist1R = rightHeader.initial_hist1; int16_t hist2R = rightHeader.initial_hist2;
+    uint32_t offsetL_ADPCM = leftHeader.data_offset;
+    uint32_t offsetR_ADPCM = rightHeader.data_offset;
     uint32_t calculatedAdpcmDataSizeBytesL = ((totalSamplesL + 13) / 14) * 8;
     uint32_t calculatedAdpcmDataSizeBytesR = ((totalSamplesR + 13) / 14) * 8;
     if (offsetL_ADPCM != 0xC0 || offsetR_ADPCM < (offsetL_ADPCM + calculatedAdpcmDataSizeBytesL) ||
         offsetL_ADPCM + calculatedAdpcmDataSizeBytesL > fileSize ||
         offsetR_ADPCM + calculatedAdpcmDataSizeBytesR > fileSize) {
     }
-    std::vector<uint8_t> fileData(fileSize);
+    Scratch<uint8_t> fileData(fileSize);
     in.seekg(0); in.read(reinterpret_cast<char*>(fileData.data()), fileSize); in.close();
-    std::vector<int16_t> leftSamples(totalSamplesL), rightSamples(totalSamplesR);
+    // An unchanged file was decoded before: write the cached PCM instead of decoding again.
+    const uint64_t cacheKey = PcmDiskCache::Key(fileData.data(), 0xC0, fileData.data() + 0xC0, fileSize - 0xC0);
+    CachedPcm cached;
+    if (PcmDiskCache::Shared().find(cacheKey, cached) && cached.channels() == 2) {
+        RunSamples(cached.sample_count());
+        RunStageTimer writeTime(RunStage::Write);
+        if (!WriteWav(wavPath, cached.samples(), cached.sample_count(), cached.sample_rate(), 2)) { RunFail(RunError::Write); return false; }
+        if (!std::filesystem::exists(PeakSidecarPath(wavPath))) {
+            std::vector<PeakPyramid> peaks(2);
+            for (unsigned c = 0; c < 2; ++c) { peaks[c].add(cached.samples(), cached.frames(), 2, c); peaks[c].finish(); }
+            WritePeakSidecar(PeakSidecarPath(wavPath), peaks, cached.sample_rate());
+        }
+        return true;
+    }
+    Scratch<int16_t> leftSamples(totalSamplesL), rightSamples(totalSamplesR);
+    std::vector<PeakPyramid> peaks(2);
     auto decodeChannel = [&](uint32_t adpcm_data_start_offset, uint32_t num_channel_samples,
         int16_t& h1, int16_t& h2, const int16_t* coefs,
         std::vector<int16_t>& out_samples, const uint8_t* all_file_data,
-        size_t total_file_size) {
+        size_t total_file_size, PeakPyramid& channel_peaks) {
             size_t pcm_idx = 0; uint32_t adpcm_block_offset = adpcm_data_start_offset;
             while (pcm_idx < num_channel_samples) {
                 if (adpcm_block_offset + 8 > total_file_size) break;
@@ -163,222 +173,157 @@ bool DecodeDS2toWav(const String& ds2Path, const String& wavPath) {
                     int32_t sVal = static_cast<int32_t>(nib) * scale; sVal <<= 11;
                     int32_t prediction = static_cast<int32_t>(c1) * h1 + static_cast<int32_t>(c2) * h2;
                     int32_t sum = sVal + prediction + 1024; int16_t sample = static_cast<int16_t>(clamp16(sum >> 11));
-                    h2 = h1; h1 = sample; out_samples[pcm_idx++] = sample;
+                    h2 = h1; h1 = sample; out_samples[pcm_idx++] = sample; channel_peaks.add(sample);
                 }
                 adpcm_block_offset += 8;
             }
         };
-    decodeChannel(offsetL_ADPCM, totalSamplesL, hist1L, hist2L, coefL, leftSamples, fileData.data(), fileSize);
-    decodeChannel(offsetR_ADPCM, totalSamplesR, hist1R, hist2R, coefR, rightSamples, fileData.data(), fileSize);
-    std::vector<int16_t> interleaved(totalSamplesL * 2);
-    for (size_t i = 0; i < totalSamplesL; ++i) {
-        interleaved[i * 2] = leftSamples[i];
-        interleaved[i * 2 + 1] = rightSamples[i];
+    Scratch<int16_t> interleaved(totalSamplesL * 2);
+    {
+        TRACE_SCOPE_CAT("decode ADPCM", "codec");
+        RunStageTimer decodeTime(RunStage::Decode);
+        decodeChannel(offsetL_ADPCM, totalSamplesL, hist1L, hist2L, coefL, *leftSamples, fileData.data(), fileSize, peaks[0]);
+        decodeChannel(offsetR_ADPCM, totalSamplesR, hist1R, hist2R, coefR, *rightSamples, fileData.data(), fileSize, peaks[1]);
+        for (size_t i = 0; i < totalSamplesL; ++i) {
+            interleaved[i * 2] = leftSamples[i];
+            interleaved[i * 2 + 1] = rightSamples[i];
+        }
     }
-    WriteWav(wavPath, interleaved, sampleRateL, 2);
+    PcmDiskCache::Shared().store(cacheKey, sampleRateL, 2, interleaved.data(), interleaved.size());
+    RunSamples(interleaved.size());
+    {
+        TRACE_SCOPE_CAT("write WAV", "io");
+        RunStageTimer writeTime(RunStage::Write);
+        if (!WriteWav(wavPath, *interleaved, sampleRateL, 2)) { RunFail(RunError::Write); return false; }
+    }
+    for (auto& p : peaks) p.finish();
+    WritePeakSidecar(PeakSidecarPath(wavPath), peaks, sampleRateL);
     return true;
 }
 
-// WavData struct and find_chunk, ReadWavFile (unchanged)
+// WavData and ReadWavFile: any PCM / float / EXTENSIBLE WAV, folded to L/R 16-bit
 struct WavData {
     uint32_t sampleRate = 0; uint16_t numChannels = 0; uint16_t bitsPerSample = 0;
-    uint32_t totalSamplesPerChannel = 0; std::vector<int16_t> pcmSamplesLeft;
-    std::vector<int16_t> pcmSamplesRight; bool valid = false;
+    uint32_t totalSamplesPerChannel = 0; Scratch<int16_t> pcmSamplesLeft;
+    Scratch<int16_t> pcmSamplesRight; bool valid = false;
 };
-bool find_chunk(std::ifstream& f, const char* chunkID_target, uint32_t& chunkSize) {
-    char id[4]; chunkSize = 0; if (!f.good()) return false;
-    std::streampos initialPos = f.tellg();
-    while (f.read(id, 4)) {
-        if (!f.read(reinterpret_cast<char*>(&chunkSize), 4)) { f.clear(); f.seekg(initialPos); return false; }
-        if (std::strncmp(id, chunkID_target, 4) == 0) { return true; }
-        std::streampos currentPos = f.tellg();
-        if (!f.seekg(chunkSize, std::ios_base::cur)) { f.clear(); f.seekg(initialPos); return false; }
-        if (f.tellg() <= currentPos && chunkSize > 0) { f.clear(); f.seekg(initialPos); return false; }
-    }
-    f.clear(); f.seekg(initialPos); return false;
-}
 WavData ReadWavFile(const String& wavPath) {
-    WavData wav; std::ifstream f(wavPath, std::ios::binary);
-    if (!f.is_open()) return wav; char chunkID[4]; uint32_t chunkSize;
-    if (!f.read(chunkID, 4) || std::strncmp(chunkID, "RIFF", 4) != 0) return wav;
-    f.seekg(4, std::ios_base::cur);
-    if (!f.read(chunkID, 4) || std::strncmp(chunkID, "WAVE", 4) != 0) return wav;
-    if (!find_chunk(f, "fmt ", chunkSize) || chunkSize < 16) return wav;
-    uint16_t audioFormat; f.read(reinterpret_cast<char*>(&audioFormat), 2);
-    f.read(reinterpret_cast<char*>(&wav.numChannels), 2); f.read(reinterpret_cast<char*>(&wav.sampleRate), 4);
-    f.seekg(4, std::ios_base::cur);
-    uint16_t blockAlign_wav;
-    f.read(reinterpret_cast<char*>(&blockAlign_wav), 2); f.read(reinterpret_cast<char*>(&wav.bitsPerSample), 2);
-    if (audioFormat != 1 || wav.numChannels == 0 || wav.bitsPerSample != 16) { return wav; }
-    if (chunkSize > 16) f.seekg(chunkSize - 16, std::ios_base::cur);
-    if (!find_chunk(f, "data", chunkSize)) return wav;
-    uint32_t bytesPerSampleSet = wav.numChannels * (wav.bitsPerSample / 8);
-    if (bytesPerSampleSet == 0) return wav;
-    wav.totalSamplesPerChannel = chunkSize / bytesPerSampleSet;
-    wav.pcmSamplesLeft.resize(wav.totalSamplesPerChannel);
-    if (wav.numChannels >= 2) {
-        wav.pcmSamplesRight.resize(wav.totalSamplesPerChannel);
-    }
-    else if (wav.numChannels == 1) {
-        wav.pcmSamplesRight.resize(wav.totalSamplesPerChannel);
-    }
-    for (uint32_t i = 0; i < wav.totalSamplesPerChannel; ++i) {
-        int16_t sampleL; if (!f.read(reinterpret_cast<char*>(&sampleL), sizeof(int16_t))) { wav.valid = false; return wav; }
-        wav.pcmSamplesLeft[i] = sampleL;
-        if (wav.numChannels >= 2) {
-            int16_t sampleR; if (!f.read(reinterpret_cast<char*>(&sampleR), sizeof(int16_t))) { wav.valid = false; return wav; }
-            wav.pcmSamplesRight[i] = sampleR;
-            if (wav.numChannels > 2) f.seekg((wav.numChannels - 2) * (wav.bitsPerSample / 8), std::ios_base::cur);
-        }
-        else if (wav.numChannels == 1) { wav.pcmSamplesRight[i] = sampleL; }
-    }
+    TRACE_SCOPE_CAT("ReadWavFile", "io");
+    RunStageTimer readTime(RunStage::Read);
+    WavData wav;
+    MappedFile file(wavPath);
+    if (!file.is_open()) { RunFail(RunError::Open); return wav; }
+    WavFormat fmt;
+    if (!ParseWavFormat(file.data(), file.size(), fmt) || fmt.frames > UINT32_MAX) return wav;
+    wav.sampleRate = fmt.sample_rate; wav.numChannels = fmt.channels; wav.bitsPerSample = fmt.bits;
+    wav.totalSamplesPerChannel = static_cast<uint32_t>(fmt.frames);
+    wav.pcmSamplesLeft->resize(fmt.frames); wav.pcmSamplesRight->resize(fmt.frames);
+    int16_t* channels[2] = { wav.pcmSamplesLeft.data(), wav.pcmSamplesRight.data() };
+    ReadWavPlanar(fmt, 2, channels, WavDither::Tpdf);
     wav.valid = true; return wav;
 }
 
-// EncodeChannelADPCM (unchanged)
-std::vector<uint8_t> EncodeChannelADPCM(
+// Converts the WAV's channels to g_encodeRate (when one is chosen) right before they are
+// ADPCM-encoded, so the header's sample count and rate describe the resampled stream.
+void ApplyEncodeRate(WavData& wav, bool stereo) {
+    TRACE_SCOPE_CAT("ApplyEncodeRate", "codec");
+    if (g_encodeRate == 0 || g_encodeRate == wav.sampleRate || wav.totalSamplesPerChannel == 0) return;
+    RunStageTimer resampleTime(RunStage::Resample);
+    *wav.pcmSamplesLeft = Resample(wav.pcmSamplesLeft.data(), wav.totalSamplesPerChannel, wav.sampleRate, g_encodeRate, g_resampleQuality);
+    if (stereo) *wav.pcmSamplesRight = Resample(wav.pcmSamplesRight.data(), wav.totalSamplesPerChannel, wav.sampleRate, g_encodeRate, g_resampleQuality);
+    else *wav.pcmSamplesRight = *wav.pcmSamplesLeft;
+    wav.totalSamplesPerChannel = static_cast<uint32_t>(wav.pcmSamplesLeft.size());
+    wav.sampleRate = g_encodeRate;
+}
+
+// EncodeChannelADPCM (one EncodeDspFrame per 14-sample block, into the caller's buffer)
+void EncodeChannelADPCM(
     const std::vector<int16_t>& pcmSamples, uint32_t totalSamplesToEncode,
     int16_t& io_hist1, int16_t& io_hist2, const int16_t adpcmCoefs[16],
-    uint16_t& out_initial_pred_scale) {
-    std::vector<uint8_t> encodedData;
-    if (pcmSamples.empty() || totalSamplesToEncode == 0) { out_initial_pred_scale = 0; return encodedData; }
-    size_t numBlocks = (totalSamplesToEncode + 13) / 14; encodedData.reserve(numBlocks * 8);
-    int16_t currentHist1 = io_hist1; int16_t currentHist2 = io_hist2; size_t sampleIdx = 0;
+    uint16_t& out_initial_pred_scale, std::vector<uint8_t>& encodedData) {
+    TRACE_SCOPE_CAT("EncodeChannelADPCM", "codec");
+    RunStageTimer encodeTime(RunStage::Encode);
+    encodedData.clear();
+    if (pcmSamples.empty() || totalSamplesToEncode == 0) { out_initial_pred_scale = 0; return; }
+    size_t numBlocks = (totalSamplesToEncode + 13) / 14; encodedData.resize(numBlocks * 8);
+    int16_t currentHist1 = io_hist1; int16_t currentHist2 = io_hist2;
     for (size_t block = 0; block < numBlocks; ++block) {
-        int samplesInBlock = static_cast<int>((std::min)(static_cast<uint32_t>(14), (totalSamplesToEncode - static_cast<uint32_t>(sampleIdx))));
-        if (samplesInBlock <= 0) break;
-        int8_t blockNibbles[14]; std::memset(blockNibbles, 0, sizeof(blockNibbles));
-        int bestPredIdx = 0; int bestShift = 0; double minErrorSumSq = -1.0;
-        int16_t blockInitialHist1 = currentHist1; int16_t blockInitialHist2 = currentHist2;
-        int8_t trialNibbles[14];
-        for (int predIdxTry = 0; predIdxTry < 8; ++predIdxTry) {
-            const int16_t c1 = adpcmCoefs[predIdxTry * 2 + 0]; const int16_t c2 = adpcmCoefs[predIdxTry * 2 + 1];
-            for (int shiftTry = 0; shiftTry < 12; ++shiftTry) {
-                int16_t tempHist1 = blockInitialHist1; int16_t tempHist2 = blockInitialHist2;
-                double currentErrorSumSq = 0;
-                for (int n = 0; n < samplesInBlock; ++n) {
-                    int16_t currentSample = pcmSamples[sampleIdx + n]; int32_t scale = 1 << shiftTry;
-                    int32_t predic = (static_cast<int32_t>(c1) * tempHist1 + static_cast<int32_t>(c2) * tempHist2);
-                    int32_t diff = (static_cast<int32_t>(currentSample) << 11) - predic;
-                    double nibble_ideal = static_cast<double>(diff) / static_cast<double>(scale << 11);
-                    int8_t nib = static_cast<int8_t>(std::round(nibble_ideal));
-                    nib = (std::max)(static_cast<int8_t>(-8), (std::min)(static_cast<int8_t>(7), nib));
-                    trialNibbles[n] = nib; int32_t sVal = static_cast<int32_t>(nib) * scale; sVal <<= 11;
-                    int32_t sum = sVal + predic + 1024; int16_t reconstructedSample = clamp16(sum >> 11);
-                    currentErrorSumSq += std::pow(static_cast<double>(currentSample) - reconstructedSample, 2);
-                    tempHist2 = tempHist1; tempHist1 = reconstructedSample;
-                }
-                if (minErrorSumSq < 0 || currentErrorSumSq < minErrorSumSq) {
-                    minErrorSumSq = currentErrorSumSq; bestPredIdx = predIdxTry; bestShift = shiftTry;
-                    for (int i = 0; i < samplesInBlock; ++i) blockNibbles[i] = trialNibbles[i];
-                }
-            }
-        }
-        uint8_t headerByte = static_cast<uint8_t>((bestPredIdx << 4) | (bestShift & 0x0F));
-        if (block == 0) { out_initial_pred_scale = headerByte; }
-        encodedData.push_back(headerByte);
-        const int16_t final_c1 = adpcmCoefs[bestPredIdx * 2 + 0]; const int16_t final_c2 = adpcmCoefs[bestPredIdx * 2 + 1];
-        int final_scale_val = 1 << bestShift;
-        for (int n = 0; n < 14; n += 2) {
-            uint8_t packedByte = (blockNibbles[n] & 0x0F) << 4;
-            if (n + 1 < 14) { packedByte |= (blockNibbles[n + 1] & 0x0F); }
-            encodedData.push_back(packedByte);
-        }
-        for (int n = 0; n < samplesInBlock; ++n) {
-            int8_t nib = blockNibbles[n]; int32_t sVal = static_cast<int32_t>(nib) * final_scale_val; sVal <<= 11;
-            int32_t predic = (static_cast<int32_t>(final_c1) * currentHist1 + static_cast<int32_t>(final_c2) * currentHist2);
-            int32_t sum = sVal + predic + 1024; int16_t sampleOut = clamp16(sum >> 11);
-            currentHist2 = currentHist1; currentHist1 = sampleOut;
-        }
-        sampleIdx += samplesInBlock;
+        size_t sampleIdx = block * 14;
+        int samplesInBlock = static_cast<int>((std::min)(static_cast<size_t>(14), totalSamplesToEncode - sampleIdx));
+        EncodeDspFrame(pcmSamples.data() + sampleIdx, samplesInBlock, adpcmCoefs, currentHist1, currentHist2, encodedData.data() + block * 8);
     }
-    io_hist1 = currentHist1; io_hist2 = currentHist2; return encodedData;
+    out_initial_pred_scale = encodedData[0];
+    io_hist1 = currentHist1; io_hist2 = currentHist2;
 }
 
-// EncodeWavToDS2 (unchanged)
 bool EncodeWavToDS2(const String& wavPath, const String& ds2Path) {
+    TRACE_SCOPE_CAT("EncodeWavToDS2", "batch");
     WavData wav = ReadWavFile(wavPath);
-    if (!wav.valid) { MessageBox(NULL, (L"DS2 Encode: Failed to read WAV: " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
-    if (wav.totalSamplesPerChannel == 0) { MessageBox(NULL, (L"DS2 Encode: WAV has zero samples: " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
+    if (!wav.valid) { RunFail(RunError::Format); MessageBox(NULL, (L"DS2 Encode: Failed to read WAV: " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
+    if (wav.totalSamplesPerChannel == 0) { RunFail(RunError::Format); MessageBox(NULL, (L"DS2 Encode: WAV has zero samples: " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
     if (wav.pcmSamplesLeft.empty() || wav.pcmSamplesRight.empty()) {
         MessageBox(NULL, (L"DS2 Encode: WAV has missing L/R channel data (after read): " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false;
     }
+    ApplyEncodeRate(wav, true);
     uint32_t totalSamples = wav.totalSamplesPerChannel;
     const int16_t dsp_coefs[16] = { 2048, 0, 0, 0, 4096, -2048, 2048, -2048, 3072, -1024, 1024, 512, 512, 256, 2048, 1024 };
     int16_t initialHist1L = 0, initialHist2L = 0; int16_t initialHist1R = 0, initialHist2R = 0;
     uint16_t predScaleL_first = 0, predScaleR_first = 0;
-    std::vector<uint8_t> adpcm_L_data = EncodeChannelADPCM(wav.pcmSamplesLeft, totalSamples, initialHist1L, initialHist2L, dsp_coefs, predScaleL_first);
-    std::vector<uint8_t> adpcm_R_data = EncodeChannelADPCM(wav.pcmSamplesRight, totalSamples, initialHist1R, initialHist2R, dsp_coefs, predScaleR_first);
+    Scratch<uint8_t> adpcm_L_data, adpcm_R_data;
+    EncodeChannelADPCM(*wav.pcmSamplesLeft, totalSamples, initialHist1L, initialHist2L, dsp_coefs, predScaleL_first, *adpcm_L_data);
+    EncodeChannelADPCM(*wav.pcmSamplesRight, totalSamples, initialHist1R, initialHist2R, dsp_coefs, predScaleR_first, *adpcm_R_data);
     uint32_t adpcm_L_data_bytes = static_cast<uint32_t>(adpcm_L_data.size());
     uint32_t adpcm_R_data_bytes = static_cast<uint32_t>(adpcm_R_data.size());
     uint32_t expected_adpcm_bytes = ((totalSamples + 13) / 14) * 8;
-    if (adpcm_L_data_bytes != expected_adpcm_bytes || adpcm_R_data_bytes != expected_adpcm_bytes) { MessageBox(NULL, (L"DS2 Encode: ADPCM size mismatch for " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
-    DspChannelHeader headerL, headerR;
-    headerL.set_num_samples(totalSamples); headerL.set_num_adpcm_nibbles(((totalSamples + 13) / 14) * 16);
-    headerL.set_sample_rate(wav.sampleRate); headerL.set_loop_flag(0); headerL.set_format_info(0x0000);
-    headerL.set_loop_start_nibble_addr(0); headerL.set_loop_end_sample_addr(totalSamples);
-    headerL.set_current_adpcm_addr(0); headerL.set_coeffs(dsp_coefs); headerL.set_gain(0);
-    headerL.set_initial_pred_scale(predScaleL_first); headerL.set_initial_hist1(0); headerL.set_initial_hist2(0);
-    headerL.set_loop_pred_scale(0); headerL.set_loop_hist1(0); headerL.set_loop_hist2(0);
-    headerL.set_unknown_constants(); headerL.set_adpcm_data_size_bytes(adpcm_L_data_bytes);
-    headerL.set_offset_to_adpcm_data(0xC0);
-    headerR.set_num_samples(totalSamples); headerR.set_num_adpcm_nibbles(((totalSamples + 13) / 14) * 16);
-    headerR.set_sample_rate(wav.sampleRate); headerR.set_loop_flag(0); headerR.set_format_info(0x0000);
-    headerR.set_loop_start_nibble_addr(0); headerR.set_loop_end_sample_addr(totalSamples);
-    headerR.set_current_adpcm_addr(0); headerR.set_coeffs(dsp_coefs); headerR.set_gain(0);
-    headerR.set_initial_pred_scale(predScaleR_first); headerR.set_initial_hist1(0); headerR.set_initial_hist2(0);
-    headerR.set_loop_pred_scale(0); headerR.set_loop_hist1(0); headerR.set_loop_hist2(0);
-    headerR.set_unknown_constants(); headerR.set_adpcm_data_size_bytes(adpcm_R_data_bytes);
-    headerR.set_offset_to_adpcm_data(0xC0 + adpcm_L_data_bytes);
+    if (adpcm_L_data_bytes != expected_adpcm_bytes || adpcm_R_data_bytes != expected_adpcm_bytes) { RunFail(RunError::Encode); MessageBox(NULL, (L"DS2 Encode: ADPCM size mismatch for " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
+    const DspHeader headerL = MakeEncodedHeader(totalSamples, wav.sampleRate, dsp_coefs, predScaleL_first, adpcm_L_data_bytes, 0xC0);
+    const DspHeader headerR = MakeEncodedHeader(totalSamples, wav.sampleRate, dsp_coefs, predScaleR_first, adpcm_R_data_bytes, 0xC0 + adpcm_L_data_bytes);
+    RunSamples(uint64_t(totalSamples) * 2);
+    RunStageTimer writeTime(RunStage::Write);
     std::ofstream out(ds2Path, std::ios::binary);
-    if (!out.is_open()) { MessageBox(NULL, (L"DS2 Encode: Failed to create output file: " + ds2Path).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
-    out.write(reinterpret_cast<const char*>(headerL.raw), sizeof(headerL.raw));
-    out.write(reinterpret_cast<const char*>(headerR.raw), sizeof(headerR.raw));
+    if (!out.is_open()) { RunFail(RunError::Write); MessageBox(NULL, (L"DS2 Encode: Failed to create output file: " + ds2Path).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
+    WriteDspHeader(out, headerL);
+    WriteDspHeader(out, headerR);
     out.write(reinterpret_cast<const char*>(adpcm_L_data.data()), adpcm_L_data.size());
     out.write(reinterpret_cast<const char*>(adpcm_R_data.data()), adpcm_R_data.size());
     out.close(); return true;
 }
 
-// EncodeWavToMonoDsp (unchanged)
 bool EncodeWavToMonoDsp(const String& wavPath, const String& dspPath) {
+    TRACE_SCOPE_CAT("EncodeWavToMonoDsp", "batch");
     WavData wav = ReadWavFile(wavPath);
-    if (!wav.valid) { MessageBox(NULL, (L"DSP Encode: Failed to read WAV: " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
-    if (wav.totalSamplesPerChannel == 0) { MessageBox(NULL, (L"DSP Encode: WAV has zero samples: " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
+    if (!wav.valid) { RunFail(RunError::Format); MessageBox(NULL, (L"DSP Encode: Failed to read WAV: " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
+    if (wav.totalSamplesPerChannel == 0) { RunFail(RunError::Format); MessageBox(NULL, (L"DSP Encode: WAV has zero samples: " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
     if (wav.pcmSamplesLeft.empty()) {
         MessageBox(NULL, (L"DSP Encode: WAV has missing L channel data (after read): " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false;
     }
-    const std::vector<int16_t>& monoPcmData = wav.pcmSamplesLeft;
+    ApplyEncodeRate(wav, false);
+    const std::vector<int16_t>& monoPcmData = *wav.pcmSamplesLeft;
     uint32_t totalSamples = wav.totalSamplesPerChannel;
     const int16_t dsp_coefs[16] = { 2048, 0, 0, 0, 4096, -2048, 2048, -2048, 3072, -1024, 1024, 512, 512, 256, 2048, 1024 };
     int16_t initialHist1 = 0, initialHist2 = 0;
     uint16_t predScale_first = 0;
-    std::vector<uint8_t> adpcm_data = EncodeChannelADPCM(monoPcmData, totalSamples, initialHist1, initialHist2, dsp_coefs, predScale_first);
+    Scratch<uint8_t> adpcm_data;
+    EncodeChannelADPCM(monoPcmData, totalSamples, initialHist1, initialHist2, dsp_coefs, predScale_first, *adpcm_data);
     uint32_t adpcm_data_bytes = static_cast<uint32_t>(adpcm_data.size());
     uint32_t expected_adpcm_bytes = ((totalSamples + 13) / 14) * 8;
-    if (adpcm_data_bytes != expected_adpcm_bytes) { MessageBox(NULL, (L"DSP Encode: ADPCM size mismatch for " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
-    DspChannelHeader header;
-    header.set_num_samples(totalSamples);
-    header.set_num_adpcm_nibbles(((totalSamples + 13) / 14) * 16);
-    header.set_sample_rate(wav.sampleRate);
-    header.set_loop_flag(0); header.set_format_info(0x0000);
-    header.set_loop_start_nibble_addr(0); header.set_loop_end_sample_addr(totalSamples);
-    header.set_current_adpcm_addr(0); header.set_coeffs(dsp_coefs); header.set_gain(0);
-    header.set_initial_pred_scale(predScale_first); header.set_initial_hist1(0); header.set_initial_hist2(0);
-    header.set_loop_pred_scale(0); header.set_loop_hist1(0); header.set_loop_hist2(0);
-    header.set_unknown_constants(); header.set_adpcm_data_size_bytes(adpcm_data_bytes);
-    header.set_offset_to_adpcm_data(0x60);
+    if (adpcm_data_bytes != expected_adpcm_bytes) { RunFail(RunError::Encode); MessageBox(NULL, (L"DSP Encode: ADPCM size mismatch for " + wavPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
+    const DspHeader header = MakeEncodedHeader(totalSamples, wav.sampleRate, dsp_coefs, predScale_first, adpcm_data_bytes, 0x60);
+    RunSamples(totalSamples);
+    RunStageTimer writeTime(RunStage::Write);
     std::ofstream out(dspPath, std::ios::binary);
-    if (!out.is_open()) { MessageBox(NULL, (L"DSP Encode: Failed to create output file: " + dspPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
-    out.write(reinterpret_cast<const char*>(header.raw), sizeof(header.raw));
+    if (!out.is_open()) { RunFail(RunError::Write); MessageBox(NULL, (L"DSP Encode: Failed to create output file: " + dspPath).c_str(), L"Error", MB_OK | MB_ICONERROR); return false; }
+    WriteDspHeader(out, header);
     out.write(reinterpret_cast<const char*>(adpcm_data.data()), adpcm_data.size());
     out.close(); return true;
 }
 
-// *** MODIFIED: DecodeMonoDspToWav with MessageBox error pop-ups ***
-// *** MODIFIED: DecodeMonoDspToWav with a 6-byte size cushion ***
+// Errors are shown in message boxes; the ADPCM data may end up to 6 bytes short (see below).
 bool DecodeMonoDspToWav(const String& dspPath, const String& wavPath, HWND hwndParent) {
+    TRACE_SCOPE_CAT("DecodeMonoDspToWav", "batch");
     std::ifstream in(dspPath, std::ios::binary | std::ios::ate);
     if (!in) {
+        RunFail(RunError::Open);
         MessageBoxW(hwndParent, (L"Could not open the DSP file for reading:\n\n" + dspPath).c_str(), L"File Open Error", MB_OK | MB_ICONERROR);
         return false;
     }
@@ -389,33 +334,39 @@ bool DecodeMonoDspToWav(const String& dspPath, const String& wavPath, HWND hwndP
         ss << L"The file is too small to be a valid DSP file.\n\n"
             << L"File: " << dspPath << L"\n"
             << L"Size: " << fileSize << L" bytes (requires at least 96 bytes for the header).";
+        RunFail(RunError::Format);
         MessageBoxW(hwndParent, ss.str().c_str(), L"DSP Decode Error", MB_OK | MB_ICONERROR);
         return false;
     }
 
     in.seekg(0);
-    DspChannelHeader header;
-    if (!in.read(reinterpret_cast<char*>(header.raw), sizeof(header.raw))) {
+    uint8_t rawHeader[sizeof(DspHeader)];
+    if (!in.read(reinterpret_cast<char*>(rawHeader), sizeof(rawHeader))) {
+        RunFail(RunError::Format);
         MessageBoxW(hwndParent, (L"Failed to read the 96-byte header from the DSP file:\n\n" + dspPath).c_str(), L"File Read Error", MB_OK | MB_ICONERROR);
         return false;
     }
+    DspHeader header;
+    BeLoad(rawHeader, header);
 
-    uint32_t totalSamples = header.get_num_samples();
+    uint32_t totalSamples = header.num_samples;
     if (totalSamples == 0) {
+        RunFail(RunError::Format);
         MessageBoxW(hwndParent, (L"The file header reports zero audio samples, so there is nothing to decode.\n\nFile: " + dspPath).c_str(), L"DSP Decode Error", MB_OK | MB_ICONWARNING);
         return false;
     }
 
-    uint32_t sampleRate = header.get_sample_rate();
+    uint32_t sampleRate = header.sample_rate;
     if (sampleRate == 0) {
+        RunFail(RunError::Format);
         MessageBoxW(hwndParent, (L"The file header reports a sample rate of 0 Hz, which is invalid.\n\nFile: " + dspPath).c_str(), L"DSP Decode Error", MB_OK | MB_ICONERROR);
         return false;
     }
 
-    uint32_t offset_ADPCM = header.get_offset_to_adpcm_data();
+    uint32_t offset_ADPCM = header.data_offset;
     uint32_t calculatedAdpcmDataSizeBytes = ((totalSamples + 13) / 14) * 8;
 
-    // MODIFIED CHECK: Allow the file to be up to 6 bytes smaller than the calculated size.
+    // Allow the file to be up to 6 bytes smaller than the calculated size.
     // This accounts for encoders that truncate the final, partially-used ADPCM block.
     if (offset_ADPCM + calculatedAdpcmDataSizeBytes > fileSize + 6) {
         std::wstringstream ss;
@@ -425,27 +376,42 @@ bool DecodeMonoDspToWav(const String& dspPath, const String& wavPath, HWND hwndP
             << L"File Size: " << fileSize << L" bytes\n"
             << L"Required Total Size: " << (offset_ADPCM + calculatedAdpcmDataSizeBytes) << L" bytes\n\n"
             << L"The file is " << ((offset_ADPCM + calculatedAdpcmDataSizeBytes) - fileSize) << L" bytes too small.";
+        RunFail(RunError::Format);
         MessageBoxW(hwndParent, ss.str().c_str(), L"DSP Decode Error", MB_OK | MB_ICONERROR);
         return false;
     }
 
     // --- The rest of the function remains the same ---
-    int16_t coefs[16];
-    header.get_coeffs(coefs);
-    int16_t hist1 = header.get_initial_hist1();
-    int16_t hist2 = header.get_initial_hist2();
+    const int16_t* coefs = header.coefs;
+    int16_t hist1 = header.initial_hist1;
+    int16_t hist2 = header.initial_hist2;
 
-    std::vector<uint8_t> fileData(fileSize);
+    Scratch<uint8_t> fileData(fileSize);
     in.seekg(0);
     in.read(reinterpret_cast<char*>(fileData.data()), fileSize);
     in.close();
 
-    std::vector<int16_t> monoSamples(totalSamples);
+    const uint64_t cacheKey = PcmDiskCache::Key(fileData.data(), 0x60, fileData.data() + 0x60, fileSize - 0x60);
+    CachedPcm cached;
+    if (PcmDiskCache::Shared().find(cacheKey, cached) && cached.channels() == 1) {
+        RunSamples(cached.sample_count());
+        RunStageTimer writeTime(RunStage::Write);
+        if (!WriteWav(wavPath, cached.samples(), cached.sample_count(), cached.sample_rate(), 1)) { RunFail(RunError::Write); return false; }
+        if (!std::filesystem::exists(PeakSidecarPath(wavPath))) {
+            std::vector<PeakPyramid> peaks(1);
+            peaks[0].add(cached.samples(), cached.frames()); peaks[0].finish();
+            WritePeakSidecar(PeakSidecarPath(wavPath), peaks, cached.sample_rate());
+        }
+        return true;
+    }
+
+    Scratch<int16_t> monoSamples(totalSamples);
+    std::vector<PeakPyramid> peaks(1);
 
     auto decodeChannel = [&](uint32_t adpcm_data_start_offset, uint32_t num_channel_samples,
         int16_t& h1, int16_t& h2, const int16_t* channel_coefs,
         std::vector<int16_t>& out_samples, const uint8_t* all_file_data,
-        size_t total_file_size) {
+        size_t total_file_size, PeakPyramid& channel_peaks) {
             size_t pcm_idx = 0; uint32_t adpcm_block_offset = adpcm_data_start_offset;
             while (pcm_idx < num_channel_samples) {
                 if (adpcm_block_offset + 8 > total_file_size) break; // This check prevents reading past the actual end of the file
@@ -462,17 +428,24 @@ bool DecodeMonoDspToWav(const String& dspPath, const String& wavPath, HWND hwndP
                     int32_t prediction = static_cast<int32_t>(c1) * h1 + static_cast<int32_t>(c2) * h2;
                     int32_t sum = sVal + prediction + 1024;
                     int16_t sample_out = static_cast<int16_t>(clamp16(sum >> 11));
-                    h2 = h1; h1 = sample_out; out_samples[pcm_idx++] = sample_out;
+                    h2 = h1; h1 = sample_out; out_samples[pcm_idx++] = sample_out; channel_peaks.add(sample_out);
                 }
                 adpcm_block_offset += 8;
             }
         };
-    decodeChannel(offset_ADPCM, totalSamples, hist1, hist2, coefs, monoSamples, fileData.data(), fileSize);
-    WriteWav(wavPath, monoSamples, sampleRate, 1);
+    {
+        RunStageTimer decodeTime(RunStage::Decode);
+        decodeChannel(offset_ADPCM, totalSamples, hist1, hist2, coefs, *monoSamples, fileData.data(), fileSize, peaks[0]);
+    }
+    PcmDiskCache::Shared().store(cacheKey, sampleRate, 1, monoSamples.data(), monoSamples.size());
+    RunSamples(monoSamples.size());
+    RunStageTimer writeTime(RunStage::Write);
+    if (!WriteWav(wavPath, *monoSamples, sampleRate, 1)) { RunFail(RunError::Write); return false; }
+    peaks[0].finish();
+    WritePeakSidecar(PeakSidecarPath(wavPath), peaks, sampleRate);
     return true;
 }
 
-// SelectFolderDialog (unchanged)
 String SelectFolderDialog(HWND hwndOwner, const wchar_t* title) {
     wchar_t path[MAX_PATH]; BROWSEINFOW bi = { 0 }; bi.hwndOwner = hwndOwner;
     bi.lpszTitle = title; bi.ulFlags = BIF_RETURNONLYFSDIRS | BIF_NEWDIALOGSTYLE;
@@ -484,7 +457,6 @@ String SelectFolderDialog(HWND hwndOwner, const wchar_t* title) {
     return L"";
 }
 
-// GetFileName and GetFileExtension (unchanged)
 String GetFileName(const String& filePath) {
     size_t lastSlash = filePath.find_last_of(L"\\/");
     return (lastSlash != String::npos) ? filePath.substr(lastSlash + 1) : filePath;
@@ -499,22 +471,95 @@ String GetFileExtension(const String& fileName) {
     return L"";
 }
 
+// Left/right DSP names for a stereo pair: "name_L.dsp" / "name_R.dsp".
+String PairedDspPath(const String& basePath, wchar_t side) {
+    size_t dotPos = basePath.find_last_of(L'.');
+    size_t slashPos = basePath.find_last_of(L"\\/");
+    String stem = (dotPos != String::npos && (slashPos == String::npos || dotPos > slashPos)) ? basePath.substr(0, dotPos) : basePath;
+    return stem + L"_" + side + L".dsp";
+}
+
+// DS2 -> name_L.dsp + name_R.dsp. Headers are rewritten, ADPCM bytes are copied from the mapping.
+bool SplitDs2ToDspPair(const String& ds2Path, const String& dspBasePath) {
+    MappedFile ds2(ds2Path);
+    DspStream left, right;
+    if (!ds2.is_open() || !ParseDs2(ds2.data(), ds2.size(), left, right)) return false;
+    return WriteDspFile(PairedDspPath(dspBasePath, L'L'), left) && WriteDspFile(PairedDspPath(dspBasePath, L'R'), right);
+}
 
-// *** MODIFIED FUNCTION for Recursive Batch Processing with HWND ***
+// name_L.dsp + name_R.dsp -> DS2. Both channels must have the same length and rate.
+bool JoinDspPairToDs2(const String& leftDspPath, const String& ds2Path) {
+    size_t dotPos = leftDspPath.find_last_of(L'.');
+    if (dotPos == String::npos || dotPos < 2 || leftDspPath.compare(dotPos - 2, 2, L"_L") != 0) return false;
+    String rightDspPath = leftDspPath; rightDspPath[dotPos - 1] = L'R';
+    MappedFile l(leftDspPath), r(rightDspPath);
+    DspStream left, right;
+    if (!l.is_open() || !r.is_open() || !ParseDsp(l.data(), l.size(), left) || !ParseDsp(r.data(), r.size(), right)) return false;
+    return WriteDs2File(ds2Path, left, right);
+}
+
+// Keeps [fromSeconds, toSeconds) of a mono DSP (toSeconds <= 0 = to the end). The start
+// snaps to a 14-sample frame; no frame is re-encoded.
+bool TrimMonoDsp(const String& dspPath, const String& outPath, double fromSeconds, double toSeconds) {
+    MappedFile in(dspPath);
+    DspStream stream;
+    if (!in.is_open() || !ParseDsp(in.data(), in.size(), stream) || stream.sample_rate() == 0) return false;
+    DspClip clip(stream), trimmed;
+    uint32_t from = static_cast<uint32_t>((std::max)(0.0, fromSeconds) * stream.sample_rate());
+    uint32_t to = toSeconds > 0 ? static_cast<uint32_t>(toSeconds * stream.sample_rate()) : clip.samples();
+    return DspTrim(clip, from, to, trimmed) && WriteDspClip(outPath, trimmed);
+}
+
+// first + second -> out. Only the frames where the two meet are re-encoded; 'note' says
+// how many, and whether the join gave up on converging and re-encoded the rest of B.
+bool AppendMonoDsp(const String& firstPath, const String& secondPath, const String& outPath, String& note) {
+    MappedFile a(firstPath), b(secondPath);
+    DspStream sa, sb;
+    if (!a.is_open() || !b.is_open() || !ParseDsp(a.data(), a.size(), sa) || !ParseDsp(b.data(), b.size(), sb)) return false;
+    DspClip joined(sa);
+    if (!DspAppend(joined, DspClip(sb)) || !WriteDspClip(outPath, joined)) return false;
+    std::wstringstream ss;
+    ss << L" (" << joined.reencoded_frames << L" frames re-encoded";
+    if (joined.fallback_edits) ss << L"; no match within " << DspClip::MAX_CONVERGE_FRAMES << L" frames, rest of B re-encoded";
+    ss << L")";
+    note = ss.str();
+    return true;
+}
+
+
+// Memory use of the run so far, appended to the batch summaries: peak RSS and how many
+// scratch buffers were reused from the pool vs. newly allocated.
+String BatchMemoryNote() {
+    const BufferPoolStats pool = GetBufferPoolStats();
+    std::wstringstream ss;
+    ss << L" | Peak RSS: " << (PeakRssBytes() >> 20) << L" MB, buffers: " << pool.reused << L" reused / " << pool.allocated << L" allocated";
+    return ss.str();
+}
+
+// Ends a batch's metrics and writes them to <root>\run_metrics_<operation>.json; the note names the file.
+String BatchMetricsNote(RunMetrics& metrics, const String& rootPath) {
+    metrics.finish();
+    const std::filesystem::path path = metrics.json_path(rootPath);
+    const String name = path.filename().wstring();
+    return metrics.write_json(path) ? L" → " + name : L" (" + name + L" could not be written)";
+}
+
+// Converts every matching file under currentDirPath, writing each directory's results to its
+// own outputSubfolderName; conversion_function_ptr takes an HWND when takes_hwnd is set.
 void RecursiveBatchProcess(
     const String& currentDirPath,
     const String& operationDesc,
     const String& outputSubfolderName,
     const String& targetInputExtensionNoDot,
     const String& outputExtensionWithDot,
-    // MODIFICATION: The function pointer can now accept an HWND
     void* conversion_function_ptr, // Use void* for generic pointer
     bool takes_hwnd, // Flag to know which function type we have
     HWND hStatusLabel,
     HWND hMainWindow,
     int& totalFilesProcessed,
     int& totalFilesSucceeded,
-    int& totalFilesFailed
+    int& totalFilesFailed,
+    RunMetrics& metrics
 ) {
     String searchPattern = currentDirPath + L"\\*";
     WIN32_FIND_DATAW findData;
@@ -568,6 +613,9 @@ void RecursiveBatchProcess(
                 UpdateWindow(hMainWindow);
                 PeekMessage(NULL, NULL, 0, 0, PM_REMOVE);
 
+                TRACE_SCOPE_CAT("batch file", "batch");
+                RunFile file(metrics);
+                file.bytes_in((static_cast<uint64_t>(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow);
                 bool success = false;
                 if (takes_hwnd) {
                     // Cast to the function type that takes an HWND
@@ -582,9 +630,13 @@ void RecursiveBatchProcess(
 
                 if (!success) {
                     totalFilesFailed++;
+                    file.fail();
                 }
                 else {
                     totalFilesSucceeded++;
+                    WIN32_FILE_ATTRIBUTE_DATA outInfo;
+                    if (GetFileAttributesExW(outFile.c_str(), GetFileExInfoStandard, &outInfo))
+                        file.bytes_out((static_cast<uint64_t>(outInfo.nFileSizeHigh) << 32) | outInfo.nFileSizeLow);
                 }
             }
         }
@@ -594,17 +646,19 @@ void RecursiveBatchProcess(
 
     for (const auto& subDir : subDirectoriesToScan) {
         RecursiveBatchProcess(subDir, operationDesc, outputSubfolderName, targetInputExtensionNoDot, outputExtensionWithDot,
-            conversion_function_ptr, takes_hwnd, hStatusLabel, hMainWindow, totalFilesProcessed, totalFilesSucceeded, totalFilesFailed);
+            conversion_function_ptr, takes_hwnd, hStatusLabel, hMainWindow, totalFilesProcessed, totalFilesSucceeded, totalFilesFailed, metrics);
     }
 }
 
 
-// *** MODIFIED WndProc to handle new function calls ***
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
     static HWND btnDecDs2S, btnEncDs2S, stat,
         btnDecDs2B, btnEncDs2B,
         btnDecDspS, btnEncDspS,
-        btnDecDspB, btnEncDspB;
+        btnDecDspB, btnEncDspB,
+        btnSplitDs2, btnJoinDsp,
+        editTrimFrom, editTrimTo, btnTrimDsp, btnAppendDsp,
+        comboEncRate, comboEncQuality, btnScanCorpus;
 
     int btnWidth = 200;
     int btnHeight = 30;
@@ -614,7 +668,12 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
     int y_row2 = y_row1 + btnHeight + 10;
     int y_row3 = y_row2 + btnHeight + 40;
     int y_row4 = y_row3 + btnHeight + 10;
-    int y_status = y_row4 + btnHeight + 20;
+    int y_row5 = y_row4 + btnHeight + 40;
+    int y_row6 = y_row5 + btnHeight + 40;
+    int y_row7 = y_row6 + btnHeight + 10;
+    int y_row8 = y_row7 + btnHeight + 40;
+    int y_row9 = y_row8 + btnHeight + 40;
+    int y_status = y_row9 + btnHeight + 20;
 
     switch (msg) {
     case WM_CREATE:
@@ -638,13 +697,60 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
         btnEncDspB = CreateWindow(L"BUTTON", L"WAV → DSP (Batch)", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
             x2, y_row4, btnWidth, btnHeight, hwnd, (HMENU)(INT_PTR)IDC_BTN_ENC_DSP_BATCH, hInst, NULL);
 
+        CreateWindow(L"STATIC", L"Remux (lossless, no re-encode)", WS_VISIBLE | WS_CHILD | SS_LEFT, x1, y_row4 + btnHeight + 15, btnWidth * 2 + 15, 20, hwnd, (HMENU)(INT_PTR)-1, hInst, NULL);
+        btnSplitDs2 = CreateWindow(L"BUTTON", L"DS2 → DSP L/R (Single)", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+            x1, y_row5, btnWidth, btnHeight, hwnd, (HMENU)(INT_PTR)IDC_BTN_SPLIT_DS2, hInst, NULL);
+        btnJoinDsp = CreateWindow(L"BUTTON", L"DSP L/R → DS2 (Single)", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+            x2, y_row5, btnWidth, btnHeight, hwnd, (HMENU)(INT_PTR)IDC_BTN_JOIN_DSP, hInst, NULL);
+
+        CreateWindow(L"STATIC", L"Edit DSP (Mono, frame-accurate)", WS_VISIBLE | WS_CHILD | SS_LEFT, x1, y_row5 + btnHeight + 15, btnWidth * 2 + 15, 20, hwnd, (HMENU)(INT_PTR)-1, hInst, NULL);
+        CreateWindow(L"STATIC", L"From (s):", WS_VISIBLE | WS_CHILD | SS_LEFT, x1, y_row6 + 6, 60, 20, hwnd, (HMENU)(INT_PTR)-1, hInst, NULL);
+        editTrimFrom = CreateWindow(L"EDIT", L"0", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_AUTOHSCROLL,
+            x1 + 60, y_row6 + 4, 70, 22, hwnd, (HMENU)(INT_PTR)IDC_EDIT_TRIM_FROM, hInst, NULL);
+        CreateWindow(L"STATIC", L"To (s):", WS_VISIBLE | WS_CHILD | SS_LEFT, x1 + 140, y_row6 + 6, 45, 20, hwnd, (HMENU)(INT_PTR)-1, hInst, NULL);
+        editTrimTo = CreateWindow(L"EDIT", L"", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_AUTOHSCROLL,
+            x1 + 185, y_row6 + 4, 70, 22, hwnd, (HMENU)(INT_PTR)IDC_EDIT_TRIM_TO, hInst, NULL);
+        btnTrimDsp = CreateWindow(L"BUTTON", L"Trim DSP (Single)", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+            x1, y_row7, btnWidth, btnHeight, hwnd, (HMENU)(INT_PTR)IDC_BTN_TRIM_DSP, hInst, NULL);
+        btnAppendDsp = CreateWindow(L"BUTTON", L"Join DSP A + B (Single)", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+            x2, y_row7, btnWidth, btnHeight, hwnd, (HMENU)(INT_PTR)IDC_BTN_APPEND_DSP, hInst, NULL);
+
+        CreateWindow(L"STATIC", L"Encode settings (WAV → DS2 / DSP)", WS_VISIBLE | WS_CHILD | SS_LEFT, x1, y_row7 + btnHeight + 15, btnWidth * 2 + 15, 20, hwnd, (HMENU)(INT_PTR)-1, hInst, NULL);
+        CreateWindow(L"STATIC", L"Rate:", WS_VISIBLE | WS_CHILD | SS_LEFT, x1, y_row8 + 6, 40, 20, hwnd, (HMENU)(INT_PTR)-1, hInst, NULL);
+        comboEncRate = CreateWindow(L"COMBOBOX", L"", WS_VISIBLE | WS_CHILD | WS_VSCROLL | CBS_DROPDOWNLIST,
+            x1 + 40, y_row8 + 2, btnWidth - 40, 200, hwnd, (HMENU)(INT_PTR)IDC_COMBO_ENC_RATE, hInst, NULL);
+        for (const wchar_t* item : { L"Keep source rate", L"48000 Hz", L"44100 Hz", L"32000 Hz", L"22050 Hz", L"16000 Hz" })
+            SendMessage(comboEncRate, CB_ADDSTRING, 0, (LPARAM)item);
+        SendMessage(comboEncRate, CB_SETCURSEL, 0, 0);
+        CreateWindow(L"STATIC", L"Quality:", WS_VISIBLE | WS_CHILD | SS_LEFT, x2, y_row8 + 6, 55, 20, hwnd, (HMENU)(INT_PTR)-1, hInst, NULL);
+        comboEncQuality = CreateWindow(L"COMBOBOX", L"", WS_VISIBLE | WS_CHILD | WS_VSCROLL | CBS_DROPDOWNLIST,
+            x2 + 55, y_row8 + 2, btnWidth - 55, 200, hwnd, (HMENU)(INT_PTR)IDC_COMBO_ENC_QUALITY, hInst, NULL);
+        for (const wchar_t* item : { L"Fast", L"Balanced", L"Best" })
+            SendMessage(comboEncQuality, CB_ADDSTRING, 0, (LPARAM)item);
+        SendMessage(comboEncQuality, CB_SETCURSEL, 1, 0);
+
+        CreateWindow(L"STATIC", L"Corpus report (headers of DSP, DS2, DSH, D2H, SPT, XBB)", WS_VISIBLE | WS_CHILD | SS_LEFT, x1, y_row8 + btnHeight + 15, btnWidth * 2 + 15, 20, hwnd, (HMENU)(INT_PTR)-1, hInst, NULL);
+        btnScanCorpus = CreateWindow(L"BUTTON", L"Scan Folder → JSON + CSV", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+            x1, y_row9, btnWidth, btnHeight, hwnd, (HMENU)(INT_PTR)IDC_BTN_SCAN_CORPUS, hInst, NULL);
+
         stat = CreateWindow(L"STATIC", L"Ready", WS_VISIBLE | WS_CHILD | SS_LEFTNOWORDWRAP,
             10, y_status, btnWidth * 2 + 15, 40, hwnd, (HMENU)(INT_PTR)IDC_STATUS, hInst, NULL);
         break;
 
     case WM_COMMAND:
+        // Encode settings
+        if (HIWORD(wp) == CBN_SELCHANGE) {
+            if (LOWORD(wp) == IDC_COMBO_ENC_RATE) {
+                LRESULT sel = SendMessage(comboEncRate, CB_GETCURSEL, 0, 0);
+                if (sel >= 0 && sel < (LRESULT)(sizeof(kEncodeRates) / sizeof(kEncodeRates[0]))) g_encodeRate = kEncodeRates[sel];
+            }
+            else if (LOWORD(wp) == IDC_COMBO_ENC_QUALITY) {
+                LRESULT sel = SendMessage(comboEncQuality, CB_GETCURSEL, 0, 0);
+                if (sel >= 0) g_resampleQuality = static_cast<ResampleQuality>(sel);
+            }
+        }
         // Single file operations
-        if (LOWORD(wp) == IDC_BTN_DEC_DS2_SINGLE) {
+        else if (LOWORD(wp) == IDC_BTN_DEC_DS2_SINGLE) {
             String in = OpenFileDialog(L"Stereo DS2 Files\0*.ds2\0All Files\0*.*\0");
             if (!in.empty()) {
                 String out = in.substr(0, in.find_last_of(L".")) + L".wav"; SetWindowText(stat, L"DS2→WAV: Decoding...");
@@ -663,7 +769,6 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
             String in = OpenFileDialog(L"Mono DSP Files\0*.dsp\0All Files\0*.*\0");
             if (!in.empty()) {
                 String out = in.substr(0, in.find_last_of(L".")) + L".wav"; SetWindowText(stat, L"DSP→WAV: Decoding...");
-                // MODIFIED: Pass 'hwnd' to the function
                 if (DecodeMonoDspToWav(in, out, hwnd)) {
                     SetWindowText(stat, (L"DSP→WAV Done: " + GetFileName(out)).c_str());
                 }
@@ -685,10 +790,11 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
             if (!folderPath.empty()) {
                 SetWindowText(stat, L"DS2→WAV Batch: Scanning..."); UpdateWindow(hwnd);
                 int successCount = 0, failCount = 0, processedCount = 0;
+                RunMetrics metrics("DS2Tool", "ds2_to_wav");
                 RecursiveBatchProcess(folderPath, L"DS2→WAV", L"converted_stereo_wav", L"ds2", L".wav",
-                    (void*)DecodeDS2toWav, false, stat, hwnd, processedCount, successCount, failCount);
+                    (void*)DecodeDS2toWav, false, stat, hwnd, processedCount, successCount, failCount, metrics);
                 std::wstringstream summary;
-                summary << L"DS2→WAV Batch Done. Processed: " << processedCount << L", OK: " << successCount << L", Failed: " << failCount;
+                summary << L"DS2→WAV Batch Done. Processed: " << processedCount << L", OK: " << successCount << L", Failed: " << failCount << BatchMemoryNote() << BatchMetricsNote(metrics, folderPath);
                 SetWindowText(stat, summary.str().c_str());
             }
             else { SetWindowText(stat, L"DS2→WAV Batch: Cancelled."); }
@@ -698,10 +804,11 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
             if (!folderPath.empty()) {
                 SetWindowText(stat, L"WAV→DS2 Batch: Scanning..."); UpdateWindow(hwnd);
                 int successCount = 0, failCount = 0, processedCount = 0;
+                RunMetrics metrics("DS2Tool", "wav_to_ds2");
                 RecursiveBatchProcess(folderPath, L"WAV→DS2", L"converted_stereo_ds2", L"wav", L".ds2",
-                    (void*)EncodeWavToDS2, false, stat, hwnd, processedCount, successCount, failCount);
+                    (void*)EncodeWavToDS2, false, stat, hwnd, processedCount, successCount, failCount, metrics);
                 std::wstringstream summary;
-                summary << L"WAV→DS2 Batch Done. Processed: " << processedCount << L", OK: " << successCount << L", Failed: " << failCount;
+                summary << L"WAV→DS2 Batch Done. Processed: " << processedCount << L", OK: " << successCount << L", Failed: " << failCount << BatchMemoryNote() << BatchMetricsNote(metrics, folderPath);
                 SetWindowText(stat, summary.str().c_str());
             }
             else { SetWindowText(stat, L"WAV→DS2 Batch: Cancelled."); }
@@ -711,11 +818,11 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
             if (!folderPath.empty()) {
                 SetWindowText(stat, L"DSP→WAV Batch: Scanning..."); UpdateWindow(hwnd);
                 int successCount = 0, failCount = 0, processedCount = 0;
-                // MODIFIED: Pass the new function pointer and set the flag to true
+                RunMetrics metrics("DS2Tool", "dsp_to_wav");
                 RecursiveBatchProcess(folderPath, L"DSP→WAV", L"converted_mono_wav_from_dsp", L"dsp", L".wav",
-                    (void*)DecodeMonoDspToWav, true, stat, hwnd, processedCount, successCount, failCount);
+                    (void*)DecodeMonoDspToWav, true, stat, hwnd, processedCount, successCount, failCount, metrics);
                 std::wstringstream summary;
-                summary << L"DSP→WAV Batch Done. Processed: " << processedCount << L", OK: " << successCount << L", Failed: " << failCount;
+                summary << L"DSP→WAV Batch Done. Processed: " << processedCount << L", OK: " << successCount << L", Failed: " << failCount << BatchMemoryNote() << BatchMetricsNote(metrics, folderPath);
                 SetWindowText(stat, summary.str().c_str());
             }
             else { SetWindowText(stat, L"DSP→WAV Batch: Cancelled."); }
@@ -725,14 +832,71 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
             if (!folderPath.empty()) {
                 SetWindowText(stat, L"WAV→DSP Batch: Scanning..."); UpdateWindow(hwnd);
                 int successCount = 0, failCount = 0, processedCount = 0;
+                RunMetrics metrics("DS2Tool", "wav_to_dsp");
                 RecursiveBatchProcess(folderPath, L"WAV→DSP", L"converted_mono_dsp", L"wav", L".dsp",
-                    (void*)EncodeWavToMonoDsp, false, stat, hwnd, processedCount, successCount, failCount);
+                    (void*)EncodeWavToMonoDsp, false, stat, hwnd, processedCount, successCount, failCount, metrics);
                 std::wstringstream summary;
-                summary << L"WAV→DSP Batch Done. Processed: " << processedCount << L", OK: " << successCount << L", Failed: " << failCount;
+                summary << L"WAV→DSP Batch Done. Processed: " << processedCount << L", OK: " << successCount << L", Failed: " << failCount << BatchMemoryNote() << BatchMetricsNote(metrics, folderPath);
                 SetWindowText(stat, summary.str().c_str());
             }
             else { SetWindowText(stat, L"WAV→DSP Batch: Cancelled."); }
         }
+        // Remux operations
+        else if (LOWORD(wp) == IDC_BTN_SPLIT_DS2) {
+            String in = OpenFileDialog(L"Stereo DS2 Files\0*.ds2\0All Files\0*.*\0");
+            if (!in.empty()) {
+                SetWindowText(stat, L"DS2→DSP L/R: Remuxing...");
+                if (SplitDs2ToDspPair(in, in)) SetWindowText(stat, (L"DS2→DSP L/R Done: " + GetFileName(PairedDspPath(in, L'L')) + L" / _R").c_str());
+                else SetWindowText(stat, L"DS2→DSP L/R: Failed.");
+            }
+        }
+        else if (LOWORD(wp) == IDC_BTN_JOIN_DSP) {
+            String in = OpenFileDialog(L"Left Channel DSP (*_L.dsp)\0*_L.dsp\0All Files\0*.*\0");
+            if (!in.empty()) {
+                String out = in.substr(0, in.find_last_of(L".") - 2) + L".ds2"; SetWindowText(stat, L"DSP L/R→DS2: Remuxing...");
+                if (JoinDspPairToDs2(in, out)) SetWindowText(stat, (L"DSP L/R→DS2 Done: " + GetFileName(out)).c_str());
+                else SetWindowText(stat, L"DSP L/R→DS2: Failed (needs matching _L/_R pair).");
+            }
+        }
+        // Edit operations
+        else if (LOWORD(wp) == IDC_BTN_TRIM_DSP) {
+            String in = OpenFileDialog(L"Mono DSP Files\0*.dsp\0All Files\0*.*\0");
+            if (!in.empty()) {
+                wchar_t fromText[32] = L"", toText[32] = L"";
+                GetWindowTextW(editTrimFrom, fromText, 32); GetWindowTextW(editTrimTo, toText, 32);
+                String out = in.substr(0, in.find_last_of(L".")) + L"_trim.dsp"; SetWindowText(stat, L"Trim DSP: Working...");
+                if (TrimMonoDsp(in, out, _wtof(fromText), _wtof(toText))) SetWindowText(stat, (L"Trim DSP Done: " + GetFileName(out)).c_str());
+                else SetWindowText(stat, L"Trim DSP: Failed (check the From/To range).");
+            }
+        }
+        else if (LOWORD(wp) == IDC_BTN_APPEND_DSP) {
+            String first = OpenFileDialog(L"First Mono DSP (A)\0*.dsp\0All Files\0*.*\0");
+            String second = first.empty() ? L"" : OpenFileDialog(L"Second Mono DSP (B)\0*.dsp\0All Files\0*.*\0");
+            if (!second.empty()) {
+                String out = first.substr(0, first.find_last_of(L".")) + L"_joined.dsp"; SetWindowText(stat, L"Join DSP: Working...");
+                String note;
+                if (AppendMonoDsp(first, second, out, note)) SetWindowText(stat, (L"Join DSP Done: " + GetFileName(out) + note).c_str());
+                else SetWindowText(stat, L"Join DSP: Failed (sample rates must match).");
+            }
+        }
+        // Corpus report
+        else if (LOWORD(wp) == IDC_BTN_SCAN_CORPUS) {
+            String folderPath = SelectFolderDialog(hwnd, L"Select Root Folder (Recursive header scan)");
+            if (!folderPath.empty()) {
+                SetWindowText(stat, L"Corpus scan: Reading headers..."); UpdateWindow(hwnd);
+                RunMetrics metrics("DS2Tool", "corpus_scan");
+                CorpusReport report = ScanCorpus(folderPath, 0, &metrics);
+                CorpusSummary s = SummarizeCorpus(report);
+                String base = folderPath + L"\\corpus_scan";
+                bool written = WriteCorpusJson(report, base + L".json") && WriteCorpusCsv(report, base + L".csv");
+                std::wstringstream summary;
+                summary << L"Corpus scan: " << s.files << L" files, " << s.streams << L" sounds (" << s.looped << L" looped), "
+                    << s.failed << L" unreadable, " << static_cast<int>(report.walk_ms + report.scan_ms) << L" ms"
+                    << (written ? L" → corpus_scan.json/.csv" : L" (report could not be written)") << BatchMetricsNote(metrics, folderPath);
+                SetWindowText(stat, summary.str().c_str());
+            }
+            else { SetWindowText(stat, L"Corpus scan: Cancelled."); }
+        }
         break;
     case WM_DESTROY:
         PostQuitMessage(0);
@@ -743,8 +907,8 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
     return 0;
 }
 
-// wWinMain (unchanged)
 int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int cmdShow) {
+    TraceSession trace;
     CoInitializeEx(NULL, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
     hInst = hInstance;
     WNDCLASSEX wc = { sizeof(WNDCLASSEX), CS_HREDRAW | CS_VREDRAW, WndProc, 0, 0,
@@ -753,7 +917,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int cmdShow) {
     RegisterClassEx(&wc);
 
     int windowWidth = 445;
-    int windowHeight = 310;
+    int windowHeight = 640;
 
     HWND hwnd = CreateWindow(L"DS2DSPConvClass", L"DS2 (Stereo) & DSP (Mono) Converter v2.2",
         WS_OVERLAPPEDWINDOW & ~(WS_THICKFRAME | WS_MAXIMIZEBOX),
@@ -771,7 +935,6 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int cmdShow) {
     return 0;
 }
 
-// OpenFileDialog (unchanged)
 String OpenFileDialog(const wchar_t* filter) {
     OPENFILENAMEW ofn{};
     wchar_t buf[MAX_PATH]{};
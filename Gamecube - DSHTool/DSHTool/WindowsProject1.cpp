@@ -5,25 +5,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <vector>
+#include <string>
 #include <commctrl.h>   // For ListView
-#pragma comment(lib, "Comctl32.lib") // Link Comctl32.lib
 
-// big-endian helpers
-static inline unsigned int get32be(const unsigned char* p) {
-    return (unsigned int)p[0] << 24 | (unsigned int)p[1] << 16 |
-        (unsigned int)p[2] << 8 | (unsigned int)p[3];
-}
-static inline void put32be(unsigned char* p, unsigned int v) {
-    p[0] = (v >> 24) & 0xFF;
-    p[1] = (v >> 16) & 0xFF;
-    p[2] = (v >> 8) & 0xFF;
-    p[3] = v & 0xFF;
-}
+#include "../../Common/AsyncIo.h"
+#include "../../Common/BeLayout.h"
+#include "../../Common/RunMetrics.h"
+#include "../../Common/Trace.h"
+#pragma comment(lib, "Comctl32.lib") // Link Comctl32.lib
 
 #define FILE_HEADER_SIZE 0x20    // 32-byte file header (count + padding)
 #define NAME_REGION_SIZE 0x100   // 256-byte filename+padding per entry
 #define DSP_HEADER_SIZE  0x60    // 96-byte DSP metadata per entry
 #define ENTRY_SIZE       (NAME_REGION_SIZE + DSP_HEADER_SIZE) // 0x160 (352 bytes)
+static_assert(ENTRY_SIZE == sizeof(DshEntry) && FILE_HEADER_SIZE == DSH_FILE_HEADER_BYTES, "DSH layout (Common/BeLayout.h)");
 
 // --- Global variables for ListView and DSP file list ---
 HWND g_hListView;
@@ -75,9 +71,11 @@ void ExtractDsh(HWND hwnd) {
         return;
     }
 
-    unsigned char buf4[4];
-    fread(buf4, 1, 4, dsh);
-    unsigned int count = get32be(buf4);
+    unsigned char headBuf[FILE_HEADER_SIZE] = { 0 };
+    fread(headBuf, 1, FILE_HEADER_SIZE, dsh);
+    DshFileHeader head;
+    BeLoad(headBuf, head);
+    unsigned int count = head.count;
     fwprintf(txt, L"Entry Count: %u\n\n", count);
 
     fseek(dsh, FILE_HEADER_SIZE, SEEK_SET);
@@ -107,15 +105,11 @@ void ExtractDsh(HWND hwnd) {
 
         fwprintf(txt, L"%3u: %s", i + 1, name16);
 
-        unsigned char* dh = entry + NAME_REGION_SIZE;
-        unsigned int samples = get32be(dh);
-        unsigned int nibbleCnt = get32be(dh + 4);
-        unsigned int rate = get32be(dh + 8);
-        unsigned short loopFlg = (unsigned short)((dh[12] << 8) | dh[13]);
-        unsigned int loopStart = get32be(dh + 16);
-        unsigned int loopEnd = get32be(dh + 20);
+        DshEntry e;
+        BeLoad(entry, e);
+        const DspHeader& dh = e.header;
         fwprintf(txt, L"  samples=%u nibble=%u rate=%u loop=%u start=%u end=%u\n",
-            samples, nibbleCnt, rate, loopFlg, loopStart, loopEnd);
+            dh.num_samples, dh.num_nibbles, dh.sample_rate, (unsigned int)dh.loop_flag, dh.loop_start, dh.loop_end);
     }
     free(entry);
     fclose(txt);
@@ -186,9 +180,11 @@ void RepackDshFromList(HWND hwnd) {
         return;
     }
 
-    unsigned char buf4[4]; put32be(buf4, (unsigned int)g_dspFileCount);
-    fwrite(buf4, 1, 4, f);
-    for (int i = 4; i < FILE_HEADER_SIZE; i++) fputc(0, f);
+    DshFileHeader head = {};
+    head.count = (unsigned int)g_dspFileCount;
+    unsigned char headBuf[FILE_HEADER_SIZE];
+    BeStore(head, headBuf);
+    fwrite(headBuf, 1, FILE_HEADER_SIZE, f);
 
     unsigned char* entry = (unsigned char*)malloc(ENTRY_SIZE);
     if (!entry) {
@@ -197,8 +193,22 @@ void RepackDshFromList(HWND hwnd) {
         return;
     }
 
+    // All DSP headers are read in one batch up front instead of an open/seek/read per file.
+    RunMetrics metrics("DSHTool", "repack");
+    std::vector<IoRead> headers(g_dspFileCount);
+    for (int i = 0; i < g_dspFileCount; i++) {
+        headers[i].path = g_dspFilePaths[i];
+        headers[i].length = DSP_HEADER_SIZE;
+    }
+    AsyncIo io;
+    {
+        RunStageTimer readTime(metrics, RunStage::Read);
+        io.read(headers, IoHint::Random);
+    }
+
     BOOL all_successful = TRUE;
     for (int i = 0; i < g_dspFileCount; i++) {
+        RunFile file(metrics);
         memset(entry, 0, ENTRY_SIZE);
 
         wchar_t dspFilenameOnly[MAX_PATH];
@@ -237,9 +247,9 @@ void RepackDshFromList(HWND hwnd) {
             MessageBoxW(hwnd, errorMsg, L"Warning", MB_OK);
         }
 
-        FILE* dsp = nullptr;
-        errno_t err = _wfopen_s(&dsp, g_dspFilePaths[i], L"rb");
-        if (err != 0 || dsp == nullptr) {
+        const IoRead& dsp = headers[i];
+        if (!dsp.ok()) {
+            file.fail(RunError::Open);
             all_successful = FALSE; // Mark as not fully successful
             wchar_t errorMsg[MAX_PATH + 100];
             swprintf(errorMsg, sizeof(errorMsg) / sizeof(wchar_t),
@@ -247,11 +257,11 @@ void RepackDshFromList(HWND hwnd) {
                 g_dspFilePaths[i]);
             MessageBoxW(hwnd, errorMsg, L"Warning", MB_OK);
         } else {
-            fseek(dsp, 0, SEEK_END);
-            long dsp_size = ftell(dsp);
-            fseek(dsp, 0, SEEK_SET);
+            long dsp_size = (long)dsp.file_size;
+            file.bytes_in(dsp.data.size());
 
             if (dsp_size < DSP_HEADER_SIZE) {
+                file.fail(RunError::Format);
                 all_successful = FALSE; // Mark as not fully successful
                 wchar_t errorMsg[MAX_PATH + 200];
                 swprintf(errorMsg, sizeof(errorMsg) / sizeof(wchar_t),
@@ -259,20 +269,26 @@ void RepackDshFromList(HWND hwnd) {
                     g_dspFilePaths[i], dsp_size, DSP_HEADER_SIZE);
                 MessageBoxW(hwnd, errorMsg, L"Warning", MB_OK);
             } else {
-                fread(entry + NAME_REGION_SIZE, 1, DSP_HEADER_SIZE, dsp);
+                memcpy(entry + NAME_REGION_SIZE, dsp.data.data(), DSP_HEADER_SIZE);
             }
-            fclose(dsp);
         }
-        fwrite(entry, 1, ENTRY_SIZE, f);
+        RunStageTimer writeTime(RunStage::Write);
+        if (fwrite(entry, 1, ENTRY_SIZE, f) == ENTRY_SIZE) file.bytes_out(ENTRY_SIZE);
+        else file.fail(RunError::Write);
     }
     free(entry);
     fclose(f);
 
+    // Metrics go next to the .dsh as run_metrics_repack.json
+    metrics.finish();
+    const std::filesystem::path metricsPath = metrics.json_path(std::filesystem::path(outPath).parent_path());
+    const std::wstring metricsName = metricsPath.filename().wstring();
+    const std::wstring metricsNote = metrics.write_json(metricsPath) ? L"\nMetrics: " + metricsName : L"\n(" + metricsName + L" could not be written)";
     if (all_successful) {
-        MessageBoxW(hwnd, L"Repacked DSH complete from list.", L"Done", MB_OK);
+        MessageBoxW(hwnd, (L"Repacked DSH complete from list." + metricsNote).c_str(), L"Done", MB_OK);
     }
     else {
-        MessageBoxW(hwnd, L"Repacked DSH complete from list, but some warnings occurred (see previous messages).", L"Done with Warnings", MB_ICONWARNING | MB_OK);
+        MessageBoxW(hwnd, (L"Repacked DSH complete from list, but some warnings occurred (see previous messages)." + metricsNote).c_str(), L"Done with Warnings", MB_ICONWARNING | MB_OK);
     }
 
     // Clear the list after repacking
@@ -320,6 +336,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 }
 
 int WINAPI WinMain(HINSTANCE hInst, HINSTANCE, LPSTR, int nCmdShow) {
+    TraceSession trace;
     INITCOMMONCONTROLSEX icex;
     icex.dwSize = sizeof(INITCOMMONCONTROLSEX);
     icex.dwICC = ICC_LISTVIEW_CLASSES;
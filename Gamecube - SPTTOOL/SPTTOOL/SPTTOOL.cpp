@@ -6,29 +6,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <vector>
 
-#define DSP_HEADER_SIZE 0x60
-#define ALIGN_8(x) (((x) + 7) & ~7)
-
-unsigned int get32be(unsigned char* p) {
-    return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
-}
-
-unsigned short get16be(unsigned char* p) {
-    return (p[0] << 8) | p[1];
-}
-
-void put32be(unsigned char* p, unsigned int val) {
-    p[0] = (val >> 24) & 0xFF;
-    p[1] = (val >> 16) & 0xFF;
-    p[2] = (val >> 8) & 0xFF;
-    p[3] = val & 0xFF;
-}
-
-void put16be(unsigned char* p, unsigned short val) {
-    p[0] = (val >> 8) & 0xFF;
-    p[1] = val & 0xFF;
-}
+#include "../../Common/DspContainer.h"
+#include "../../Common/MappedFile.h"
+#include "../../Common/RunMetrics.h"
+#include "../../Common/SoundArchive.h"
+#include "../../Common/Trace.h"
 
 BOOL BrowseForFolder(HWND hwnd, wchar_t* outPath, const wchar_t* title) {
     BROWSEINFOW bi = { 0 };
@@ -66,71 +51,21 @@ void ExtractSptSpd(HWND hwnd) {
 
     if (!BrowseForFolder(hwnd, outDir, L"Select Output Folder for DSPs")) return;
 
-    FILE* spt = nullptr;
-    errno_t err = _wfopen_s(&spt, sptPath, L"rb");
-    if (err != 0 || !spt) {
-        MessageBoxW(hwnd, L"Failed to open SPT file.", L"Error", MB_OK);
+    // Streams are remuxed, not decoded: each DSP is a rebuilt header plus the SPD bytes as-is.
+    SoundArchive bank;
+    if (!bank.open(sptPath, spdPath)) {
+        MessageBoxW(hwnd, L"Failed to open SPT or SPD file.", L"Error", MB_OK);
         return;
     }
-
-    FILE* spd = nullptr;
-    errno_t spdErr = _wfopen_s(&spd, spdPath, L"rb");
-    if (spdErr != 0 || !spd) {
-        MessageBoxW(hwnd, L"Failed to open SPD file.", L"Error", MB_OK);
-        fclose(spt);
+    if (!bank.valid()) {
+        MessageBoxW(hwnd, L"SPT entries do not match the SPD file.", L"Error", MB_OK);
         return;
     }
 
-    unsigned char buf[4];
-    fread(buf, 1, 4, spt);
-    int filecount = get32be(buf);
-
-    int part1idx = 4;
-    int part2idx = part1idx + filecount * 0x1C;
-    int dataoff = 0;
-
-    for (int i = 0; i < filecount; i++) {
-        unsigned char buf1[0x1C], buf2[0x2E];
-
-        fseek(spt, part1idx, SEEK_SET);
-        fread(buf1, 1, 0x1C, spt);
-        fseek(spt, part2idx, SEEK_SET);
-        fread(buf2, 1, 0x2E, spt);
-
-        int nextdataoff = get32be(buf1 + 0x10) / 2 + 1;
-        wchar_t fname[MAX_PATH];
-        swprintf(fname, MAX_PATH, L"%s\\%03d.dsp", outDir, i);
-        FILE* out = nullptr;
-        errno_t err = _wfopen_s(&out, fname, L"wb");
-        if (err != 0 || !out) {
-            // Handle error if file cannot be opened
-            continue;
-        }
-
-        int size = (nextdataoff - dataoff);
-        int samples = size * 7 / 4;
-
-        put32be(buf, samples); fwrite(buf, 1, 4, out);
-        put32be(buf, size * 2); fwrite(buf, 1, 4, out);
-        fwrite(buf1 + 4, 1, 4, out);
-        put16be(buf, get32be(buf1) & 1); fwrite(buf, 1, 2, out);
-        put16be(buf, 0); fwrite(buf, 1, 2, out);
-        put32be(buf, get32be(buf1 + 8) - dataoff * 2); fwrite(buf, 1, 4, out);
-        put32be(buf, get32be(buf1 + 12) - dataoff * 2); fwrite(buf, 1, 4, out);
-        put32be(buf, 2); fwrite(buf, 1, 4, out);
-        fwrite(buf2, 1, 0x2E, out);
-
-        fseek(out, 0x60, SEEK_SET);
-        fseek(spd, dataoff, SEEK_SET);
-        for (int j = 0; j < size; j++) fputc(fgetc(spd), out);
-        fclose(out);
-
-        dataoff = ((nextdataoff + 7) / 8) * 8;
-        part1idx += 0x1C;
-        part2idx += 0x2E;
+    ArchiveStream dsp;
+    for (size_t i = 0; i < bank.size(); i++) {
+        if (bank.open_entry(i, dsp)) WriteArchiveStream(std::filesystem::path(outDir) / bank.entry_name(i), dsp);
     }
-    fclose(spt);
-    fclose(spd);
     MessageBoxW(hwnd, L"Extraction Complete!", L"Success", MB_OK);
 }
 
@@ -160,88 +95,40 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                 size_t len = wcslen(outputSPD);
                 if (len > 4) wcscpy_s(&outputSPD[len - 4], MAX_PATH - (len - 4), L".spd");
 
-                FILE* out_spt = nullptr;
-                errno_t sptErr = _wfopen_s(&out_spt, outputSPT, L"wb");
-                if (sptErr != 0 || !out_spt) {
-                    MessageBoxW(hwnd, L"Failed to create output SPT file.", L"Error", MB_OK);
-                    return 0;
-                }
-
-                FILE* out_spd = nullptr;
-                errno_t spdErr = _wfopen_s(&out_spd, outputSPD, L"wb");
-                if (spdErr != 0 || !out_spd) {
-                    MessageBoxW(hwnd, L"Failed to create output SPD file.", L"Error", MB_OK);
-                    fclose(out_spt);
-                    return 0;
-                }
-
-                int filecount = 0;
+                // Every DSP is mapped and its ADPCM bytes go into the SPD unchanged.
+                RunMetrics metrics("SPTTOOL", "repack");
+                std::vector<MappedFile> dsps;
+                std::vector<DspStream> streams;
                 for (int i = 0;; i++) {
                     wchar_t dsp_path_w[MAX_PATH];
                     swprintf(dsp_path_w, MAX_PATH, L"%s\\%03d.dsp", folderPath, i);
                     if (GetFileAttributesW(dsp_path_w) == INVALID_FILE_ATTRIBUTES) break;
-                    filecount++;
-                }
-
-                unsigned char buf[4];
-                put32be(buf, filecount);
-                fwrite(buf, 1, 4, out_spt);
-
-                unsigned int data_offset = 0;
-                for (int i = 0; i < filecount; i++) {
-                    wchar_t dsp_path_w[MAX_PATH];
-                    char dsp_path[MAX_PATH];
-                    swprintf(dsp_path_w, MAX_PATH, L"%s\\%03d.dsp", folderPath, i);
-                    size_t convertedChars = 0;
-                    wcstombs_s(&convertedChars, dsp_path, MAX_PATH, dsp_path_w, MAX_PATH);
-
-                    FILE* dsp = nullptr;
-                    if (fopen_s(&dsp, dsp_path, "rb") != 0) {
-                        // Handle error if file cannot be opened
-                        dsp = nullptr;
-                    }
-                    if (!dsp) continue;
 
-                    unsigned char dsp_header[DSP_HEADER_SIZE];
-                    fread(dsp_header, 1, DSP_HEADER_SIZE, dsp);
-
-                    unsigned int sample_rate = get32be(dsp_header + 8);
-                    unsigned int loop_flag = get16be(dsp_header + 0x0C);
-                    unsigned int loop_start = get32be(dsp_header + 0x10);
-                    unsigned int loop_end = get32be(dsp_header + 0x14);
-                    unsigned int nibble_count = get32be(dsp_header + 4);
-                    unsigned int data_size = nibble_count / 2;
-                    unsigned int next_data_offset = data_offset + data_size;
-
-                    unsigned char part1[0x1C] = { 0 };
-                    put32be(part1, loop_flag ? 1 : 0);
-                    put32be(part1 + 4, sample_rate);
-                    put32be(part1 + 8, loop_start * 2 + data_offset * 2);
-                    put32be(part1 + 12, loop_end * 2 + data_offset * 2);
-                    put32be(part1 + 0x10, next_data_offset * 2);
-                    fwrite(part1, 1, 0x1C, out_spt);
-
-                    unsigned char part2[0x2E] = { 0 };
-                    memcpy(part2, dsp_header + 0x1C, 0x2E);
-                    fwrite(part2, 1, 0x2E, out_spt);
-
-                    fseek(dsp, DSP_HEADER_SIZE, SEEK_SET);
-                    unsigned char* adpcm_data = (unsigned char*)malloc(data_size);
-                    fread(adpcm_data, 1, data_size, dsp);
-                    fwrite(adpcm_data, 1, data_size, out_spd);
-
-                    int padding = ALIGN_8(data_size) - data_size;
-                    for (int j = 0; j < padding; j++) fputc(0, out_spd);
-
-                    free(adpcm_data);
-                    fclose(dsp);
-
-                    data_offset = ALIGN_8(next_data_offset);
+                    RunFile file(metrics);
+                    MappedFile dsp(dsp_path_w);
+                    if (!dsp.is_open()) { file.fail(RunError::Open); continue; }
+                    file.bytes_in(dsp.size());
+                    DspStream stream;
+                    bool parsed;
+                    { RunStageTimer parseTime(RunStage::Parse); parsed = ParseDsp(dsp.data(), dsp.size(), stream); }
+                    if (!parsed) { file.fail(RunError::Format); continue; }
+                    file.samples(stream.samples());
+                    file.bytes_out(stream.size);
+                    streams.push_back(stream);
+                    dsps.push_back(std::move(dsp));
                 }
 
-                fclose(out_spt);
-                fclose(out_spd);
-                MessageBoxW(hwnd, L"Repack Complete!", L"Success", MB_OK);
+                bool written;
+                { RunStageTimer writeTime(metrics, RunStage::Write); written = WriteSptSpd(outputSPT, outputSPD, streams); }
+                metrics.finish();
+                const std::filesystem::path metricsPath = metrics.json_path(std::filesystem::path(outputSPT).parent_path());
+                const std::wstring metricsName = metricsPath.filename().wstring();
+                const std::wstring metricsNote = metrics.write_json(metricsPath) ? L"\nMetrics: " + metricsName : L"\n(" + metricsName + L" could not be written)";
+                if (!written) {
+                    MessageBoxW(hwnd, (L"Failed to write the SPT/SPD files." + metricsNote).c_str(), L"Error", MB_OK);
+                    return 0;
+                }
+                MessageBoxW(hwnd, (L"Repack Complete!" + metricsNote).c_str(), L"Success", MB_OK);
             }
         }
         else if (LOWORD(wParam) == 2) {
@@ -257,6 +144,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 }
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+    TraceSession trace;
     const wchar_t CLASS_NAME[] = L"SptexRepackWindow";
 
     WNDCLASSW wc = { 0 };
@@ -0,0 +1,166 @@
+// BeLayoutTest.cpp
+// BeLoad / BeStore against the per-field big-endian accessors the tools used before
+// (read_u32_be / write_u16_be at hand-written offsets, kept here only as a reference).
+// On random bytes, every member of DspHeader, SptPart1, SptPart2, DshEntry, D2hEntry and
+// the SPT and DSH/D2H file headers must equal the per-field read, and BeStore must give
+// the original bytes back; a header filled through the old setters must store to the same
+// bytes as the struct. Then both ways of loading a DSP header are timed.
+//   BeLayoutTest [headers for the timing run, default 200000]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "../Common/BeLayout.h"
+#include "Check.h"
+
+namespace {
+namespace legacy {
+inline uint16_t read_u16_be(const uint8_t* buf) { return (uint16_t)((buf[0] << 8) | buf[1]); }
+inline int16_t read_s16_be(const uint8_t* buf) { return (int16_t)((buf[0] << 8) | buf[1]); }
+inline uint32_t read_u32_be(const uint8_t* buf) { return (uint32_t)((buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | buf[3]); }
+inline void write_u16_be(uint8_t* buf, uint16_t val) { buf[0] = static_cast<uint8_t>((val >> 8) & 0xFF); buf[1] = static_cast<uint8_t>(val & 0xFF); }
+inline void write_s16_be(uint8_t* buf, int16_t val) { write_u16_be(buf, static_cast<uint16_t>(val)); }
+inline void write_u32_be(uint8_t* buf, uint32_t val) { buf[0] = static_cast<uint8_t>((val >> 24) & 0xFF); buf[1] = static_cast<uint8_t>((val >> 16) & 0xFF); buf[2] = static_cast<uint8_t>((val >> 8) & 0xFF); buf[3] = static_cast<uint8_t>(val & 0xFF); }
+
+// Every field of a 0x60-byte DSP header, one accessor call each.
+void LoadDsp(const uint8_t* raw, DspHeader& h) {
+    h.num_samples = read_u32_be(raw + 0x00);
+    h.num_nibbles = read_u32_be(raw + 0x04);
+    h.sample_rate = read_u32_be(raw + 0x08);
+    h.loop_flag = read_u16_be(raw + 0x0C);
+    h.format = read_u16_be(raw + 0x0E);
+    h.loop_start = read_u32_be(raw + 0x10);
+    h.loop_end = read_u32_be(raw + 0x14);
+    h.current_address = read_u32_be(raw + 0x18);
+    for (int i = 0; i < 16; ++i) h.coefs[i] = read_s16_be(raw + 0x1C + i * 2);
+    h.gain = read_u16_be(raw + 0x3C);
+    h.initial_ps = read_u16_be(raw + 0x3E);
+    h.initial_hist1 = read_s16_be(raw + 0x40);
+    h.initial_hist2 = read_s16_be(raw + 0x42);
+    h.loop_ps = read_u16_be(raw + 0x44);
+    h.loop_hist1 = read_s16_be(raw + 0x46);
+    h.loop_hist2 = read_s16_be(raw + 0x48);
+    for (int i = 0; i < 7; ++i) h.reserved[i] = read_u16_be(raw + 0x4A + i * 2);
+    h.data_size = read_u32_be(raw + 0x58);
+    h.data_offset = read_u32_be(raw + 0x5C);
+}
+
+// The encoder's setter sequence for a fresh header.
+void StoreEncoded(uint8_t* raw, uint32_t samples, uint32_t rate, const int16_t coefs[16], uint16_t ps, uint32_t bytes, uint32_t offset) {
+    memset(raw, 0, 0x60);
+    write_u32_be(raw + 0x00, samples);
+    write_u32_be(raw + 0x04, ((samples + 13) / 14) * 16);
+    write_u32_be(raw + 0x08, rate);
+    write_u32_be(raw + 0x14, samples);
+    for (int i = 0; i < 16; ++i) write_s16_be(raw + 0x1C + i * 2, coefs[i]);
+    write_u16_be(raw + 0x3E, ps);
+    write_u16_be(raw + 0x4A, 0x5E3D);
+    write_u32_be(raw + 0x58, bytes);
+    write_u32_be(raw + 0x5C, offset);
+}
+} // namespace legacy
+
+bool SameDsp(const DspHeader& a, const DspHeader& b) { return memcmp(&a, &b, sizeof(DspHeader)) == 0; }
+
+template <class T>
+bool StoresBack(const T& h, const uint8_t* raw) {
+    uint8_t back[sizeof(T)];
+    BeStore(h, back);
+    return memcmp(back, raw, sizeof(T)) == 0;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t headers = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 200000;
+    std::mt19937 rng(1);
+
+    for (int it = 0; it < 10000; ++it) {
+        uint8_t raw[sizeof(D2hEntry)];
+        for (uint8_t& b : raw) b = static_cast<uint8_t>(rng());
+
+        DspHeader h, ref;
+        BeLoad(raw, h);
+        legacy::LoadDsp(raw, ref);
+        CHECK(SameDsp(h, ref));
+        CHECK(StoresBack(h, raw));
+
+        SptPart1 p1;
+        BeLoad(raw, p1);
+        CHECK(p1.loop_flag == legacy::read_u32_be(raw) && p1.sample_rate == legacy::read_u32_be(raw + 4));
+        CHECK(p1.loop_start == legacy::read_u32_be(raw + 8) && p1.loop_end == legacy::read_u32_be(raw + 0xC));
+        CHECK(p1.end_address == legacy::read_u32_be(raw + 0x10) && p1.current_address == legacy::read_u32_be(raw + 0x14));
+        CHECK(p1.reserved == legacy::read_u32_be(raw + 0x18));
+        CHECK(StoresBack(p1, raw));
+
+        // Part2 is header bytes 0x1C..0x4A.
+        SptPart2 p2;
+        BeLoad(raw + 0x1C, p2);
+        CHECK(memcmp(p2.coefs, ref.coefs, sizeof(p2.coefs)) == 0);
+        CHECK(p2.gain == ref.gain && p2.initial_ps == ref.initial_ps);
+        CHECK(p2.initial_hist1 == ref.initial_hist1 && p2.initial_hist2 == ref.initial_hist2);
+        CHECK(p2.loop_ps == ref.loop_ps && p2.loop_hist1 == ref.loop_hist1 && p2.loop_hist2 == ref.loop_hist2);
+        CHECK(StoresBack(p2, raw + 0x1C));
+
+        DshEntry dsh;
+        BeLoad(raw, dsh);
+        legacy::LoadDsp(raw + DSH_NAME_BYTES, ref);
+        CHECK(memcmp(dsh.name, raw, DSH_NAME_BYTES) == 0 && SameDsp(dsh.header, ref));
+        CHECK(StoresBack(dsh, raw));
+
+        D2hEntry d2h;
+        BeLoad(raw, d2h);
+        DspHeader ref_right;
+        legacy::LoadDsp(raw + DSH_NAME_BYTES + 0x60, ref_right);
+        CHECK(memcmp(d2h.name, raw, DSH_NAME_BYTES) == 0 && SameDsp(d2h.left, ref) && SameDsp(d2h.right, ref_right));
+        CHECK(StoresBack(d2h, raw));
+
+        SptFileHeader spt;
+        BeLoad(raw, spt);
+        CHECK(spt.count == legacy::read_u32_be(raw) && StoresBack(spt, raw));
+        DshFileHeader bank;
+        BeLoad(raw, bank);
+        CHECK(bank.count == legacy::read_u32_be(raw) && memcmp(bank.reserved, raw + 4, sizeof(bank.reserved)) == 0);
+        CHECK(StoresBack(bank, raw));
+    }
+
+    const int16_t coefs[16] = { 2048, 0, 0, 0, 4096, -2048, 2048, -2048, 3072, -1024, 1024, 512, 512, 256, 2048, 1024 };
+    for (int it = 0; it < 1000; ++it) {
+        const uint32_t samples = rng(), rate = rng() % 96000, bytes = rng(), offset = rng();
+        const uint16_t ps = static_cast<uint16_t>(rng());
+        uint8_t old_raw[0x60], new_raw[0x60];
+        legacy::StoreEncoded(old_raw, samples, rate, coefs, ps, bytes, offset);
+        DspHeader h{};
+        h.num_samples = samples; h.num_nibbles = ((samples + 13) / 14) * 16;
+        h.sample_rate = rate; h.loop_end = samples;
+        memcpy(h.coefs, coefs, sizeof(coefs));
+        h.initial_ps = ps;
+        h.reserved[0] = 0x5E3D;
+        h.data_size = bytes; h.data_offset = offset;
+        BeStore(h, new_raw);
+        CHECK(memcmp(old_raw, new_raw, 0x60) == 0);
+    }
+
+    // Load time per header, best of three.
+    std::vector<uint8_t> buf(0x60 * headers);
+    for (uint8_t& b : buf) b = static_cast<uint8_t>(rng());
+    std::vector<DspHeader> out(headers);
+    double field_ns = 1e300, bulk_ns = 1e300;
+    for (int run = 0; run < 3; ++run) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < headers; ++i) legacy::LoadDsp(&buf[i * 0x60], out[i]);
+        auto t1 = std::chrono::steady_clock::now();
+        field_ns = (std::min)(field_ns, std::chrono::duration<double, std::nano>(t1 - t0).count() / headers);
+        const DspHeader last = out.back();
+        t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < headers; ++i) BeLoad(&buf[i * 0x60], out[i]);
+        t1 = std::chrono::steady_clock::now();
+        bulk_ns = (std::min)(bulk_ns, std::chrono::duration<double, std::nano>(t1 - t0).count() / headers);
+        CHECK(SameDsp(last, out.back()));
+    }
+    std::printf("DSP header load, %zu headers: per-field %.2f ns, BeLoad %.2f ns\n", headers, field_ns, bulk_ns);
+    return TestExit("BeLayoutTest");
+}
@@ -0,0 +1,135 @@
+// BufferPoolTest.cpp
+// Scratch<T> / the per-thread pools:
+//   - a returned buffer serves the next request of its size class or the one below it
+//     (same memory, contents value-initialised again), never a request 4x smaller;
+//   - a class keeps at most MAX_PER_CLASS buffers, the rest are freed and counted;
+//   - pools are per thread: a buffer returned on one thread is not handed out on another;
+//   - moves hand the vector over and leave the source empty;
+//   - every take is counted as either reused or allocated.
+// Then a batch-shaped loop (file buffer plus left/right/interleaved PCM per "file") is
+// timed with plain vectors and with Scratch.
+//   BufferPoolTest [files for the timing run, default 3000]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "../Common/BufferPool.h"
+#include "../Common/ProcessStats.h"
+#include "Check.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+double MsSince(Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); }
+
+volatile int g_sink;
+template <class V> void Touch(V& a) { for (size_t i = 0; i < a.size(); i += 512) a[i] = static_cast<int16_t>(i); g_sink = g_sink + a[0]; }
+
+BufferPoolStats Since(const BufferPoolStats& a) {
+    const BufferPoolStats b = GetBufferPoolStats();
+    return { b.takes - a.takes, b.reused - a.reused, b.allocated - a.allocated, b.released - a.released };
+}
+
+void CheckReuse() {
+    BufferPoolStats start = GetBufferPoolStats();
+    const int16_t* first;
+    {
+        Scratch<int16_t> a(1000);
+        for (size_t i = 0; i < a.size(); ++i) a[i] = 7;
+        first = a.data();
+    }
+    {
+        Scratch<int16_t> b(900);                    // same class: reused, zeroed
+        CHECK(b.data() == first && b.size() == 900);
+        bool zero = true;
+        for (size_t i = 0; i < b.size(); ++i) zero = zero && b[i] == 0;
+        CHECK(zero);
+    }
+    {
+        Scratch<int16_t> c(300);                    // one class down still fits
+        CHECK(c.data() == first);
+    }
+    {
+        Scratch<int16_t> d(100);                    // 4x smaller: a buffer of its own
+        CHECK(d.data() != first);
+    }
+    BufferPoolStats s = Since(start);
+    CHECK(s.takes == 4 && s.reused == 2 && s.allocated == 2 && s.released == 0);
+
+    // Six buffers of one class returned at once: the pool keeps MAX_PER_CLASS of them.
+    start = GetBufferPoolStats();
+    {
+        std::vector<Scratch<float>> held;
+        for (int i = 0; i < 6; ++i) held.emplace_back(5000);
+    }
+    s = Since(start);
+    CHECK(s.released == 6 - pool_detail::LocalPool<float>::MAX_PER_CLASS);
+    {
+        std::vector<Scratch<float>> again;
+        for (int i = 0; i < 6; ++i) again.emplace_back(5000);
+    }
+    s = Since(start);
+    CHECK(s.reused == pool_detail::LocalPool<float>::MAX_PER_CLASS);
+
+    Scratch<int16_t> none;
+    CHECK(none.empty());
+}
+
+void CheckPerThread() {
+    const uint8_t* mine;
+    {
+        Scratch<uint8_t> a(1 << 16);
+        mine = a.data();
+    }
+    const uint8_t* theirs = nullptr;
+    std::thread([&] { Scratch<uint8_t> b(1 << 16); theirs = b.data(); }).join();
+    CHECK(theirs != mine);
+    Scratch<uint8_t> c(1 << 16);
+    CHECK(c.data() == mine);
+}
+
+void CheckMoves() {
+    Scratch<int16_t> a(10);
+    a[3] = 5;
+    Scratch<int16_t> b(std::move(a));
+    CHECK(b.size() == 10 && b[3] == 5 && a.empty());
+    Scratch<int16_t> c(4);
+    c = std::move(b);
+    CHECK(c.size() == 10 && c[3] == 5);
+    (*c).push_back(1);
+    CHECK(c->size() == 11);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const int files = argc > 1 ? std::atoi(argv[1]) : 3000;
+    CheckReuse();
+    CheckPerThread();
+    CheckMoves();
+
+    const BufferPoolStats before = GetBufferPoolStats();
+    Clock::time_point t = Clock::now();
+    for (int i = 0; i < files; ++i) {
+        const size_t n = 200000 + (i * 7919) % 400000;
+        std::vector<uint8_t> file(n * 2 / 3);
+        std::vector<int16_t> l(n), r(n), inter(2 * n);
+        Touch(l); Touch(r); Touch(inter);
+    }
+    const double vector_ms = MsSince(t);
+    t = Clock::now();
+    for (int i = 0; i < files; ++i) {
+        const size_t n = 200000 + (i * 7919) % 400000;
+        Scratch<uint8_t> file(n * 2 / 3);
+        Scratch<int16_t> l(n), r(n), inter(2 * n);
+        Touch(*l); Touch(*r); Touch(*inter);
+    }
+    const double pool_ms = MsSince(t);
+    const BufferPoolStats s = Since(before);
+    CHECK(s.takes == static_cast<uint64_t>(files) * 4 && s.reused + s.allocated == s.takes);
+    std::printf("%d files: std::vector %.1f ms, Scratch %.1f ms (%llu of %llu buffers reused), peak RSS %llu MB\n",
+        files, vector_ms, pool_ms, static_cast<unsigned long long>(s.reused), static_cast<unsigned long long>(s.takes),
+        static_cast<unsigned long long>(PeakRssBytes() >> 20));
+    return TestExit("BufferPoolTest");
+}
@@ -0,0 +1,21 @@
+#pragma once
+// Check.h
+// Minimal assertions for the console tests. CHECK prints the failing expression and keeps
+// going so one run reports every failure; TestExit() turns the count into the exit code
+// ctest looks at.
+
+#include <cstdio>
+
+namespace check_detail {
+inline int& Failures() { static int n = 0; return n; }
+} // namespace check_detail
+
+#define CHECK(expr) \
+    do { if (!(expr)) { std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #expr); ++check_detail::Failures(); } } while (0)
+
+inline int TestExit(const char* name) {
+    const int n = check_detail::Failures();
+    if (n) std::printf("%s: %d check(s) failed\n", name, n);
+    else std::printf("%s: ok\n", name);
+    return n ? 1 : 0;
+}
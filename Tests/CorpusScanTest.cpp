@@ -0,0 +1,253 @@
+// CorpusScanTest.cpp
+// ScanCorpus on a generated tree holding one file of every kind it reads (DSP, DS2, DSH,
+// D2H, SPT/SPD, XBB with an inline PCM entry and a streamed Xbox ADPCM entry with a loop)
+// plus a file it must skip and a bank it must reject:
+//   - the DSP, DS2 and SPT streams agree with ParseDsp / ParseDs2 / ParseSptSpd on the
+//     whole file, and the bank entries with the headers they were written from;
+//   - only headers are read: files with large payloads cost a small fraction of their size;
+//   - one worker and many workers give the same report;
+//   - the CSV quotes entry names holding commas and quotes, and the JSON gets written.
+// Then a synthetic corpus of banks is scanned and timed.
+//   CorpusScanTest [directories in the timing corpus, default 20] [threads, default all]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../Common/CorpusScan.h"
+#include "Check.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+void Put(const fs::path& p, const std::vector<uint8_t>& b) {
+    fs::create_directories(p.parent_path());
+    std::ofstream(p, std::ios::binary).write(reinterpret_cast<const char*>(b.data()), static_cast<std::streamsize>(b.size()));
+}
+
+std::vector<uint8_t> Load(const fs::path& p) {
+    std::ifstream in(p, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+void Le(std::vector<uint8_t>& v, uint32_t x, int bytes = 4) { for (int i = 0; i < bytes; ++i) v.push_back(static_cast<uint8_t>(x >> (8 * i))); }
+
+DspHeader Header(uint32_t samples, uint32_t rate, bool looped) {
+    DspHeader h{};
+    h.num_samples = samples; h.num_nibbles = (samples + 13) / 14 * 16; h.sample_rate = rate;
+    h.loop_flag = looped; h.loop_start = looped ? 2 : 0; h.loop_end = looped ? h.num_nibbles - 1 : 0;
+    return h;
+}
+
+// A DSH (channels 1) or D2H (channels 2) bank with one entry per name.
+std::vector<uint8_t> Bank(const std::vector<std::string>& names, const std::vector<DspHeader>& headers, int channels) {
+    std::vector<uint8_t> b(DSH_FILE_HEADER_BYTES, 0);
+    DshFileHeader head{};
+    head.count = static_cast<uint32_t>(names.size());
+    BeStore(head, b.data());
+    for (size_t i = 0; i < names.size(); ++i) {
+        std::vector<uint8_t> e(DSH_NAME_BYTES + channels * DSP_HEADER_BYTES, 0);
+        memcpy(e.data(), names[i].data(), names[i].size());
+        for (int c = 0; c < channels; ++c) BeStore(headers[i], e.data() + DSH_NAME_BYTES + c * DSP_HEADER_BYTES);
+        b.insert(b.end(), e.begin(), e.end());
+    }
+    return b;
+}
+
+// RIFF header of an XBB entry: fmt, optional smpl loop, data (inline bytes or an empty
+// chunk for XSB-streamed audio). The RIFF size field holds the whole header's length.
+std::vector<uint8_t> XbbRiff(uint16_t tag, uint16_t channels, uint32_t rate, uint16_t bits, uint32_t loop_start, uint32_t loop_end, uint32_t inline_bytes) {
+    std::vector<uint8_t> r = { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' };
+    Le(r, 16); Le(r, tag, 2); Le(r, channels, 2); Le(r, rate); Le(r, 0); Le(r, tag == 0x69 ? 36 * channels : channels * bits / 8, 2); Le(r, bits, 2);
+    if (loop_end) {
+        r.insert(r.end(), { 's', 'm', 'p', 'l' }); Le(r, 60);
+        for (int i = 0; i < 7; ++i) Le(r, 0);
+        Le(r, 1); Le(r, 0);                                         // one loop, no sampler data
+        Le(r, 0); Le(r, 0); Le(r, loop_start); Le(r, loop_end); Le(r, 0); Le(r, 0);
+    }
+    r.insert(r.end(), { 'd', 'a', 't', 'a' }); Le(r, inline_bytes);
+    r.resize(r.size() + inline_bytes, 5);
+    const uint32_t len = static_cast<uint32_t>(r.size());
+    memcpy(&r[4], &len, 4);
+    return r;
+}
+
+const ScanFile* Find(const CorpusReport& rep, const char* rel) {
+    for (const ScanFile& f : rep.files) if (f.path.lexically_relative(rep.root) == fs::path(rel)) return &f;
+    return nullptr;
+}
+
+bool SameAsParsed(const ScanStream& s, const DspStream& d) {
+    return s.samples == d.samples() && s.sample_rate == d.sample_rate() && s.looped == (d.loop_flag() != 0)
+        && s.loop_start == d.loop_start() && s.loop_end == d.loop_end();
+}
+
+bool SameReport(const CorpusReport& a, const CorpusReport& b) {
+    if (a.files.size() != b.files.size()) return false;
+    for (size_t i = 0; i < a.files.size(); ++i) {
+        const ScanFile& x = a.files[i];
+        const ScanFile& y = b.files[i];
+        if (x.path != y.path || x.error != y.error || x.streams.size() != y.streams.size()) return false;
+        for (size_t k = 0; k < x.streams.size(); ++k) {
+            const ScanStream& s = x.streams[k];
+            const ScanStream& t = y.streams[k];
+            if (s.name != t.name || s.samples != t.samples || s.sample_rate != t.sample_rate || s.looped != t.looped
+                || s.loop_start != t.loop_start || s.loop_end != t.loop_end || s.data_bytes != t.data_bytes) return false;
+        }
+    }
+    return true;
+}
+
+void CheckSmallTree(const fs::path& root) {
+    // DSP with a payload well past its header, and a DS2.
+    const DspHeader mono = Header(140000, 32000, true);
+    std::vector<uint8_t> dsp(DSP_HEADER_BYTES + (140000 + 13) / 14 * 8, 3);
+    BeStore(mono, dsp.data());
+    Put(root / "a" / "x.DSP", dsp);
+
+    DspHeader left = Header(2800, 22050, false), right = left;
+    left.data_offset = DS2_HEADER_BYTES; right.data_offset = DS2_HEADER_BYTES + 1600;
+    std::vector<uint8_t> ds2(DS2_HEADER_BYTES + 3200, 0);
+    BeStore(left, ds2.data()); BeStore(right, ds2.data() + DSP_HEADER_BYTES);
+    Put(root / "a" / "y.ds2", ds2);
+
+    const std::vector<DspHeader> bank_headers = { Header(28, 32000, false), Header(1400, 44100, true) };
+    Put(root / "b" / "bank.dsh", Bank({ "one.dsp", "two,\"q\".dsp" }, bank_headers, 1));
+    Put(root / "b" / "bank.d2h", Bank({ "st.ds2" }, { Header(700, 48000, true) }, 2));
+
+    // SPT/SPD through the shared writer.
+    std::vector<uint8_t> pay(4096, 0x11);
+    DspStream s1, s2;
+    BeStore(Header(28, 32000, true), s1.header); s1.data = pay.data(); s1.size = 16;
+    BeStore(Header(2800, 16000, false), s2.header); s2.data = pay.data(); s2.size = 1600;
+    fs::create_directories(root / "c");
+    CHECK(WriteSptSpd(root / "c" / "s.spt", root / "c" / "s.spd", { s1, s2 }));
+
+    // XBB: 22 kHz inline PCM, then 44 kHz stereo Xbox ADPCM streamed from the XSB (720 bytes).
+    std::vector<uint8_t> xbb = { 'X', 'B', 'B', '0' };
+    Le(xbb, 2);
+    const struct { std::vector<uint8_t> riff; uint32_t streamed; } entries[] = {
+        { XbbRiff(1, 1, 22050, 16, 0, 0, 200), 0 }, { XbbRiff(0x69, 2, 44100, 4, 100, 900, 0), 720 },
+    };
+    for (const auto& e : entries) {
+        xbb.insert(xbb.end(), e.riff.begin(), e.riff.end());
+        Le(xbb, 0); Le(xbb, e.streamed);                            // trailer: XSB offset, length
+    }
+    Put(root / "d" / "snd.xbb", xbb);
+
+    Put(root / "d" / "readme.txt", { 1, 2, 3 });
+    Put(root / "d" / "bad.dsh", { 0, 0, 0, 9 });
+
+    const CorpusReport rep = ScanCorpus(root, 1);
+    CHECK(rep.files.size() == 7);                                   // neither the .txt nor the .spd
+    CHECK(SameReport(rep, ScanCorpus(root, 8)));
+
+    if (const ScanFile* f = Find(rep, "a/x.DSP")) {
+        const std::vector<uint8_t> bytes = Load(f->path);
+        DspStream d;
+        CHECK(ParseDsp(bytes.data(), bytes.size(), d));
+        CHECK(f->streams.size() == 1 && SameAsParsed(f->streams[0], d) && f->streams[0].data_bytes == d.size);
+        CHECK(f->bytes_read == DSP_HEADER_BYTES && f->bytes_read * 100 < f->size);
+    }
+    else CHECK(!"a/x.DSP scanned");
+
+    if (const ScanFile* f = Find(rep, "a/y.ds2")) {
+        const std::vector<uint8_t> bytes = Load(f->path);
+        DspStream l, r;
+        CHECK(ParseDs2(bytes.data(), bytes.size(), l, r));
+        CHECK(f->streams.size() == 1 && f->streams[0].channels == 2 && SameAsParsed(f->streams[0], l));
+        CHECK(f->streams[0].data_bytes == l.size + r.size);
+    }
+    else CHECK(!"a/y.ds2 scanned");
+
+    if (const ScanFile* f = Find(rep, "b/bank.dsh")) {
+        CHECK(f->error.empty() && f->streams.size() == 2 && f->reads == 2);
+        for (size_t i = 0; i < (std::min)(f->streams.size(), bank_headers.size()); ++i) {
+            DspStream d;
+            BeStore(bank_headers[i], d.header);
+            CHECK(SameAsParsed(f->streams[i], d) && f->streams[i].data_bytes == DspPayloadBytes(d.fields()));
+        }
+        if (f->streams.size() == 2) CHECK(f->streams[1].name == "two,\"q\".dsp");
+    }
+    else CHECK(!"b/bank.dsh scanned");
+
+    if (const ScanFile* f = Find(rep, "b/bank.d2h")) {
+        CHECK(f->streams.size() == 1 && f->streams[0].channels == 2 && f->streams[0].name == "st.ds2");
+        CHECK(f->streams.size() == 1 && f->streams[0].sample_rate == 48000 && f->streams[0].looped);
+    }
+    else CHECK(!"b/bank.d2h scanned");
+
+    if (const ScanFile* f = Find(rep, "c/s.spt")) {
+        const std::vector<uint8_t> spt = Load(root / "c" / "s.spt"), spd = Load(root / "c" / "s.spd");
+        std::vector<DspStream> parsed;
+        CHECK(ParseSptSpd(spt.data(), spt.size(), spd.data(), spd.size(), parsed));
+        CHECK(f->streams.size() == parsed.size());
+        for (size_t i = 0; i < (std::min)(f->streams.size(), parsed.size()); ++i) {
+            CHECK(SameAsParsed(f->streams[i], parsed[i]));
+            CHECK(f->streams[i].data_bytes == parsed[i].size);
+        }
+    }
+    else CHECK(!"c/s.spt scanned");
+
+    if (const ScanFile* f = Find(rep, "d/snd.xbb")) {
+        CHECK(f->error.empty() && f->streams.size() == 2);
+        if (f->streams.size() == 2) {
+            const ScanStream& pcm = f->streams[0];
+            const ScanStream& adpcm = f->streams[1];
+            CHECK(pcm.format == 1 && pcm.sample_rate == 22050 && pcm.data_bytes == 200 && pcm.samples == 100 && !pcm.looped);
+            CHECK(adpcm.format == 0x69 && adpcm.channels == 2 && adpcm.data_bytes == 720 && adpcm.samples == 640);
+            CHECK(adpcm.looped && adpcm.loop_start == 100 && adpcm.loop_end == 900);
+        }
+    }
+    else CHECK(!"d/snd.xbb scanned");
+
+    const ScanFile* bad = Find(rep, "d/bad.dsh");
+    CHECK(bad && !bad->error.empty() && bad->streams.empty());
+
+    const CorpusSummary s = SummarizeCorpus(rep);
+    CHECK(s.files == 7 && s.failed == 1 && s.streams == 9 && s.looped == 5);
+
+    CHECK(WriteCorpusJson(rep, "CorpusScanTest.json") && fs::file_size("CorpusScanTest.json") > 0);
+    CHECK(WriteCorpusCsv(rep, "CorpusScanTest.csv"));
+    std::stringstream csv;
+    csv << std::ifstream("CorpusScanTest.csv").rdbuf();
+    CHECK(csv.str().find(",\"two,\"\"q\"\".dsp\",") != std::string::npos);
+    fs::remove("CorpusScanTest.json");
+    fs::remove("CorpusScanTest.csv");
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const int dirs = argc > 1 ? std::atoi(argv[1]) : 20;
+    const unsigned threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 0;
+    const fs::path root = "CorpusScanTest.tree";
+    fs::remove_all(root);
+    CheckSmallTree(root);
+    fs::remove_all(root);
+
+    // Timing corpus: per directory one 200-entry DSH and twenty 8 KiB DSPs.
+    std::vector<std::string> names;
+    std::vector<DspHeader> headers;
+    for (int i = 0; i < 200; ++i) { names.push_back("s" + std::to_string(i) + ".dsp"); headers.push_back(Header(14000 + i, 32000, i & 1)); }
+    const std::vector<uint8_t> bank = Bank(names, headers, 1);
+    std::vector<uint8_t> dsp(DSP_HEADER_BYTES + 8000, 7);
+    BeStore(Header(14000, 22050, false), dsp.data());
+    for (int d = 0; d < dirs; ++d) {
+        const fs::path dir = root / ("d" + std::to_string(d));
+        Put(dir / "bank.dsh", bank);
+        for (int k = 0; k < 20; ++k) Put(dir / ("f" + std::to_string(k) + ".dsp"), dsp);
+    }
+    const CorpusReport rep = ScanCorpus(root, threads);
+    const CorpusSummary s = SummarizeCorpus(rep);
+    CHECK(s.files == static_cast<uint64_t>(dirs) * 21 && s.failed == 0 && s.streams == static_cast<uint64_t>(dirs) * 220);
+    std::printf("%llu files, %llu streams: walk %.1f ms, scan %.1f ms on %u threads, %llu header bytes in %llu reads\n",
+        static_cast<unsigned long long>(s.files), static_cast<unsigned long long>(s.streams), rep.walk_ms, rep.scan_ms, rep.threads,
+        static_cast<unsigned long long>(s.bytes_read), static_cast<unsigned long long>(s.reads));
+    fs::remove_all(root);
+    return TestExit("CorpusScanTest");
+}
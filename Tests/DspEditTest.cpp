@@ -0,0 +1,262 @@
+// DspEditTest.cpp
+// DspEdit against the decode -> edit PCM -> re-encode round trip it replaces. On synthetic
+// mono streams:
+//   - history lookups through the index match a decode from the start;
+//   - Trim decodes bit-identically to the same slice of the source and re-encodes nothing;
+//   - Cut and Append keep the untouched side bit-identical, re-encode only the frames up
+//     to where the histories meet, and end up closer to the edited source PCM than a full
+//     re-encode of that PCM does;
+//   - clips with different coefficient tables, and joins that do not converge within
+//     MAX_CONVERGE_FRAMES, re-encode the rest of the second clip (the latter is reported
+//     in fallback_edits);
+//   - a written clip parses back to the same samples.
+//   DspEditTest [seconds of source audio, default 180]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../Common/DspEdit.h"
+#include "../Common/MappedFile.h"
+#include "Check.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+double MsSince(Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); }
+
+const int16_t COEFS_A[16] = { 2048, 0, 0, 0, 4096, -2048, 2048, -2048, 3072, -1024, 1024, 512, 512, 256, 2048, 1024 };
+const int16_t COEFS_B[16] = { 1800, 0, 0, 0, 3900, -1900, 2048, -2048, 3072, -1024, 1024, 512, 512, 256, 2048, 1024 };
+
+struct Source {
+    std::vector<uint8_t> file;
+    DspStream stream;
+};
+
+// Two drifting tones plus a little noise.
+std::vector<int16_t> MakePcm(uint32_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<int16_t> p(n);
+    double ph = 0, ph2 = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        ph += 0.03 + 0.02 * std::sin(i * 1e-4);
+        ph2 += 0.31;
+        p[i] = static_cast<int16_t>(9000 * std::sin(ph) + 3000 * std::sin(ph2) + static_cast<int>(rng() % 600) - 300);
+    }
+    return p;
+}
+
+// Whole-stream encode from zero history: what a full re-encode writes.
+std::vector<uint8_t> EncodeFrames(const std::vector<int16_t>& pcm, const int16_t coefs[16]) {
+    const uint32_t frames = DspClip::frames_for(static_cast<uint32_t>(pcm.size()));
+    std::vector<uint8_t> out(static_cast<size_t>(frames) * DSP_FRAME_BYTES);
+    int16_t h1 = 0, h2 = 0;
+    for (uint32_t f = 0; f < frames; ++f) {
+        const int count = static_cast<int>((std::min)(static_cast<size_t>(DSP_FRAME_SAMPLES), pcm.size() - f * DSP_FRAME_SAMPLES));
+        EncodeDspFrame(&pcm[f * DSP_FRAME_SAMPLES], count, coefs, h1, h2, &out[static_cast<size_t>(f) * DSP_FRAME_BYTES]);
+    }
+    return out;
+}
+
+Source MakeSource(const std::vector<int16_t>& pcm, const int16_t coefs[16], uint32_t rate = 32000) {
+    Source s;
+    const std::vector<uint8_t> frames = EncodeFrames(pcm, coefs);
+    s.file.assign(DSP_HEADER_BYTES, 0);
+    s.file.insert(s.file.end(), frames.begin(), frames.end());
+    const uint32_t n = static_cast<uint32_t>(pcm.size());
+    DspHeader h{};
+    h.num_samples = n;
+    h.num_nibbles = n + 2 * DspClip::frames_for(n);
+    h.sample_rate = rate;
+    memcpy(h.coefs, coefs, sizeof(h.coefs));
+    h.initial_ps = s.file[DSP_HEADER_BYTES];
+    BeStore(h, s.file.data());
+    CHECK(ParseDsp(s.file.data(), s.file.size(), s.stream));
+    return s;
+}
+
+std::vector<int16_t> Decode(const DspClip& c) {
+    int16_t coefs[16]; c.coefs(coefs);
+    int16_t h1 = c.initial_hist1(), h2 = c.initial_hist2();
+    std::vector<int16_t> out(c.samples());
+    for (uint32_t f = 0; f < DspClip::frames_for(c.samples()); ++f) {
+        int16_t t[DSP_FRAME_SAMPLES];
+        DecodeDspFrame(c.frame(f), coefs, h1, h2, t);
+        for (uint32_t n = 0; n < DSP_FRAME_SAMPLES && f * DSP_FRAME_SAMPLES + n < c.samples(); ++n) out[f * DSP_FRAME_SAMPLES + n] = t[n];
+    }
+    return out;
+}
+
+// Decoded PCM of a full re-encode of 'pcm', and how long the encode took.
+std::vector<int16_t> FullReencode(const std::vector<int16_t>& pcm, const int16_t coefs[16], double& ms) {
+    const Clock::time_point t = Clock::now();
+    const std::vector<uint8_t> frames = EncodeFrames(pcm, coefs);
+    ms = MsSince(t);
+    std::vector<int16_t> out(pcm.size());
+    int16_t h1 = 0, h2 = 0;
+    for (size_t f = 0; f * DSP_FRAME_SAMPLES < pcm.size(); ++f) {
+        int16_t s[DSP_FRAME_SAMPLES];
+        DecodeDspFrame(&frames[f * DSP_FRAME_BYTES], coefs, h1, h2, s);
+        for (size_t n = 0; n < DSP_FRAME_SAMPLES && f * DSP_FRAME_SAMPLES + n < pcm.size(); ++n) out[f * DSP_FRAME_SAMPLES + n] = s[n];
+    }
+    return out;
+}
+
+double SquaredError(const std::vector<int16_t>& a, const std::vector<int16_t>& b, size_t from = 0) {
+    double e = 0;
+    for (size_t i = from; i < (std::min)(a.size(), b.size()); ++i) e += static_cast<double>(a[i] - b[i]) * (a[i] - b[i]);
+    return e;
+}
+
+// Last index where a and b differ, or -1.
+long long LastDiff(const std::vector<int16_t>& a, const std::vector<int16_t>& b) {
+    for (size_t i = (std::min)(a.size(), b.size()); i-- > 0;) if (a[i] != b[i]) return static_cast<long long>(i);
+    return -1;
+}
+
+// Edited clip vs a full re-encode of the same edited PCM ('want'): the untouched prefix
+// must match exactly, and the total error must be no higher (re-encoding already-ADPCM PCM
+// is close to lossless, so the two usually differ only around the edit).
+void CompareWithReencode(const char* what, const DspClip& edited, const std::vector<int16_t>& want, size_t exact_prefix, double edit_ms) {
+    const std::vector<int16_t> got = Decode(edited);
+    CHECK(got.size() == want.size());
+    CHECK(LastDiff(std::vector<int16_t>(got.begin(), got.begin() + exact_prefix), std::vector<int16_t>(want.begin(), want.begin() + exact_prefix)) < 0);
+    double full_ms;
+    int16_t coefs[16]; edited.coefs(coefs);
+    const std::vector<int16_t> full = FullReencode(want, coefs, full_ms);
+    const double edit_err = SquaredError(got, want), full_err = SquaredError(full, want);
+    CHECK(edit_err <= full_err * 1.01);
+    std::printf("%-22s %6u frames re-encoded, %.2f ms (full re-encode %.1f ms), squared error %.0f vs %.0f\n",
+        what, edited.reencoded_frames, edit_ms, full_ms, edit_err, full_err);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 180.0;
+    const uint32_t n = static_cast<uint32_t>(32000 * seconds);
+    const std::vector<int16_t> pcm_a = MakePcm(n, 1), pcm_b = MakePcm(50000, 2), pcm_c = MakePcm(30000, 3);
+    const Source a = MakeSource(pcm_a, COEFS_A), b = MakeSource(pcm_b, COEFS_A), c = MakeSource(pcm_c, COEFS_B);
+    const DspClip clip_a(a.stream), clip_b(b.stream), clip_c(c.stream);
+    const std::vector<int16_t> da = Decode(clip_a), db = Decode(clip_b), dc = Decode(clip_c);
+    const uint32_t frames_a = clip_a.frame_count();
+
+    // History lookups: the first one past frame 64 builds the index.
+    {
+        Clock::time_point t = Clock::now();
+        int16_t h1, h2;
+        DspHistoryAt(clip_a, frames_a - 3, h1, h2);
+        std::printf("history index over %u frames: %.2f ms\n", frames_a, MsSince(t));
+        std::mt19937 rng(9);
+        int16_t coefs[16]; clip_a.coefs(coefs);
+        for (int k = 0; k < 20; ++k) {
+            const uint32_t at = rng() % frames_a;
+            int16_t y1 = 0, y2 = 0;
+            for (uint32_t f = 0; f < at; ++f) DecodeDspFrame(clip_a.frame(f), coefs, y1, y2, nullptr);
+            DspHistoryAt(clip_a, at, h1, h2);
+            CHECK(h1 == y1 && h2 == y2);
+        }
+    }
+
+    // Trim: the same samples, nothing re-encoded.
+    {
+        const uint32_t from = n / 7 + 5, to = n / 2 + 3, start = from - from % DSP_FRAME_SAMPLES;
+        DspClip t;
+        CHECK(DspTrim(clip_a, from, to, t));
+        const std::vector<int16_t> dt = Decode(t);
+        CHECK(dt.size() == to - start);
+        CHECK(LastDiff(dt, std::vector<int16_t>(da.begin() + start, da.begin() + to)) < 0);
+        CHECK(t.reencoded_frames == 0);
+    }
+
+    // Cut from the middle of the stream.
+    {
+        const uint32_t c0 = (n / 3 + 3) / DSP_FRAME_SAMPLES * DSP_FRAME_SAMPLES, c1 = (n / 2 + 5) / DSP_FRAME_SAMPLES * DSP_FRAME_SAMPLES;
+        std::vector<int16_t> want(da.begin(), da.begin() + c0);
+        want.insert(want.end(), da.begin() + c1, da.end());
+        DspClip x;
+        const Clock::time_point t = Clock::now();
+        CHECK(DspCut(clip_a, c0, c1, x));
+        const double ms = MsSince(t);
+        CHECK(x.fallback_edits == 0);
+        CHECK(x.reencoded_frames < DspClip::MAX_CONVERGE_FRAMES);
+        CompareWithReencode("cut", x, want, c0, ms);
+        CHECK(LastDiff(Decode(x), want) < static_cast<long long>(c0 + x.reencoded_frames * DSP_FRAME_SAMPLES));
+    }
+
+    // Append with a partial last frame and the same coefficients.
+    {
+        const uint32_t keep = n / 2 + 3 - (n / 2) % DSP_FRAME_SAMPLES;   // ends 3 samples into a frame
+        DspClip j;
+        CHECK(DspTrim(clip_a, 0, keep, j));
+        const uint32_t pad = (DSP_FRAME_SAMPLES - keep % DSP_FRAME_SAMPLES) % DSP_FRAME_SAMPLES;
+        const Clock::time_point t = Clock::now();
+        CHECK(DspAppend(j, clip_b));
+        const double ms = MsSince(t);
+        CHECK(j.fallback_edits == 0);
+        // The ramp samples of the padded frame are new; compare around them.
+        std::vector<int16_t> want(da.begin(), da.begin() + keep);
+        const std::vector<int16_t> got = Decode(j);
+        want.insert(want.end(), got.begin() + keep, got.begin() + keep + pad);
+        want.insert(want.end(), db.begin(), db.end());
+        CompareWithReencode("append", j, want, keep, ms);
+    }
+
+    // Different coefficient tables: all of the second clip is re-encoded with the first's.
+    {
+        DspClip j = clip_b;
+        CHECK(DspAppend(j, clip_c));
+        CHECK(j.reencoded_frames == clip_c.frame_count() + (clip_b.samples() % DSP_FRAME_SAMPLES ? 1 : 0));
+        CHECK(j.fallback_edits == 0);
+        const std::vector<int16_t> got = Decode(j);
+        const size_t at = clip_b.frame_count() * DSP_FRAME_SAMPLES;
+        double full_ms;
+        const std::vector<int16_t> full = FullReencode(dc, COEFS_A, full_ms);
+        const double rms = std::sqrt(SquaredError(std::vector<int16_t>(got.begin() + at, got.end()), dc) / dc.size());
+        const double full_rms = std::sqrt(SquaredError(full, dc) / dc.size());
+        CHECK(rms < full_rms * 1.1 + 1);
+        std::printf("append, other coefs    %6u frames re-encoded, rms %.1f (full re-encode %.1f)\n", j.reencoded_frames, rms, full_rms);
+    }
+
+    // A near full-scale sine joined out of phase never lets the histories meet: past the cap
+    // the rest is re-encoded and the join is reported.
+    {
+        auto sine = [](size_t n) {
+            std::vector<int16_t> p(n);
+            for (size_t i = 0; i < n; ++i) p[i] = static_cast<int16_t>(30000 * std::sin(i * 0.074));
+            return p;
+        };
+        const uint32_t head = 19999, pad = DSP_FRAME_SAMPLES - head % DSP_FRAME_SAMPLES;
+        const Source la = MakeSource(sine(head), COEFS_A), lb = MakeSource(sine(DspClip::MAX_CONVERGE_FRAMES * DSP_FRAME_SAMPLES * 3), COEFS_A);
+        DspClip j(la.stream);
+        const DspClip clip_lb(lb.stream);
+        const Clock::time_point t = Clock::now();
+        CHECK(DspAppend(j, clip_lb));
+        const double ms = MsSince(t);
+        CHECK(j.fallback_edits == 1);
+        CHECK(j.reencoded_frames == clip_lb.frame_count() + 1);
+        std::vector<int16_t> want = Decode(DspClip(la.stream));
+        const std::vector<int16_t> got = Decode(j), tail = Decode(clip_lb);
+        want.insert(want.end(), got.begin() + head, got.begin() + head + pad);   // the ramp
+        want.insert(want.end(), tail.begin(), tail.end());
+        CompareWithReencode("append, no convergence", j, want, head, ms);
+    }
+
+    // Write and parse back.
+    {
+        DspClip j;
+        CHECK(DspTrim(clip_a, 0, 20000, j));
+        CHECK(DspAppend(j, clip_b));
+        const std::filesystem::path path = "DspEditTest.dsp";
+        CHECK(WriteDspClip(path, j));
+        {
+            MappedFile m(path);
+            DspStream s;
+            CHECK(m.is_open() && ParseDsp(m.data(), m.size(), s));
+            CHECK(Decode(DspClip(s)) == Decode(j));
+        }
+        std::filesystem::remove(path);
+    }
+    return TestExit("DspEditTest");
+}
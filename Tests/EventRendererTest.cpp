@@ -0,0 +1,246 @@
+// EventRendererTest.cpp
+// The event render path, bottom up:
+//   - MixAdd and BusToPcm16 (8 samples per SSE2 step where available, plain C++ for the
+//     tail) against one-sample-at-a-time reference loops, for every length up to 70 and
+//     at offsets that leave the vectors unaligned, including saturation and ties;
+//   - PcmCache decodes a key once even when many threads ask at once, remembers a failed
+//     decode, and survives a decode that throws (the caller sees the exception, everyone
+//     else a failed decode);
+//   - PlanEventMap on Simple, Random (SimpleEvent-only, SoundDataFile-only, mixed),
+//     Compound rows with delays, mislabelled, missing and unknown-type rows;
+//   - MixVariant places parts at their delays, converts rate and channels to the bus,
+//     and skips and counts missing sources.
+// Then MixAdd + BusToPcm16 throughput is timed against the reference loops.
+//   EventRendererTest [seconds of 48 kHz stereo for the timing run, default 60]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../Common/EventRenderer.h"
+#include "Check.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+double MsSince(Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); }
+
+namespace reference {
+void MixAdd(float* bus, const int16_t* src, size_t n, float gain) { for (size_t i = 0; i < n; ++i) bus[i] += static_cast<float>(src[i]) * gain; }
+void BusToPcm16(const float* bus, int16_t* dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) dst[i] = static_cast<int16_t>((std::min)(32767.0f, (std::max)(-32768.0f, std::nearbyint(bus[i]))));
+}
+} // namespace reference
+
+void CheckMixer() {
+    std::mt19937 rng(1);
+    int bad = 0;
+    for (size_t n = 0; n <= 70; ++n) {
+        for (size_t skew = 0; skew < 3; ++skew) {
+            std::vector<int16_t> src(n + skew);
+            for (int16_t& s : src) s = static_cast<int16_t>(rng());
+            std::vector<float> bus(n + skew), ref;
+            for (float& f : bus) f = static_cast<float>(static_cast<int>(rng() % 200001) - 100000) * 0.5f;   // .5 ties included
+            ref = bus;
+            const float gain = skew == 1 ? 1.0f : 0.25f + static_cast<float>(rng() % 1000) / 250.0f;
+            MixAdd(bus.data() + skew, src.data() + skew, n, gain);
+            reference::MixAdd(ref.data() + skew, src.data() + skew, n, gain);
+            bad += bus != ref;
+
+            std::vector<int16_t> out(n + skew), want(n + skew);
+            BusToPcm16(bus.data() + skew, out.data() + skew, n);
+            reference::BusToPcm16(ref.data() + skew, want.data() + skew, n);
+            bad += out != want;
+        }
+    }
+    CHECK(bad == 0);
+
+    // Saturation and round-half-to-even at the edges of the 16-bit range.
+    const float edge[16] = { 32767.4f, 32767.5f, 32768.0f, 1e9f, -32768.4f, -32768.5f, -32769.0f, -1e9f,
+                             0.5f, 1.5f, 2.5f, -0.5f, -1.5f, -2.5f, 0.49f, -0.51f };
+    int16_t out[16], want[16];
+    BusToPcm16(edge, out, 16);
+    reference::BusToPcm16(edge, want, 16);
+    CHECK(std::equal(out, out + 16, want));
+    CHECK(out[1] == 32767 && out[3] == 32767 && out[5] == -32768 && out[7] == -32768);
+    CHECK(out[8] == 0 && out[9] == 2 && out[10] == 2 && out[12] == -2);
+}
+
+void CheckPcmCache() {
+    PcmCache cache;
+    std::atomic<int> decodes{ 0 };
+    auto decode = [&](PcmBuffer& p) {
+        ++decodes;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        p.sample_rate = 22050; p.channels = 1; p.samples.assign(100, 7);
+        return true;
+    };
+    std::vector<PcmPtr> got(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < got.size(); ++i) threads.emplace_back([&, i] { got[i] = cache.get(42, decode); });
+    for (std::thread& t : threads) t.join();
+    CHECK(decodes == 1 && got[0] && got[0]->samples.size() == 100);
+    CHECK(std::all_of(got.begin(), got.end(), [&](const PcmPtr& p) { return p == got[0]; }));
+    CHECK(cache.misses() == 1 && cache.hits() == 7 && cache.size() == 1 && cache.bytes() == 200);
+
+    CHECK(!cache.get(43, [&](PcmBuffer&) { ++decodes; return false; }));
+    CHECK(!cache.get(43, decode) && decodes == 2);   // remembered, not decoded again
+
+    bool threw = false;
+    try { cache.get(44, [](PcmBuffer&) -> bool { throw std::runtime_error("bad data"); }); }
+    catch (const std::runtime_error&) { threw = true; }
+    CHECK(threw);
+    CHECK(!cache.get(44, decode) && decodes == 2);
+}
+
+flo::Model Parse(const char* text) {
+    flo::Model m;
+    CHECK(flo::ParseText(text, m));
+    CHECK(m.warnings.empty());
+    return m;
+}
+
+// sdf ids of every part, variant by variant; 'delays' gets the parts' delays the same way.
+std::vector<std::vector<int>> Plan(const flo::Model& m, size_t row, std::vector<std::vector<float>>* delays = nullptr) {
+    flo::IdTables ids;
+    ids.build(m);
+    std::vector<flo::RenderVariant> vs;
+    flo::PlanEventMap(m, ids, row, vs);
+    std::vector<std::vector<int>> r;
+    if (delays) delays->clear();
+    for (const flo::RenderVariant& v : vs) {
+        r.emplace_back();
+        if (delays) delays->emplace_back();
+        for (const flo::RenderPart& p : v.parts) { r.back().push_back(p.sdf_id); if (delays) delays->back().push_back(p.delay); }
+    }
+    return r;
+}
+
+void CheckPlan() {
+    const flo::Model m = Parse(
+        "SoundDataFiles\n6\n0, c, a.wav\n1, c, b.wav\n2, c, c.wav\n3, c, d.wav\n4, c, e.wav\n5, c, f.wav\n"
+        "SimpleEvents\n3\n10, 0, 2, 0\n11, 1, 2, 0\n12, 2, 2, 0\n"
+        "RandomEvents\n4\n"
+        "20, 2\n0, 10\n0, 11\n"             // SimpleEvents only
+        "21, 2\n3\n4\n"                     // SoundDataFiles only
+        "22, 3\n0, 12\n5\n0, 99\n"          // mixed, one SimpleEvent missing
+        "23, 1\n0, 98\n"                    // only a missing SimpleEvent
+        "CompoundEvents\n2\n"
+        "30, 3\n0, 10\n0, 12, 0.5\n5\n"
+        "31, 2\n0, 11, -1\n0, 99, 2\n"
+        "EventMaps\nPre\n11\n"
+        "0, 0, 10, EV*s\n"
+        "1, 1, 20, EV*r1\n"
+        "2, 1, 21, EV*r2\n"
+        "3, 1, 22, EV*r3\n"
+        "4, 1, 23, EV*r4\n"
+        "5, 2, 30, EV*c1\n"
+        "6, 2, 31, EV*c2\n"
+        "7, 1, 30, EV*r_is_c\n"
+        "8, 2, 21, EV*c_is_r\n"
+        "9, 0, 77, EV*missing\n"
+        "10, 5, 10, EV*badtype\n"
+        "Pan\n0\nPos\n0\n");
+    using V = std::vector<std::vector<int>>;
+    CHECK((Plan(m, 0) == V{ { 0 } }));
+    CHECK((Plan(m, 1) == V{ { 0 }, { 1 } }));
+    CHECK((Plan(m, 2) == V{ { 3 }, { 4 } }));
+    CHECK((Plan(m, 3) == V{ { 2 } }));                  // the direct SoundDataFile link is not a choice
+    CHECK(Plan(m, 4).empty());                          // no compound 23 to fall back to
+    std::vector<std::vector<float>> delays;
+    CHECK((Plan(m, 5, &delays) == V{ { 0, 2, 5 } }));
+    CHECK((delays == std::vector<std::vector<float>>{ { 0.0f, 0.5f, 0.0f } }));
+    CHECK((Plan(m, 6, &delays) == V{ { 1 } }));         // negative delay clamped, missing link dropped
+    CHECK((delays == std::vector<std::vector<float>>{ { 0.0f } }));
+    CHECK((Plan(m, 7) == V{ { 0, 2, 5 } }));            // Random row naming a Compound
+    CHECK((Plan(m, 8) == V{ { 3 }, { 4 } }));           // and the other way round
+    CHECK(Plan(m, 9).empty() && Plan(m, 10).empty());
+
+    // Random 24 is mixed with only a dangling SimpleEvent: nothing to play, like the renamer.
+    const flo::Model m2 = Parse("SoundDataFiles\n1\n3, c, d.wav\nSimpleEvents\n0\nRandomEvents\n1\n24, 2\n3\n0, 98\n"
+                                "CompoundEvents\n0\nEventMaps\nPre\n1\n0, 1, 24, EV*r\nPan\n0\nPos\n0\n");
+    CHECK(Plan(m2, 0).empty());
+}
+
+PcmPtr Tone(uint32_t rate, uint16_t channels, size_t frames, int16_t base) {
+    auto p = std::make_shared<PcmBuffer>();
+    p->sample_rate = rate; p->channels = channels;
+    p->samples.resize(frames * channels);
+    for (size_t i = 0; i < p->samples.size(); ++i) p->samples[i] = static_cast<int16_t>(base + static_cast<int>(i % 50));
+    return p;
+}
+
+void CheckMix() {
+    // Two mono 16 kHz parts, the second 0.25 s in: a mono 16 kHz bus, 8000 frames long.
+    flo::RenderVariant v{ { { 1, 0.0f }, { 2, 0.25f }, { 9, 0.0f } } };
+    const PcmPtr a = Tone(16000, 1, 4000, 100), b = Tone(16000, 1, 4000, -300);
+    auto source = [&](int id) -> PcmPtr { return id == 1 ? a : id == 2 ? b : nullptr; };
+    PcmBuffer out;
+    size_t missing = 0;
+    CHECK(flo::MixVariant(v, source, out, &missing));
+    CHECK(missing == 1 && out.sample_rate == 16000 && out.channels == 1 && out.frames() == 8000);
+    CHECK(out.samples[0] == a->samples[0] && out.samples[3999] == a->samples[3999]);
+    CHECK(out.samples[4000] == b->samples[0] && out.samples[7999] == b->samples[3999]);
+
+    // Overlap: a 2 s mono 8 kHz part under a 1 s stereo 16 kHz part.
+    flo::RenderVariant w{ { { 1, 0.0f }, { 2, 0.0f } } };
+    const PcmPtr c = Tone(8000, 1, 16000, 1000), d = Tone(16000, 2, 16000, 2000);
+    auto source2 = [&](int id) -> PcmPtr { return id == 1 ? c : d; };
+    CHECK(flo::MixVariant(w, source2, out));
+    CHECK(out.sample_rate == 16000 && out.channels == 2 && out.frames() == 32000);
+    std::vector<int16_t> conv;
+    ConvertPcm(*c, 16000, 2, conv);
+    CHECK(conv.size() == out.samples.size());
+    bool same = conv.size() == out.samples.size();
+    for (size_t i = 0; same && i < out.samples.size(); ++i) {
+        const int want = conv[i] + (i < d->samples.size() ? d->samples[i] : 0);
+        same = out.samples[i] == want;
+    }
+    CHECK(same);
+
+    CHECK(!flo::MixVariant(v, [](int) -> PcmPtr { return nullptr; }, out, &missing) && missing == 4);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 60.0;
+    CheckMixer();
+    CheckPcmCache();
+    CheckPlan();
+    CheckMix();
+
+    // Four sources summed into one bus and converted back, best of three.
+    const size_t n = static_cast<size_t>(seconds * 48000) * 2;
+    std::vector<int16_t> src(n);
+    std::mt19937 rng(3);
+    for (int16_t& s : src) s = static_cast<int16_t>(rng());
+    std::vector<float> bus(n);
+    std::vector<int16_t> out(n), want(n);
+    double ref_ms = 1e300, mix_ms = 1e300;
+    for (int run = 0; run < 3; ++run) {
+        Clock::time_point t = Clock::now();
+        std::fill(bus.begin(), bus.end(), 0.0f);
+        for (int k = 0; k < 4; ++k) reference::MixAdd(bus.data(), src.data(), n, 0.25f);
+        reference::BusToPcm16(bus.data(), want.data(), n);
+        ref_ms = (std::min)(ref_ms, MsSince(t));
+        t = Clock::now();
+        std::fill(bus.begin(), bus.end(), 0.0f);
+        for (int k = 0; k < 4; ++k) MixAdd(bus.data(), src.data(), n, 0.25f);
+        BusToPcm16(bus.data(), out.data(), n);
+        mix_ms = (std::min)(mix_ms, MsSince(t));
+    }
+    CHECK(out == want);
+#ifdef MIXER_SSE2
+    const char* path = "SSE2";
+#else
+    const char* path = "scalar";
+#endif
+    std::printf("%.0f s of 48 kHz stereo, 4 sources: reference %.2f ms, MixAdd/BusToPcm16 (%s) %.2f ms\n", seconds, ref_ms, path, mix_ms);
+    return TestExit("EventRendererTest");
+}
@@ -0,0 +1,197 @@
+// FloIndexTest.cpp
+// The .flo.idx sidecar (FloIndex.h):
+//   - LoadOrParse writes it after a clean parse and loads it next time, giving every
+//     column, block span and expansion step of a fresh parse;
+//   - a .flo that changed size, mtime or (at the same size and mtime) content is parsed
+//     again instead;
+//   - a truncated sidecar, random bytes, the sidecar of another .flo, and a well-formed
+//     sidecar whose columns do not fit together (unequal lengths, ranges past the end,
+//     sdf_row out of range) are all refused, leaving the model empty.
+// Then loading from the sidecar is timed against a full parse.
+//   FloIndexTest [events, default 20000]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../Common/FloIndex.h"
+#include "Check.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+double MsSince(Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); }
+
+void WriteFlo(const fs::path& path, int n, int seed) {
+    std::mt19937 rng(seed);
+    std::string s = "\xEF\xBB\xBF";
+    auto line = [&](const std::string& l) { s += l; s += "\r\n"; };
+    line("SoundDataBundles"); line("1"); line("0,\tc,\tdata/audio/a.xsb");
+    line("SoundDataFiles"); line(std::to_string(n));
+    for (int i = 0; i < n; ++i) line(std::to_string(i) + ",\tc,\tsnd_" + std::to_string(i % 977) + ".wav");
+    line("SimpleEvents"); line(std::to_string(n));
+    for (int i = 0; i < n; ++i) line(std::to_string(i) + ",\t" + std::to_string(rng() % (n + 10)) + ", 2, 0");
+    line("RandomEvents"); line("50");
+    for (int r = 0; r < 50; ++r) { line(std::to_string(r) + ", 2"); line("0, " + std::to_string(rng() % n)); line(std::to_string(rng() % n)); }
+    line("CompoundEvents"); line("50");
+    for (int r = 0; r < 50; ++r) { line(std::to_string(r) + ", 2"); line("0, " + std::to_string(rng() % n) + ", 0.25"); line("0, " + std::to_string(rng() % n)); }
+    line("SoundParameterSets");
+    line("Pre"); line("1"); line("0, 1, 2, 3");
+    line("Pan"); line("0");
+    line("Pos"); line("0");
+    line("EventMaps");
+    line("Pre"); line(std::to_string(n));
+    for (int i = 0; i < n; ++i) line(std::to_string(i) + ",\t" + std::to_string(i % 3) + ", " + std::to_string(i % 3 ? i % 60 : i) + ", EV*Grp" + std::to_string(i % 40) + "_N" + std::to_string(i));
+    line("Pan"); line("0");
+    line("Pos"); line("0");
+    std::ofstream(path, std::ios::binary).write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+// Every column flattened to bytes (strings by content), for whole-model comparisons.
+struct Flatten {
+    std::string out;
+    template <class T> void operator()(const std::vector<T>& col) {
+        const size_t n = col.size();
+        out.append(reinterpret_cast<const char*>(&n), sizeof(n));
+        if (n) out.append(reinterpret_cast<const char*>(col.data()), n * sizeof(T));
+    }
+    void operator()(const std::vector<std::string_view>& col) {
+        for (std::string_view s : col) { out += s; out += '\0'; }
+    }
+};
+
+std::string Flat(const flo::Model& m, const flo::Expansion& x) {
+    Flatten f;
+    flo::detail::VisitColumns(m, x, f);
+    for (const flo::BlockSpan& s : m.blocks) {
+        const uint32_t v[] = { s.present, static_cast<uint32_t>(s.declared), static_cast<uint32_t>(s.parsed), s.header_begin, s.count_begin, s.count_end, s.body_end };
+        f.out.append(reinterpret_cast<const char*>(v), sizeof(v));
+    }
+    f.out += m.has_event_maps ? '1' : '0';
+    return f.out;
+}
+
+bool Refused(const fs::path& flo) {
+    flo::Model m; flo::Expansion x;
+    const bool loaded = flo::LoadIndex(flo, m, x);
+    return !loaded && m.sdf.size() == 0 && m.maps.size() == 0 && x.size() == 0 && !m.blocks[flo::BLK_SDF].present;
+}
+
+// Writes a sidecar for a copy of the parse with one thing broken by 'damage'.
+template <class F>
+bool RefusedAfter(const fs::path& flo, F damage) {
+    flo::Model m; flo::Expansion x;
+    CHECK(flo::ParseFile(flo, m));
+    flo::ResolveEventMaps(m, x);
+    damage(m, x);
+    CHECK(flo::WriteIndex(flo, m, x));
+    return Refused(flo);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const int events = argc > 1 ? (std::max)(100, std::atoi(argv[1])) : 20000;
+    const fs::path path = "FloIndexTest.flo", other = "FloIndexTest.other.flo";
+    const fs::path idx = flo::IndexPathFor(path);
+    fs::remove(idx);
+    WriteFlo(path, events, 1);
+
+    // Round trip: the second load comes from the sidecar and matches a fresh parse.
+    flo::Model parsed, cached; flo::Expansion px, cx;
+    bool from_cache = true;
+    CHECK(flo::LoadOrParse(path, parsed, px, &from_cache) && !from_cache);
+    CHECK(parsed.warnings.empty() && fs::exists(idx));
+    CHECK(flo::LoadOrParse(path, cached, cx, &from_cache) && from_cache);
+    CHECK(Flat(parsed, px) == Flat(cached, cx));
+    CHECK(cached.text.size() + 3 == fs::file_size(path) && cached.sdf.filename[5] == parsed.sdf.filename[5]);
+
+    // Staleness: size, mtime, and content at the same size and mtime.
+    const fs::file_time_type stamp = fs::last_write_time(path);
+    { std::ofstream(path, std::ios::binary | std::ios::app) << "\r\n"; }
+    CHECK(Refused(path));
+    WriteFlo(path, events, 1);
+    fs::last_write_time(path, stamp);
+    CHECK(!Refused(path));
+    fs::last_write_time(path, stamp + std::chrono::seconds(2));
+    CHECK(Refused(path));
+    {
+        std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(-6, std::ios::end);
+        f.put('7');
+    }
+    fs::last_write_time(path, stamp);
+    CHECK(Refused(path));
+    WriteFlo(path, events, 1);
+    fs::last_write_time(path, stamp);
+    CHECK(!Refused(path));
+
+    // Truncated, foreign and random sidecars.
+    const std::uintmax_t full = fs::file_size(idx);
+    for (std::uintmax_t keep : { full - 1, full / 2, std::uintmax_t(sizeof(flo::detail::IndexHeader)), std::uintmax_t(20), std::uintmax_t(0) }) {
+        flo::Model m; flo::Expansion x;
+        CHECK(flo::ParseFile(path, m));
+        flo::ResolveEventMaps(m, x);
+        CHECK(flo::WriteIndex(path, m, x));
+        fs::resize_file(idx, keep);
+        CHECK(Refused(path));
+    }
+    WriteFlo(other, events, 2);
+    {
+        flo::Model m; flo::Expansion x;
+        CHECK(flo::LoadOrParse(other, m, x));
+    }
+    fs::copy_file(flo::IndexPathFor(other), idx, fs::copy_options::overwrite_existing);
+    CHECK(Refused(path));
+    {
+        std::mt19937 rng(3);
+        std::string junk(full, '\0');
+        for (char& c : junk) c = static_cast<char>(rng());
+        memcpy(&junk[0], flo::detail::INDEX_MAGIC, sizeof(flo::detail::INDEX_MAGIC));
+        std::ofstream(idx, std::ios::binary | std::ios::trunc).write(junk.data(), static_cast<std::streamsize>(junk.size()));
+        CHECK(Refused(path));
+    }
+
+    // Well-formed sidecars whose columns do not fit together.
+    CHECK(RefusedAfter(path, [](flo::Model& m, flo::Expansion&) { m.sdf.filename.pop_back(); }));
+    CHECK(RefusedAfter(path, [](flo::Model& m, flo::Expansion&) { m.random.link_arity.pop_back(); }));
+    CHECK(RefusedAfter(path, [](flo::Model& m, flo::Expansion&) { m.compound.count.back() += 1; }));
+    CHECK(RefusedAfter(path, [](flo::Model& m, flo::Expansion&) { m.sps.first[0] = 1000000; }));
+    CHECK(RefusedAfter(path, [](flo::Model& m, flo::Expansion&) { m.maps.name.pop_back(); }));
+    CHECK(RefusedAfter(path, [](flo::Model&, flo::Expansion& x) { x.status.pop_back(); }));
+    CHECK(RefusedAfter(path, [](flo::Model&, flo::Expansion& x) { x.sdf_row.pop_back(); }));
+    CHECK(RefusedAfter(path, [](flo::Model&, flo::Expansion& x) { x.count.back() = static_cast<uint32_t>(x.steps() + 1); }));
+    CHECK(RefusedAfter(path, [](flo::Model&, flo::Expansion& x) { x.first.back() = 0xFFFFFFF0u; }));
+    CHECK(RefusedAfter(path, [](flo::Model& m, flo::Expansion& x) { x.sdf_row[0] = static_cast<int>(m.sdf.size()); }));
+    CHECK(RefusedAfter(path, [](flo::Model&, flo::Expansion& x) { x.sdf_row[0] = -3; }));
+    CHECK(RefusedAfter(path, [](flo::Model& m, flo::Expansion&) { m.blocks[flo::BLK_SIMPLE].body_end = static_cast<uint32_t>(m.text.size() + 1); }));
+    CHECK(!RefusedAfter(path, [](flo::Model&, flo::Expansion& x) { x.sdf_row[0] = flo::ROW_SDF_MISSING; }));
+
+    // Load time, best of three.
+    {
+        flo::Model m; flo::Expansion x;
+        fs::remove(idx);
+        CHECK(flo::LoadOrParse(path, m, x));
+    }
+    double parse_ms = 1e300, load_ms = 1e300;
+    for (int run = 0; run < 3; ++run) {
+        flo::Model m; flo::Expansion x;
+        Clock::time_point t = Clock::now();
+        CHECK(flo::ParseFile(path, m));
+        flo::ResolveEventMaps(m, x);
+        parse_ms = (std::min)(parse_ms, MsSince(t));
+        t = Clock::now();
+        CHECK(flo::LoadIndex(path, m, x));
+        load_ms = (std::min)(load_ms, MsSince(t));
+    }
+    std::printf("%d events: parse + resolve %.2f ms, sidecar %.2f ms\n", events, parse_ms, load_ms);
+
+    for (const fs::path& p : { path, idx, other, flo::IndexPathFor(other) }) fs::remove(p);
+    return TestExit("FloIndexTest");
+}
@@ -0,0 +1,250 @@
+// FloParseBench.cpp
+// Times flo::ParseFile against the loader it replaced (std::wifstream into a vector of
+// lines, a linear search per section header, std::wstringstream + getline(',') per field)
+// on a generated .flo, and checks that both read the same entries. The legacy loader is
+// kept here only as a reference; _wtoi is replaced by wcstol so it builds everywhere.
+// Only parsing is timed: the old loader's per-event filename lookup and sort are left out.
+// A corrupt entry count is also checked to parse without reserving for it.
+//   FloParseBench [events, default 50000] [runs, default 5] [existing .flo instead of a generated one]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../Common/FloParser.h"
+#include "Check.h"
+
+namespace {
+
+// Same layout as a level .flo: bundles, one SoundDataFile and SimpleEvent per event,
+// 100 random and 100 compound events, parameter sets, and the events split over Pre/Pos.
+void WriteFlo(const std::filesystem::path& path, int n) {
+    std::mt19937 rng(1);
+    std::string s;
+    auto line = [&](const std::string& l) { s += l; s += "\r\n"; };
+    line("SoundDataBundles"); line("2");
+    line("0,\tc,\tdata/audio/a.xsb"); line("1,\tb,\tdata/audio/b.xsb");
+    line("SoundDataFiles"); line(std::to_string(n));
+    char buf[128];
+    for (int i = 0; i < n; ++i) { std::snprintf(buf, sizeof(buf), "%d,\tc,\tsnd_%05d.wav", i, i); line(buf); }
+    line("SimpleEvents"); line(std::to_string(n));
+    for (int i = 0; i < n; ++i) { std::snprintf(buf, sizeof(buf), "%d,\t%d, 2, 0", i, i); line(buf); }
+    line("RandomEvents"); line("100");
+    for (int r = 0; r < 100; ++r) {
+        std::snprintf(buf, sizeof(buf), "%d, 3", r); line(buf);
+        for (int k = 0; k < 3; ++k) { std::snprintf(buf, sizeof(buf), "0, %d", static_cast<int>(rng() % n)); line(buf); }
+    }
+    line("CompoundEvents"); line("100");
+    for (int r = 0; r < 100; ++r) {
+        std::snprintf(buf, sizeof(buf), "%d, 2", r); line(buf);
+        for (int k = 0; k < 2; ++k) { std::snprintf(buf, sizeof(buf), "0, %d, %d", static_cast<int>(rng() % n), static_cast<int>(rng() % 5)); line(buf); }
+    }
+    line("SoundParameterSets");
+    line("Pre"); line("2"); line("0, 1, 2, 3"); line("1, 4, 5");
+    line("Pan"); line("0");
+    line("Pos"); line("1"); line("0, 9");
+    line("EventMaps");
+    line("Pre"); line(std::to_string(n / 2));
+    for (int i = 0; i < n / 2; ++i) {
+        std::snprintf(buf, sizeof(buf), "%d,\t%d, %d, EV*Grp%d_Name%d", i, i % 3 == 0 ? 0 : 1, i % 3 ? i % 100 : i, i % 40, i);
+        line(buf);
+    }
+    line("Pan"); line("0");
+    line("Pos"); line(std::to_string(n - n / 2));
+    for (int i = n / 2; i < n; ++i) { std::snprintf(buf, sizeof(buf), "%d,\t0, %d, EV*Pos%d_X%d", i, i, i % 7, i); line(buf); }
+    std::ofstream(path, std::ios::binary).write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+// --- The replaced loader, trimmed to the parts that read entries ---
+namespace legacy {
+struct Sdf { int id; std::wstring type_char, filename; };
+struct Simple { int id, sound_data_file_id, type, linked_event_id; };
+struct Link { int param_1, simple_event_id; };
+struct Linked { int id; std::vector<Link> links; };
+struct MapEntry { int event_id, link_type_val, linked_id; std::wstring event_name, section; };
+struct Flo {
+    std::vector<Sdf> sdf;
+    std::vector<Simple> simple;
+    std::vector<Linked> random, compound;
+    std::vector<MapEntry> maps;
+};
+
+std::wstring Trim(const std::wstring& s) {
+    const wchar_t* ws = L" \t\r\n";
+    auto start = s.find_first_not_of(ws);
+    if (start == std::wstring::npos) return L"";
+    auto end = s.find_last_not_of(ws);
+    return s.substr(start, end - start + 1);
+}
+int ToInt(const std::wstring& s) { return static_cast<int>(std::wcstol(s.c_str(), nullptr, 10)); }
+
+bool Parse(const std::filesystem::path& path, Flo& out) {
+    std::wifstream in(path);
+    if (!in) return false;
+    std::vector<std::wstring> lines;
+    for (std::wstring line; std::getline(in, line); ) lines.push_back(line);
+    const int n = static_cast<int>(lines.size());
+    auto find = [&](const wchar_t* name, int from) {
+        for (int i = from; i < n; ++i) if (Trim(lines[i]) == name) return i;
+        return -1;
+    };
+
+    int idx = find(L"SoundDataFiles", 0);
+    if (idx >= 0 && idx + 1 < n) {
+        const int count = ToInt(Trim(lines[idx + 1]));
+        for (int j = 0; j < count && idx + 2 + j < n; ++j) {
+            std::wstringstream ss(lines[idx + 2 + j]);
+            Sdf e; std::wstring tok;
+            std::getline(ss, tok, L','); e.id = ToInt(Trim(tok));
+            std::getline(ss, tok, L','); e.type_char = Trim(tok);
+            std::getline(ss, tok); e.filename = Trim(tok);
+            out.sdf.push_back(e);
+        }
+    }
+    idx = find(L"SimpleEvents", 0);
+    if (idx >= 0 && idx + 1 < n) {
+        const int count = ToInt(Trim(lines[idx + 1]));
+        for (int j = 0; j < count && idx + 2 + j < n; ++j) {
+            std::wstringstream ss(lines[idx + 2 + j]);
+            Simple e; std::wstring tok;
+            std::getline(ss, tok, L','); e.id = ToInt(Trim(tok));
+            std::getline(ss, tok, L','); e.sound_data_file_id = ToInt(Trim(tok));
+            std::getline(ss, tok, L','); e.type = ToInt(Trim(tok));
+            std::getline(ss, tok, L','); e.linked_event_id = ToInt(Trim(tok));
+            out.simple.push_back(e);
+        }
+    }
+    auto parseLinked = [&](const wchar_t* name, std::vector<Linked>& events) {
+        const int at = find(name, 0);
+        if (at < 0 || at + 1 >= n) return;
+        const int count = ToInt(Trim(lines[at + 1]));
+        int li = at + 2;
+        for (int i = 0; i < count && li < n; ++i) {
+            std::wstringstream ss(lines[li++]);
+            Linked ev; std::wstring tok;
+            std::getline(ss, tok, L','); ev.id = ToInt(Trim(tok));
+            std::getline(ss, tok, L','); const int links = ToInt(Trim(tok));
+            for (int j = 0; j < links && li < n; ++j) {
+                std::wstringstream ls(lines[li++]);
+                Link link;
+                std::getline(ls, tok, L','); link.param_1 = ToInt(Trim(tok));
+                std::getline(ls, tok, L','); link.simple_event_id = ToInt(Trim(tok));
+                ev.links.push_back(link);
+            }
+            events.push_back(std::move(ev));
+        }
+    };
+    parseLinked(L"RandomEvents", out.random);
+    parseLinked(L"CompoundEvents", out.compound);
+
+    const int maps = find(L"EventMaps", 0);
+    if (maps < 0) return false;
+    for (const wchar_t* section : { L"Pre", L"Pos" }) {
+        const int at = find(section, maps + 1);
+        if (at < 0 || at + 1 >= n) continue;
+        const int count = ToInt(Trim(lines[at + 1]));
+        for (int j = 0; j < count && at + 2 + j < n; ++j) {
+            std::wstringstream ss(lines[at + 2 + j]);
+            MapEntry e; std::wstring tok;
+            std::getline(ss, tok, L','); e.event_id = ToInt(Trim(tok));
+            std::getline(ss, tok, L','); e.link_type_val = ToInt(Trim(tok));
+            std::getline(ss, tok, L','); e.linked_id = ToInt(Trim(tok));
+            std::getline(ss, tok); e.event_name = Trim(tok);
+            e.section = section;
+            out.maps.push_back(e);
+        }
+    }
+    return true;
+}
+} // namespace legacy
+
+void CompareLinked(const std::vector<legacy::Linked>& old, const flo::LinkedEvents& ev) {
+    CHECK(old.size() == ev.size());
+    for (size_t i = 0; i < (std::min)(old.size(), ev.size()); ++i) {
+        CHECK(old[i].id == ev.id[i]);
+        CHECK(old[i].links.size() == ev.count[i]);
+        for (uint32_t k = 0; k < (std::min)(static_cast<uint32_t>(old[i].links.size()), ev.count[i]); ++k) {
+            CHECK(old[i].links[k].param_1 == ev.link_a[ev.first[i] + k]);
+            CHECK(old[i].links[k].simple_event_id == ev.link_b[ev.first[i] + k]);
+        }
+    }
+}
+
+// Both loaders must see the same entries, field for field.
+void Compare(const legacy::Flo& old, const flo::Model& m) {
+    CHECK(old.sdf.size() == m.sdf.size());
+    for (size_t i = 0; i < (std::min)(old.sdf.size(), m.sdf.size()); ++i) {
+        CHECK(old.sdf[i].id == m.sdf.id[i]);
+        CHECK(old.sdf[i].filename == flo::Widen(m.sdf.filename[i]));
+    }
+    CHECK(old.simple.size() == m.simple.size());
+    for (size_t i = 0; i < (std::min)(old.simple.size(), m.simple.size()); ++i) {
+        CHECK(old.simple[i].id == m.simple.id[i]);
+        CHECK(old.simple[i].sound_data_file_id == m.simple.sdf_id[i]);
+    }
+    CompareLinked(old.random, m.random);
+    CompareLinked(old.compound, m.compound);
+
+    std::vector<size_t> rows;   // Pre and Pos rows, the ones the old loader kept
+    for (size_t i = 0; i < m.maps.size(); ++i) if (m.maps.sub[i] != flo::SUB_PAN) rows.push_back(i);
+    CHECK(old.maps.size() == rows.size());
+    for (size_t i = 0; i < (std::min)(old.maps.size(), rows.size()); ++i) {
+        const size_t r = rows[i];
+        CHECK(old.maps[i].event_id == m.maps.id[r]);
+        CHECK(old.maps[i].link_type_val == m.maps.type[r]);
+        CHECK(old.maps[i].linked_id == m.maps.ref[r]);
+        CHECK(old.maps[i].event_name == flo::Widen(m.maps.name[r]));
+        CHECK(old.maps[i].section == flo::Widen(flo::SubSectionName(m.maps.sub[r])));
+    }
+}
+
+template <typename F>
+double BestMs(int runs, F&& f) {
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        const auto t0 = std::chrono::steady_clock::now();
+        f();
+        best = (std::min)(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    }
+    return best;
+}
+
+// A count far beyond what the file holds must not be reserved up front: the parse reads
+// what is there and warns that the block ended early.
+void CheckCorruptCount() {
+    flo::Model m;
+    CHECK(flo::ParseText("SoundDataFiles\n2000000000\n1, wav, a.wav\nSimpleEvents\n2147483647\n1, 1, 0, 0\n", m));
+    CHECK(m.sdf.size() == 1 && m.simple.size() == 1);
+    CHECK(m.sdf.id.capacity() < 100 && m.simple.id.capacity() < 100);
+    CHECK(!m.warnings.empty());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int events = argc > 1 ? std::atoi(argv[1]) : 50000;
+    const int runs = argc > 2 ? (std::max)(1, std::atoi(argv[2])) : 5;
+    std::filesystem::path path = argc > 3 ? std::filesystem::path(argv[3]) : std::filesystem::path("FloParseBench.flo");
+    if (argc <= 3) WriteFlo(path, events);
+    CheckCorruptCount();
+
+    legacy::Flo old;
+    flo::Model model;
+    const double old_ms = BestMs(runs, [&] { old = legacy::Flo(); CHECK(legacy::Parse(path, old)); });
+    const double new_ms = BestMs(runs, [&] { CHECK(flo::ParseFile(path, model)); });
+    CHECK(model.warnings.empty());
+    Compare(old, model);
+
+    std::printf("%s: %ju bytes, %zu event maps, best of %d\n", path.string().c_str(),
+        static_cast<uintmax_t>(std::filesystem::file_size(path)), model.maps.size(), runs);
+    std::printf("  legacy wifstream/wstringstream  %9.2f ms\n", old_ms);
+    std::printf("  flo::ParseFile                  %9.2f ms  (%.1fx)\n", new_ms, old_ms / new_ms);
+    if (argc <= 3) std::filesystem::remove(path);
+    return TestExit("FloParseBench");
+}
@@ -0,0 +1,186 @@
+// FloResolveTest.cpp
+// flo::ResolveEventMaps against the per-row expansion the renamer used before
+// (ExpandRefWithFallback in WavRenameGladius.cpp, kept here only as a reference). On a
+// generated .flo whose Random events mix SimpleEvent and direct SoundDataFile links -
+// plus missing targets and rows whose type names the wrong section - every EventMaps row
+// must give the same SoundDataFiles and SimpleEvents either way: the cached expansion when
+// it has any, the legacy fallback otherwise, exactly as WavRename's ParseFlo combines them.
+//   FloResolveTest [random events, default 2000]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../Common/FloResolve.h"
+#include "Check.h"
+
+namespace {
+namespace legacy {
+enum { DOMAIN_SIMPLE = 0, DOMAIN_RANDOM = 1, DOMAIN_COMPOUND = 2 };
+struct RandomEventEntry { int id{}; std::vector<int> choices_simple; std::vector<int> choices_sdf; };
+struct CompoundEventEntry { int id{}; struct Comp { int simple_event_id{ -1 }; int sdf_id{ -1 }; }; std::vector<Comp> components; };
+
+struct Tables {
+    std::map<int, int> simple_to_sdf;
+    std::map<int, RandomEventEntry> random;
+    std::map<int, CompoundEventEntry> compound;
+};
+
+// The lookup maps ParseFlo fills from the model.
+Tables Build(const flo::Model& m) {
+    Tables t;
+    for (size_t i = 0; i < m.simple.size(); ++i) t.simple_to_sdf[m.simple.id[i]] = m.simple.sdf_id[i];
+    for (size_t i = 0; i < m.random.size(); ++i) {
+        RandomEventEntry re{}; re.id = m.random.id[i];
+        for (uint32_t k = m.random.first[i]; k < m.random.first[i] + m.random.count[i]; ++k) {
+            if (m.random.link_arity[k] == 0) continue;
+            if (m.random.link_arity[k] == 1) re.choices_sdf.push_back(m.random.link_a[k]); else re.choices_simple.push_back(m.random.link_b[k]);
+        }
+        t.random[re.id] = std::move(re);
+    }
+    for (size_t i = 0; i < m.compound.size(); ++i) {
+        CompoundEventEntry ce{}; ce.id = m.compound.id[i];
+        for (uint32_t k = m.compound.first[i]; k < m.compound.first[i] + m.compound.count[i]; ++k) {
+            if (m.compound.link_arity[k] == 0) continue;
+            CompoundEventEntry::Comp c{};
+            if (m.compound.link_arity[k] == 1) c.sdf_id = m.compound.link_a[k]; else c.simple_event_id = m.compound.link_b[k];
+            ce.components.push_back(c);
+        }
+        t.compound[ce.id] = std::move(ce);
+    }
+    return t;
+}
+
+void ExpandRandomToSdf(const RandomEventEntry* re, const std::map<int, int>& simple_to_sdf, std::vector<int>& out_sdf, std::vector<int>* out_simple) {
+    if (!re) return;
+    if (!re->choices_simple.empty()) {
+        for (int se : re->choices_simple) {
+            auto it = simple_to_sdf.find(se);
+            if (it != simple_to_sdf.end()) { out_sdf.push_back(it->second); if (out_simple) out_simple->push_back(se); }
+        }
+    }
+    else if (!re->choices_sdf.empty()) {
+        out_sdf.insert(out_sdf.end(), re->choices_sdf.begin(), re->choices_sdf.end());
+    }
+}
+
+void ExpandCompoundToSdf(const CompoundEventEntry* ce, const std::map<int, int>& simple_to_sdf, std::vector<int>& out_sdf, std::vector<int>* out_simple) {
+    if (!ce) return;
+    for (const auto& c : ce->components) {
+        if (c.simple_event_id >= 0) {
+            auto it = simple_to_sdf.find(c.simple_event_id);
+            if (it != simple_to_sdf.end()) { out_sdf.push_back(it->second); if (out_simple) out_simple->push_back(c.simple_event_id); }
+        }
+        else if (c.sdf_id >= 0) {
+            out_sdf.push_back(c.sdf_id);
+        }
+    }
+}
+
+void SortUnique(std::vector<int>& v) { std::sort(v.begin(), v.end()); v.erase(std::unique(v.begin(), v.end()), v.end()); }
+
+// Without the log line on a fallback.
+int ExpandRefWithFallback(int raw_type, int link_id, const Tables& t, std::vector<int>& out_sdf_ids, std::vector<int>& out_via_simple) {
+    int domain = (raw_type == 0) ? DOMAIN_SIMPLE : (raw_type == 1) ? DOMAIN_RANDOM : DOMAIN_COMPOUND;
+    auto try_expand = [&](int dom) -> bool {
+        out_sdf_ids.clear(); out_via_simple.clear();
+        if (dom == DOMAIN_SIMPLE) {
+            auto it = t.simple_to_sdf.find(link_id);
+            if (it != t.simple_to_sdf.end()) { out_sdf_ids.push_back(it->second); out_via_simple.push_back(link_id); }
+        }
+        else if (dom == DOMAIN_RANDOM) { auto it = t.random.find(link_id); if (it != t.random.end()) ExpandRandomToSdf(&it->second, t.simple_to_sdf, out_sdf_ids, &out_via_simple); }
+        else if (dom == DOMAIN_COMPOUND) { auto it = t.compound.find(link_id); if (it != t.compound.end()) ExpandCompoundToSdf(&it->second, t.simple_to_sdf, out_sdf_ids, &out_via_simple); }
+        SortUnique(out_sdf_ids); SortUnique(out_via_simple);
+        return !out_sdf_ids.empty();
+    };
+    if (try_expand(domain)) return domain;
+    if (raw_type == 1 || raw_type == 2) {
+        int swapped = (domain == DOMAIN_RANDOM) ? DOMAIN_COMPOUND : DOMAIN_RANDOM;
+        if (try_expand(swapped)) return swapped;
+    }
+    return domain;
+}
+} // namespace legacy
+
+// Random events of every shape: SimpleEvent links only, SoundDataFile links only, both
+// mixed, SimpleEvent links that all point nowhere, and none at all.
+std::string MakeFlo(int randoms) {
+    std::mt19937 rng(1);
+    const int sdfs = 500, simples = 400;   // SimpleEvents [simples, simples + 50) are referenced but missing
+    std::string s;
+    auto line = [&](const std::string& l) { s += l; s += "\r\n"; };
+    line("SoundDataFiles"); line(std::to_string(sdfs));
+    for (int i = 0; i < sdfs; ++i) line(std::to_string(i) + ",\tc,\tsnd_" + std::to_string(i) + ".wav");
+    line("SimpleEvents"); line(std::to_string(simples));
+    for (int i = 0; i < simples; ++i) line(std::to_string(i) + ",\t" + std::to_string(rng() % sdfs) + ", 2, 0");
+    auto linked = [&](const char* header, int n) {
+        line(header); line(std::to_string(n));
+        for (int r = 0; r < n; ++r) {
+            const int shape = r % 5, links = shape == 4 ? 0 : 1 + static_cast<int>(rng() % 5);
+            line(std::to_string(r) + ", " + std::to_string(links));
+            for (int k = 0; k < links; ++k) {
+                const bool simple = shape == 0 || shape == 3 || (shape == 2 && (k == 0 || rng() % 2));
+                if (!simple) line(std::to_string(rng() % sdfs));
+                else if (shape == 3) line("0, " + std::to_string(simples + rng() % 50));
+                else line("0, " + std::to_string(rng() % (simples + 50)) + (rng() % 2 ? ", 0.5" : ""));
+            }
+        }
+    };
+    linked("RandomEvents", randoms);
+    linked("CompoundEvents", randoms / 2);
+    const int rows = randoms * 3;
+    line("EventMaps");
+    line("Pre"); line(std::to_string(rows));
+    for (int i = 0; i < rows; ++i) {
+        const int type = static_cast<int>(rng() % 4);   // 3: not a link type
+        const int ref = static_cast<int>(rng() % (type == 0 ? simples + 50 : randoms + 10));
+        line(std::to_string(i) + ",\t" + std::to_string(type) + ", " + std::to_string(ref) + ", EV*Row" + std::to_string(i));
+    }
+    line("Pan"); line("0");
+    line("Pos"); line("0");
+    return s;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const int randoms = argc > 1 ? (std::max)(10, std::atoi(argv[1])) : 2000;
+    const std::string text = MakeFlo(randoms);
+    flo::Model m;
+    CHECK(flo::ParseText(text, m));
+    CHECK(m.warnings.empty());
+    flo::Expansion x;
+    flo::ResolveEventMaps(m, x);
+    CHECK(x.size() == m.maps.size());
+    const legacy::Tables t = legacy::Build(m);
+
+    size_t mixed = 0, cached = 0, fell_back = 0, differ = 0;
+    for (size_t i = 0; i < m.maps.size(); ++i) {
+        // The renamer: the cached expansion (sorted, unique) when it produced anything.
+        std::vector<int> sdf, simple;
+        for (uint32_t k = x.first[i]; k < x.first[i] + x.count[i]; ++k) {
+            if (x.sdf_row[k] == flo::ROW_SIMPLE_MISSING) continue;
+            sdf.push_back(x.sdf_id[k]);
+            if (x.simple_id[k] >= 0) simple.push_back(x.simple_id[k]);
+        }
+        legacy::SortUnique(sdf); legacy::SortUnique(simple);
+        std::vector<int> want_sdf, want_simple;
+        legacy::ExpandRefWithFallback(m.maps.type[i], m.maps.ref[i], t, want_sdf, want_simple);
+        if (sdf.empty()) { legacy::ExpandRefWithFallback(m.maps.type[i], m.maps.ref[i], t, sdf, simple); ++fell_back; }
+        else ++cached;
+        differ += sdf != want_sdf || simple != want_simple;
+
+        if (m.maps.type[i] == 1) {
+            auto it = t.random.find(m.maps.ref[i]);
+            mixed += it != t.random.end() && !it->second.choices_simple.empty() && !it->second.choices_sdf.empty();
+        }
+    }
+    CHECK(differ == 0);
+    CHECK(mixed > 0 && cached > 0 && fell_back > 0);
+    std::printf("%zu EventMaps rows (%zu on mixed Random events): %zu from the expansion, %zu via fallback, %zu differ\n",
+        m.maps.size(), mixed, cached, fell_back, differ);
+    return TestExit("FloResolveTest");
+}
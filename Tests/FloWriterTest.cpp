@@ -0,0 +1,111 @@
+// FloWriterTest.cpp
+// flo::SaveWithAppends written out and compared byte for byte with the file it should
+// give, with and without a UTF-8 BOM:
+//   - counts that gain a digit (9 -> 10, 99 -> 100) are rewritten in full;
+//   - a block that ended before its declared count gets entries read + lines added, not
+//     the stale declared count;
+//   - blocks nobody appended to, and the BOM, are copied unchanged;
+// and the output parses without warnings. Then appending many lines to one block of a
+// larger file is timed, parse and write included.
+//   FloWriterTest [lines to append in the timing run, default 10000]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "../Common/FloWriter.h"
+#include "Check.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+double MsSince(Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); }
+
+std::string SdfLine(int i) { return std::to_string(i) + ", wav, s" + std::to_string(i) + ".wav\r\n"; }
+std::string SimpleLine(int i) { return std::to_string(i) + ", " + std::to_string(i) + ", 0, 0\r\n"; }
+std::string BundleLine(int i) { return std::to_string(i) + ",\tc,\tdata/audio/b" + std::to_string(i) + ".xsb\r\n"; }
+
+// A .flo with 'bundles' of 'bundles_declared' bundle lines present, then 'sdf' files and
+// 'simple' events, each block's count as given.
+std::string Flo(bool bom, int bundles_declared, int bundles, int sdf, int simple) {
+    std::string s = bom ? "\xEF\xBB\xBF" : "";
+    s += "SoundDataBundles\r\n" + std::to_string(bundles_declared) + "\r\n";
+    for (int i = 0; i < bundles; ++i) s += BundleLine(i);
+    s += "SoundDataFiles\r\n" + std::to_string(sdf) + "\r\n";
+    for (int i = 0; i < sdf; ++i) s += SdfLine(i);
+    s += "SimpleEvents\r\n" + std::to_string(simple) + "\r\n";
+    for (int i = 0; i < simple; ++i) s += SimpleLine(i);
+    s += "RandomEvents\r\n0\r\n";
+    return s;
+}
+
+void Put(const std::filesystem::path& p, const std::string& s) { std::ofstream(p, std::ios::binary).write(s.data(), static_cast<std::streamsize>(s.size())); }
+std::string Get(const std::filesystem::path& p) {
+    std::ifstream in(p, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void CheckRoundTrip(bool bom) {
+    const std::filesystem::path src = "FloWriterTest.flo", dst = "FloWriterTest.out.flo";
+    Put(src, Flo(bom, 5, 2, 9, 99));
+    flo::Model before;
+    CHECK(flo::ParseFile(src, before));
+    CHECK(before.blocks[flo::BLK_BUNDLES].declared == 5 && before.blocks[flo::BLK_BUNDLES].parsed == 2);
+    CHECK(!before.warnings.empty());
+
+    flo::Appends a;
+    a.add(flo::BLK_BUNDLES, BundleLine(2));
+    a.add(flo::BLK_SDF, SdfLine(9));
+    a.add(flo::BLK_SIMPLE, SimpleLine(99));
+    std::string error;
+    CHECK(flo::SaveWithAppends(src, dst, a, error));
+    CHECK(error.empty());
+    CHECK(Get(dst) == Flo(bom, 3, 3, 10, 100));
+
+    flo::Model after;
+    CHECK(flo::ParseFile(dst, after));
+    CHECK(after.warnings.empty());
+    CHECK(after.bundles.size() == 3 && after.sdf.size() == 10 && after.simple.size() == 100);
+
+    // Nothing to add: the file comes back as it was.
+    CHECK(flo::SaveWithAppends(src, dst, flo::Appends(), error));
+    CHECK(Get(dst) == Get(src));
+
+    // A block the file does not have is an error and leaves no output behind.
+    std::filesystem::remove(dst);
+    flo::Appends missing;
+    missing.add(flo::BLK_COMPOUND, "1, 1\r\n");
+    CHECK(!flo::SaveWithAppends(src, dst, missing, error) && !error.empty());
+    CHECK(!std::filesystem::exists(dst));
+
+    std::filesystem::remove(src);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const int added = argc > 1 ? std::atoi(argv[1]) : 10000;
+    CheckRoundTrip(false);
+    CheckRoundTrip(true);
+
+    // 'added' new SimpleEvents after the 20000 already in the file, best of three.
+    const std::filesystem::path src = "FloWriterTest.flo", dst = "FloWriterTest.out.flo";
+    Put(src, Flo(false, 2, 2, 20000, 20000));
+    flo::Appends a;
+    for (int i = 0; i < added; ++i) a.add(flo::BLK_SIMPLE, SimpleLine(20000 + i));
+    double best = 1e300;
+    std::string error;
+    for (int run = 0; run < 3; ++run) {
+        const Clock::time_point t = Clock::now();
+        CHECK(flo::SaveWithAppends(src, dst, a, error));
+        best = (std::min)(best, MsSince(t));
+    }
+    CHECK(Get(dst) == Flo(false, 2, 2, 20000, 20000 + added));
+    std::printf("%d lines appended to a %ju-byte .flo: %.2f ms (parse + write)\n", added,
+        static_cast<uintmax_t>(std::filesystem::file_size(src)), best);
+    std::filesystem::remove(src);
+    std::filesystem::remove(dst);
+    return TestExit("FloWriterTest");
+}
@@ -0,0 +1,174 @@
+// GroupedRowViewTest.cpp
+// GroupedRowView against a plain scan of the display order (keep a row if its group is
+// the one shown, or ALL, and it is in the match set, if any):
+//   - add_row buckets rows per group, in add order, and lists groups first-seen;
+//   - set_group shows one group, ALL every row, an unknown group nothing;
+//   - set_match narrows either to the intersection, nullptr lifts it, an empty set
+//     shows nothing;
+//   - set_order re-orders whatever is shown, including after rows were added and after
+//     the same vector was re-sorted in place;
+// over a random sequence of those calls. Then switching through every group of a large
+// table, with and without a match set, is timed against the view's old rebuild
+// (intersect, then sort the group's rows by display position).
+//   GroupedRowViewTest [rows for the timing run, default 200000]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "../Common/GroupedRowView.h"
+#include "Check.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+double MsSince(Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); }
+
+std::vector<uint32_t> Shown(const GroupedRowView& v) {
+    std::vector<uint32_t> r(v.size());
+    for (size_t i = 0; i < r.size(); ++i) r[i] = v.row_at(i);
+    return r;
+}
+
+std::vector<uint32_t> Expected(const GroupedRowView& v, const std::vector<uint32_t>& order, uint32_t group, const std::vector<uint32_t>* match) {
+    std::vector<uint32_t> r;
+    for (uint32_t row : order) {
+        if (group != GroupedRowView::ALL && v.group_of(row) != group) continue;
+        if (match && !std::binary_search(match->begin(), match->end(), row)) continue;
+        r.push_back(row);
+    }
+    return r;
+}
+
+namespace legacy {
+// The rebuild the view did on every filter change.
+void Rebuild(const std::vector<uint32_t>& bucket, const std::vector<uint32_t>* match, const std::vector<uint32_t>& position, std::vector<uint32_t>& visible) {
+    visible.clear();
+    if (!match) visible = bucket;
+    else std::set_intersection(bucket.begin(), bucket.end(), match->begin(), match->end(), std::back_inserter(visible));
+    std::sort(visible.begin(), visible.end(), [&](uint32_t a, uint32_t b) { return position[a] < position[b]; });
+}
+} // namespace legacy
+
+void CheckBasics() {
+    GroupedRowView v;
+    CHECK(v.size() == 0);
+    const uint32_t groups[] = { 7, 3, 7, 9, 3, 7 };
+    for (uint32_t g : groups) v.add_row(g);
+    CHECK(v.row_count() == 6 && v.group_of(3) == 9);
+    CHECK((v.groups() == std::vector<uint32_t>{ 7, 3, 9 }));
+    CHECK((v.group_rows(7) == std::vector<uint32_t>{ 0, 2, 5 }) && v.group_rows(42).empty());
+    CHECK(v.size() == 0);   // nothing shown before an order is set
+
+    std::vector<uint32_t> order = { 5, 4, 3, 2, 1, 0 };
+    v.set_order(order);
+    CHECK(Shown(v) == order && v.group() == GroupedRowView::ALL);
+    v.set_group(7);
+    CHECK((Shown(v) == std::vector<uint32_t>{ 5, 2, 0 }));
+    const std::vector<uint32_t> match = { 0, 1, 5 };
+    v.set_match(&match);
+    CHECK((Shown(v) == std::vector<uint32_t>{ 5, 0 }));
+    v.set_group(GroupedRowView::ALL);
+    CHECK((Shown(v) == std::vector<uint32_t>{ 5, 1, 0 }));
+    v.set_group(42);
+    CHECK(v.size() == 0);
+    v.set_group(3);
+    order = { 1, 0, 2, 3, 4, 5 };               // re-sorted in place
+    v.set_order(order);
+    CHECK((Shown(v) == std::vector<uint32_t>{ 1 }));
+    v.set_match(nullptr);
+    CHECK((Shown(v) == std::vector<uint32_t>{ 1, 4 }));
+    const std::vector<uint32_t> none;
+    v.set_match(&none);
+    CHECK(v.size() == 0);
+
+    v.clear();
+    CHECK(v.row_count() == 0 && v.groups().empty() && v.size() == 0 && v.group() == GroupedRowView::ALL);
+}
+
+void CheckRandom() {
+    std::mt19937 rng(1);
+    GroupedRowView v;
+    std::vector<uint32_t> order, match;
+    const std::vector<uint32_t>* m = nullptr;
+    uint32_t group = GroupedRowView::ALL;
+    for (int i = 0; i < 200; ++i) v.add_row(rng() % 12);
+    order.resize(v.row_count());
+    std::iota(order.begin(), order.end(), 0u);
+    v.set_order(order);
+    int bad = 0;
+    for (int step = 0; step < 5000; ++step) {
+        switch (rng() % 5) {
+        case 0:                                  // new rows; the caller then sets the order again
+            for (int k = rng() % 4; k >= 0; --k) { v.add_row(rng() % 14); order.push_back(static_cast<uint32_t>(order.size())); }
+            std::shuffle(order.begin(), order.end(), rng);
+            v.set_order(order);
+            break;
+        case 1:
+            std::shuffle(order.begin(), order.end(), rng);
+            v.set_order(order);
+            break;
+        case 2:
+            group = rng() % 4 == 0 ? GroupedRowView::ALL : rng() % 16;   // 14, 15: never used
+            v.set_group(group);
+            break;
+        case 3:
+            match.clear();
+            for (uint32_t r = 0; r < v.row_count(); ++r) if (rng() % 3 == 0) match.push_back(r);
+            m = &match;
+            v.set_match(m);
+            break;
+        case 4:
+            m = nullptr;
+            v.set_match(m);
+            break;
+        }
+        bad += Shown(v) != Expected(v, order, group, m);
+    }
+    CHECK(bad == 0);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t rows = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 200000;
+    CheckBasics();
+    CheckRandom();
+
+    // Every group once, then every group with a match set, best of three.
+    std::mt19937 rng(2);
+    const uint32_t groups = 400;
+    GroupedRowView v;
+    for (size_t i = 0; i < rows; ++i) v.add_row(static_cast<uint32_t>(rng() % groups));
+    std::vector<uint32_t> order(rows), match;
+    std::iota(order.begin(), order.end(), 0u);
+    std::shuffle(order.begin(), order.end(), rng);
+    for (uint32_t r = 0; r < rows; ++r) if (rng() % 4 == 0) match.push_back(r);
+    std::vector<uint32_t> position(rows), visible;
+    for (size_t i = 0; i < rows; ++i) position[order[i]] = static_cast<uint32_t>(i);
+
+    const std::vector<uint32_t>* const filters[] = { nullptr, &match };
+    double old_ms = 1e300, new_ms = 1e300;
+    size_t old_total = 0, new_total = 0;
+    for (int run = 0; run < 3; ++run) {
+        old_total = new_total = 0;
+        Clock::time_point t = Clock::now();
+        for (const std::vector<uint32_t>* m : filters)
+            for (uint32_t g : v.groups()) { legacy::Rebuild(v.group_rows(g), m, position, visible); old_total += visible.size(); }
+        old_ms = (std::min)(old_ms, MsSince(t));
+        t = Clock::now();
+        v.set_order(order);
+        for (const std::vector<uint32_t>* m : filters) {
+            v.set_match(m);
+            for (uint32_t g : v.groups()) { v.set_group(g); new_total += v.size(); }
+        }
+        new_ms = (std::min)(new_ms, MsSince(t));
+    }
+    CHECK(old_total == new_total);
+    std::printf("%zu rows, %u groups, every group shown twice: sort per switch %.2f ms, ordered buckets %.2f ms\n",
+        rows, groups, old_ms, new_ms);
+    return TestExit("GroupedRowViewTest");
+}
@@ -0,0 +1,183 @@
+// LogSinkTest.cpp
+// LogSink with a file target and a UI target, in the build directory:
+//   - lines pushed from several threads at once all arrive, each producer's lines in the
+//     order it pushed them, in the file and in the UI text alike;
+//   - flush() returns only once every line pushed before it is in the file and ready for
+//     take_ui(); it returns at once before start() and with nothing pending;
+//   - lines pushed before start(), and after stop(), are kept and written first once the
+//     sink runs, in push order;
+//   - non-ASCII text reaches the file as UTF-8.
+// Then pushing from the producers is timed.
+//   LogSinkTest [lines per producer, default 200000]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Common/LogSink.h"
+#include "Check.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+double MsSince(Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); }
+
+const unsigned PRODUCERS = 4;
+
+std::vector<std::string> FileLines(const fs::path& path) {
+    std::ifstream f(path, std::ios::binary);
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(f, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+std::vector<std::string> UiLines(const std::wstring& text) {
+    std::vector<std::string> lines;
+    std::wstringstream ss(text);
+    for (std::wstring line; std::getline(ss, line);) {
+        if (!line.empty() && line.back() == L'\r') line.pop_back();
+        lines.emplace_back(line.begin(), line.end());   // ASCII only here
+    }
+    return lines;
+}
+
+// "p<producer> <index>" lines: every one present once, each producer's in increasing order.
+bool InProducerOrder(const std::vector<std::string>& lines, unsigned producers, int per_producer) {
+    std::vector<int> next(producers, 0);
+    for (const std::string& line : lines) {
+        unsigned p = 0; int i = -1;
+        if (std::sscanf(line.c_str(), "p%u %d", &p, &i) != 2 || p >= producers || i != next[p]) return false;
+        ++next[p];
+    }
+    for (int n : next) if (n != per_producer) return false;
+    return true;
+}
+
+void Produce(LogSink& log, unsigned producers, int per_producer) {
+    std::vector<std::thread> threads;
+    std::atomic<unsigned> ready{ 0 };
+    for (unsigned p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            ++ready;
+            while (ready.load() < producers) std::this_thread::yield();   // push all at once
+            for (int i = 0; i < per_producer; ++i) log.push(L"p" + std::to_wstring(p) + L" " + std::to_wstring(i));
+        });
+    }
+    for (std::thread& t : threads) t.join();
+}
+
+void CheckOrder(const fs::path& file, int per_producer) {
+    fs::remove(file);
+    std::atomic<int> notified{ 0 };
+    LogSink log;
+    LogTargets targets;
+    targets.file = file;
+    targets.ui_notify = [&] { ++notified; };
+    targets.ui_interval_ms = 1;
+    CHECK(log.start(targets));
+    Produce(log, PRODUCERS, per_producer);
+    log.flush();
+    CHECK(log.lines() == uint64_t(PRODUCERS) * per_producer);
+    CHECK(InProducerOrder(FileLines(file), PRODUCERS, per_producer));
+    std::wstring ui;
+    CHECK(log.take_ui(ui));
+    CHECK(InProducerOrder(UiLines(ui), PRODUCERS, per_producer));
+    CHECK(!log.take_ui(ui) && ui.empty());   // everything was taken at once
+
+    // The sink tells the UI once text is waiting (right after the batch that brought it).
+    notified = 0;
+    log.push(L"tail");
+    log.flush();
+    const Clock::time_point t = Clock::now();
+    while (notified.load() == 0 && MsSince(t) < 2000) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    CHECK(notified.load() > 0);
+    CHECK(log.take_ui(ui) && UiLines(ui) == std::vector<std::string>{ "tail" });
+    log.stop();
+}
+
+void CheckFlush(const fs::path& file) {
+    fs::remove(file);
+    LogSink log;
+    log.flush();                              // not started: returns at once
+    LogTargets targets;
+    targets.file = file;
+    CHECK(log.start(targets));
+    log.flush();                              // nothing pending
+    CHECK(FileLines(file).empty());
+    for (int round = 1; round <= 50; ++round) {
+        log.push(L"round " + std::to_wstring(round));
+        log.flush();
+        const std::vector<std::string> lines = FileLines(file);
+        CHECK(lines.size() == static_cast<size_t>(round) && lines.back() == "round " + std::to_string(round));
+    }
+    log.push(L"été 日本");
+    log.flush();
+    CHECK(FileLines(file).back() == "\xC3\xA9t\xC3\xA9 \xE6\x97\xA5\xE6\x9C\xAC");
+    log.stop();
+
+    LogTargets missing;
+    missing.file = file.parent_path() / "LogSinkTest.no-such-dir" / "log.txt";
+    CHECK(!log.start(missing));               // the sink still runs without the file
+    log.push(L"dropped");
+    log.flush();
+    log.stop();
+}
+
+void CheckBeforeStart(const fs::path& file) {
+    fs::remove(file);
+    LogSink log;
+    for (int i = 0; i < 3; ++i) log.push(L"early " + std::to_wstring(i));
+    LogTargets targets;
+    targets.file = file;
+    CHECK(log.start(targets));
+    log.push(L"running");
+    log.flush();
+    CHECK((FileLines(file) == std::vector<std::string>{ "early 0", "early 1", "early 2", "running" }));
+    log.stop();
+    log.push(L"after stop");                  // kept until the sink runs again
+    CHECK(FileLines(file).size() == 4);
+    CHECK(log.start(targets));
+    log.flush();
+    CHECK(FileLines(file).size() == 5 && FileLines(file).back() == "after stop");
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const int per_producer = argc > 1 ? (std::max)(1, std::atoi(argv[1])) : 200000;
+    const fs::path file = fs::absolute("LogSinkTest.log");
+    CheckOrder(file, (std::min)(per_producer, 20000));
+    CheckFlush(file);
+    CheckBeforeStart(file);
+
+    // Push cost with the sink writing to a file behind the producers, best of three.
+    double push_ms = 1e300, drain_ms = 1e300;
+    for (int run = 0; run < 3; ++run) {
+        fs::remove(file);
+        LogSink log;
+        LogTargets targets;
+        targets.file = file;
+        CHECK(log.start(targets));
+        Clock::time_point t = Clock::now();
+        Produce(log, PRODUCERS, per_producer);
+        push_ms = (std::min)(push_ms, MsSince(t));
+        log.flush();
+        drain_ms = (std::min)(drain_ms, MsSince(t));
+        CHECK(FileLines(file).size() == size_t(PRODUCERS) * per_producer);
+    }
+    std::printf("%u producers x %d lines: pushed in %.2f ms (%.0f ns/line), in the file after %.2f ms\n",
+        PRODUCERS, per_producer, push_ms, push_ms * 1e6 / (double(PRODUCERS) * per_producer), drain_ms);
+    fs::remove(file);
+    return TestExit("LogSinkTest");
+}
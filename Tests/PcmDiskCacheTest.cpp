@@ -0,0 +1,138 @@
+// PcmDiskCacheTest.cpp
+// PcmDiskCache in a folder of its own under the build directory, with a cap of a few
+// entries:
+//   - store -> find gives the samples, rate and channels back, from this instance, from
+//     a second one opened on the folder, and from one that only saw the entry appear
+//     after it opened; load_or_decode decodes a key once;
+//   - a truncated entry, one with a bad magic and one filed under another key's name are
+//     dropped (file removed, no longer counted) instead of served;
+//   - going past the cap drops the least recently used entries until the folder is at or
+//     under 90% of it, both on store and when open() finds an oversized folder.
+// Then storing and finding entries is timed.
+//   PcmDiskCacheTest [entries for the timing run, default 2000]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "../Common/PcmDiskCache.h"
+#include "Check.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+using Clock = std::chrono::steady_clock;
+double MsSince(Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); }
+
+const size_t SAMPLES = 1000;   // mono: one entry is 32 + 2000 bytes
+const uint64_t ENTRY_BYTES = CachedPcm::HEADER_SIZE + SAMPLES * 2;
+
+PcmBuffer Sound(uint64_t key) {
+    PcmBuffer p;
+    p.sample_rate = 22050 + static_cast<uint32_t>(key); p.channels = 1;
+    p.samples.resize(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; ++i) p.samples[i] = static_cast<int16_t>(key * 1000 + i);
+    return p;
+}
+
+bool Holds(PcmDiskCache& c, uint64_t key) {
+    CachedPcm hit;
+    if (!c.find(key, hit)) return false;
+    PcmBuffer got;
+    hit.copy_to(got);
+    const PcmBuffer want = Sound(key);
+    return hit.frames() == SAMPLES && got.sample_rate == want.sample_rate && got.channels == 1 && got.samples == want.samples;
+}
+
+fs::path EntryPath(const fs::path& dir, uint64_t key) {
+    char name[24];
+    snprintf(name, sizeof(name), "%016llx.pcm", static_cast<unsigned long long>(key));
+    return dir / name;
+}
+
+void CheckRoundTrip(const fs::path& dir) {
+    PcmDiskCache c(dir, 100 * ENTRY_BYTES);
+    CHECK(c.is_open() && c.entry_count() == 0);
+    for (uint64_t k = 1; k <= 3; ++k) CHECK(c.store(k, Sound(k)));
+    CHECK(Holds(c, 1) && Holds(c, 2) && Holds(c, 3) && !Holds(c, 4));
+    CHECK(c.entry_count() == 3 && c.total_bytes() == 3 * ENTRY_BYTES);
+
+    PcmDiskCache other(dir, 100 * ENTRY_BYTES);   // indexes what is already there
+    CHECK(other.entry_count() == 3 && Holds(other, 2));
+    CHECK(c.store(4, Sound(4)));                  // written after 'other' opened
+    CHECK(Holds(other, 4) && other.entry_count() == 4);
+
+    int decodes = 0;
+    auto decode = [&](PcmBuffer& p) { ++decodes; p = Sound(5); return true; };
+    PcmBuffer a, b;
+    CHECK(c.load_or_decode(5, a, decode) && c.load_or_decode(5, b, decode));
+    CHECK(decodes == 1 && a.samples == b.samples && a.sample_rate == Sound(5).sample_rate);
+    CHECK(!c.load_or_decode(6, a, [](PcmBuffer&) { return false; }) && !Holds(c, 6));
+}
+
+void CheckDamaged(const fs::path& dir) {
+    PcmDiskCache c(dir, 100 * ENTRY_BYTES);
+    for (uint64_t k = 1; k <= 4; ++k) CHECK(c.store(k, Sound(k)));
+    fs::resize_file(EntryPath(dir, 1), ENTRY_BYTES - 1);
+    { std::fstream f(EntryPath(dir, 2), std::ios::binary | std::ios::in | std::ios::out); f.put('X'); }
+    fs::copy_file(EntryPath(dir, 3), EntryPath(dir, 9));
+    PcmDiskCache fresh(dir, 100 * ENTRY_BYTES);
+    CHECK(fresh.entry_count() == 5);
+    for (uint64_t k : { 1, 2, 9 }) {
+        CHECK(!Holds(fresh, k));
+        CHECK(!fs::exists(EntryPath(dir, k)));
+    }
+    CHECK(Holds(fresh, 3) && Holds(fresh, 4));
+    CHECK(fresh.entry_count() == 2 && fresh.total_bytes() == 2 * ENTRY_BYTES);
+}
+
+void CheckTrim(const fs::path& dir) {
+    // Ten entries fill the cap exactly; the eleventh drops the two oldest (90% = 9 entries).
+    {
+        PcmDiskCache c(dir, 10 * ENTRY_BYTES);
+        for (uint64_t k = 0; k < 10; ++k) CHECK(c.store(k, Sound(k)));
+        CHECK(c.entry_count() == 10 && c.total_bytes() == c.cap());
+        CHECK(c.store(10, Sound(10)));
+        CHECK(c.entry_count() == 9 && c.total_bytes() <= c.cap() / 10 * 9);
+        CHECK(!fs::exists(EntryPath(dir, 0)) && !fs::exists(EntryPath(dir, 1)));
+        for (uint64_t k = 2; k <= 10; ++k) CHECK(Holds(c, k));
+    }
+    // Recency is the file time: make 7, 3 and 9 the oldest, then open with room for six.
+    const fs::file_time_type now = fs::file_time_type::clock::now();
+    uint64_t age = 0;
+    for (uint64_t k : { 7, 3, 9, 2, 4, 5, 6, 8, 10 }) fs::last_write_time(EntryPath(dir, k), now - std::chrono::hours(100 - age++));
+    PcmDiskCache c(dir, ENTRY_BYTES * 60 / 9 + 10);   // 90% of it holds six entries, not seven
+    CHECK(c.entry_count() == 6 && c.total_bytes() <= c.cap() / 10 * 9);
+    for (uint64_t k : { 7, 3, 9 }) CHECK(!fs::exists(EntryPath(dir, k)));
+    for (uint64_t k : { 2, 4, 5, 6, 8, 10 }) CHECK(Holds(c, k));
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const int entries = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const fs::path dir = "PcmDiskCacheTest.cache";
+    for (void (*check)(const fs::path&) : { CheckRoundTrip, CheckDamaged, CheckTrim }) {
+        fs::remove_all(dir);
+        check(dir);
+    }
+
+    fs::remove_all(dir);
+    PcmDiskCache c(dir);
+    std::vector<PcmBuffer> sounds;
+    for (int i = 0; i < entries; ++i) sounds.push_back(Sound(static_cast<uint64_t>(i)));
+    Clock::time_point t = Clock::now();
+    for (int i = 0; i < entries; ++i) c.store(static_cast<uint64_t>(i) + 1000, sounds[i]);
+    const double store_ms = MsSince(t);
+    t = Clock::now();
+    int found = 0;
+    for (int i = 0; i < entries; ++i) { CachedPcm hit; found += c.find(static_cast<uint64_t>(i) + 1000, hit); }
+    const double find_ms = MsSince(t);
+    CHECK(found == entries);
+    std::printf("%d entries of %llu bytes: store %.2f ms, find %.2f ms\n", entries,
+        static_cast<unsigned long long>(ENTRY_BYTES), store_ms, find_ms);
+    fs::remove_all(dir);
+    return TestExit("PcmDiskCacheTest");
+}
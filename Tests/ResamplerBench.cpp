@@ -0,0 +1,122 @@
+// ResamplerBench.cpp
+// Throughput and quality of each Resampler preset on the rate pairs the encoders see.
+// For every pair: input Msamples/s, SNR of a resampled 1 kHz sine against the ideal sine
+// at the output rate, and (when downsampling) the level of a tone above the output Nyquist
+// rate that folds back into the band. Fails if a preset drops below its quality floor,
+// if an output length differs from OutputLength(), or if streamed output in random block
+// sizes differs from Resample() on the whole buffer.
+//   ResamplerBench [seconds of signal per run, default 20]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../Common/Resampler.h"
+#include "Check.h"
+
+namespace {
+constexpr double PI = 3.14159265358979323846;
+constexpr double AMP = 16384.0;
+constexpr size_t EDGE = 1000;   // filter start-up and tail, left out of the measurements
+
+std::vector<int16_t> Sine(double freq, uint32_t rate, size_t n) {
+    std::vector<int16_t> x(n);
+    for (size_t i = 0; i < n; ++i) x[i] = static_cast<int16_t>(AMP * std::sin(2 * PI * freq * i / rate));
+    return x;
+}
+
+// Level of one frequency in dB relative to AMP, by projecting onto sin/cos.
+double ToneDb(const std::vector<int16_t>& y, double freq, uint32_t rate) {
+    double c = 0, s = 0;
+    size_t n = 0;
+    for (size_t i = EDGE; i + EDGE < y.size(); ++i, ++n) {
+        c += y[i] * std::cos(2 * PI * freq * i / rate);
+        s += y[i] * std::sin(2 * PI * freq * i / rate);
+    }
+    return 20 * std::log10(2 * std::sqrt(c * c + s * s) / n / AMP + 1e-12);
+}
+
+double SineSnrDb(const std::vector<int16_t>& y, double freq, uint32_t rate) {
+    double err = 0;
+    size_t n = 0;
+    for (size_t i = EDGE; i + EDGE < y.size(); ++i, ++n) {
+        const double d = y[i] - AMP * std::sin(2 * PI * freq * i / rate);
+        err += d * d;
+    }
+    return 10 * std::log10((AMP * AMP / 2) / (err / n));
+}
+
+struct Floor { double snr_db, alias_db; };
+
+Floor QualityFloor(ResampleQuality q) {
+    switch (q) {
+    case ResampleQuality::Fast: return { 50.0, -45.0 };
+    case ResampleQuality::Balanced: return { 70.0, -70.0 };
+    default: return { 80.0, -85.0 };
+    }
+}
+
+const char* QualityName(ResampleQuality q) {
+    switch (q) {
+    case ResampleQuality::Fast: return "Fast";
+    case ResampleQuality::Balanced: return "Balanced";
+    default: return "Best";
+    }
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 20.0;
+    const struct { uint32_t src, dst; } pairs[] = { { 44100, 32000 }, { 48000, 32000 }, { 22050, 32000 }, { 32000, 32000 } };
+    const ResampleQuality presets[] = { ResampleQuality::Fast, ResampleQuality::Balanced, ResampleQuality::Best };
+
+    std::printf("%-13s %-8s %10s %9s %9s\n", "rates", "preset", "Msamp/s", "SNR dB", "alias dB");
+    for (const auto& p : pairs) {
+        const size_t n = static_cast<size_t>(p.src * seconds);
+        const std::vector<int16_t> tone = Sine(1000.0, p.src, n);
+        // Above the output Nyquist rate, between it and the input one: must be filtered out.
+        const double high = p.dst * 0.5 + (p.src * 0.5 - p.dst * 0.5) * 0.6;
+        const std::vector<int16_t> above = p.src > p.dst ? Sine(high, p.src, n) : std::vector<int16_t>();
+
+        for (ResampleQuality q : presets) {
+            const auto t0 = std::chrono::steady_clock::now();
+            const std::vector<int16_t> y = Resample(tone.data(), n, p.src, p.dst, q);
+            const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            CHECK(y.size() == PolyphaseResampler::OutputLength(n, p.src, p.dst));
+
+            const Floor floor = QualityFloor(q);
+            const double snr = SineSnrDb(y, 1000.0, p.dst);
+            CHECK(snr >= floor.snr_db);
+            CHECK(std::fabs(ToneDb(y, 1000.0, p.dst)) < 0.1);
+
+            char alias_text[16] = "-";
+            if (!above.empty()) {
+                const std::vector<int16_t> w = Resample(above.data(), n, p.src, p.dst, q);
+                const double alias = ToneDb(w, p.dst - high, p.dst);
+                CHECK(alias <= floor.alias_db);
+                std::snprintf(alias_text, sizeof(alias_text), "%.1f", alias);
+            }
+            std::printf("%5u->%-6u %-8s %10.1f %9.1f %9s\n", p.src, p.dst, QualityName(q), n / sec / 1e6, snr, alias_text);
+        }
+    }
+
+    // Streaming in uneven blocks gives the same samples as one whole-buffer call.
+    std::mt19937 rng(1);
+    std::vector<int16_t> noise(100000);
+    for (auto& s : noise) s = static_cast<int16_t>(static_cast<int>(rng() % 20000) - 10000);
+    const std::vector<int16_t> whole = Resample(noise.data(), noise.size(), 44100, 32000);
+    PolyphaseResampler r(44100, 32000);
+    std::vector<int16_t> streamed;
+    for (size_t i = 0; i < noise.size();) {
+        const size_t block = (std::min)(static_cast<size_t>(1 + rng() % 777), noise.size() - i);
+        r.process(&noise[i], block, streamed);
+        i += block;
+    }
+    r.flush(streamed);
+    CHECK(streamed == whole);
+
+    return TestExit("ResamplerBench");
+}
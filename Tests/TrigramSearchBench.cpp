@@ -0,0 +1,135 @@
+// TrigramSearchBench.cpp
+// Search-box benchmark for TrigramIndex, moved out of FloGui. Indexes at least 100k rows
+// (event names joined with their resolved filenames, as FloGui does; a loaded .flo is
+// repeated with each copy renamed so rows stay distinct) and times queries of 3-10
+// characters cut from random names and filenames against a plain scan of the folded
+// texts. Every query's hits must equal the scan's.
+//   TrigramSearchBench [rows, default 100000] [queries, default 500] [.flo to take rows from]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cwctype>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../Common/FloResolve.h"
+#include "../Common/TrigramIndex.h"
+#include "Check.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+double MsSince(Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); }
+
+// Name + filenames of every Pre/Pos event in a .flo.
+std::vector<std::wstring> RowsFromFlo(const char* path) {
+    std::vector<std::wstring> texts;
+    flo::Model m;
+    if (!flo::ParseFile(path, m)) return texts;
+    flo::Expansion ex;
+    flo::ResolveEventMaps(m, ex);
+    for (size_t r = 0; r < m.maps.size(); ++r) {
+        if (m.maps.sub[r] == flo::SUB_PAN) continue;
+        std::wstring text = flo::Widen(m.maps.name[r]);
+        for (uint32_t k = ex.first[r]; k < ex.first[r] + ex.count[r]; ++k) {
+            if (ex.sdf_row[k] < 0) continue;
+            text += TrigramIndex::FIELD_SEPARATOR;
+            text += flo::Widen(m.sdf.filename[ex.sdf_row[k]]);
+        }
+        texts.push_back(std::move(text));
+    }
+    return texts;
+}
+
+// Level-like names ("EV*Grp12_Name345") with one to three sound files each.
+std::vector<std::wstring> SyntheticRows(size_t n) {
+    std::mt19937 rng(7);
+    std::vector<std::wstring> texts(n);
+    wchar_t buf[64];
+    for (size_t i = 0; i < n; ++i) {
+        std::swprintf(buf, 64, L"EV*Grp%u_Name%zu", static_cast<unsigned>(rng() % 40), i);
+        texts[i] = buf;
+        for (unsigned f = 0, files = 1 + rng() % 3; f < files; ++f) {
+            std::swprintf(buf, 64, L"Snd_%05u.WAV", static_cast<unsigned>(rng() % 50000));
+            texts[i] += TrigramIndex::FIELD_SEPARATOR;
+            texts[i] += buf;
+        }
+    }
+    return texts;
+}
+
+std::wstring Fold(std::wstring_view s) {
+    std::wstring out(s);
+    for (wchar_t& c : out) c = static_cast<wchar_t>(towlower(c));
+    return out;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t min_rows = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 100000;
+    const int queries = argc > 2 ? std::atoi(argv[2]) : 500;
+
+    std::vector<std::wstring> base = argc > 3 ? RowsFromFlo(argv[3]) : SyntheticRows(min_rows);
+    if (base.empty()) { std::printf("no rows to index\n"); return 1; }
+    const size_t rows = (std::max)(base.size(), min_rows);
+    std::vector<std::wstring> texts(rows), folded(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        texts[i] = base[i % base.size()];
+        if (i >= base.size()) texts[i] += L"_copy" + std::to_wstring(i / base.size());
+        folded[i] = Fold(texts[i]);
+    }
+
+    TrigramIndex index;
+    Clock::time_point t = Clock::now();
+    for (size_t i = 0; i < rows; ++i) index.set(static_cast<uint32_t>(i), texts[i]);
+    const double build_ms = MsSince(t);
+
+    std::mt19937 rng(12345);
+    double total_ms = 0, worst_ms = 0, scan_ms = 0;
+    int under_1ms = 0, ran = 0;
+    size_t hits = 0;
+    for (int attempt = 0; ran < queries && attempt < queries * 20; ++attempt) {
+        // Cut the query from one field (name or a filename) of a random row
+        std::wstring_view text = texts[rng() % rows];
+        std::vector<std::wstring_view> fields;
+        for (size_t from = 0;;) {
+            const size_t sep = text.find(TrigramIndex::FIELD_SEPARATOR, from);
+            fields.push_back(text.substr(from, sep == std::wstring_view::npos ? std::wstring_view::npos : sep - from));
+            if (sep == std::wstring_view::npos) break;
+            from = sep + 1;
+        }
+        const std::wstring_view src = fields[rng() % fields.size()];
+        if (src.size() < 3) continue;
+        ++ran;
+        const size_t len = 3 + rng() % (std::min<size_t>)(src.size() - 2, 8);
+        const size_t at = rng() % (src.size() - len + 1);
+        const std::wstring query(src.substr(at, len));
+
+        t = Clock::now();
+        std::vector<uint32_t> found = index.search(query);
+        const double ms = MsSince(t);
+        total_ms += ms;
+        worst_ms = (std::max)(worst_ms, ms);
+        if (ms < 1.0) ++under_1ms;
+        hits += found.size();
+
+        t = Clock::now();
+        const std::wstring needle = Fold(query);
+        std::vector<uint32_t> expected;
+        for (size_t i = 0; i < rows; ++i) {
+            if (folded[i].find(needle) != std::wstring::npos) expected.push_back(static_cast<uint32_t>(i));
+        }
+        scan_ms += MsSince(t);
+        std::sort(found.begin(), found.end());
+        CHECK(found == expected);
+    }
+
+    const int n = (std::max)(ran, 1);
+    std::printf("rows indexed: %zu (%zu trigrams), build %.1f ms\n", rows, index.key_count(), build_ms);
+    std::printf("%d queries of 3-10 characters: average %.3f ms, worst %.3f ms, under 1 ms %d / %d, average hits %zu\n",
+        ran, total_ms / n, worst_ms, under_1ms, ran, hits / n);
+    std::printf("plain scan of the folded texts: average %.3f ms\n", scan_ms / n);
+    return TestExit("TrigramSearchBench");
+}
@@ -0,0 +1,203 @@
+// WavIngestTest.cpp
+// ParseWavFormat + ReadWavPlanar on generated WAVs:
+//   - every accepted layout (8/16/24/32-bit PCM, 32/64-bit float, EXTENSIBLE wrappers)
+//     lands within its quantisation step of the source signal;
+//   - 16-bit stereo and mono -> stereo are bit-exact, with or without dither;
+//   - 5.1 -> stereo / mono and stereo -> mono follow the fold rules (centre and surrounds
+//     at -3 dB, LFE dropped, rows scaled back to unity);
+//   - a data chunk cut short keeps the whole frames that are there;
+//   - for many channel counts and odd lengths, the output equals a plain per-channel
+//     reference (one strided pass per output channel, same dither sequence).
+//   WavIngestTest [seconds for the timing run, default 60]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../Common/WavIngest.h"
+#include "Check.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+double MsSince(Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); }
+
+void Put(std::vector<uint8_t>& v, uint64_t x, int bytes) { for (int i = 0; i < bytes; ++i) v.push_back(static_cast<uint8_t>(x >> (8 * i))); }
+
+// A WAV of interleaved samples in [-1, 1). mask != 0 writes WAVE_FORMAT_EXTENSIBLE.
+std::vector<uint8_t> MakeWav(uint16_t tag, uint16_t channels, uint16_t bits, uint32_t mask, const std::vector<double>& s) {
+    std::vector<uint8_t> d;
+    for (double x : s) {
+        if (tag == WAVE_FORMAT_FLOAT_TAG && bits == 32) { const float f = static_cast<float>(x); uint32_t u; memcpy(&u, &f, 4); Put(d, u, 4); }
+        else if (tag == WAVE_FORMAT_FLOAT_TAG) { uint64_t u; memcpy(&u, &x, 8); Put(d, u, 8); }
+        else if (bits == 8) Put(d, static_cast<uint8_t>(std::lround(x * 127 + 128)), 1);
+        else Put(d, static_cast<uint64_t>(std::llround(x * ((1LL << (bits - 1)) - 1))), bits / 8);
+    }
+    std::vector<uint8_t> f = { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E', 'L', 'I', 'S', 'T', 4, 0, 0, 0, 1, 2, 3, 0 };
+    const bool ext = mask != 0;
+    f.insert(f.end(), { 'f', 'm', 't', ' ' });
+    Put(f, ext ? 40 : 16, 4); Put(f, ext ? WAVE_FORMAT_EXTENSIBLE_TAG : tag, 2); Put(f, channels, 2);
+    Put(f, 44100, 4); Put(f, 44100u * channels * bits / 8, 4); Put(f, channels * bits / 8, 2); Put(f, bits, 2);
+    if (ext) {
+        Put(f, 22, 2); Put(f, bits, 2); Put(f, mask, 4); Put(f, tag, 2);
+        const uint8_t guid_tail[14] = { 0, 0, 0, 0, 0x10, 0, 0x80, 0, 0, 0xAA, 0, 0x38, 0x9B, 0x71 };
+        f.insert(f.end(), guid_tail, guid_tail + 14);
+    }
+    f.insert(f.end(), { 'd', 'a', 't', 'a' });
+    Put(f, d.size(), 4);
+    f.insert(f.end(), d.begin(), d.end());
+    const uint32_t riff = static_cast<uint32_t>(f.size() - 8);
+    memcpy(&f[4], &riff, 4);
+    return f;
+}
+
+std::vector<std::vector<int16_t>> Read(const std::vector<uint8_t>& file, uint16_t out_channels, WavDither dither = WavDither::None) {
+    WavFormat fmt;
+    CHECK(ParseWavFormat(file.data(), file.size(), fmt));
+    std::vector<std::vector<int16_t>> out(out_channels, std::vector<int16_t>(fmt.frames));
+    std::vector<int16_t*> ptrs;
+    for (auto& o : out) ptrs.push_back(o.data());
+    ReadWavPlanar(fmt, out_channels, ptrs.data(), dither);
+    return out;
+}
+
+// One strided pass per output channel - ReadWavPlanar's behaviour, spelled out plainly.
+std::vector<std::vector<int16_t>> ReferenceRead(const std::vector<uint8_t>& file, uint16_t out_channels, WavDither dither) {
+    using namespace wav_detail;
+    WavFormat fmt;
+    CHECK(ParseWavFormat(file.data(), file.size(), fmt));
+    const uint16_t n = fmt.channels;
+    std::vector<std::vector<int16_t>> out(out_channels, std::vector<int16_t>(fmt.frames));
+    const std::vector<float> m = FoldMatrix(fmt, out_channels);
+    bool folded = false;
+    for (uint16_t o = 0; o < out_channels; ++o) {
+        int nonzero = 0;
+        for (uint16_t c = 0; c < n; ++c) if (m[o * n + c] != 0) ++nonzero;
+        if (nonzero != 1) folded = true;
+        else for (uint16_t c = 0; c < n; ++c) if (m[o * n + c] != 0 && m[o * n + c] != 1.0f) folded = true;
+    }
+    const bool use_dither = dither == WavDither::Tpdf && (fmt.wider_than_16() || folded);
+    TpdfDither tpdf;
+    std::vector<float> inter(BLOCK_FRAMES * n), bus(BLOCK_FRAMES);
+    for (size_t first = 0; first < fmt.frames; first += BLOCK_FRAMES) {
+        const size_t count = (std::min)(BLOCK_FRAMES, fmt.frames - first);
+        ToFloat(fmt, fmt.data + first * fmt.block_align, inter.data(), count * n);
+        for (uint16_t o = 0; o < out_channels; ++o) {
+            for (size_t i = 0; i < count; ++i) {
+                float acc = 0;
+                for (uint16_t c = 0; c < n; ++c) if (m[o * n + c] != 0) acc += inter[i * n + c] * m[o * n + c];
+                bus[i] = acc;
+            }
+            if (use_dither) tpdf.apply(bus.data(), count);
+            Clamp16(bus.data(), count);
+            BusToPcm16(bus.data(), out[o].data() + first, count);
+        }
+    }
+    return out;
+}
+
+double MaxError(const std::vector<int16_t>& got, const std::vector<double>& src, uint16_t channels, uint16_t c, double scale = 32767) {
+    double e = 0;
+    for (size_t i = 0; i < got.size(); ++i) e = (std::max)(e, std::fabs(got[i] - src[i * channels + c] * scale));
+    return e;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 60.0;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> uni(-0.9, 0.9);
+    const size_t frames = 10007;
+    std::vector<double> stereo(frames * 2), mono(frames);
+    for (auto& x : stereo) x = uni(rng);
+    for (auto& x : mono) x = uni(rng);
+
+    // Every layout, read to stereo; 'scale' is the layout's full scale in 16-bit units.
+    const struct { uint16_t tag, bits; uint32_t mask; double scale, tolerance; const char* name; } layouts[] = {
+        { WAVE_FORMAT_PCM_TAG, 8, 0, 127 * 256.0, 128.5, "u8" },
+        { WAVE_FORMAT_PCM_TAG, 16, 0, 32767, 0.51, "s16" },
+        { WAVE_FORMAT_PCM_TAG, 24, 0, 8388607 / 256.0, 0.51, "s24" },
+        { WAVE_FORMAT_PCM_TAG, 32, 0, 2147483647 / 65536.0, 0.51, "s32" },
+        { WAVE_FORMAT_FLOAT_TAG, 32, 0, 32768, 0.51, "f32" },
+        { WAVE_FORMAT_FLOAT_TAG, 64, 0, 32768, 0.51, "f64" },
+        { WAVE_FORMAT_PCM_TAG, 24, 3, 8388607 / 256.0, 0.51, "ext s24" },
+        { WAVE_FORMAT_FLOAT_TAG, 32, 3, 32768, 0.51, "ext f32" },
+    };
+    for (const auto& l : layouts) {
+        const auto out = Read(MakeWav(l.tag, 2, l.bits, l.mask, stereo), 2);
+        CHECK(out[0].size() == frames);
+        const double e = (std::max)(MaxError(out[0], stereo, 2, 0, l.scale), MaxError(out[1], stereo, 2, 1, l.scale));
+        if (!(e <= l.tolerance)) std::printf("%s: max error %.2f LSB\n", l.name, e);
+        CHECK(e <= l.tolerance);
+    }
+
+    // 16-bit pass-through and mono -> stereo are exact, dither or not.
+    {
+        const std::vector<uint8_t> s16 = MakeWav(WAVE_FORMAT_PCM_TAG, 2, 16, 0, stereo), m16 = MakeWav(WAVE_FORMAT_PCM_TAG, 1, 16, 0, mono);
+        const auto plain = Read(s16, 2), dithered = Read(s16, 2, WavDither::Tpdf);
+        CHECK(plain == dithered);
+        CHECK(MaxError(plain[0], stereo, 2, 0) <= 0.51 && MaxError(plain[1], stereo, 2, 1) <= 0.51);
+        const auto dup = Read(m16, 2, WavDither::Tpdf);
+        CHECK(dup[0] == dup[1]);
+        CHECK(MaxError(dup[0], mono, 1, 0) <= 0.51);
+    }
+
+    // Folds.
+    {
+        const double h = std::sqrt(0.5);
+        std::vector<double> six(frames * 6, 0.0);
+        for (size_t i = 0; i < frames; ++i) { six[i * 6 + 0] = 0.5; six[i * 6 + 2] = 0.4; six[i * 6 + 3] = 0.9; six[i * 6 + 5] = -0.3; }
+        const std::vector<uint8_t> surround = MakeWav(WAVE_FORMAT_PCM_TAG, 6, 16, 0x3F, six);
+        const auto st = Read(surround, 2);
+        const double l = (0.5 + 0.4 * h) / (1 + 2 * h) * 32767, r = (0.4 * h - 0.3 * h) / (1 + 2 * h) * 32767;   // LFE (0.9) dropped
+        CHECK(std::fabs(st[0][100] - l) <= 1 && std::fabs(st[1][100] - r) <= 1);
+        const auto mid = Read(surround, 1);
+        CHECK(std::fabs(mid[0][100] - (l + r) / 2) <= 1);
+
+        const auto down = Read(MakeWav(WAVE_FORMAT_PCM_TAG, 2, 16, 0, stereo), 1);
+        double e = 0;
+        for (size_t i = 0; i < frames; ++i) e = (std::max)(e, std::fabs(down[0][i] - (stereo[2 * i] + stereo[2 * i + 1]) * 0.5 * 32767));
+        CHECK(e <= 1.01);
+    }
+
+    // A data chunk cut short keeps its whole frames.
+    {
+        std::vector<uint8_t> cut = MakeWav(WAVE_FORMAT_PCM_TAG, 2, 16, 0, stereo);
+        cut.resize(cut.size() - 3);
+        WavFormat fmt;
+        CHECK(ParseWavFormat(cut.data(), cut.size(), fmt));
+        CHECK(fmt.frames == frames - 1);
+    }
+
+    // Same samples as the per-channel reference for every channel count and output width.
+    for (uint16_t channels : { 1, 2, 3, 4, 5, 6, 8 }) {
+        for (const size_t n : { size_t(1), size_t(3), size_t(4097), size_t(9001) }) {
+            std::vector<double> s(n * channels);
+            for (auto& x : s) x = uni(rng);
+            for (uint16_t bits : { 16, 24 }) {
+                const std::vector<uint8_t> wav = MakeWav(WAVE_FORMAT_PCM_TAG, channels, bits, 0, s);
+                for (uint16_t out : { 1, 2 }) {
+                    for (WavDither d : { WavDither::None, WavDither::Tpdf }) CHECK(Read(wav, out, d) == ReferenceRead(wav, out, d));
+                }
+            }
+        }
+    }
+
+    // Timing: stereo float and 5.1 16-bit, both to stereo with dither.
+    {
+        const size_t n = static_cast<size_t>(44100 * seconds);
+        std::vector<double> s2(n * 2), s6(n * 6);
+        for (auto& x : s2) x = uni(rng);
+        for (auto& x : s6) x = uni(rng) * 0.4;
+        const std::vector<uint8_t> f32 = MakeWav(WAVE_FORMAT_FLOAT_TAG, 2, 32, 0, s2), pcm6 = MakeWav(WAVE_FORMAT_PCM_TAG, 6, 16, 0x3F, s6);
+        Clock::time_point t = Clock::now();
+        Read(f32, 2, WavDither::Tpdf);
+        const double f32_ms = MsSince(t);
+        t = Clock::now();
+        Read(pcm6, 2, WavDither::Tpdf);
+        std::printf("%.0f s at 44.1 kHz: float stereo %.1f ms, 16-bit 5.1 -> stereo %.1f ms\n", seconds, f32_ms, MsSince(t));
+    }
+    return TestExit("WavIngestTest");
+}
@@ -0,0 +1,105 @@
+// WavWriterTest.cpp
+// WavWriter output read back through ParseWavFormat. The plain-RIFF limit is lowered to
+// 1 MiB of sample data so the RF64 path runs on a few megabytes instead of 4 GB:
+//   - WriteWavFile with a known length gives the canonical 44-byte header;
+//   - a streamed file of unknown length that stays under the limit is RIFF with a JUNK
+//     chunk, and readers skip it;
+//   - one that grows past the limit becomes RF64, with the riff/data sizes and frame count
+//     in ds64 and 0xFFFFFFFF in the 32-bit fields;
+//   - a stated length that turns out too small for RIFF makes close() fail;
+// and in every readable case the samples come back unchanged.
+//   WavWriterTest [megabytes of samples for the RF64 file, default 3]
+
+#define WAVWRITER_MAX_RIFF_DATA (1ull << 20)
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include "../Common/MappedFile.h"
+#include "../Common/WavIngest.h"
+#include "../Common/WavWriter.h"
+#include "Check.h"
+
+namespace {
+uint32_t Le32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+uint64_t Le64(const uint8_t* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+
+std::vector<int16_t> Samples(size_t n) {
+    std::vector<int16_t> s(n);
+    for (size_t i = 0; i < n; ++i) s[i] = static_cast<int16_t>(i * 7 + (i >> 9));
+    return s;
+}
+
+// Streams 's' in uneven blocks; expected_frames as for WavWriter::open.
+bool Stream(const std::filesystem::path& path, const std::vector<int16_t>& s, uint16_t channels, uint64_t expected_frames) {
+    WavWriter w;
+    if (!w.open(path, 32000, channels, expected_frames)) return false;
+    std::mt19937 rng(1);
+    bool ok = true;
+    for (size_t i = 0; i < s.size();) {
+        const size_t block = (std::min)(channels * static_cast<size_t>(1 + rng() % 4000), s.size() - i);
+        ok = w.write(s.data() + i, block) && ok;
+        i += block;
+    }
+    CHECK(w.frames() == s.size() / channels);
+    return w.close() && ok;
+}
+
+// Parses 'path' and compares its samples with 's'. Returns the file's header bytes.
+size_t ReadBack(const std::filesystem::path& path, const std::vector<int16_t>& s, uint16_t channels) {
+    MappedFile m(path);
+    CHECK(m.is_open());
+    WavFormat fmt;
+    CHECK(ParseWavFormat(m.data(), m.size(), fmt));
+    CHECK(fmt.format == WAVE_FORMAT_PCM_TAG && fmt.bits == 16 && fmt.channels == channels && fmt.sample_rate == 32000);
+    CHECK(fmt.frames == s.size() / channels);
+    CHECK(fmt.data && memcmp(fmt.data, s.data(), s.size() * 2) == 0);
+    return fmt.data ? static_cast<size_t>(fmt.data - m.data()) : 0;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    const double mb = argc > 1 ? std::atof(argv[1]) : 3.0;
+    const std::filesystem::path path = "WavWriterTest.wav";
+
+    // Known length: canonical header, nothing reserved.
+    const std::vector<int16_t> small = Samples(44100 * 2);
+    CHECK(WriteWavFile(path, small.data(), small.size(), 32000, 2));
+    CHECK(ReadBack(path, small, 2) == 44);
+    CHECK(std::filesystem::file_size(path) == 44 + small.size() * 2);
+
+    // Unknown length, under the limit: RIFF with the JUNK chunk left in place.
+    CHECK(Stream(path, small, 2, 0));
+    CHECK(ReadBack(path, small, 2) == 80);
+    {
+        MappedFile m(path);
+        CHECK(memcmp(m.data(), "RIFF", 4) == 0 && memcmp(m.data() + 12, "JUNK", 4) == 0);
+        CHECK(Le32(m.data() + 4) == m.size() - 8);
+    }
+
+    // Unknown length, past the limit: RF64 with the real sizes in ds64.
+    const std::vector<int16_t> big = Samples(static_cast<size_t>(mb * (1 << 20) / 2) / 3 * 3);
+    CHECK(big.size() * 2 > WAVWRITER_MAX_RIFF_DATA);
+    CHECK(Stream(path, big, 3, 0));
+    CHECK(ReadBack(path, big, 3) == 80);
+    {
+        MappedFile m(path);
+        const uint8_t* h = m.data();
+        CHECK(memcmp(h, "RF64", 4) == 0 && Le32(h + 4) == 0xFFFFFFFFu);
+        CHECK(memcmp(h + 12, "ds64", 4) == 0 && Le32(h + 16) == 28);
+        CHECK(Le64(h + 20) == m.size() - 8);
+        CHECK(Le64(h + 28) == big.size() * 2);
+        CHECK(Le64(h + 36) == big.size() / 3);
+        CHECK(memcmp(h + 72, "data", 4) == 0 && Le32(h + 76) == 0xFFFFFFFFu);
+    }
+
+    // A stated length that fits RIFF, then more data than RIFF can describe.
+    CHECK(!Stream(path, big, 3, small.size() / 3));
+
+    std::filesystem::remove(path);
+    return TestExit("WavWriterTest");
+}
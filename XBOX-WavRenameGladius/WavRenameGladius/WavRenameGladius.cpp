@@ -19,6 +19,23 @@
 #include <cwctype>
 #include <iomanip>
 #include <cstdint>
+#include <atomic>
+
+#include "../../Common/AsyncIo.h"
+#include "../../Common/EventRenderer.h"
+#include "../../Common/FloIndex.h"
+#include "../../Common/FloParser.h"
+#include "../../Common/Hash.h"
+#include "../../Common/LogSink.h"
+#include "../../Common/MappedFile.h"
+#include "../../Common/PcmCache.h"
+#include "../../Common/PcmDiskCache.h"
+#include "../../Common/Riff.h"
+#include "../../Common/RunMetrics.h"
+#include "../../Common/SoundArchive.h"
+#include "../../Common/ThreadPool.h"
+#include "../../Common/Trace.h"
+#include "../../Common/XboxAdpcm.h"
 
 #pragma comment(lib, "shell32.lib")
 #pragma comment(lib, "ole32.lib")
@@ -33,21 +50,86 @@ namespace fs = std::filesystem;
 #define ID_BUTTON_EXTRACT_RENAME    1003
 #define ID_BUTTON_REPACK            1004
 #define IDC_LOG                     1005
+#define ID_BUTTON_RENDER            1006
+#define WM_APP_LOG                  (WM_APP + 1)   // the log sink has text for the log control
 
 // --- Global Variables ---
 HINSTANCE g_hInst = nullptr;
 HWND g_hLog = nullptr;
+DWORD g_uiThread = 0;
+LogSink g_log;                // every log line goes through here; the control is fed in batches
+constexpr size_t MAX_LOG_CHARS = 1 << 20;   // oldest lines are dropped from the control beyond this
+PcmCache g_pcmCache; // decoded bank entries, shared by every render of the session
+std::atomic<size_t> g_pcmDecodes{ 0 }; // session-cache misses that the on-disk cache could not serve either
 
 // =================================================================================
 // SECTION: HELPER FUNCTIONS
 // =================================================================================
 
-static void AppendLog(const std::wstring& msg) {
-    if (!g_hLog) return;
-    int len = GetWindowTextLengthW(g_hLog);
+// Appends the text the sink has collected to the log control in one EM_REPLACESEL, first
+// dropping whole lines from the top once the control would pass MAX_LOG_CHARS. UI thread only.
+static void DrainLog(bool onlyIfDue) {
+    std::wstring text;
+    if (!g_hLog || !g_log.take_ui(text, onlyIfDue)) return;
+    if (text.size() > MAX_LOG_CHARS) { size_t cut = text.find(L'\n', text.size() - MAX_LOG_CHARS / 2); text.erase(0, cut == std::wstring::npos ? 0 : cut + 1); }
+    size_t len = (size_t)GetWindowTextLengthW(g_hLog);
+    if (len + text.size() > MAX_LOG_CHARS) {
+        const size_t drop = len + text.size() - MAX_LOG_CHARS / 2;
+        const LRESULT line = SendMessageW(g_hLog, EM_LINEFROMCHAR, (WPARAM)(std::min)(drop, len), 0);
+        LRESULT end = SendMessageW(g_hLog, EM_LINEINDEX, (WPARAM)(line + 1), 0);
+        if (end < 0) end = (LRESULT)len;
+        SendMessageW(g_hLog, EM_SETSEL, 0, (LPARAM)end);
+        SendMessageW(g_hLog, EM_REPLACESEL, 0, (LPARAM)L"");
+        len = (size_t)GetWindowTextLengthW(g_hLog);
+    }
     SendMessageW(g_hLog, EM_SETSEL, (WPARAM)len, (LPARAM)len);
-    SendMessageW(g_hLog, EM_REPLACESEL, 0, (LPARAM)msg.c_str());
-    SendMessageW(g_hLog, EM_REPLACESEL, 0, (LPARAM)L"\r\n");
+    SendMessageW(g_hLog, EM_REPLACESEL, 0, (LPARAM)text.c_str());
+}
+
+// Callable from any thread: the line is queued for the sink. On the UI thread (which runs
+// the batches) the control is also refreshed, at most once per sink UI interval.
+static void AppendLog(const std::wstring& msg) {
+    g_log.push(msg);
+    if (GetCurrentThreadId() == g_uiThread) DrainLog(true);
+}
+
+// Everything logged so far, shown now: before a "Done" box or clearing the log.
+static void FlushLog() {
+    g_log.flush();
+    DrainLog(false);
+}
+
+// Flushes the log when a batch's scope ends, so every return path shows its last lines, then
+// shows the closing box set with done() - after the flush, so the box never sits over a log
+// that is still catching up. The one place a batch flushes.
+class FlushLogOnExit {
+public:
+    explicit FlushLogOnExit(HWND hwnd) : m_hwnd(hwnd) {}
+    ~FlushLogOnExit() {
+        FlushLog();
+        if (!m_done.empty()) MessageBoxW(m_hwnd, m_done.c_str(), L"Done", MB_OK);
+    }
+    FlushLogOnExit(const FlushLogOnExit&) = delete;
+    FlushLogOnExit& operator=(const FlushLogOnExit&) = delete;
+
+    void done(std::wstring message) { m_done = std::move(message); }
+
+private:
+    HWND m_hwnd;
+    std::wstring m_done;
+};
+
+// Ends a run's metrics, writes them as JSON into 'dir' (run_metrics_<operation>.json) and logs a one-line summary.
+static void LogRunMetrics(RunMetrics& metrics, const fs::path& dir) {
+    metrics.finish();
+    const fs::path jsonPath = metrics.json_path(dir);
+    const RunTotals t = metrics.totals();
+    std::wstringstream ss;
+    ss << L"Metrics: " << t.files << L" item(s), " << t.failed << L" failed, " << (t.bytes_in >> 20) << L" MB in, " << (t.bytes_out >> 20) << L" MB out, "
+       << std::fixed << std::setprecision(2) << metrics.seconds() << L" s, p95 " << t.percentile_ns(0.95) / 1e6 << L" ms";
+    if (metrics.write_json(jsonPath)) ss << L" -> " << jsonPath.filename().wstring();
+    else ss << L" (could not write " << jsonPath.wstring() << L")";
+    AppendLog(ss.str());
 }
 
 static std::wstring Trim(const std::wstring& s) {
@@ -111,29 +193,6 @@ static std::wstring LowerExt(const fs::path& p) {
     return e;
 }
 
-static int find_fourcc(const uint8_t* buf, size_t len, const char fourcc[4]) {
-    if (len < 4) return -1;
-    for (size_t i = 0; i + 4 <= len; ++i) {
-        if (buf[i + 0] == (uint8_t)fourcc[0] && buf[i + 1] == (uint8_t)fourcc[1] &&
-            buf[i + 2] == (uint8_t)fourcc[2] && buf[i + 3] == (uint8_t)fourcc[3]) {
-            return (int)i;
-        }
-    }
-    return -1;
-}
-
-static bool patch_wav_lengths(std::vector<uint8_t>& wavHeader, uint32_t dataLen) {
-    if (wavHeader.size() < 12) return false;
-    if (memcmp(&wavHeader[0], "RIFF", 4) != 0 || memcmp(&wavHeader[8], "WAVE", 4) != 0)
-        return false;
-    int dataPos = find_fourcc(wavHeader.data(), wavHeader.size(), "data");
-    if (dataPos < 0 || dataPos + 8 >(int)wavHeader.size()) return false;
-    memcpy(&wavHeader[dataPos + 4], &dataLen, 4);
-    uint32_t riffSize = (uint32_t)(wavHeader.size() - 8);
-    memcpy(&wavHeader[4], &riffSize, 4);
-    return true;
-}
-
 static inline std::wstring CsvEscape(const std::wstring& s) {
     std::wstring out = s;
     size_t p = 0;
@@ -150,35 +209,26 @@ struct SoundDataFileEntry { int id{}; char type_char{}; std::string xbb_filename
 struct SimpleEventEntry { int id{}; int sound_data_file_id{}; int param_set_idx{}; int pan_idx{}; };
 struct RandomEventEntry { int id{}; std::vector<int> choices_simple; std::vector<int> choices_sdf; };
 struct CompoundEventEntry { int id{}; struct Comp { int simple_event_id{ -1 }; int sdf_id{ -1 }; float delay{ 0.0f }; }; std::vector<Comp> components; };
-struct EventMapEntry { std::string section_name; int id_col1{}; int type_col2{}; int event_ref_col3{}; std::wstring name_col4; };
+struct EventMapEntry { std::string section_name; int id_col1{}; int type_col2{}; int event_ref_col3{}; std::wstring name_col4; std::vector<int> resolved_sdf, resolved_simple; };
 struct SPSRow { int id{}; std::vector<int> fields; };
 struct SoundParameterSets { std::vector<SPSRow> pre, pan, pos; };
 struct LinkProvenance { int eventmap_id{ -1 }; std::wstring section; int domain{ -1 }; int link_id{ -1 }; std::wstring global_name; int via_simple_id{ -1 }; int via_sdf_id{ -1 }; int appearance_idx{ -1 }; int expansion_size{ -1 }; };
 
+// Fills the lookup maps from the shared parser, or from the level's .flo.idx sidecar when it is current (Common/FloIndex.h).
+// EventMap rows carry their cached SDF expansion (sorted, unique); rows that resolve to nothing are left to ExpandRefWithFallback.
 static bool ParseFlo(const fs::path& floPath, std::map<int, SoundDataFileEntry>& soundDataFiles, std::map<int, SimpleEventEntry>& simpleEvents, std::map<int, RandomEventEntry>& randomEvents, std::map<int, CompoundEventEntry>& compoundEvents, std::vector<EventMapEntry>& eventMaps, SoundParameterSets& sps_out) {
     soundDataFiles.clear(); simpleEvents.clear(); randomEvents.clear(); compoundEvents.clear(); eventMaps.clear(); sps_out = {};
-    std::ifstream in(floPath);
-    if (!in) { AppendLog(L"  Error: Could not open .flo file: " + floPath.wstring()); return false; }
-    std::string line, section, subSection; int entries_to_read = 0, read_in_this_block = 0;
-    auto parse_int_list = [](const std::string& l) { std::vector<int> vals; std::stringstream ss(l); std::string tok; while (std::getline(ss, tok, ',')) { tok = TrimA(tok); if (!tok.empty()) { try { vals.push_back(std::stoi(tok)); } catch (...) {} } } return vals; };
-    auto read_count_line = [&](int& outCount)->bool { std::streampos pos = in.tellg(); std::string cnt; if (!std::getline(in, cnt)) return false; cnt = TrimA(cnt); if (cnt.empty()) { if (!std::getline(in, cnt)) return false; cnt = TrimA(cnt); } try { outCount = std::stoi(cnt); return true; } catch (...) { in.clear(); in.seekg(pos); return false; } };
-    while (std::getline(in, line)) {
-        line = TrimA(line); if (line.empty()) continue;
-        if (entries_to_read > 0) {
-            if (section == "SoundDataFiles") { std::stringstream ss(line); std::string t0, t1, t2; std::getline(ss, t0, ','); std::getline(ss, t1, ','); std::getline(ss, t2); t0 = TrimA(t0); t1 = TrimA(t1); t2 = TrimA(t2); if (!t0.empty() && !t1.empty() && !t2.empty()) { SoundDataFileEntry e{}; e.id = std::stoi(t0); e.type_char = t1.empty() ? ' ' : t1[0]; e.xbb_filename = t2; soundDataFiles[e.id] = e; } }
-            else if (section == "SimpleEvents") { auto v = parse_int_list(line); if (v.size() >= 4) { SimpleEventEntry e{ v[0],v[1],v[2],v[3] }; simpleEvents[e.id] = e; } }
-            else if (section == "RandomEvents") { auto head = parse_int_list(line); if (head.size() >= 2) { RandomEventEntry re{}; re.id = head[0]; int n = head[1]; for (int i = 0; i < n; ++i) { std::string ch; if (!std::getline(in, ch)) break; ch = TrimA(ch); auto vals = parse_int_list(ch); if (vals.empty()) continue; if (vals.size() == 1) { re.choices_sdf.push_back(vals[0]); } else { re.choices_simple.push_back(vals[1]); } } randomEvents[re.id] = std::move(re); } else if (head.size() == 1) { RandomEventEntry re{}; re.id = head[0]; std::string next; if (!std::getline(in, next)) { randomEvents[re.id] = re; continue; } next = TrimA(next); int n = 0; try { n = std::stoi(next); } catch (...) { n = 0; } for (int i = 0; i < n; ++i) { std::string ch; if (!std::getline(in, ch)) break; ch = TrimA(ch); auto vals = parse_int_list(ch); if (vals.empty()) continue; if (vals.size() == 1) re.choices_sdf.push_back(vals[0]); else re.choices_simple.push_back(vals[1]); } randomEvents[re.id] = std::move(re); } }
-            else if (section == "CompoundEvents") { auto head = parse_int_list(line); if (head.size() >= 2) { CompoundEventEntry ce{}; ce.id = head[0]; int n = head[1]; for (int i = 0; i < n; ++i) { std::string comp; if (!std::getline(in, comp)) break; comp = TrimA(comp); auto vals = parse_int_list(comp); if (vals.empty()) continue; CompoundEventEntry::Comp c{}; if (vals.size() == 1) { c.sdf_id = vals[0]; } else { c.simple_event_id = vals[1]; if (vals.size() >= 3) c.delay = (float)vals[2]; } ce.components.push_back(c); } compoundEvents[ce.id] = std::move(ce); } else if (head.size() == 1) { CompoundEventEntry ce{}; ce.id = head[0]; std::string next; if (!std::getline(in, next)) { compoundEvents[ce.id] = ce; continue; } next = TrimA(next); int n = 0; try { n = std::stoi(next); } catch (...) { n = 0; } for (int i = 0; i < n; ++i) { std::string comp; if (!std::getline(in, comp)) break; comp = TrimA(comp); auto vals = parse_int_list(comp); if (vals.empty()) continue; CompoundEventEntry::Comp c{}; if (vals.size() == 1) { c.sdf_id = vals[0]; } else { c.simple_event_id = vals[1]; if (vals.size() >= 3) c.delay = (float)vals[2]; } ce.components.push_back(c); } compoundEvents[ce.id] = std::move(ce); } }
-            else if (section == "SoundParameterSets") { auto vals = parse_int_list(line); if (!vals.empty()) { SPSRow row{}; row.id = vals[0]; if (vals.size() > 1) row.fields.assign(vals.begin() + 1, vals.end()); if (subSection == "Pre") sps_out.pre.push_back(row); else if (subSection == "Pan") sps_out.pan.push_back(row); else if (subSection == "Pos") sps_out.pos.push_back(row); } }
-            else if (section == "EventMaps") { std::stringstream ss(line); std::string t0, t1, t2, t3; std::getline(ss, t0, ','); std::getline(ss, t1, ','); std::getline(ss, t2, ','); std::getline(ss, t3); t0 = TrimA(t0); t1 = TrimA(t1); t2 = TrimA(t2); t3 = TrimA(t3); if (!t0.empty() && !t1.empty() && !t2.empty() && !t3.empty()) { EventMapEntry em{}; em.section_name = subSection; em.id_col1 = std::stoi(t0); em.type_col2 = std::stoi(t1); em.event_ref_col3 = std::stoi(t2); size_t star = t3.find('*'); if (star != std::string::npos) t3 = t3.substr(star + 1); em.name_col4 = s2ws(t3); eventMaps.push_back(std::move(em)); } }
-            if (++read_in_this_block >= entries_to_read) { entries_to_read = 0; read_in_this_block = 0; if (section != "EventMaps" && section != "SoundParameterSets") section.clear(); subSection.clear(); } continue;
-        }
-        if (line == "SoundDataFiles" || line == "SimpleEvents" || line == "RandomEvents" || line == "CompoundEvents" || line == "SoundParameterSets" || line == "EventMaps" || line == "Pre" || line == "Pan" || line == "Pos") {
-            if (line == "Pre" || line == "Pan" || line == "Pos") { if (section == "EventMaps" || section == "SoundParameterSets") { subSection = line; int cnt = 0; if (!read_count_line(cnt)) { AppendLog(L"  Error: Expected count after '" + s2ws(section + " / " + subSection) + L"'"); section.clear(); subSection.clear(); continue; } entries_to_read = cnt; read_in_this_block = 0; } else { AppendLog(L"  Warning: Found subsection '" + s2ws(line) + L"' without active parent header."); subSection.clear(); } }
-            else { section = line; subSection.clear(); if (section == "EventMaps" || section == "SoundParameterSets") continue; std::string cnt; if (!std::getline(in, cnt)) break; cnt = TrimA(cnt); try { entries_to_read = std::stoi(cnt); read_in_this_block = 0; } catch (...) { AppendLog(L"  Error: Expected count after header '" + s2ws(section) + L"', but got: " + s2ws(cnt)); section.clear(); entries_to_read = 0; } }
-        }
-    }
-    in.close(); return true;
+    flo::Model m; flo::Expansion x;
+    if (!flo::LoadOrParse(floPath, m, x)) { AppendLog(L"  Error: Could not open .flo file: " + floPath.wstring()); return false; }
+    for (const auto& w : m.warnings) AppendLog(L"  Warning: " + s2ws(w));
+    for (size_t i = 0; i < m.sdf.size(); ++i) { if (m.sdf.type[i].empty() || m.sdf.filename[i].empty()) continue; SoundDataFileEntry e{}; e.id = m.sdf.id[i]; e.type_char = m.sdf.type[i][0]; e.xbb_filename.assign(m.sdf.filename[i]); soundDataFiles[e.id] = e; }
+    for (size_t i = 0; i < m.simple.size(); ++i) { SimpleEventEntry e{ m.simple.id[i], m.simple.sdf_id[i], m.simple.param_set[i], m.simple.pan[i] }; simpleEvents[e.id] = e; }
+    for (size_t i = 0; i < m.random.size(); ++i) { RandomEventEntry re{}; re.id = m.random.id[i]; for (uint32_t k = m.random.first[i]; k < m.random.first[i] + m.random.count[i]; ++k) { if (m.random.link_arity[k] == 0) continue; if (m.random.link_arity[k] == 1) re.choices_sdf.push_back(m.random.link_a[k]); else re.choices_simple.push_back(m.random.link_b[k]); } randomEvents[re.id] = std::move(re); }
+    for (size_t i = 0; i < m.compound.size(); ++i) { CompoundEventEntry ce{}; ce.id = m.compound.id[i]; for (uint32_t k = m.compound.first[i]; k < m.compound.first[i] + m.compound.count[i]; ++k) { if (m.compound.link_arity[k] == 0) continue; CompoundEventEntry::Comp c{}; if (m.compound.link_arity[k] == 1) { c.sdf_id = m.compound.link_a[k]; } else { c.simple_event_id = m.compound.link_b[k]; c.delay = m.compound.link_delay[k]; } ce.components.push_back(c); } compoundEvents[ce.id] = std::move(ce); }
+    for (size_t i = 0; i < m.sps.size(); ++i) { SPSRow row{}; row.id = m.sps.id[i]; row.fields.assign(m.sps.fields.begin() + m.sps.first[i], m.sps.fields.begin() + m.sps.first[i] + m.sps.count[i]); if (m.sps.sub[i] == flo::SUB_PRE) sps_out.pre.push_back(std::move(row)); else if (m.sps.sub[i] == flo::SUB_PAN) sps_out.pan.push_back(std::move(row)); else sps_out.pos.push_back(std::move(row)); }
+    eventMaps.reserve(m.maps.size());
+    for (size_t i = 0; i < m.maps.size(); ++i) { if (m.maps.name[i].empty()) continue; EventMapEntry em{}; em.section_name = flo::SubSectionName(m.maps.sub[i]); em.id_col1 = m.maps.id[i]; em.type_col2 = m.maps.type[i]; em.event_ref_col3 = m.maps.ref[i]; std::string_view nm = flo::NameAfterStar(m.maps.name[i]); em.name_col4 = s2ws(std::string(nm)); for (uint32_t k = x.first[i]; k < x.first[i] + x.count[i]; ++k) { if (x.sdf_row[k] == flo::ROW_SIMPLE_MISSING) continue; em.resolved_sdf.push_back(x.sdf_id[k]); if (x.simple_id[k] >= 0) em.resolved_simple.push_back(x.simple_id[k]); } std::sort(em.resolved_sdf.begin(), em.resolved_sdf.end()); em.resolved_sdf.erase(std::unique(em.resolved_sdf.begin(), em.resolved_sdf.end()), em.resolved_sdf.end()); std::sort(em.resolved_simple.begin(), em.resolved_simple.end()); em.resolved_simple.erase(std::unique(em.resolved_simple.begin(), em.resolved_simple.end()), em.resolved_simple.end()); eventMaps.push_back(std::move(em)); }
+    return true;
 }
 
 enum { DOMAIN_SIMPLE = 0, DOMAIN_RANDOM = 1, DOMAIN_COMPOUND = 2 };
@@ -193,7 +243,7 @@ static int DomainPriority(int d) { if (d == DOMAIN_SIMPLE) return 0; if (d == DO
 // =================================================================================
 
 // **NEW**: Batch extraction function that takes a path and doesn't prompt the user.
-void BatchExtractAll(const std::wstring& rootPath) {
+void BatchExtractAll(const std::wstring& rootPath, RunMetrics& metrics) {
     AppendLog(L"--- Starting Recursive Batch Audio Extraction ---");
     AppendLog(L"Scanning for .xbb files in: " + rootPath);
     int xbb_files_found = 0;
@@ -201,77 +251,28 @@ void BatchExtractAll(const std::wstring& rootPath) {
         if (!entry.is_regular_file() || LowerExt(entry.path()) != L".xbb") continue;
         xbb_files_found++;
         const fs::path xbbPath = entry.path();
-        fs::path xsbPath = xbbPath; xsbPath.replace_extension(L".xsb");
         AppendLog(L"Processing: " + xbbPath.wstring());
+        TRACE_SCOPE_CAT("extract bank", "batch");
+        RunFile file(metrics);
         fs::path outDir = entry.path().parent_path() / L"extracted";
         std::error_code ec; fs::create_directory(outDir, ec);
-        FILE* fXBB = _wfopen(xbbPath.c_str(), L"rb");
-        if (!fXBB) { AppendLog(L"  Error: Could not open " + xbbPath.filename().wstring()); continue; }
-        FILE* fXSB = _wfopen(xsbPath.c_str(), L"rb");
-        uint64_t xsbSize = 0;
-        if (fXSB) { _fseeki64(fXSB, 0, SEEK_END); xsbSize = _ftelli64(fXSB); _fseeki64(fXSB, 0, SEEK_SET); }
-        uint32_t xbbDeclared = 0, entryCount = 0;
-        fread(&xbbDeclared, 4, 1, fXBB); fread(&entryCount, 4, 1, fXBB);
-        _fseeki64(fXBB, 0, SEEK_END); const uint64_t xbbSize = _ftelli64(fXBB);
-        uint64_t cursor = 8;
-        for (uint32_t i = 0; i < entryCount; ++i) {
-            if (cursor + 8 > xbbSize) break;
-            _fseeki64(fXBB, cursor + 4, SEEK_SET);
-            uint32_t headerLen = 0; fread(&headerLen, 4, 1, fXBB);
-            if (headerLen == 0 || cursor + headerLen + 8 > xbbSize) { cursor += 8; continue; }
-            std::vector<uint8_t> headerBuf(headerLen);
-            _fseeki64(fXBB, cursor, SEEK_SET); fread(headerBuf.data(), 1, headerLen, fXBB);
-            uint8_t tail8[8] = { 0 };
-            _fseeki64(fXBB, cursor + headerLen, SEEK_SET); fread(&tail8[0], 1, 8, fXBB);
-            uint32_t offLE = 0, lenLE = 0;
-            memcpy(&offLE, &tail8[0], 4); memcpy(&lenLE, &tail8[4], 4);
-            int dataPos = find_fourcc(headerBuf.data(), headerBuf.size(), "data");
-            bool isInline = false; bool addTail8 = false; uint32_t headerDataLen = 0;
-            if (dataPos >= 0 && dataPos + 8 <= (int)headerBuf.size()) {
-                memcpy(&headerDataLen, &headerBuf[dataPos + 4], 4);
-                uint64_t dataEnd = (uint64_t)dataPos + 8 + headerDataLen;
-                if (headerDataLen > 0 && dataEnd == headerBuf.size()) isInline = true;
-                if (!isInline && headerDataLen > 0 && dataEnd == headerBuf.size() + 8) { isInline = true; addTail8 = true; }
-                if (headerDataLen >= 0xF0000000) { isInline = false; addTail8 = false; }
-            }
-            bool streamedOK = false; uint64_t off = 0, len = 0;
-            if (!isInline) { off = offLE; len = lenLE; streamedOK = (fXSB != nullptr) && (len > 0) && (off + len <= xsbSize); }
-            wchar_t outPath[MAX_PATH]; swprintf(outPath, MAX_PATH, L"%s\\track_%03u.wav", outDir.wstring().c_str(), i);
-            FILE* out = _wfopen(outPath, L"wb"); if (!out) { cursor += headerLen + 8; continue; }
-            if (isInline) {
-                patch_wav_lengths(headerBuf, headerDataLen);
-                uint32_t riffSz = (uint32_t)(headerBuf.size() - 8 + (addTail8 ? 8 : 0));
-                memcpy(&headerBuf[4], &riffSz, 4);
-                fwrite(headerBuf.data(), 1, headerBuf.size(), out);
-                if (addTail8) fwrite(&tail8[0], 1, 8, out);
-            }
-            else if (streamedOK) {
-                patch_wav_lengths(headerBuf, (uint32_t)len);
-                uint32_t newRiff = (uint32_t)((uint64_t)headerBuf.size() + len - 8);
-                memcpy(&headerBuf[4], &newRiff, 4);
-                fwrite(headerBuf.data(), 1, headerBuf.size(), out);
-                _fseeki64(fXSB, off, SEEK_SET);
-                const size_t BUFSZ = 1 << 20;
-                std::vector<uint8_t> buf(BUFSZ);
-                uint64_t remaining = len;
-                while (remaining) { size_t chunk = (size_t)std::min<uint64_t>(remaining, BUFSZ); size_t got = fread(buf.data(), 1, chunk, fXSB); if (got == 0) break; fwrite(buf.data(), 1, got, out); remaining -= got; }
-            }
-            else {
-                patch_wav_lengths(headerBuf, 0);
-                uint32_t riffSz = (uint32_t)(headerBuf.size() - 8);
-                memcpy(&headerBuf[4], &riffSz, 4);
-                fwrite(headerBuf.data(), 1, headerBuf.size(), out);
-            }
-            fclose(out);
-            cursor += headerLen + 8;
+        file.bytes_in(entry.file_size(ec));
+        // Entry i is SDF id i and extracts as track_i.wav with its lengths patched.
+        SoundArchive bank;
+        if (!bank.open(xbbPath) || !bank.valid()) { file.fail(RunError::Open); AppendLog(L"  Error: Could not open " + xbbPath.filename().wstring()); continue; }
+        ArchiveStream track;
+        RunStageTimer writeTime(RunStage::Write);
+        for (size_t i = 0; i < bank.size(); ++i) {
+            if (!bank.open_entry(i, track)) { file.fail(RunError::Format); continue; }
+            if (WriteArchiveStream(outDir / bank.entry_name(i), track)) file.bytes_out(track.size());
+            else file.fail(RunError::Write);
         }
-        fclose(fXBB); if (fXSB) fclose(fXSB);
     }
     if (xbb_files_found == 0) { AppendLog(L"Extraction pass complete. No .xbb files were found."); }
     else { AppendLog(L"Extraction pass complete. Processed " + std::to_wstring(xbb_files_found) + L" file(s)."); }
 }
 
-void AnalyzeAndRenameWavs(const std::wstring& rootPath) {
+void AnalyzeAndRenameWavs(const std::wstring& rootPath, RunMetrics& metrics) {
     AppendLog(L"--- Starting Recursive WAV Renaming and Analysis ---");
     std::error_code ec;
     for (auto it = fs::recursive_directory_iterator(rootPath, fs::directory_options::skip_permission_denied, ec); it != fs::recursive_directory_iterator(); it.increment(ec)) {
@@ -281,15 +282,20 @@ void AnalyzeAndRenameWavs(const std::wstring& rootPath) {
         AppendLog(L"Processing .flo: " + floPath.wstring());
         fs::path extractedDir = floPath.parent_path() / L"extracted";
         if (!fs::exists(extractedDir) || !fs::is_directory(extractedDir)) { AppendLog(L"  No 'extracted' folder found, skipping rename for this .flo."); continue; }
+        RunFile file(metrics);
+        file.bytes_in(it->file_size(ec)); ec.clear();
         std::map<int, SoundDataFileEntry> soundDataFiles; std::map<int, SimpleEventEntry> simpleEvents; std::map<int, RandomEventEntry> randomEvents; std::map<int, CompoundEventEntry> compoundEvents; std::vector<EventMapEntry> eventMaps; SoundParameterSets sps;
-        if (!ParseFlo(floPath, soundDataFiles, simpleEvents, randomEvents, compoundEvents, eventMaps, sps)) { continue; }
+        bool parsed;
+        { RunStageTimer parseTime(RunStage::Parse); parsed = ParseFlo(floPath, soundDataFiles, simpleEvents, randomEvents, compoundEvents, eventMaps, sps); }
+        if (!parsed) { file.fail(RunError::Format); continue; }
         AppendLog(L"  --- Detailed .flo Analysis ---");
         AppendLog(L"    Parsed: " + std::to_wstring(soundDataFiles.size()) + L" SDFs, " + std::to_wstring(simpleEvents.size()) + L" Simple, " + std::to_wstring(randomEvents.size()) + L" Random, " + std::to_wstring(compoundEvents.size()) + L" Compound, " + std::to_wstring(eventMaps.size()) + L" EventMap entries.");
         std::map<int, int> simple_to_sdf; for (auto& kv : simpleEvents) simple_to_sdf[kv.first] = kv.second.sound_data_file_id;
         std::map<int, std::vector<LinkProvenance>> sdf_to_eventmaps; int appearance_counter = 0, unresolved_rows = 0;
         for (const auto& em : eventMaps) {
-            std::vector<int> sdf_ids_here, via_simple_ids;
-            int used_domain = ExpandRefWithFallback(em.type_col2, em.event_ref_col3, simpleEvents, randomEvents, compoundEvents, simple_to_sdf, sdf_ids_here, via_simple_ids);
+            std::vector<int> sdf_ids_here, via_simple_ids; int used_domain;
+            if (!em.resolved_sdf.empty()) { sdf_ids_here = em.resolved_sdf; via_simple_ids = em.resolved_simple; used_domain = (em.type_col2 == 0) ? DOMAIN_SIMPLE : (em.type_col2 == 1) ? DOMAIN_RANDOM : DOMAIN_COMPOUND; }
+            else used_domain = ExpandRefWithFallback(em.type_col2, em.event_ref_col3, simpleEvents, randomEvents, compoundEvents, simple_to_sdf, sdf_ids_here, via_simple_ids);
             if (sdf_ids_here.empty()) { ++unresolved_rows; }
             std::set<int> uniq_sdf(sdf_ids_here.begin(), sdf_ids_here.end());
             for (int sdf_id : uniq_sdf) { LinkProvenance p{}; p.eventmap_id = em.id_col1; p.section = s2ws(em.section_name); p.domain = used_domain; p.link_id = em.event_ref_col3; p.global_name = em.name_col4; p.appearance_idx = appearance_counter; p.expansion_size = (int)uniq_sdf.size(); p.via_sdf_id = sdf_id; if (!via_simple_ids.empty()) p.via_simple_id = via_simple_ids.front(); sdf_to_eventmaps[sdf_id].push_back(std::move(p)); }
@@ -340,6 +346,7 @@ void AnalyzeAndRenameWavs(const std::wstring& rootPath) {
         std::map<int, std::wstring> finalNameForSdf = primaryNameForSdf; std::map<std::wstring, std::vector<int>> byName; for (const auto& kvp : primaryNameForSdf) byName[kvp.second].push_back(kvp.first);
         for (auto& kvn : byName) { auto& sdfs = kvn.second; if (sdfs.size() <= 1) continue; std::sort(sdfs.begin(), sdfs.end()); for (size_t i = 0; i < sdfs.size(); ++i) { finalNameForSdf[sdfs[i]] = kvn.first + L"_" + std::to_wstring(i + 1); } }
         AppendLog(L"  --- Renaming WAV files in " + extractedDir.wstring() + L" ---");
+        RunStageTimer renameTime(RunStage::Write);
         int renamed = 0, errors = 0; std::map<std::wstring, int> targetCollisionCheck;
         for (auto& f : fs::directory_iterator(extractedDir, ec)) {
             if (ec) { ec.clear(); continue; } if (!f.is_regular_file() || LowerExt(f.path()) != L".wav") continue;
@@ -357,12 +364,15 @@ void AnalyzeAndRenameWavs(const std::wstring& rootPath) {
             else { AppendLog(L"  Renamed " + f.path().filename().wstring() + L" -> " + newPath.filename().wstring()); targetCollisionCheck[newPath.filename().wstring()] = sdf_id; ++renamed; }
         }
         AppendLog(L"  Finished for " + floPath.filename().wstring() + L". Renamed: " + std::to_wstring(renamed) + L", Errors: " + std::to_wstring(errors));
+        if (errors) file.fail(RunError::Write);
     }
     AppendLog(L"Renaming and analysis pass complete.");
 }
 
 void RepackAudio(HWND hwnd) {
+    FlushLogOnExit flushOnExit(hwnd);
     AppendLog(L"--- Starting Audio Repack ---");
+    TRACE_SCOPE_CAT("RepackAudio", "batch");
     std::wstring wavDir = BrowseForFolderModern(hwnd, L"Select folder containing .WAV files to repack");
     if (wavDir.empty()) { AppendLog(L"Repack cancelled: No source folder selected."); return; }
     wchar_t xbbPath[MAX_PATH] = { 0 }, xsbPath[MAX_PATH] = { 0 };
@@ -378,31 +388,147 @@ void RepackAudio(HWND hwnd) {
     if (wavFiles.empty()) { AppendLog(L"Error: No .wav files found in the selected directory."); return; }
     AppendLog(L"Found " + std::to_wstring(wavFiles.size()) + L" .wav files to repack.");
     uint32_t entryCount = (uint32_t)wavFiles.size();
-    FILE* fXBB = _wfopen(xbbPath, L"wb"); FILE* fXSB = _wfopen(xsbPath, L"wb");
-    if (!fXBB || !fXSB) { AppendLog(L"Error: Failed to create output files."); if (fXBB) fclose(fXBB); if (fXSB) fclose(fXSB); return; }
-    fwrite("\0\0\0\0", 4, 1, fXBB); fwrite(&entryCount, 4, 1, fXBB);
-    uint32_t entryStart = 8, currentOffset = 0;
-    for (uint32_t i = 0; i < entryCount; i++) {
-        FILE* w = _wfopen(wavFiles[i].c_str(), L"rb");
-        if (!w) { AppendLog(L"  Error: Could not open " + wavFiles[i]); continue; }
-        fseek(w, 0, SEEK_END); long fileSize = ftell(w); fseek(w, 0, SEEK_SET);
-        if (fileSize < 44) { fclose(w); continue; }
-        std::vector<uint8_t> wavBuf(fileSize); fread(wavBuf.data(), 1, fileSize, w); fclose(w);
-        int dataPos = find_fourcc(wavBuf.data(), wavBuf.size(), "data");
-        if (dataPos == -1) { AppendLog(L"  Warning: Could not find 'data' chunk in " + fs::path(wavFiles[i]).filename().wstring()); continue; }
-        uint32_t dataLength = 0; memcpy(&dataLength, &wavBuf[dataPos + 4], 4);
-        uint32_t headerLen = dataPos + 8;
-        if (headerLen + dataLength > wavBuf.size()) { AppendLog(L"  Warning: Corrupt WAV header in " + fs::path(wavFiles[i]).filename().wstring()); continue; }
-        fseek(fXBB, entryStart, SEEK_SET); fwrite(wavBuf.data(), 1, headerLen, fXBB);
-        entryStart += headerLen;
-        fwrite(&currentOffset, 4, 1, fXBB); fwrite(&dataLength, 4, 1, fXBB);
-        entryStart += 8;
-        fseek(fXSB, currentOffset, SEEK_SET); fwrite(wavBuf.data() + headerLen, 1, dataLength, fXSB);
-        currentOffset += dataLength;
+    RunMetrics metrics("WavRename", "repack");
+    AsyncIo io; IoOutput outXBB, outXSB;
+    if (!outXBB.open(xbbPath) || !outXSB.open(xsbPath)) { AppendLog(L"Error: Failed to create output files."); return; }
+    // The XBB (headers only) is built in memory and written once; the audio goes to the XSB batch by batch:
+    // REPACK_BATCH whole WAVs are read together, then their data chunks are written together at their offsets.
+    constexpr size_t REPACK_BATCH = 64;
+    std::vector<uint8_t> xbb(8, 0); memcpy(&xbb[4], &entryCount, 4);
+    uint32_t currentOffset = 0; bool writeOk = true;
+    for (size_t first = 0; first < wavFiles.size(); first += REPACK_BATCH) {
+        std::vector<IoRead> wavs((std::min)(REPACK_BATCH, wavFiles.size() - first));
+        for (size_t k = 0; k < wavs.size(); ++k) wavs[k].path = wavFiles[first + k];
+        { RunStageTimer readTime(metrics, RunStage::Read); io.read(wavs, IoHint::Sequential); }
+        std::vector<IoWrite> audio;
+        for (size_t k = 0; k < wavs.size(); ++k) {
+            const IoRead& w = wavs[k]; const std::wstring& wavFile = wavFiles[first + k];
+            RunFile file(metrics);
+            if (!w.ok()) { file.fail(RunError::Open); AppendLog(L"  Error: Could not open " + wavFile); continue; }
+            file.bytes_in(w.data.size());
+            if (w.data.size() < 44) { file.fail(RunError::Format); continue; }
+            RiffChunk data;
+            if (!RiffReader(w.data.data(), w.data.size()).find("data", data)) { file.fail(RunError::Format); AppendLog(L"  Warning: Could not find 'data' chunk in " + fs::path(wavFile).filename().wstring()); continue; }
+            if (!data.complete() || data.size > 0xFFFFFFFFu) { file.fail(RunError::Format); AppendLog(L"  Warning: Corrupt WAV header in " + fs::path(wavFile).filename().wstring()); continue; }
+            uint32_t dataLength = (uint32_t)data.size;
+            uint32_t headerLen = (uint32_t)data.data_offset();
+            file.bytes_out(uint64_t(headerLen) + 8 + dataLength);
+            xbb.insert(xbb.end(), w.data.begin(), w.data.begin() + headerLen);
+            const size_t at = xbb.size(); xbb.resize(at + 8);
+            memcpy(&xbb[at], &currentOffset, 4); memcpy(&xbb[at + 4], &dataLength, 4);
+            audio.push_back({ currentOffset, w.data.data() + headerLen, dataLength });
+            currentOffset += dataLength;
+        }
+        RunStageTimer writeTime(metrics, RunStage::Write);
+        writeOk = io.write(outXSB, audio) && writeOk;
+    }
+    uint32_t finalSize = (uint32_t)xbb.size(); memcpy(&xbb[0], &finalSize, 4);
+    {
+        RunStageTimer writeTime(metrics, RunStage::Write);
+        writeOk = io.write(outXBB, { { 0, xbb.data(), xbb.size() } }) && writeOk;
+        outXBB.close(); outXSB.close();
+    }
+    LogRunMetrics(metrics, fs::path(xbbPath).parent_path());
+    if (!writeOk) { AppendLog(L"Error: Writing " + std::wstring(xbbPath) + L" / .xsb failed."); return; }
+    flushOnExit.done(L"Repack complete!");
+}
+
+// =================================================================================
+// SECTION: EVENT RENDERING
+// =================================================================================
+
+// Decoded PCM of one bank entry, keyed by the entry's fmt + audio bytes: the session cache first, then the on-disk one.
+static PcmPtr DecodeXbbEntry(const ArchiveEntry& e) {
+    TRACE_SCOPE_CAT("DecodeXbbEntry", "codec");
+    if (!e.header || !e.data) return nullptr;
+    RiffChunk fmtChunk;
+    if (!RiffReader(e.header, e.header_len).find("fmt ", fmtChunk) || !fmtChunk.complete()) return nullptr;
+    const uint8_t* fmt = fmtChunk.data; const uint32_t fmtLen = (uint32_t)fmtChunk.size;
+    const uint64_t key = PcmDiskCache::Key(fmt, fmtLen, e.data, e.data_len);
+    return g_pcmCache.get(key, [&](PcmBuffer& out) { return PcmDiskCache::Shared().load_or_decode(key, out, [&](PcmBuffer& pcm) { RunStageTimer decodeTime(RunStage::Decode); ++g_pcmDecodes; return DecodeWaveData(fmt, fmtLen, e.data, e.data_len, pcm); }); });
+}
+
+static fs::path FindBankForFlo(const fs::path& floPath) {
+    fs::path same = floPath; same.replace_extension(L".xbb");
+    if (fs::exists(same)) return same;
+    fs::path found; int count = 0; std::error_code ec;
+    for (auto& f : fs::directory_iterator(floPath.parent_path(), ec)) if (f.is_regular_file() && LowerExt(f.path()) == L".xbb") { found = f.path(); ++count; }
+    return count == 1 ? found : fs::path();
+}
+
+// Renders every named EventMap row of one .flo into <flo folder>\rendered: one WAV per row, or one per choice
+// (name_vN.wav) for Random events. Rows are mixed on the pool; logging happens afterwards on this thread.
+static void RenderEventsForFlo(const fs::path& floPath, ThreadPool& pool, RunMetrics& metrics) {
+    TRACE_SCOPE_CAT("RenderEventsForFlo", "batch");
+    AppendLog(L"Rendering events of: " + floPath.wstring());
+    fs::path bankPath = FindBankForFlo(floPath);
+    if (bankPath.empty()) { AppendLog(L"  No matching .xbb next to this .flo, skipping."); return; }
+    SoundArchive bank;
+    if (!bank.open(bankPath) || !bank.valid()) { AppendLog(L"  Error: Could not read " + bankPath.filename().wstring()); return; }
+    flo::Model m; flo::Expansion x;
+    if (!flo::LoadOrParse(floPath, m, x)) { AppendLog(L"  Error: Could not open .flo file: " + floPath.wstring()); return; }
+    flo::IdTables ids; ids.build(m);
+    fs::path outDir = floPath.parent_path() / L"rendered"; std::error_code ec; fs::create_directory(outDir, ec);
+
+    // Output names are fixed up front so duplicate EventMap names never race for a file.
+    std::vector<size_t> rows; std::vector<std::wstring> names; std::set<std::wstring> used;
+    for (size_t i = 0; i < m.maps.size(); ++i) {
+        std::string_view nm = flo::NameAfterStar(m.maps.name[i]); if (nm.empty()) continue;
+        std::wstring base = s2ws(std::string(nm)); for (auto& c : base) if (c == L'*' || c == L'/' || c == L'\\' || c == L':' || c == L'?' || c == L'"' || c == L'<' || c == L'>' || c == L'|') c = L'_';
+        if (!used.insert(base).second) { base += L"_" + std::to_wstring(m.maps.id[i]); used.insert(base); }
+        rows.push_back(i); names.push_back(base);
+    }
+    std::vector<std::wstring> problems(rows.size()); std::vector<int> written(rows.size(), 0);
+    const std::vector<ArchiveEntry>& entries = bank.entries();   // walked here, read-only on the pool
+    auto source = [&](int sdf_id) -> PcmPtr { return (sdf_id >= 0 && (size_t)sdf_id < entries.size()) ? DecodeXbbEntry(entries[sdf_id]) : nullptr; };
+    pool.parallel_for(rows.size(), [&](size_t r, unsigned) {
+        TRACE_SCOPE_CAT("render row", "flo");
+        RunFile row(metrics);
+        std::vector<flo::RenderVariant> variants;
+        if (!flo::PlanEventMap(m, ids, rows[r], variants)) { problems[r] = L"nothing to play"; row.fail(RunError::Format); return; }
+        PcmBuffer mix;
+        RunError lastError = RunError::None;
+        for (size_t v = 0; v < variants.size(); ++v) {
+            size_t missing = 0;
+            bool mixed;
+            { RunStageTimer mixTime(RunStage::Mix); mixed = flo::MixVariant(variants[v], source, mix, &missing); }
+            if (!mixed) { problems[r] = L"no decodable source"; lastError = RunError::Decode; continue; }
+            if (missing) problems[r] = std::to_wstring(missing) + L" source(s) missing or undecodable";
+            std::wstring file = names[r] + (variants.size() > 1 ? L"_v" + std::to_wstring(v + 1) : L"") + L".wav";
+            RunStageTimer writeTime(RunStage::Write);
+            if (flo::WritePcmWav(outDir / file, mix)) { ++written[r]; row.samples(mix.samples.size()); row.bytes_out(mix.samples.size() * sizeof(int16_t)); }
+            else { problems[r] = L"could not write " + file; lastError = RunError::Write; }
+        }
+        if (written[r] == 0) row.fail(lastError);
+    });
+    int files = 0, failed = 0;
+    for (size_t r = 0; r < rows.size(); ++r) {
+        files += written[r]; if (written[r] == 0) ++failed;
+        if (!problems[r].empty()) AppendLog(L"  " + names[r] + L": " + problems[r]);
+    }
+    AppendLog(L"  Rendered " + std::to_wstring(files) + L" WAV(s) for " + std::to_wstring(rows.size() - failed) + L" of " + std::to_wstring(rows.size()) + L" EventMap rows into " + outDir.wstring());
+}
+
+void RenderAllEvents(HWND hwnd) {
+    wchar_t buf[MAX_PATH];
+    GetWindowTextW(GetDlgItem(hwnd, IDC_EDIT_PATH), buf, MAX_PATH);
+    std::wstring rootPath(buf);
+    if (rootPath.empty() || !fs::is_directory(rootPath)) { MessageBoxW(hwnd, L"Select a root Audio folder first using the 'Browse' button.", L"Error", MB_OK | MB_ICONERROR); return; }
+    FlushLog(); SetWindowTextW(g_hLog, L"");
+    FlushLogOnExit flushOnExit(hwnd);
+    AppendLog(L"--- Starting Event Rendering ---");
+    RunMetrics metrics("WavRename", "render_events");
+    const size_t misses0 = g_pcmCache.misses(), hits0 = g_pcmCache.hits(), decodes0 = g_pcmDecodes;
+    ThreadPool pool;
+    std::error_code ec; int flos = 0;
+    for (auto it = fs::recursive_directory_iterator(rootPath, fs::directory_options::skip_permission_denied, ec); it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec) { ec.clear(); continue; }
+        if (it->is_regular_file() && LowerExt(it->path()) == L".flo") { RenderEventsForFlo(it->path(), pool, metrics); ++flos; }
     }
-    uint32_t finalSize = entryStart; fseek(fXBB, 0, SEEK_SET); fwrite(&finalSize, 4, 1, fXBB);
-    fclose(fXBB); fclose(fXSB);
-    MessageBoxW(hwnd, L"Repack complete!", L"Done", MB_OK);
+    const size_t loaded = g_pcmCache.misses() - misses0, decoded = g_pcmDecodes - decodes0;
+    AppendLog(L"Rendering complete. " + std::to_wstring(flos) + L" .flo file(s), " + std::to_wstring(decoded) + L" sound(s) decoded, " + std::to_wstring(loaded - decoded) + L" loaded from the disk cache, " + std::to_wstring(g_pcmCache.hits() - hits0) + L" reused in memory.");
+    LogRunMetrics(metrics, rootPath);
+    flushOnExit.done(L"Event rendering complete!");
 }
 
 // **NEW**: Orchestrator for the unified batch process.
@@ -413,18 +539,23 @@ void DoUnifiedBatchProcess(HWND hwnd) {
     if (rootPath.empty()) { MessageBoxW(hwnd, L"Select a root Audio folder first using the 'Browse' button.", L"Error", MB_OK | MB_ICONERROR); return; }
     if (!fs::exists(rootPath) || !fs::is_directory(rootPath)) { MessageBoxW(hwnd, L"The selected path is not a valid directory.", L"Error", MB_OK | MB_ICONERROR); return; }
 
-    SetWindowTextW(g_hLog, L"");
+    FlushLog(); SetWindowTextW(g_hLog, L"");
+    FlushLogOnExit flushOnExit(hwnd);
 
     // First Pass: Extract all audio throughout the entire directory tree.
-    BatchExtractAll(rootPath);
+    RunMetrics extractMetrics("WavRename", "extract");
+    BatchExtractAll(rootPath, extractMetrics);
+    LogRunMetrics(extractMetrics, rootPath);
     AppendLog(L"");
 
     // Second Pass: Analyze all .flo files and rename the newly extracted audio.
-    AnalyzeAndRenameWavs(rootPath);
+    RunMetrics renameMetrics("WavRename", "rename");
+    AnalyzeAndRenameWavs(rootPath, renameMetrics);
+    LogRunMetrics(renameMetrics, rootPath);
     AppendLog(L"");
 
     AppendLog(L"--- All tasks complete! ---");
-    MessageBoxW(hwnd, L"Batch processing complete for all subdirectories!", L"Done", MB_OK);
+    flushOnExit.done(L"Batch processing complete for all subdirectories!");
 }
 
 // =================================================================================
@@ -437,8 +568,9 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         CreateWindowW(L"STATIC", L"Root Folder:", WS_CHILD | WS_VISIBLE, 10, 12, 80, 20, hwnd, NULL, g_hInst, NULL);
         CreateWindowW(L"EDIT", NULL, WS_CHILD | WS_VISIBLE | WS_BORDER | ES_READONLY, 90, 10, 360, 25, hwnd, (HMENU)IDC_EDIT_PATH, g_hInst, NULL);
         CreateWindowW(L"BUTTON", L"Browse...", WS_CHILD | WS_VISIBLE, 460, 10, 80, 25, hwnd, (HMENU)IDC_BROWSE, g_hInst, NULL);
-        CreateWindowW(L"BUTTON", L"Extract & Rename All", WS_CHILD | WS_VISIBLE, 10, 45, 260, 30, hwnd, (HMENU)ID_BUTTON_EXTRACT_RENAME, g_hInst, NULL);
-        CreateWindowW(L"BUTTON", L"Repack Audio to XBB/XSB", WS_CHILD | WS_VISIBLE, 280, 45, 260, 30, hwnd, (HMENU)ID_BUTTON_REPACK, g_hInst, NULL);
+        CreateWindowW(L"BUTTON", L"Extract & Rename All", WS_CHILD | WS_VISIBLE, 10, 45, 170, 30, hwnd, (HMENU)ID_BUTTON_EXTRACT_RENAME, g_hInst, NULL);
+        CreateWindowW(L"BUTTON", L"Render Events to WAV", WS_CHILD | WS_VISIBLE, 190, 45, 170, 30, hwnd, (HMENU)ID_BUTTON_RENDER, g_hInst, NULL);
+        CreateWindowW(L"BUTTON", L"Repack Audio to XBB/XSB", WS_CHILD | WS_VISIBLE, 370, 45, 170, 30, hwnd, (HMENU)ID_BUTTON_REPACK, g_hInst, NULL);
         g_hLog = CreateWindowW(L"EDIT", NULL, WS_CHILD | WS_VISIBLE | WS_BORDER | ES_MULTILINE | ES_AUTOVSCROLL | ES_READONLY | WS_VSCROLL | WS_HSCROLL, 10, 85, 530, 260, hwnd, (HMENU)IDC_LOG, g_hInst, NULL);
         SendMessageW(g_hLog, EM_LIMITTEXT, 0, 0);
     } break;
@@ -450,10 +582,14 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         else if (LOWORD(wParam) == ID_BUTTON_EXTRACT_RENAME) {
             DoUnifiedBatchProcess(hwnd);
         }
+        else if (LOWORD(wParam) == ID_BUTTON_RENDER) {
+            RenderAllEvents(hwnd);
+        }
         else if (LOWORD(wParam) == ID_BUTTON_REPACK) {
             RepackAudio(hwnd);
         }
         break;
+    case WM_APP_LOG: DrainLog(false); break;
     case WM_DESTROY: PostQuitMessage(0); break;
     default: return DefWindowProcW(hwnd, msg, wParam, lParam);
     }
@@ -461,6 +597,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 }
 
 int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, int nCmdShow) {
+    TraceSession trace;
     g_hInst = hInst;
     if (FAILED(CoInitializeEx(NULL, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE))) {
         MessageBoxW(NULL, L"COM Initialization failed.", L"Error", MB_OK | MB_ICONERROR);
@@ -474,10 +611,19 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, int nCmdShow) {
         WS_OVERLAPPEDWINDOW & ~WS_THICKFRAME & ~WS_MAXIMIZEBOX,
         CW_USEDEFAULT, CW_USEDEFAULT, 565, 400, NULL, NULL, hInst, NULL);
     if (!hwnd) { MessageBoxW(NULL, L"Window Creation Failed!", L"Error", MB_ICONERROR | MB_OK); return 1; }
+    // Log sink: the control (posted to, rate-limited) and, when GLADIUS_LOG names a file, that file too.
+    g_uiThread = GetCurrentThreadId();
+    LogTargets logTargets;
+    wchar_t logPath[MAX_PATH];
+    const DWORD logLen = GetEnvironmentVariableW(L"GLADIUS_LOG", logPath, MAX_PATH);
+    if (logLen > 0 && logLen < MAX_PATH) logTargets.file = logPath;
+    logTargets.ui_notify = [hwnd] { PostMessageW(hwnd, WM_APP_LOG, 0, 0); };
+    g_log.start(logTargets);
     ShowWindow(hwnd, nCmdShow);
     UpdateWindow(hwnd);
     MSG msg;
     while (GetMessageW(&msg, NULL, 0, 0) > 0) { TranslateMessage(&msg); DispatchMessageW(&msg); }
+    g_log.stop();
     CoUninitialize();
     return (int)msg.wParam;
 }
\ No newline at end of file